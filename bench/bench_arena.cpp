@@ -0,0 +1,79 @@
+// Compares the allocation strategies for document indexes built for small, frequent documents:
+// the default allocator (i.e. malloc), `ArenaResource` reset after every document and
+// `std::pmr::monotonic_buffer_resource` created for every document.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_arena.cpp -o bench_arena && ./bench_arena
+
+#include "../parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // Documents of a few hundred bytes, like the bodies of typical API requests
+    auto MakeDocuments(size_t count) -> std::vector<std::string> {
+        auto docs = std::vector<std::string>{};
+        for (size_t i = 0; i != count; ++i) {
+            auto doc = std::string{"{\"request_id\": "} + std::to_string(i * 7919)
+                + ", \"user\": {\"id\": " + std::to_string(i) + ", \"name\": \"user" + std::to_string(i) + "\"}"
+                + ", \"tags\": [";
+            for (size_t j = 0; j != i % 8 + 1; ++j) doc += "\"tag" + std::to_string(j) + "\", ";
+            doc += "], \"params\": {";
+            for (size_t j = 0; j != i % 12 + 1; ++j) {
+                doc += "\"p" + std::to_string(j) + "\": " + std::to_string(i * j) + ", ";
+            }
+            doc += "}}";
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+    template <class TBuild>
+    auto Measure(const char* name, const std::vector<std::string>& docs, size_t nRounds, TBuild&& build) -> void {
+        size_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round != nRounds; ++round) {
+            for (const auto& doc : docs) checksum += build(JsonValue{doc});
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        std::printf(
+            "%-28s %8.1f ns/document (checksum %zu)\n",
+            name, elapsed.count() / static_cast<double>(nRounds * docs.size()), checksum
+        );
+    }
+} // namespace
+
+
+auto main() -> int {
+    const auto docs = MakeDocuments(256);
+    constexpr size_t nRounds = 2000;
+
+    Measure("malloc", docs, nRounds, [](const JsonValue& json) {
+        const auto& index = DocumentIndex::Build(json).Value();
+        return index.View(json).Value().Root().size().Value();
+    });
+
+    auto arena = ArenaResource{};
+    Measure("ArenaResource", docs, nRounds, [&arena](const JsonValue& json) {
+        size_t result = 0;
+        {
+            const auto built = pmr::DocumentIndex::Build(json, &arena);
+            result = built.Value().View(json).Value().Root().size().Value();
+        }
+        arena.Reset();
+        return result;
+    });
+
+    Measure("monotonic_buffer_resource", docs, nRounds, [](const JsonValue& json) {
+        auto resource = std::pmr::monotonic_buffer_resource{};
+        const auto built = pmr::DocumentIndex::Build(json, &resource);
+        return built.Value().View(json).Value().Root().size().Value();
+    });
+}
@@ -0,0 +1,101 @@
+// Compares building the indexes of many small documents one by one (with the default allocator
+// and with an `ArenaResource` reset after every document) with `BatchParser`, for documents
+// of different sizes. Reports documents per second and MB/s.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_batch.cpp -o bench_batch && ./bench_batch
+
+#include "../parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // Request-like documents of about `size` bytes each, `totalSize` bytes in all,
+    // so that the larger documents don't fit into the caches either
+    auto MakeDocuments(size_t size, size_t totalSize) -> std::vector<std::string> {
+        auto docs = std::vector<std::string>{};
+        for (size_t i = 0; i * size < totalSize; ++i) {
+            auto doc = std::string{"{\"request_id\": "} + std::to_string(i * 7919)
+                + ", \"user\": {\"id\": " + std::to_string(i) + ", \"name\": \"user" + std::to_string(i) + "\"}"
+                + ", \"items\": [";
+            for (size_t j = 0; doc.size() + 40 < size; ++j) {
+                doc += "{\"sku\": " + std::to_string(i * 31 + j) + ", \"qty\": " + std::to_string(j % 7 + 1) + "}, ";
+            }
+            doc += "{}]}";
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+    template <class TBuild>
+    auto Measure(const char* name, size_t size, const std::vector<std::string_view>& docs, TBuild&& build) -> void {
+        size_t nBytes = 0;
+        for (const auto doc : docs) nBytes += doc.size();
+        size_t checksum = 0;
+        size_t nRounds = 0;
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>{};
+        do {
+            checksum += build(docs);
+            ++nRounds;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.5);
+        const auto seconds = elapsed.count() / static_cast<double>(nRounds);
+        std::printf(
+            "%6zu B  %-14s %12.0f documents/s %8.1f MB/s (checksum %zu)\n",
+            size, name, static_cast<double>(docs.size()) / seconds, static_cast<double>(nBytes) / seconds / 1e6, checksum
+        );
+    }
+} // namespace
+
+
+auto main() -> int {
+    for (const size_t size : {256, 512, 1024, 2048, 4096}) {
+        const auto docs = MakeDocuments(size, 16 << 20);
+        const auto views = std::vector<std::string_view>(docs.begin(), docs.end());
+
+        Measure("malloc", size, views, [](const std::vector<std::string_view>& batch) {
+            size_t result = 0;
+            for (const auto doc : batch) {
+                const auto json = JsonValue{doc};
+                const auto index = DocumentIndex::Build(json).Value();
+                result += index.View(json).Value().Root()["items"].size().Value();
+            }
+            return result;
+        });
+
+        auto arena = ArenaResource{};
+        Measure("ArenaResource", size, views, [&arena](const std::vector<std::string_view>& batch) {
+            size_t result = 0;
+            for (const auto doc : batch) {
+                const auto json = JsonValue{doc};
+                {
+                    const auto index = pmr::DocumentIndex::Build(json, &arena);
+                    result += index.Value().View(json).Value().Root()["items"].size().Value();
+                }
+                arena.Reset();
+            }
+            return result;
+        });
+
+        auto parser = BatchParser{};
+        Measure("BatchParser", size, views, [&parser](const std::vector<std::string_view>& batch) {
+            size_t result = 0;
+            // Batches of the size a server might collect at once
+            for (size_t begin = 0; begin < batch.size(); begin += 1024) {
+                const auto end = begin + 1024 < batch.size() ? begin + 1024 : batch.size();
+                for (const auto& root : parser.Parse(std::span{batch}.subspan(begin, end - begin))) {
+                    result += root["items"].size().Value();
+                }
+            }
+            return result;
+        });
+    }
+}
@@ -0,0 +1,77 @@
+// Compares the cost of navigating the documents of the benchmark corpus in the text form (`JsonValue`)
+// and in the binary form (`BinaryValue`), with the same accessor code for both, and measures the
+// throughput of `ToBinary`. In the text form, every access scans the containers on the way; in the
+// binary form, the sizes of the containers and the positions of their elements are stored.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_binary.cpp -o bench_binary && ./bench_binary
+
+#include "corpus.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    template <class TRun>
+    auto Measure(const std::string& name, size_t nRounds, TRun&& run) -> void {
+        size_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round != nRounds; ++round) checksum += run();
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        std::printf(
+            "%-40s %12.2f us/op (checksum %zu)\n",
+            name.c_str(), elapsed.count() / static_cast<double>(nRounds) / 1000, checksum
+        );
+    }
+
+    // Visits every value of the document
+    template <class TValue>
+    auto CountValues(const TValue& value) -> size_t {
+        size_t count = 1;
+        if (const auto mapping = value.template As<Mapping>(); mapping.HasValue()) {
+            for (const auto [key, child] : mapping) count += CountValues(child.Value());
+        } else if (const auto array = value.template As<Array>(); array.HasValue()) {
+            for (const auto child : array) count += CountValues(child.Value());
+        }
+        return count;
+    }
+
+    template <class TValue>
+    auto Navigate(const std::string& name, const TValue& root) -> void {
+        const auto nItems = root["items"].template As<Array>().size().Value();
+        Measure(name + ": size of items", 200, [&] {
+            return root["items"].template As<Array>().size().Value();
+        });
+        Measure(name + ": last item", 200, [&] {
+            return root["items"][nItems - 1].Value().GetData().size();
+        });
+        Measure(name + ": every 100th item", 20, [&] {
+            size_t sum = 0;
+            for (size_t i = 0; i < nItems; i += 100) sum += root["items"][i].Value().GetData().size();
+            return sum;
+        });
+        Measure(name + ": all values", 20, [&] {
+            return CountValues(root);
+        });
+    }
+} // namespace
+
+
+auto main() -> int {
+    for (const auto& [name, data] : NBench::MakeCorpus()) {
+        const auto json = JsonValue{data};
+        const auto binary = ToBinary(json).Value();
+        std::printf("%s: %zu bytes of json, %zu bytes in the binary form\n", name.c_str(), data.size(), binary.size());
+        Measure(name + ": ToBinary", 20, [&] {
+            return ToBinary(json).Value().size();
+        });
+        Navigate(name + ", json", json);
+        Navigate(name + ", binary", BinaryValue{binary});
+        std::printf("\n");
+    }
+}
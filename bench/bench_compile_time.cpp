@@ -0,0 +1,157 @@
+// Measures the cost of parsing json at compile time: for documents of increasing size, generates
+// a translation unit that iterates over a constexpr document in a `static_assert`, compiles it
+// with every available compiler and reports the compile time and the peak memory of the compiler.
+// The first row of every compiler ("0 bytes") is the cost of just including the library.
+// A compilation that fails (usually because the constexpr evaluation limit is hit) is reported
+// as such, with the first line of the error.
+//
+// Build and run (POSIX only):
+//     g++ --std=c++20 -O2 bench/bench_compile_time.cpp -o bench_compile_time && ./bench_compile_time
+//
+// Options:
+//     --compilers=<list>  comma-separated compilers to use ("g++,clang++" by default)
+//     --max-size=<bytes>  the size of the largest document (256 KiB by default; sizes grow 4x from 1 KiB)
+//     --flags=<flags>     extra compiler flags, e.g. "-fconstexpr-ops-limit=1000000000" for gcc or
+//                         "-fconstexpr-steps=1000000000" for clang to raise the evaluation limits
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace {
+    struct Options {
+        std::vector<std::string> Compilers = {"g++", "clang++"};
+        size_t MaxSize = 256 << 10;
+        std::string Flags;
+    };
+
+    auto Split(const std::string& str, char delimiter) -> std::vector<std::string> {
+        auto result = std::vector<std::string>{};
+        auto in = std::istringstream{str};
+        for (auto part = std::string{}; std::getline(in, part, delimiter);) {
+            if (!part.empty()) result.push_back(part);
+        }
+        return result;
+    }
+
+    // An array of `nItems` small mappings; the test sums their "id" fields
+    auto MakeDocument(size_t nItems) -> std::string {
+        auto doc = std::string{"{\n    \"items\": [\n"};
+        for (size_t i = 0; i != nItems; ++i) {
+            doc += "        {\"id\": " + std::to_string(i) + ", \"name\": \"item" + std::to_string(i)
+                + "\", \"tags\": [\"a\", \"b\"]}" + (i + 1 == nItems ? "\n" : ",\n");
+        }
+        doc += "    ]\n}\n";
+        return doc;
+    }
+
+    auto MakeSource(const std::string& parserPath, size_t nItems) -> std::string {
+        auto src = std::string{"#include \""} + parserPath + "\"\n";
+        if (nItems == 0) return src;
+        src += "using namespace NJsonParser;\n";
+        src += "constexpr char kDoc[] = R\"json(" + MakeDocument(nItems) + ")json\";\n";
+        src += "consteval auto SumIds() -> Int {\n"
+               "    Int sum = 0;\n"
+               "    for (const auto item : JsonValue{kDoc}[\"items\"].As<Array>()) sum += item[\"id\"].As<Int>().Value();\n"
+               "    return sum;\n"
+               "}\n";
+        src += "static_assert(SumIds() == " + std::to_string(nItems * (nItems - 1) / 2) + ");\n";
+        return src;
+    }
+
+    struct Measurement {
+        bool Started = false;
+        bool Succeeded = false;
+        double Seconds = 0;
+        long PeakMemoryKb = 0;
+        std::string FirstErrorLine;
+    };
+
+    auto Compile(const std::string& compiler, const std::string& flags, const std::string& srcPath) -> Measurement {
+        const auto errPath = srcPath + ".err";
+        auto args = std::vector<std::string>{compiler, "--std=c++20", "-fsyntax-only"};
+        for (const auto& flag : Split(flags, ' ')) args.push_back(flag);
+        args.push_back(srcPath);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto pid = fork();
+        if (pid == 0) {
+            if (!freopen(errPath.c_str(), "w", stderr)) _exit(126);
+            auto argv = std::vector<char*>{};
+            for (auto& arg : args) argv.push_back(arg.data());
+            argv.push_back(nullptr);
+            execvp(argv[0], argv.data());
+            _exit(127);
+        }
+        int status = 0;
+        auto usage = rusage{};
+        wait4(pid, &status, 0, &usage);
+        auto result = Measurement{};
+        result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.Started = !(WIFEXITED(status) && WEXITSTATUS(status) == 127);
+        result.Succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        result.PeakMemoryKb = usage.ru_maxrss;
+        if (!result.Succeeded) {
+            auto err = std::ifstream{errPath};
+            for (auto line = std::string{}; std::getline(err, line);) {
+                if (line.find("error") != std::string::npos) {
+                    result.FirstErrorLine = line.substr(0, 160);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+} // namespace
+
+
+auto main(int argc, char** argv) -> int {
+    auto options = Options{};
+    for (int i = 1; i != argc; ++i) {
+        const auto arg = std::string{argv[i]};
+        if (arg.starts_with("--compilers=")) options.Compilers = Split(arg.substr(12), ',');
+        else if (arg.starts_with("--max-size=")) options.MaxSize = std::stoull(arg.substr(11));
+        else if (arg.starts_with("--flags=")) options.Flags = arg.substr(8);
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    // The library is found relative to this file
+    const auto benchDir = std::string{__FILE__}.substr(0, std::string{__FILE__}.rfind('/') + 1);
+    char cwd[4096] = {};
+    const auto isRelative = benchDir.empty() || benchDir[0] != '/';
+    const auto parserPath = (isRelative && getcwd(cwd, sizeof(cwd)) ? std::string{cwd} + "/" : std::string{})
+        + benchDir + "../parser.hpp";
+    const auto srcPath = std::string{"/tmp/njson_bench_compile_time.cpp"};
+
+    std::printf("%-10s %10s %8s %12s %12s\n", "compiler", "bytes", "items", "seconds", "peak MiB");
+    for (const auto& compiler : options.Compilers) {
+        for (size_t size = 0; size <= options.MaxSize; size = (size == 0 ? 1024 : 4 * size)) {
+            // Every item takes about 60 bytes
+            const auto nItems = size / 60;
+            const auto src = MakeSource(parserPath, nItems);
+            std::ofstream{srcPath} << src;
+            const auto result = Compile(compiler, options.Flags, srcPath);
+            if (!result.Started) {
+                std::printf("%-10s not available\n", compiler.c_str());
+                break;
+            }
+            std::printf(
+                "%-10s %10zu %8zu %12.2f %12.1f%s%s\n",
+                compiler.c_str(), size == 0 ? 0 : MakeDocument(nItems).size(), nItems,
+                result.Seconds, static_cast<double>(result.PeakMemoryKb) / 1024,
+                result.Succeeded ? "" : "  FAILED: ", result.FirstErrorLine.c_str()
+            );
+            std::fflush(stdout);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// Measures how lookups into one large document scale with the number of reader threads when
+// the threads share one `LazyDocumentIndex` and when every thread builds an index of its own.
+// With a shared index, the containers are scanned once in total, so the throughput should grow
+// almost linearly with the number of threads (as long as there are enough cores).
+//
+// Build and run:
+//     g++ --std=c++20 -O2 -pthread bench/bench_lazy_index.cpp -o bench_lazy_index && ./bench_lazy_index
+
+#include "../parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr size_t kNRows = 20000;
+    constexpr size_t kNFields = 16;
+    constexpr size_t kNLookupsPerThread = 400000;
+
+    // An array of mappings like `[{"f0": 0, "f1": 1, ...}, ...]`
+    auto MakeDocument() -> std::string {
+        auto doc = std::string{"["};
+        for (size_t i = 0; i != kNRows; ++i) {
+            doc += "{";
+            for (size_t j = 0; j != kNFields; ++j) {
+                doc += "\"f" + std::to_string(j) + "\": " + std::to_string(i + j) + ", ";
+            }
+            doc += "}, ";
+        }
+        doc += "]";
+        return doc;
+    }
+
+    auto Lookups(const LazyDocumentIndex& index, size_t seed) -> Int {
+        static const auto fields = [] {
+            auto result = std::vector<std::string>{};
+            for (size_t j = 0; j != kNFields; ++j) result.push_back("f" + std::to_string(j));
+            return result;
+        }();
+        Int checksum = 0;
+        auto state = seed * 2654435761u + 1;
+        for (size_t i = 0; i != kNLookupsPerThread; ++i) {
+            state = state * 6364136223846793005u + 1442695040888963407u;
+            const auto row = (state >> 33) % kNRows;
+            checksum += index.Root()[row][fields[(state >> 20) % kNFields]].As<Int>().Value();
+        }
+        return checksum;
+    }
+
+    template <class TWork>
+    auto Measure(const char* name, size_t nThreads, TWork&& work) -> void {
+        const auto start = std::chrono::steady_clock::now();
+        auto threads = std::vector<std::thread>{};
+        for (size_t t = 0; t != nThreads; ++t) threads.emplace_back([&work, t] { work(t); });
+        for (auto& thread : threads) thread.join();
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        std::printf(
+            "%-14s %2zu threads: %8.2f M lookups/s\n",
+            name, nThreads, static_cast<double>(nThreads * kNLookupsPerThread) / elapsed.count() / 1e6
+        );
+    }
+} // namespace
+
+
+auto main() -> int {
+    const auto doc = MakeDocument();
+    const auto json = JsonValue{doc};
+    const auto maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+        const auto shared = LazyDocumentIndex{json};
+        Measure("shared index", nThreads, [&shared](size_t t) { Lookups(shared, t); });
+        Measure("own index", nThreads, [&json](size_t t) { Lookups(LazyDocumentIndex{json}, t); });
+    }
+}
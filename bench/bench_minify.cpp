@@ -0,0 +1,72 @@
+// Measures the throughput of `Minify` and how much it speeds up navigating a pretty-printed document.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_minify.cpp -o bench_minify && ./bench_minify
+
+#include "../parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // A pretty-printed config of a few hundred kilobytes, about half of which is indentation
+    auto MakeConfig(size_t nServices) -> std::string {
+        auto doc = std::string{"{\n    \"services\": [\n"};
+        for (size_t i = 0; i != nServices; ++i) {
+            doc += "        {\n";
+            doc += "            \"name\": \"service-" + std::to_string(i) + "\",\n";
+            doc += "            \"replicas\": " + std::to_string(i % 7 + 1) + ",\n";
+            doc += "            \"ports\": [\n                " + std::to_string(8000 + i) + ",\n                "
+                + std::to_string(9000 + i) + "\n            ],\n";
+            doc += "            \"env\": {\n                \"LOG_LEVEL\": \"info\",\n                \"REGION\": \"eu-west-1\"\n            }\n";
+            doc += (i + 1 == nServices ? "        }\n" : "        },\n");
+        }
+        doc += "    ]\n}\n";
+        return doc;
+    }
+
+    template <class TRun>
+    auto Measure(const char* name, size_t nBytes, size_t nRounds, TRun&& run) -> void {
+        size_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round != nRounds; ++round) checksum += run();
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        const auto nsPerRound = elapsed.count() / static_cast<double>(nRounds);
+        std::printf(
+            "%-32s %10.1f us/op %8.2f GB/s (checksum %zu)\n",
+            name, nsPerRound / 1000, static_cast<double>(nBytes) / nsPerRound, checksum
+        );
+    }
+} // namespace
+
+
+auto main() -> int {
+    const auto pretty = MakeConfig(2000);
+    auto buffer = std::string(pretty.size(), '\0');
+    const auto minified = std::string{Minify(pretty, buffer).Value()};
+    std::printf("pretty: %zu bytes, minified: %zu bytes\n", pretty.size(), minified.size());
+    constexpr size_t nRounds = 200;
+
+    Measure("Minify", pretty.size(), nRounds, [&] {
+        return Minify(pretty, buffer).Value().size();
+    });
+    Measure("NUtils::MinifyScalar", pretty.size(), nRounds, [&] {
+        return NUtils::MinifyScalar(pretty, buffer.data(), {}).OutPos;
+    });
+    // Looking up the last element scans the whole document
+    Measure("last service, pretty", pretty.size(), nRounds, [&] {
+        return JsonValue{pretty}["services"][1999]["replicas"].As<Int>().Value();
+    });
+    Measure("last service, minified", minified.size(), nRounds, [&] {
+        return JsonValue{minified}["services"][1999]["replicas"].As<Int>().Value();
+    });
+    Measure("Minify + last service", pretty.size(), nRounds, [&] {
+        const auto json = JsonValue{Minify(pretty, buffer).Value()};
+        return json["services"][1999]["replicas"].As<Int>().Value();
+    });
+}
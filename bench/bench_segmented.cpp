@@ -0,0 +1,83 @@
+// Compares reading a few fields of documents received as chains of 1500-byte buffers by
+// concatenating the buffers for `JsonValue` and by navigating them with `SegmentedDocument`,
+// for documents of different sizes. Reports documents per second and MB/s.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_segmented.cpp -o bench_segmented && ./bench_segmented
+
+#include "../parser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr size_t kSegmentSize = 1500;
+
+    // Request-like documents of about `size` bytes each, `totalSize` bytes in all
+    auto MakeDocuments(size_t size, size_t totalSize) -> std::vector<std::string> {
+        auto docs = std::vector<std::string>{};
+        for (size_t i = 0; i * size < totalSize; ++i) {
+            auto doc = std::string{"{\"request_id\": "} + std::to_string(i * 7919) + ", \"items\": [";
+            for (size_t j = 0; doc.size() + 80 < size; ++j) {
+                doc += "{\"sku\": " + std::to_string(i * 31 + j) + ", \"note\": \"item " + std::to_string(j) + "\"}, ";
+            }
+            doc += "{}], \"user\": {\"id\": " + std::to_string(i) + ", \"name\": \"user" + std::to_string(i) + "\"}}";
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+    template <class TRead>
+    auto Measure(const char* name, size_t size, const std::vector<std::vector<std::string_view>>& docs, TRead&& read) -> void {
+        size_t nBytes = 0;
+        for (const auto& segments : docs) {
+            for (const auto segment : segments) nBytes += segment.size();
+        }
+        size_t checksum = 0;
+        size_t nRounds = 0;
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration<double>{};
+        do {
+            for (const auto& segments : docs) checksum += read(segments);
+            ++nRounds;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < 0.5);
+        const auto seconds = elapsed.count() / static_cast<double>(nRounds);
+        std::printf(
+            "%6zu B  %-18s %12.0f documents/s %8.1f MB/s (checksum %zu)\n",
+            size, name, static_cast<double>(docs.size()) / seconds, static_cast<double>(nBytes) / seconds / 1e6, checksum
+        );
+    }
+} // namespace
+
+
+auto main() -> int {
+    for (const size_t size : {2048, 8192, 32768, 131072}) {
+        const auto docs = MakeDocuments(size, 16 << 20);
+        auto chains = std::vector<std::vector<std::string_view>>{};
+        for (const auto& doc : docs) {
+            auto& chain = chains.emplace_back();
+            for (size_t pos = 0; pos < doc.size(); pos += kSegmentSize) chain.push_back(std::string_view{doc}.substr(pos, kSegmentSize));
+        }
+
+        auto buffer = std::string{};
+        Measure("concatenated", size, chains, [&buffer](const std::vector<std::string_view>& segments) {
+            buffer.clear();
+            for (const auto segment : segments) buffer += segment;
+            const auto root = JsonValue{buffer};
+            return static_cast<size_t>(root["user"]["id"].As<Int>().Value() + root["request_id"].As<Int>().Value());
+        });
+
+        Measure("SegmentedDocument", size, chains, [](const std::vector<std::string_view>& segments) {
+            const auto document = SegmentedDocument{segments};
+            const auto root = document.Root();
+            return static_cast<size_t>(root["user"]["id"].As<Int>().Value() + root["request_id"].As<Int>().Value());
+        });
+    }
+}
@@ -0,0 +1,333 @@
+// Measures the basic operations of the parser on a deterministic corpus (see `bench/corpus.hpp`):
+// `size()` of a large array, `operator[]` by index and by key, `As<T>()` of scalar values and
+// a full recursive iteration over a document. Reports ns/op and GB/s (the number of bytes of
+// the containers and values that an operation has to look at, divided by its time), and, with
+// `--perf`, cycles and instructions per operation read from the Linux perf events.
+//
+// Build and run:
+//     g++ --std=c++20 -O2 bench/bench_suite.cpp -o bench_suite && ./bench_suite
+//
+// Options:
+//     --filter=<substring>  run only the benchmarks whose names ("<document>/<operation>") contain it
+//     --min-time=<seconds>  the minimal time spent measuring every benchmark (0.5 by default)
+//     --size=<bytes>        the approximate size of every document of the corpus (1 MiB by default)
+//     --seed=<number>       the seed of the corpus (42 by default)
+//     --json=<path>         also write the results as json to be compared across commits
+//     --perf                count cycles and instructions with perf_event_open(2)
+//
+// To profile a single benchmark with `perf`, filter it, e.g.
+//     perf stat -e cycles,instructions,branch-misses ./bench_suite --filter=catalog/key --min-time=5
+
+#include "corpus.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    struct Options {
+        std::string Filter;
+        double MinTime = 0.5;
+        size_t Size = 1 << 20;
+        uint64_t Seed = 42;
+        std::string JsonPath;
+        bool Perf = false;
+    };
+
+    auto ParseOptions(int argc, char** argv) -> Options {
+        auto options = Options{};
+        for (int i = 1; i != argc; ++i) {
+            const auto arg = std::string_view{argv[i]};
+            const auto valueOf = [arg](std::string_view name) -> std::optional<std::string> {
+                if (!arg.starts_with(name)) return std::nullopt;
+                return std::string{arg.substr(name.size())};
+            };
+            if (const auto v = valueOf("--filter=")) options.Filter = *v;
+            else if (const auto v = valueOf("--min-time=")) options.MinTime = std::stod(*v);
+            else if (const auto v = valueOf("--size=")) options.Size = std::stoull(*v);
+            else if (const auto v = valueOf("--seed=")) options.Seed = std::stoull(*v);
+            else if (const auto v = valueOf("--json=")) options.JsonPath = *v;
+            else if (arg == "--perf") options.Perf = true;
+            else {
+                std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+
+    // Hardware counters of the calling thread (Linux only)
+    class PerfCounters {
+    private:
+        int CyclesFd = -1;
+        int InstructionsFd = -1;
+    private:
+#if defined(__linux__)
+        static auto Open(uint64_t config, int groupFd) -> int {
+            auto attr = perf_event_attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config;
+            attr.disabled = (groupFd == -1);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+        }
+#endif
+        static auto Read(int fd) -> uint64_t {
+            uint64_t value = 0;
+#if defined(__linux__)
+            if (read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#endif
+            return value;
+        }
+    public:
+        struct Values {
+            uint64_t Cycles = 0;
+            uint64_t Instructions = 0;
+        };
+
+        PerfCounters() {
+#if defined(__linux__)
+            CyclesFd = Open(PERF_COUNT_HW_CPU_CYCLES, -1);
+            if (CyclesFd != -1) InstructionsFd = Open(PERF_COUNT_HW_INSTRUCTIONS, CyclesFd);
+#endif
+        }
+        ~PerfCounters() {
+#if defined(__linux__)
+            if (InstructionsFd != -1) close(InstructionsFd);
+            if (CyclesFd != -1) close(CyclesFd);
+#endif
+        }
+        auto IsAvailable() const -> bool {
+            return CyclesFd != -1 && InstructionsFd != -1;
+        }
+        auto Start() -> void {
+#if defined(__linux__)
+            ioctl(CyclesFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(CyclesFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+        }
+        auto Stop() -> Values {
+#if defined(__linux__)
+            ioctl(CyclesFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+            return {.Cycles = Read(CyclesFd), .Instructions = Read(InstructionsFd)};
+        }
+    };
+
+    struct Benchmark {
+        std::string Name;
+        // The number of operations done by a single call of `Run`
+        size_t NOps;
+        // The number of bytes these operations look at
+        size_t NBytes;
+        // Returns a checksum, so that the work can't be optimized away
+        std::function<uint64_t()> Run;
+    };
+
+    struct Result {
+        std::string Name;
+        double NsPerOp;
+        double GBPerSecond;
+        double CyclesPerOp = 0;
+        double InstructionsPerOp = 0;
+    };
+
+    auto IsContainer(const JsonValue& value) -> bool {
+        const auto data = value.GetData();
+        return !data.empty() && (data.front() == '[' || data.front() == '{');
+    }
+
+    // Calls `onValue` for every value of the document
+    template <class TCallback>
+    auto Walk(const JsonValue& value, TCallback&& onValue) -> void {
+        onValue(value);
+        const auto data = value.GetData();
+        if (data.empty()) return;
+        if (data.front() == '[') {
+            for (const auto elem : value.As<Array>()) Walk(elem.Value(), onValue);
+        } else if (data.front() == '{') {
+            for (const auto [key, elem] : value.As<Mapping>()) Walk(elem.Value(), onValue);
+        }
+    }
+
+    auto ConvertScalar(const JsonValue& value) -> uint64_t {
+        const auto data = value.GetData();
+        switch (data.front()) {
+            case '"': return value.As<String>().Value().size();
+            case 't':
+            case 'f': return value.As<Bool>().Value();
+            case 'n': return 0;
+        }
+        if (data.find_first_of(".eE") != std::string_view::npos) return static_cast<uint64_t>(value.As<Float>().Value());
+        return static_cast<uint64_t>(value.As<Int>().Value());
+    }
+
+    auto MakeBenchmarks(const NBench::Document& doc) -> std::vector<Benchmark> {
+        const auto root = JsonValue{doc.Data};
+        const auto items = root["items"].As<Array>().Value();
+        const auto nItems = items.size();
+        const auto itemsSize = items.GetData().size();
+        auto benchmarks = std::vector<Benchmark>{};
+        const auto prefix = doc.Name + "/";
+
+        benchmarks.push_back({prefix + "size", 1, itemsSize, [items] {
+            return items.size();
+        }});
+
+        constexpr size_t kNIndexes = 16;
+        auto indexedBytes = size_t{0};
+        for (size_t k = 0; k != kNIndexes; ++k) indexedBytes += items[k * nItems / kNIndexes].Value().GetData().end() - items.GetData().begin();
+        benchmarks.push_back({prefix + "index", kNIndexes, indexedBytes, [items, nItems] {
+            uint64_t checksum = 0;
+            for (size_t k = 0; k != kNIndexes; ++k) checksum += items[k * nItems / kNIndexes].Value().GetData().size();
+            return checksum;
+        }});
+
+        // The last key of each of the first items
+        auto lookups = std::vector<std::pair<JsonValue, std::string_view>>{};
+        auto lookedUpBytes = size_t{0};
+        for (const auto item : items) {
+            if (lookups.size() == 256) break;
+            if (item.Value().GetData().front() != '{') break;
+            auto lastKey = std::string_view{};
+            for (const auto [key, value] : item.As<Mapping>()) lastKey = key.Value();
+            lookups.emplace_back(item.Value(), lastKey);
+            lookedUpBytes += item.Value().GetData().size();
+        }
+        if (!lookups.empty()) {
+            benchmarks.push_back({prefix + "key", lookups.size(), lookedUpBytes, [lookups] {
+                uint64_t checksum = 0;
+                for (const auto& [item, key] : lookups) checksum += item[key].Value().GetData().size();
+                return checksum;
+            }});
+        }
+
+        auto scalars = std::vector<JsonValue>{};
+        auto scalarBytes = size_t{0};
+        Walk(root, [&](const JsonValue& value) {
+            if (scalars.size() == 4096 || IsContainer(value)) return;
+            scalars.push_back(value);
+            scalarBytes += value.GetData().size();
+        });
+        benchmarks.push_back({prefix + "as", scalars.size(), scalarBytes, [scalars] {
+            uint64_t checksum = 0;
+            for (const auto& value : scalars) checksum += ConvertScalar(value);
+            return checksum;
+        }});
+
+        benchmarks.push_back({prefix + "iterate", 1, doc.Data.size(), [root] {
+            uint64_t nValues = 0;
+            Walk(root, [&nValues](const JsonValue&) { ++nValues; });
+            return nValues;
+        }});
+        return benchmarks;
+    }
+
+    auto Measure(const Benchmark& benchmark, const Options& options, PerfCounters* perf) -> Result {
+        using TClock = std::chrono::steady_clock;
+        volatile uint64_t sink = 0;
+        // Calibration: find the number of runs that takes about a fifth of the minimal time
+        size_t nRuns = 1;
+        for (;;) {
+            const auto start = TClock::now();
+            for (size_t i = 0; i != nRuns; ++i) sink = sink + benchmark.Run();
+            const auto elapsed = std::chrono::duration<double>(TClock::now() - start).count();
+            if (elapsed >= options.MinTime / 5 || nRuns >= (size_t{1} << 40)) break;
+            nRuns *= 2;
+        }
+        // The median of five samples
+        auto samples = std::vector<std::pair<double, PerfCounters::Values>>{};
+        for (size_t sample = 0; sample != 5; ++sample) {
+            if (perf) perf->Start();
+            const auto start = TClock::now();
+            for (size_t i = 0; i != nRuns; ++i) sink = sink + benchmark.Run();
+            const auto elapsed = std::chrono::duration<double, std::nano>(TClock::now() - start).count();
+            samples.emplace_back(elapsed, perf ? perf->Stop() : PerfCounters::Values{});
+        }
+        std::sort(samples.begin(), samples.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        const auto& [ns, counters] = samples[samples.size() / 2];
+        const auto nOps = static_cast<double>(nRuns * benchmark.NOps);
+        return {
+            .Name = benchmark.Name,
+            .NsPerOp = ns / nOps,
+            .GBPerSecond = static_cast<double>(nRuns * benchmark.NBytes) / ns,
+            .CyclesPerOp = static_cast<double>(counters.Cycles) / nOps,
+            .InstructionsPerOp = static_cast<double>(counters.Instructions) / nOps,
+        };
+    }
+
+    auto ToJson(const Options& options, const std::vector<Result>& results) -> std::string {
+        auto writer = Writer{};
+        writer.BeginMapping()
+            .Key("seed").Value(options.Seed)
+            .Key("size").Value(options.Size)
+            .Key("compiler").Value(__VERSION__)
+            .Key("results").BeginArray();
+        for (const auto& result : results) {
+            writer.BeginMapping()
+                .Key("name").Value(result.Name)
+                .Key("ns_per_op").Value(result.NsPerOp)
+                .Key("gb_per_s").Value(result.GBPerSecond);
+            if (options.Perf) {
+                writer.Key("cycles_per_op").Value(result.CyclesPerOp)
+                    .Key("instructions_per_op").Value(result.InstructionsPerOp);
+            }
+            writer.EndMapping();
+        }
+        writer.EndArray().EndMapping();
+        return std::string{writer.Finish().Value()};
+    }
+} // namespace
+
+
+auto main(int argc, char** argv) -> int {
+    const auto options = ParseOptions(argc, argv);
+    auto perf = std::optional<PerfCounters>{};
+    if (options.Perf) {
+        perf.emplace();
+        if (!perf->IsAvailable()) {
+            std::fprintf(stderr, "perf events are not available (see /proc/sys/kernel/perf_event_paranoid)\n");
+            return 1;
+        }
+    }
+
+    const auto corpus = NBench::MakeCorpus(options.Seed, options.Size);
+    auto results = std::vector<Result>{};
+    std::printf("%-28s %12s %10s%s\n", "benchmark", "ns/op", "GB/s", options.Perf ? "     cycles/op    instrs/op" : "");
+    for (const auto& doc : corpus) {
+        for (const auto& benchmark : MakeBenchmarks(doc)) {
+            if (benchmark.Name.find(options.Filter) == std::string::npos) continue;
+            const auto result = Measure(benchmark, options, perf ? &*perf : nullptr);
+            std::printf("%-28s %12.1f %10.3f", result.Name.c_str(), result.NsPerOp, result.GBPerSecond);
+            if (options.Perf) std::printf(" %13.0f %12.0f", result.CyclesPerOp, result.InstructionsPerOp);
+            std::printf("\n");
+            std::fflush(stdout);
+            results.push_back(result);
+        }
+    }
+
+    if (!options.JsonPath.empty()) {
+        auto out = std::ofstream{options.JsonPath};
+        out << ToJson(options, results) << "\n";
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+// A deterministic generator of benchmark documents. The same seed gives the same documents on
+// every platform (the generator doesn't use the standard distributions, the results of which
+// depend on the standard library), so measurements can be compared across commits and machines.
+// Every document is a mapping with an "items" array, which is what the benchmarks navigate.
+
+#include "../parser.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace NBench {
+    // splitmix64
+    class Rng {
+    private:
+        uint64_t State;
+    public:
+        explicit Rng(uint64_t seed) : State(seed) {}
+        auto Next() -> uint64_t {
+            auto z = (State += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+        auto Below(uint64_t bound) -> uint64_t {
+            return Next() % bound;
+        }
+    };
+
+    struct Document {
+        std::string Name;
+        std::string Data;
+    };
+
+    inline auto Word(Rng& rng) -> std::string {
+        constexpr auto kSyllables = std::string_view{"kamotirasunelovibudepa"};
+        auto result = std::string{};
+        for (auto n = 2 + rng.Below(4); n; --n) {
+            const auto pos = 2 * rng.Below(kSyllables.size() / 2);
+            result += kSyllables.substr(pos, 2);
+        }
+        return result;
+    }
+    inline auto Sentence(Rng& rng, size_t nWords) -> std::string {
+        auto result = Word(rng);
+        for (size_t i = 1; i != nWords; ++i) result += " " + Word(rng);
+        return result;
+    }
+
+    // Social network posts: pretty-printed, mostly strings, with nested user objects
+    inline auto MakeTwitterLike(Rng& rng, size_t nItems) -> std::string {
+        auto doc = std::string{"{\n  \"search_metadata\": {\"count\": "} + std::to_string(nItems) + ", \"query\": \"json\"},\n  \"items\": [\n";
+        for (size_t i = 0; i != nItems; ++i) {
+            doc += "    {\n";
+            doc += "      \"id\": " + std::to_string(1000000000 + rng.Below(1000000000)) + ",\n";
+            doc += "      \"created_at\": \"2024-0" + std::to_string(1 + rng.Below(9)) + "-1" + std::to_string(rng.Below(10)) + "T12:00:00Z\",\n";
+            doc += "      \"text\": \"" + Sentence(rng, 8 + rng.Below(16)) + "\",\n";
+            doc += "      \"user\": {\n";
+            doc += "        \"id\": " + std::to_string(rng.Below(1000000)) + ",\n";
+            doc += "        \"screen_name\": \"" + Word(rng) + "\",\n";
+            doc += "        \"followers_count\": " + std::to_string(rng.Below(100000)) + ",\n";
+            doc += "        \"verified\": " + std::string{rng.Below(10) == 0 ? "true" : "false"} + "\n";
+            doc += "      },\n";
+            doc += "      \"hashtags\": [";
+            for (auto n = rng.Below(4); n; --n) doc += "\"" + Word(rng) + "\"" + (n == 1 ? "" : ", ");
+            doc += "],\n";
+            doc += "      \"retweet_count\": " + std::to_string(rng.Below(5000)) + ",\n";
+            doc += "      \"favorited\": " + std::string{rng.Below(2) ? "true" : "false"} + "\n";
+            doc += (i + 1 == nItems ? "    }\n" : "    },\n");
+        }
+        doc += "  ]\n}\n";
+        return doc;
+    }
+
+    // Product catalog: compact, many small mappings with numbers and short strings
+    inline auto MakeCatalogLike(Rng& rng, size_t nItems) -> std::string {
+        auto doc = std::string{"{\"currency\": \"EUR\", \"items\": ["};
+        for (size_t i = 0; i != nItems; ++i) {
+            if (i) doc += ", ";
+            doc += "{\"sku\": \"SKU-" + std::to_string(100000 + i) + "\", \"title\": \"" + Sentence(rng, 3) + "\"";
+            doc += ", \"price\": " + std::to_string(rng.Below(100000) / 100) + "." + std::to_string(10 + rng.Below(90));
+            doc += ", \"in_stock\": " + std::string{rng.Below(3) ? "true" : "false"};
+            doc += ", \"tags\": [\"" + Word(rng) + "\", \"" + Word(rng) + "\"]";
+            doc += ", \"dimensions\": {\"w\": " + std::to_string(rng.Below(200)) + ", \"h\": " + std::to_string(rng.Below(200))
+                + ", \"d\": " + std::to_string(rng.Below(200)) + "}}";
+        }
+        doc += "]}";
+        return doc;
+    }
+
+    // Arrays of numbers, like time series or embeddings
+    inline auto MakeNumericHeavy(Rng& rng, size_t nItems) -> std::string {
+        auto doc = std::string{"{\"items\": ["};
+        for (size_t i = 0; i != nItems; ++i) {
+            if (i) doc += ", ";
+            doc += "[";
+            for (size_t j = 0; j != 16; ++j) {
+                if (j) doc += ", ";
+                if (j % 2) doc += std::to_string(static_cast<int64_t>(rng.Below(2000000)) - 1000000);
+                else doc += std::to_string(rng.Below(1000)) + "." + std::to_string(rng.Below(1000000)) + "e-" + std::to_string(rng.Below(10));
+            }
+            doc += "]";
+        }
+        doc += "]}";
+        return doc;
+    }
+
+    // Items that are nested 32 levels deep
+    inline auto MakeDeeplyNested(Rng& rng, size_t nItems) -> std::string {
+        auto doc = std::string{"{\"items\": ["};
+        for (size_t i = 0; i != nItems; ++i) {
+            if (i) doc += ", ";
+            for (size_t depth = 0; depth != 32; ++depth) doc += (depth % 2 ? "[" : "{\"level\": ");
+            doc += std::to_string(rng.Below(1000));
+            for (size_t depth = 32; depth != 0; --depth) doc += (depth % 2 ? "}" : "]");
+        }
+        doc += "]}";
+        return doc;
+    }
+
+    // A few items with strings of tens of kilobytes
+    inline auto MakeHugeStrings(Rng& rng, size_t nItems) -> std::string {
+        auto doc = std::string{"{\"items\": ["};
+        for (size_t i = 0; i != nItems; ++i) {
+            if (i) doc += ", ";
+            doc += "{\"name\": \"" + Word(rng) + "\", \"body\": \"" + Sentence(rng, 5000 + rng.Below(5000)) + "\"}";
+        }
+        doc += "]}";
+        return doc;
+    }
+
+    // All the documents of the corpus, each of about `targetSize` bytes
+    inline auto MakeCorpus(uint64_t seed = 42, size_t targetSize = 1 << 20) -> std::vector<Document> {
+        auto rng = Rng{seed};
+        auto corpus = std::vector<Document>{
+            {"twitter", MakeTwitterLike(rng, targetSize / 420)},
+            {"catalog", MakeCatalogLike(rng, targetSize / 200)},
+            {"numeric", MakeNumericHeavy(rng, targetSize / 190)},
+            {"nested", MakeDeeplyNested(rng, targetSize / 310)},
+            {"huge_strings", MakeHugeStrings(rng, targetSize / 45000 + 1)},
+        };
+        auto minified = std::string(corpus[0].Data.size(), '\0');
+        minified.resize(NJsonParser::Minify(corpus[0].Data, minified).Value().size());
+        corpus.push_back({"twitter_minified", std::move(minified)});
+        return corpus;
+    }
+} // namespace NBench
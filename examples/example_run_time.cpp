@@ -94,14 +94,16 @@ constexpr auto Example() -> void {
     }
     assert((keys == std::vector<std::string_view>{"aba", "caba"}));
 
+    // Arrays with elements of different types are decoded with `Visit`, which calls
+    // the handler for the type of an element right away, without trying other types first:
     auto numbers = std::vector<Int>{};
     auto strings = std::vector<String>{};
     for (const auto elem : json["caba"].As<Array>()) {
-        if (auto i = elem.As<Int>(); i.HasValue()) {
-            numbers.push_back(i.Value());
-        } else {
-            strings.push_back(elem.As<String>().Value());
-        }
+        elem.Visit(Overloaded{
+            [&numbers](Int i) { numbers.push_back(i); },
+            [&strings](String s) { strings.push_back(s); },
+            [](const auto&) {},
+        });
     }
     assert((numbers == std::vector<Int>{1, 2, 4}));
     assert((strings == std::vector<String>{"fizz", "buzz"}));
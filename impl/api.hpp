@@ -25,6 +25,34 @@ namespace NJsonParser {
                      || std::same_as<T, Mapping>;
     // A type that holds an arbitrary json value
     class JsonValue;
+    // What `JsonValue::Visit` passes to the visitor for `null`
+    struct Null {
+        constexpr auto operator==(const Null&) const -> bool = default;
+    };
+
+    // The kind of a json value, as told by its first character (see `JsonValue::Type()`)
+    enum class JsonType : uint8_t {
+        // No data at all, e.g. a default-constructed `JsonValue`
+        Missing = 0,
+        Null,
+        Bool,
+        // `Int` or `Float`
+        Number,
+        String,
+        Array,
+        Mapping,
+        // The first character can't start any json value
+        Invalid,
+    };
+
+    // A visitor made of several lambdas, e.g. for `JsonValue::Visit`:
+    // `value.Visit(Overloaded{[](Int i) { ... }, [](String s) { ... }, [](auto) { ... }})`
+    template <class... TFuncs>
+    struct Overloaded : TFuncs... {
+        using TFuncs::operator()...;
+    };
+    template <class... TFuncs>
+    Overloaded(TFuncs...) -> Overloaded<TFuncs...>;
 
 
     class Array : public DataHolderMixin {
@@ -46,20 +74,38 @@ namespace NJsonParser {
         friend class JsonValue;
     public:
         constexpr auto operator[](std::string_view key) const noexcept -> Expected<JsonValue>;
+        // Same as `operator[]`, but for mappings whose keys are known to be in ascending order
+        // (like in documents written with sorted keys): stops at the first key greater than `key`
+        constexpr auto FindSorted(std::string_view key) const noexcept -> Expected<JsonValue>;
         constexpr auto size() const noexcept -> size_t;
         class Iterator;
         constexpr auto begin() const noexcept -> Iterator;
         constexpr auto end() const noexcept -> Iterator;
+    private:
+        constexpr auto Find(std::string_view key, bool sortedKeys) const noexcept -> Expected<JsonValue>;
     }; 
 
 
     class JsonValue : public DataHolderMixin {
     public:
-        explicit constexpr JsonValue(std::string_view, LinePositionCounter = {}) noexcept;
+        // A default-constructed `JsonValue` holds no data and represents a missing value
+        explicit constexpr JsonValue(std::string_view = {}, LinePositionCounter = {}) noexcept;
         template <CJsonType T> constexpr auto As() const noexcept -> Expected<T>;
         // Same effect as `.As<Array>()[idx]`
         constexpr auto operator[](size_t idx) const noexcept -> Expected<JsonValue>;
         // Same effect as `.As<Mapping>()[key]`
         constexpr auto operator[](std::string_view key) const noexcept -> Expected<JsonValue>;
+        // Evaluates a json pointer (RFC 6901) like "/params/compilers/1/name"
+        // against this value, see `impl/pointer.hpp`
+        constexpr auto AtPointer(std::string_view pointer) const noexcept -> Expected<JsonValue>;
+        // Looks only at the first character, so it takes O(1) time and never creates errors;
+        // a value of type `Number`, `String`, `Array` or `Mapping` can still turn out to be malformed
+        constexpr auto Type() const noexcept -> JsonType;
+        // Calls `visitor` with the value converted to the type `Type()` tells (`Null`, `Bool`, `Int`
+        // or `Float`, `String`, `Array` or `Mapping`) without trying the other types first, or with
+        // the `NError::Error` the conversion gives if the value is malformed. All the calls must return
+        // the same type (like with `std::visit`), which is what `Visit` returns
+        template <class TVisitor>
+        constexpr auto Visit(TVisitor&& visitor) const -> decltype(auto);
     }; 
 }
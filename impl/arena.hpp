@@ -0,0 +1,165 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+
+
+namespace NJsonParser {
+    // A bump allocator for the auxiliary structures of the library, like document indexes
+    // (see `impl/document_index.hpp`), meant to be used once per request and then reset:
+    //
+    //     auto arena = ArenaResource{};
+    //     for (const auto& request : requests) {
+    //         const auto index = pmr::DocumentIndex::Build(JsonValue{request}, &arena);
+    //         ...
+    //         arena.Reset();
+    //     }
+    //
+    // Memory is taken from the upstream resource in chunks of geometrically growing sizes, and
+    // individual deallocations are ignored, like in `std::pmr::monotonic_buffer_resource`. There
+    // are two differences that matter for the way the library allocates memory:
+    //   - freeing the most recent allocation returns its memory to the arena, so a temporary
+    //     that is freed right away doesn't use up the chunk. Older allocations are only reclaimed
+    //     by a reset: e.g. a vector that grows allocates its new buffer before freeing the old one,
+    //     so the space of the old buffer stays used;
+    //   - `Reset()` keeps the largest chunk, so after the first few requests an arena that is reset
+    //     between requests doesn't call the upstream resource at all.
+    // An arena may also start with a caller-provided buffer (e.g. one on the stack).
+    // Like the standard pmr resources, an arena is not thread-safe.
+    class ArenaResource : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t kDefaultChunkSize = 4096;
+
+        struct Stats {
+            // The number of bytes handed out since the last reset
+            size_t BytesAllocated = 0;
+            // The number of bytes currently held from the upstream resource
+            size_t BytesReserved = 0;
+            // The number of calls to the upstream resource since the construction
+            size_t NUpstreamAllocations = 0;
+        };
+    private:
+        // Every chunk starts with this header
+        struct Chunk {
+            Chunk* Prev;
+            size_t Size;
+        };
+        std::pmr::memory_resource* Upstream;
+        std::span<std::byte> InitialBuffer;
+        Chunk* LastChunk = nullptr;
+        std::byte* Cur = nullptr;
+        std::byte* End = nullptr;
+        // The start of the most recent allocation, which can still be freed
+        std::byte* LastAllocation = nullptr;
+        size_t NextChunkSize;
+        Stats CurStats;
+    private:
+        auto UseInitialBuffer() noexcept -> void {
+            Cur = InitialBuffer.data();
+            End = InitialBuffer.data() + InitialBuffer.size();
+        }
+        auto UseChunk(Chunk* chunk) noexcept -> void {
+            Cur = reinterpret_cast<std::byte*>(chunk) + sizeof(Chunk);
+            End = reinterpret_cast<std::byte*>(chunk) + chunk->Size;
+        }
+        auto FreeChunksBefore(Chunk* chunk) noexcept -> void {
+            while (chunk) {
+                const auto prev = chunk->Prev;
+                CurStats.BytesReserved -= chunk->Size;
+                Upstream->deallocate(chunk, chunk->Size, alignof(Chunk));
+                chunk = prev;
+            }
+        }
+        // Returns `Cur` aligned by `alignment` if `bytes` bytes fit in the current chunk after it
+        auto TryFit(size_t bytes, size_t alignment) const noexcept -> std::byte* {
+            if (!Cur) return nullptr;
+            const auto addr = reinterpret_cast<uintptr_t>(Cur);
+            const auto aligned = Cur + ((alignment - addr % alignment) % alignment);
+            if (aligned > End || static_cast<size_t>(End - aligned) < bytes) return nullptr;
+            return aligned;
+        }
+    protected:
+        auto do_allocate(size_t bytes, size_t alignment) -> void* override {
+            auto result = TryFit(bytes, alignment);
+            if (!result) {
+                auto size = NextChunkSize;
+                while (size < sizeof(Chunk) + bytes + alignment) size *= 2;
+                auto chunk = static_cast<Chunk*>(Upstream->allocate(size, alignof(Chunk)));
+                *chunk = {.Prev = LastChunk, .Size = size};
+                LastChunk = chunk;
+                NextChunkSize = 2 * size;
+                CurStats.BytesReserved += size;
+                ++CurStats.NUpstreamAllocations;
+                UseChunk(chunk);
+                result = TryFit(bytes, alignment);
+            }
+            LastAllocation = result;
+            Cur = result + bytes;
+            CurStats.BytesAllocated += bytes;
+            return result;
+        }
+
+        auto do_deallocate(void* ptr, size_t bytes, size_t) noexcept -> void override {
+            if (ptr != LastAllocation || LastAllocation + bytes != Cur) return;
+            Cur = LastAllocation;
+            LastAllocation = nullptr;
+            CurStats.BytesAllocated -= bytes;
+        }
+
+        auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+            return this == &other;
+        }
+    public:
+        explicit ArenaResource(
+            size_t initialChunkSize = kDefaultChunkSize,
+            std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+        ) noexcept
+            : Upstream(upstream), NextChunkSize(initialChunkSize < 2 * sizeof(Chunk) ? 2 * sizeof(Chunk) : initialChunkSize) {}
+
+        explicit ArenaResource(
+            std::span<std::byte> initialBuffer,
+            std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+        ) noexcept
+            : Upstream(upstream), InitialBuffer(initialBuffer), NextChunkSize(kDefaultChunkSize)
+        {
+            UseInitialBuffer();
+        }
+
+        ArenaResource(const ArenaResource&) = delete;
+        auto operator=(const ArenaResource&) -> ArenaResource& = delete;
+
+        ~ArenaResource() override {
+            Release();
+        }
+
+        // Makes all the memory of the arena available again. Everything allocated from the arena
+        // must not be used anymore. The largest chunk is kept for the next allocations
+        auto Reset() noexcept -> void {
+            if (LastChunk) {
+                FreeChunksBefore(LastChunk->Prev);
+                LastChunk->Prev = nullptr;
+                UseChunk(LastChunk);
+            } else {
+                UseInitialBuffer();
+            }
+            LastAllocation = nullptr;
+            CurStats.BytesAllocated = 0;
+        }
+
+        // Same as `Reset()`, but returns all the chunks to the upstream resource
+        auto Release() noexcept -> void {
+            FreeChunksBefore(LastChunk);
+            LastChunk = nullptr;
+            UseInitialBuffer();
+            LastAllocation = nullptr;
+            CurStats.BytesAllocated = 0;
+        }
+
+        auto GetStats() const noexcept -> Stats {
+            return CurStats;
+        }
+    };
+} // namespace NJsonParser
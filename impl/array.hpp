@@ -34,6 +34,12 @@ namespace NJsonParser {
             return copy;
         }
         constexpr auto operator==(const Iterator& other) const -> bool = default;
+        // An iterator that has encountered an error (e.g. a syntax error
+        // in the underlying data) compares equal to `end()`, so, after a loop
+        // over the array is finished, these methods allow to tell apart
+        // an array that was exhausted from an array that is malformed
+        constexpr auto HasError() const -> bool { return Iter.HasError(); }
+        constexpr auto Error() const -> const NError::Error& { return Iter.Error(); }
     };
 
     constexpr auto Array::begin() const noexcept -> Iterator { 
@@ -54,7 +60,7 @@ namespace NJsonParser {
     constexpr auto Array::operator[](size_t idx) const noexcept -> Expected<JsonValue> { 
         size_t i = 0;
         auto it = begin();
-        for (; it != end(); ++it, ++i) {
+        for (const auto endIt = end(); it != endIt; ++it, ++i) {
             const auto elem = *it;
             if (i == idx) return elem;
             if (elem.HasError()) return elem;
@@ -71,6 +77,8 @@ namespace NJsonParser {
     }
 
     constexpr auto Array::size() const noexcept -> size_t {
+        // Only malformed contents need the iterators to find out how many elements come before the error
+        if (const auto n = NUtils::CountElements(Data, false)) return *n;
         return std::distance(begin(), end());
     }
 
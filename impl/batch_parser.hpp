@@ -0,0 +1,194 @@
+#pragma once
+
+
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace NJsonParser {
+    // Builds the indexes (see `impl/document_index.hpp`) of many small documents in one go, like
+    // the bodies of the requests received by a server in a batch, and returns their root values:
+    //
+    //     auto parser = BatchParser{};
+    //     ...
+    //     for (const auto& root : parser.Parse(bodies)) {
+    //         if (root.HasError()) ...;
+    //         const auto id = root["request_id"].As<Int>();
+    //     }
+    //
+    // What building an index per document spends on setting things up is paid once per parser:
+    // the tables of all the documents of a batch are stored together, and the temporary memory
+    // of the builders is reused, so a batch doesn't allocate at all once the parser has seen
+    // a batch of the same size. `kInFlight` documents are indexed at the same time, in turns of
+    // `kStepsPerTurn` values, and the parts of the documents that come next are prefetched,
+    // so that waiting for the memory of one document overlaps with the work on the others.
+    // All the memory of the parser, including the tables of the batch, is taken from the memory
+    // resource it is constructed with (e.g. `BatchParser{&arena}`, see `impl/arena.hpp`).
+    //
+    // The results refer to the documents and to the parser: both must outlive them, and the next
+    // call to `Parse` invalidates them. Like `DocumentCache`, the parser is a run-time only facility.
+    class BatchParser {
+    public:
+        static constexpr size_t kInFlight = 8;
+        static constexpr size_t kStepsPerTurn = 16;
+    private:
+        // The tables of the index of one document while it's being built
+        struct Tables {
+            template <class T>
+            using TVector = std::pmr::vector<T>;
+            TVector<NIndex::ContainerRecord> Containers;
+            TVector<NIndex::ChildRecord> Children;
+            TVector<uint32_t> KeySlots;
+
+            explicit Tables(std::pmr::memory_resource* resource)
+                : Containers(resource), Children(resource), KeySlots(resource) {}
+
+            auto get_allocator() const noexcept -> std::pmr::polymorphic_allocator<std::byte> {
+                return Containers.get_allocator();
+            }
+        };
+        // Where the tables of a document are among the tables of the batch
+        struct Extent {
+            JsonValue Root = JsonValue{};
+            size_t FirstContainer = 0;
+            size_t NContainers = 0;
+            size_t FirstChild = 0;
+            size_t NChildren = 0;
+            size_t FirstKeySlot = 0;
+            size_t NKeySlots = 0;
+            std::optional<NError::Error> Error;
+        };
+        // Every builder writes to the tables with the same index (the addresses of the elements
+        // of a vector don't change when it is moved, so neither do the ones the builders refer to)
+        std::pmr::vector<Tables> SlotTables;
+        std::pmr::vector<NUtils::DocumentIndexBuilder<Tables>> Builders;
+        std::pmr::vector<NIndex::ContainerRecord> Containers;
+        std::pmr::vector<NIndex::ChildRecord> Children;
+        std::pmr::vector<uint32_t> KeySlots;
+        std::pmr::vector<Extent> Extents;
+        std::pmr::vector<DocumentIndexView> Views;
+        std::pmr::vector<Expected<IndexedValue>> Roots;
+    private:
+        static auto Prefetch(const char* ptr) noexcept -> void {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(ptr);
+#else
+            static_cast<void>(ptr);
+#endif
+        }
+
+        // Copies the tables of a built index to the tables of the batch. The documents are built
+        // in turns, so a builder can't append to the tables of the batch directly; its own tables
+        // keep their memory for the next document of the slot
+        auto Store(Extent& extent, Tables& tables) -> void {
+            const auto append = [](auto& to, const auto& from, size_t& first, size_t& n) {
+                first = to.size();
+                n = from.size();
+                to.insert(to.end(), from.begin(), from.end());
+            };
+            append(Containers, tables.Containers, extent.FirstContainer, extent.NContainers);
+            append(Children, tables.Children, extent.FirstChild, extent.NChildren);
+            append(KeySlots, tables.KeySlots, extent.FirstKeySlot, extent.NKeySlots);
+        }
+
+    public:
+        explicit BatchParser(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : SlotTables(resource)
+            , Builders(resource)
+            , Containers(resource)
+            , Children(resource)
+            , KeySlots(resource)
+            , Extents(resource)
+            , Views(resource)
+            , Roots(resource)
+        {
+            SlotTables.reserve(kInFlight);
+            Builders.reserve(kInFlight);
+            for (size_t slot = 0; slot != kInFlight; ++slot) Builders.emplace_back(JsonValue{}, SlotTables.emplace_back(resource));
+        }
+        BatchParser(const BatchParser&) = delete;
+        auto operator=(const BatchParser&) -> BatchParser& = delete;
+        BatchParser(BatchParser&&) noexcept = default;
+        // Assigning vectors with different memory resources would move their elements,
+        // and the builders would refer to the old tables
+        auto operator=(BatchParser&&) -> BatchParser& = delete;
+
+        // Returns the root values of the `documents`, in the same order: either the root value
+        // of the index of a document or the error building the index ran into (the same as the one
+        // of `DocumentIndex::Build`)
+        auto Parse(std::span<const std::string_view> documents) -> std::span<const Expected<IndexedValue>> {
+            Containers.clear();
+            Children.clear();
+            KeySlots.clear();
+            Extents.assign(documents.size(), Extent{});
+            auto slotDocuments = std::array<size_t, kInFlight>{};
+            auto busy = std::array<bool, kInFlight>{};
+            size_t nextDocument = 0;
+            size_t nBusy = 0;
+            while (nextDocument != documents.size() || nBusy != 0) {
+                for (size_t slot = 0; slot != kInFlight; ++slot) {
+                    auto& builder = Builders[slot];
+                    if (!busy[slot]) {
+                        if (nextDocument == documents.size()) continue;
+                        auto& tables = SlotTables[slot];
+                        tables.Containers.clear();
+                        tables.Children.clear();
+                        tables.KeySlots.clear();
+                        // The document that takes this slot next is fetched while this one is worked on
+                        if (nextDocument + kInFlight < documents.size()) Prefetch(documents[nextDocument + kInFlight].data());
+                        slotDocuments[slot] = nextDocument;
+                        Extents[nextDocument].Root = JsonValue{documents[nextDocument]};
+                        builder.Reset(Extents[nextDocument].Root);
+                        builder.Start();
+                        ++nextDocument;
+                        busy[slot] = true;
+                        ++nBusy;
+                    }
+                    auto error = std::optional<NError::Error>{};
+                    for (size_t step = 0; step != kStepsPerTurn && !builder.IsDone() && !error; ++step) {
+                        error = builder.Step();
+                    }
+                    if (!error && !builder.IsDone()) {
+                        Prefetch(builder.Upcoming() + 64);
+                        continue;
+                    }
+                    auto& extent = Extents[slotDocuments[slot]];
+                    if (!error) error = builder.Finish();
+                    if (error) extent.Error = std::move(error);
+                    else Store(extent, SlotTables[slot]);
+                    busy[slot] = false;
+                    --nBusy;
+                }
+            }
+            // The tables don't grow anymore, so the views can refer to them
+            Views.resize(documents.size());
+            Roots.clear();
+            Roots.reserve(documents.size());
+            for (size_t i = 0; i != documents.size(); ++i) {
+                const auto& extent = Extents[i];
+                if (extent.Error) {
+                    Roots.emplace_back(*extent.Error);
+                    continue;
+                }
+                Views[i] = DocumentIndexView{
+                    .Data = extent.Root.GetData(),
+                    .RootLpCounter = extent.Root.GetLpCounter(),
+                    .Containers = std::span{Containers}.subspan(extent.FirstContainer, extent.NContainers),
+                    .Children = std::span{Children}.subspan(extent.FirstChild, extent.NChildren),
+                    .KeySlots = std::span{KeySlots}.subspan(extent.FirstKeySlot, extent.NKeySlots),
+                };
+                Roots.emplace_back(Views[i].Root());
+            }
+            return Roots;
+        }
+    };
+} // namespace NJsonParser
@@ -0,0 +1,665 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "line_position_counter.hpp"
+#include "pointer.hpp"
+#include "utils.hpp"
+
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace NJsonParser {
+    class BinaryValue;
+    class BinaryArray;
+    class BinaryMapping;
+} // namespace NJsonParser
+
+namespace NJsonParser::NBinary {
+    // The binary form of a json value starts with a one-byte tag, which is followed by:
+    //   - nothing for `Null`, `False` and `True`;
+    //   - a 64-bit integer for `Int` and the bits of a double for `Float`;
+    //   - the 32-bit length and the bytes of the string for `String` (escape sequences are left as is);
+    //   - for `Array`: the 32-bit size of the whole binary form of the array, the number of the elements,
+    //     a table of 32-bit offsets of the elements and then the elements themselves;
+    //   - for `Mapping`: the 32-bit size of the whole binary form of the mapping, the number of the pairs,
+    //     the number of the key slots, a table of 12-byte entries (the lower 32 bits of the hash of the key,
+    //     see `NUtils::Hash`, the length of the key and the offset of the value), a hash table of the keys
+    //     with the same layout as those of `DocumentIndex` (empty for small mappings) and then the pairs,
+    //     each of which is the bytes of the key followed by the value.
+    // All the numbers are little-endian, and all the offsets are counted from the tag of the container,
+    // so that the size of any value, the number of elements of any container and the position of any
+    // element are known without looking at anything else.
+    enum class Tag : uint8_t {
+        Null = 0,
+        False,
+        True,
+        Int,
+        Float,
+        String,
+        Array,
+        Mapping,
+    };
+
+    inline constexpr size_t kArrayHeaderSize = 9;
+    inline constexpr size_t kMappingHeaderSize = 13;
+    inline constexpr size_t kMappingEntrySize = 12;
+
+    constexpr auto ReadU32(std::string_view data, size_t pos) noexcept -> uint32_t {
+        uint32_t result = 0;
+        for (size_t i = 0; i != 4; ++i) result |= uint32_t{static_cast<uint8_t>(data[pos + i])} << (8 * i);
+        return result;
+    }
+    constexpr auto ReadU64(std::string_view data, size_t pos) noexcept -> uint64_t {
+        return ReadU32(data, pos) | uint64_t{ReadU32(data, pos + 4)} << 32;
+    }
+
+    // The size of the binary form of the value that starts at `pos`
+    constexpr auto ValueSize(std::string_view data, size_t pos) noexcept -> size_t {
+        switch (static_cast<Tag>(data[pos])) {
+            case Tag::Int:
+            case Tag::Float:
+                return 9;
+            case Tag::String:
+                return 5 + size_t{ReadU32(data, pos + 1)};
+            case Tag::Array:
+            case Tag::Mapping:
+                return ReadU32(data, pos + 1);
+            default:
+                return 1;
+        }
+    }
+
+    // `BinaryValue::As<T>()` gives the binary counterparts of `Array` and `Mapping`
+    // and the same results as `JsonValue::As<T>()` for the other json types
+    template <class T> struct TAsResult { using TType = T; };
+    template <> struct TAsResult<Array> { using TType = BinaryArray; };
+    template <> struct TAsResult<Mapping> { using TType = BinaryMapping; };
+    template <CJsonType T> using TAs = typename TAsResult<T>::TType;
+} // namespace NJsonParser::NBinary
+
+namespace NJsonParser {
+    // A json value in the binary form produced by `ToBinary`. Has the same navigation methods as
+    // `JsonValue` (and `BinaryArray` and `BinaryMapping` have the same ones as `Array` and `Mapping`),
+    // so code that reads documents switches between the formats by changing one type:
+    //
+    //     const auto binary = ToBinary(json).Value(); // an `std::pmr::string`, which can be stored and reused
+    //     const auto root = BinaryValue{binary};
+    //     const auto name = root["params"]["compilers"][1]["name"].As<String>();
+    //
+    // Unlike with `JsonValue`, getting the number of elements of a container, getting an element
+    // by its index and skipping a value take O(1) time, and getting a value by its key is a lookup
+    // in a hash table for large mappings. Since a binary form is produced from a valid document,
+    // the only errors are type errors and missing elements; they are the same as those of
+    // `JsonValue`, but carry no line and position. The binary form must come from `ToBinary`
+    // (it is not validated) and, like a serialized document, must outlive all the values obtained from it.
+    class BinaryValue {
+    private:
+        // The binary form of the value, starting with its tag. Empty for a missing value
+        std::string_view Data;
+    private:
+        constexpr auto GetTag() const noexcept -> NBinary::Tag {
+            return static_cast<NBinary::Tag>(Data.front());
+        }
+        constexpr auto Find(
+            std::string_view requestedKey,
+            uint32_t keyHash,
+            auto&& matches
+        ) const noexcept -> Expected<BinaryValue>;
+    public:
+        // A default-constructed `BinaryValue` holds no data and represents a missing value
+        explicit constexpr BinaryValue(std::string_view data = {}) noexcept : Data(data) {}
+        constexpr auto GetData() const noexcept -> std::string_view {
+            return Data;
+        }
+        template <CJsonType T> constexpr auto As() const noexcept -> Expected<NBinary::TAs<T>>;
+        // Same effect as `.As<Array>()[idx]`
+        constexpr auto operator[](size_t idx) const noexcept -> Expected<BinaryValue>;
+        // Same effect as `.As<Mapping>()[key]`
+        constexpr auto operator[](std::string_view key) const noexcept -> Expected<BinaryValue>;
+        // Applies a segment of a json pointer with the key hash precomputed by `CompiledPointer`
+        constexpr auto operator[](const PointerSegment& segment) const noexcept -> Expected<BinaryValue>;
+        constexpr auto AtPointer(std::string_view pointer) const noexcept -> Expected<BinaryValue>;
+    };
+
+    class BinaryArray {
+    private:
+        std::string_view Data;
+    private:
+        explicit constexpr BinaryArray(std::string_view data) noexcept : Data(data) {}
+        friend class BinaryValue;
+
+        constexpr auto Element(size_t idx) const noexcept -> BinaryValue {
+            const auto offset = NBinary::ReadU32(Data, NBinary::kArrayHeaderSize + 4 * idx);
+            return BinaryValue{Data.substr(offset, NBinary::ValueSize(Data, offset))};
+        }
+    public:
+        constexpr auto GetData() const noexcept -> std::string_view {
+            return Data;
+        }
+        constexpr auto operator[](size_t idx) const noexcept -> Expected<BinaryValue>;
+        constexpr auto size() const noexcept -> size_t {
+            return NBinary::ReadU32(Data, 5);
+        }
+        class Iterator;
+        constexpr auto begin() const noexcept -> Iterator;
+        constexpr auto end() const noexcept -> Iterator;
+    };
+
+    class BinaryMapping {
+    private:
+        std::string_view Data;
+    private:
+        explicit constexpr BinaryMapping(std::string_view data) noexcept : Data(data) {}
+        friend class BinaryValue;
+
+        constexpr auto Entry(size_t idx) const noexcept -> size_t {
+            return NBinary::kMappingHeaderSize + NBinary::kMappingEntrySize * idx;
+        }
+        constexpr auto Key(size_t idx) const noexcept -> std::string_view {
+            const auto keyLen = NBinary::ReadU32(Data, Entry(idx) + 4);
+            return Data.substr(NBinary::ReadU32(Data, Entry(idx) + 8) - keyLen, keyLen);
+        }
+        constexpr auto Value(size_t idx) const noexcept -> BinaryValue {
+            const auto offset = NBinary::ReadU32(Data, Entry(idx) + 8);
+            return BinaryValue{Data.substr(offset, NBinary::ValueSize(Data, offset))};
+        }
+        // Returns the index of the first pair whose key is `key`, or `std::nullopt`
+        constexpr auto FindPair(uint32_t keyHash, auto&& matches) const noexcept -> std::optional<size_t> {
+            const auto keyMatches = [&](size_t idx) {
+                return NBinary::ReadU32(Data, Entry(idx)) == keyHash && matches(Key(idx));
+            };
+            const auto nSlots = NBinary::ReadU32(Data, 9);
+            if (nSlots == 0) {
+                for (size_t i = 0; i != size(); ++i) {
+                    if (keyMatches(i)) return i;
+                }
+                return std::nullopt;
+            }
+            const auto slots = Entry(size());
+            const auto mask = nSlots - 1;
+            for (auto slot = keyHash & mask;; slot = (slot + 1) & mask) {
+                const auto entry = NBinary::ReadU32(Data, slots + 4 * slot);
+                if (entry == 0) return std::nullopt;
+                if (keyMatches(entry - 1)) return entry - 1;
+            }
+        }
+    public:
+        constexpr auto GetData() const noexcept -> std::string_view {
+            return Data;
+        }
+        constexpr auto operator[](std::string_view key) const noexcept -> Expected<BinaryValue>;
+        constexpr auto size() const noexcept -> size_t {
+            return NBinary::ReadU32(Data, 5);
+        }
+        class Iterator;
+        constexpr auto begin() const noexcept -> Iterator;
+        constexpr auto end() const noexcept -> Iterator;
+    };
+
+    // The specialization of `Expected` class template for `BinaryValue`
+    template <>
+    struct Expected<BinaryValue> : public ExpectedMixin<BinaryValue> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<BinaryValue>::ExpectedMixin;
+        // Monadic methods specific to `Expected<BinaryValue>`:
+        template <CJsonType T> constexpr auto As() const -> Expected<NBinary::TAs<T>> {
+            return HasValue() ? Value().As<T>() : Error();
+        }
+        constexpr auto operator[](size_t idx) const -> Expected<BinaryValue> {
+            return HasValue() ? Value()[idx] : Error();
+        }
+        constexpr auto operator[](std::string_view key) const -> Expected<BinaryValue> {
+            return HasValue() ? Value()[key] : Error();
+        }
+        constexpr auto operator[](const PointerSegment& segment) const -> Expected<BinaryValue> {
+            return HasValue() ? Value()[segment] : Error();
+        }
+        constexpr auto AtPointer(std::string_view pointer) const -> Expected<BinaryValue> {
+            return HasValue() ? Value().AtPointer(pointer) : Error();
+        }
+    };
+
+    // The specialization of `Expected` class template for `BinaryArray`
+    template <>
+    struct Expected<BinaryArray> : public ExpectedMixin<BinaryArray> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<BinaryArray>::ExpectedMixin;
+        // Monadic methods specific to `Expected<BinaryArray>`:
+        constexpr auto operator[](size_t idx) const noexcept -> Expected<BinaryValue> {
+            return HasValue() ? Value()[idx] : Error();
+        }
+        constexpr auto size() const noexcept -> Expected<size_t> {
+            return HasValue() ? Expected<size_t>{Value().size()} : Error();
+        }
+        // An error is iterated over as an empty array
+        constexpr auto begin() const noexcept -> BinaryArray::Iterator;
+        constexpr auto end() const noexcept -> BinaryArray::Iterator;
+    };
+
+    // The specialization of `Expected` class template for `BinaryMapping`
+    template <>
+    struct Expected<BinaryMapping> : public ExpectedMixin<BinaryMapping> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<BinaryMapping>::ExpectedMixin;
+        // Monadic methods specific to `Expected<BinaryMapping>`:
+        constexpr auto operator[](std::string_view key) const noexcept -> Expected<BinaryValue> {
+            return HasValue() ? Value()[key] : Error();
+        }
+        constexpr auto size() const noexcept -> Expected<size_t> {
+            return HasValue() ? Expected<size_t>{Value().size()} : Error();
+        }
+        // An error is iterated over as an empty mapping
+        constexpr auto begin() const noexcept -> BinaryMapping::Iterator;
+        constexpr auto end() const noexcept -> BinaryMapping::Iterator;
+    };
+
+    class BinaryArray::Iterator {
+    private:
+        std::string_view Data;
+        size_t Idx = 0;
+        friend class BinaryArray;
+    private:
+        constexpr Iterator(std::string_view data, size_t idx) noexcept : Data(data), Idx(idx) {}
+    public:
+        using difference_type = int;
+        using value_type = Expected<BinaryValue>;
+    public:
+        constexpr Iterator() noexcept = default;
+        constexpr auto operator*() const -> value_type {
+            return BinaryArray{Data}.Element(Idx);
+        }
+        constexpr auto operator++() -> Iterator& {
+            ++Idx;
+            return *this;
+        }
+        constexpr auto operator++(int) -> Iterator {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+        constexpr auto operator==(const Iterator& other) const -> bool {
+            return Data.data() == other.Data.data() && Idx == other.Idx;
+        }
+    };
+
+    class BinaryMapping::Iterator {
+    private:
+        std::string_view Data;
+        size_t Idx = 0;
+        friend class BinaryMapping;
+    private:
+        constexpr Iterator(std::string_view data, size_t idx) noexcept : Data(data), Idx(idx) {}
+    public:
+        using difference_type = int;
+        struct value_type {
+            Expected<String> Key;
+            Expected<BinaryValue> Value;
+        };
+    public:
+        constexpr Iterator() noexcept = default;
+        constexpr auto operator*() const -> value_type {
+            const auto mapping = BinaryMapping{Data};
+            return {
+                .Key = mapping.Key(Idx),
+                .Value = mapping.Value(Idx),
+            };
+        }
+        constexpr auto operator++() -> Iterator& {
+            ++Idx;
+            return *this;
+        }
+        constexpr auto operator++(int) -> Iterator {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+        constexpr auto operator==(const Iterator& other) const -> bool {
+            return Data.data() == other.Data.data() && Idx == other.Idx;
+        }
+    };
+
+    constexpr auto BinaryArray::begin() const noexcept -> Iterator {
+        return {Data, 0};
+    }
+    constexpr auto BinaryArray::end() const noexcept -> Iterator {
+        return {Data, size()};
+    }
+    constexpr auto BinaryArray::operator[](size_t idx) const noexcept -> Expected<BinaryValue> {
+        if (idx >= size()) return MakeError(
+            {},
+            NError::ErrorCode::ArrayIndexOutOfRange,
+            NError::ArrayIndexOutOfRangeAdditionalInfo{
+                .Index = idx,
+                .ArrayLen = size(),
+            }
+        );
+        return Element(idx);
+    }
+
+    constexpr auto BinaryMapping::begin() const noexcept -> Iterator {
+        return {Data, 0};
+    }
+    constexpr auto BinaryMapping::end() const noexcept -> Iterator {
+        return {Data, size()};
+    }
+    constexpr auto BinaryMapping::operator[](std::string_view key) const noexcept -> Expected<BinaryValue> {
+        const auto idx = FindPair(static_cast<uint32_t>(NUtils::Hash(key)), [key](std::string_view other) {
+            return other == key;
+        });
+        if (!idx) return MakeError(
+            {},
+            NError::ErrorCode::MappingKeyNotFound,
+            NError::MappingKeyNotFoundAdditionalInfo{key}
+        );
+        return Value(*idx);
+    }
+
+    constexpr auto Expected<BinaryArray>::begin() const noexcept -> BinaryArray::Iterator {
+        return HasValue() ? Value().begin() : BinaryArray::Iterator{};
+    }
+    constexpr auto Expected<BinaryArray>::end() const noexcept -> BinaryArray::Iterator {
+        return HasValue() ? Value().end() : BinaryArray::Iterator{};
+    }
+    constexpr auto Expected<BinaryMapping>::begin() const noexcept -> BinaryMapping::Iterator {
+        return HasValue() ? Value().begin() : BinaryMapping::Iterator{};
+    }
+    constexpr auto Expected<BinaryMapping>::end() const noexcept -> BinaryMapping::Iterator {
+        return HasValue() ? Value().end() : BinaryMapping::Iterator{};
+    }
+
+    template <CJsonType T>
+    constexpr auto BinaryValue::As() const noexcept -> Expected<NBinary::TAs<T>> {
+        using NBinary::Tag;
+        // The errors are the same as those of `JsonValue::As<T>()`
+        const auto typeError = [](std::string_view message) {
+            return MakeError({}, NError::ErrorCode::TypeError, message);
+        };
+        if constexpr (std::same_as<T, Bool>) {
+            if (Data.empty()) return MakeError({}, NError::ErrorCode::MissingValueError);
+            if (GetTag() == Tag::True) return true;
+            if (GetTag() == Tag::False) return false;
+            return typeError("expected bool, got something else");
+        } else if constexpr (std::same_as<T, Int>) {
+            if (Data.empty()) return MakeError({}, NError::ErrorCode::MissingValueError);
+            if (GetTag() == Tag::Int) return std::bit_cast<Int>(NBinary::ReadU64(Data, 1));
+            return typeError("expected int, got something else");
+        } else if constexpr (std::same_as<T, Float>) {
+            if (Data.empty()) return MakeError({}, NError::ErrorCode::MissingValueError);
+            if (GetTag() == Tag::Float) return std::bit_cast<Float>(NBinary::ReadU64(Data, 1));
+            if (GetTag() == Tag::Int) return static_cast<Float>(std::bit_cast<Int>(NBinary::ReadU64(Data, 1)));
+            return typeError("expected double, got something else");
+        } else if constexpr (std::same_as<T, String>) {
+            if (Data.empty()) return MakeError(
+                {},
+                NError::ErrorCode::MissingValueError,
+                "empty underlying data while expecting a string"
+            );
+            if (GetTag() == Tag::String) return Data.substr(5);
+            return typeError("either both double quotes are missing or the underlying data does not represent a string");
+        } else if constexpr (std::same_as<T, Array>) {
+            if (Data.empty()) return MakeError(
+                {},
+                NError::ErrorCode::MissingValueError,
+                "empty underlying data while expecting an array"
+            );
+            if (GetTag() == Tag::Array) return BinaryArray{Data};
+            return typeError("either both square brackets are missing or the underlying data does not represent an array");
+        } else {
+            if (Data.empty()) return MakeError(
+                {},
+                NError::ErrorCode::MissingValueError,
+                "empty underlying data while expecting a mapping"
+            );
+            if (GetTag() == Tag::Mapping) return BinaryMapping{Data};
+            return typeError(
+                "either both curly braces ('{' and '}') are missing "
+                "or the underlying data does not represent a mapping"
+            );
+        }
+    }
+
+    constexpr auto BinaryValue::Find(
+        std::string_view requestedKey,
+        uint32_t keyHash,
+        auto&& matches
+    ) const noexcept -> Expected<BinaryValue> {
+        const auto mapping = As<Mapping>();
+        if (mapping.HasError()) return mapping.Error();
+        const auto idx = mapping.Value().FindPair(keyHash, matches);
+        if (!idx) return MakeError(
+            {},
+            NError::ErrorCode::MappingKeyNotFound,
+            NError::MappingKeyNotFoundAdditionalInfo{requestedKey}
+        );
+        return mapping.Value().Value(*idx);
+    }
+
+    constexpr auto BinaryValue::operator[](size_t idx) const noexcept -> Expected<BinaryValue> {
+        return As<Array>()[idx];
+    }
+
+    constexpr auto BinaryValue::operator[](std::string_view key) const noexcept -> Expected<BinaryValue> {
+        return As<Mapping>()[key];
+    }
+
+    constexpr auto BinaryValue::operator[](const PointerSegment& segment) const noexcept -> Expected<BinaryValue> {
+        if (!Data.empty() && GetTag() == NBinary::Tag::Array) {
+            if (!segment.IsIndex()) return MakeError(
+                {},
+                NError::ErrorCode::InvalidPointerError,
+                "json pointer refers to an array element with something that is not an array index"
+            );
+            return (*this)[segment.Index];
+        }
+        if (!Data.empty() && GetTag() == NBinary::Tag::Mapping) {
+            return Find(segment.Raw, static_cast<uint32_t>(segment.KeyHash), [&segment](std::string_view key) {
+                return segment.Matches(key);
+            });
+        }
+        if (Data.empty()) return MakeError({}, NError::ErrorCode::MissingValueError);
+        return MakeError(
+            {},
+            NError::ErrorCode::TypeError,
+            "json pointer refers to an element of something that is neither an array nor a mapping"
+        );
+    }
+
+    constexpr auto BinaryValue::AtPointer(std::string_view pointer) const noexcept -> Expected<BinaryValue> {
+        auto cur = *this;
+        for (auto pos = std::string_view::size_type{0}; pos != pointer.size();) {
+            const auto segment = NUtils::ParsePointerSegment(pointer, pos);
+            if (segment.HasError()) return segment.Error();
+            const auto next = cur[segment.Value()];
+            if (next.HasError()) return next;
+            cur = next.Value();
+        }
+        return cur;
+    }
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // Writes the binary form of a document by walking over its index, which provides the number
+    // of elements of every container (needed to lay out its table before its elements) and the
+    // hash tables of the keys. Containers are written in the order of the document with an explicit
+    // stack of the open ones, so deeply nested documents don't exhaust the call stack. The output
+    // and the scratch stacks are allocated from the given memory resource.
+    class BinaryTranscoder {
+    private:
+        struct TFrame {
+            uint64_t Container;
+            uint64_t NextChild;
+            // The position of the tag of the container in the output
+            size_t Begin;
+        };
+        const DocumentIndexView& View;
+        std::pmr::string Out;
+        std::pmr::vector<TFrame> Stack;
+        // The key table of the current mapping, if the index has none
+        std::pmr::vector<uint32_t> KeySlots;
+    private:
+        auto AppendU32(uint32_t value) -> void {
+            for (size_t i = 0; i != 4; ++i) Out += static_cast<char>(value >> (8 * i));
+        }
+        auto AppendU64(uint64_t value) -> void {
+            AppendU32(static_cast<uint32_t>(value));
+            AppendU32(static_cast<uint32_t>(value >> 32));
+        }
+        auto PatchU32(size_t pos, uint64_t value) -> void {
+            for (size_t i = 0; i != 4; ++i) Out[pos + i] = static_cast<char>(value >> (8 * i));
+        }
+        auto AppendTag(NBinary::Tag tag) -> void {
+            Out += static_cast<char>(tag);
+        }
+
+        auto WriteScalar(std::string_view value, LinePositionCounter lpCounter) -> std::optional<NError::Error> {
+            using NBinary::Tag;
+            if (value.empty()) return MakeError(lpCounter, NError::ErrorCode::MissingValueError);
+            if (value.front() == '"') {
+                AppendTag(Tag::String);
+                AppendU32(static_cast<uint32_t>(value.size() - 2));
+                Out += value.substr(1, value.size() - 2);
+                return std::nullopt;
+            }
+            if (value == "true" || value == "false" || value == "null") {
+                AppendTag(value == "true" ? Tag::True : value == "false" ? Tag::False : Tag::Null);
+                return std::nullopt;
+            }
+            const auto isDigit = [](char ch) { return '0' <= ch && ch <= '9'; };
+            if (isDigit(value.front()) || (value.size() > 1 && value.front() == '-' && isDigit(value[1]))) {
+                const auto end = value.data() + value.size();
+                auto intValue = Int{0};
+                if (const auto [ptr, ec] = std::from_chars(value.data(), end, intValue); ec == std::errc{} && ptr == end) {
+                    AppendTag(Tag::Int);
+                    AppendU64(std::bit_cast<uint64_t>(intValue));
+                    return std::nullopt;
+                }
+                // Like with `JsonValue`, integers that don't fit into `Int` are read as `Float`
+                auto floatValue = Float{0};
+                const auto [ptr, ec] = std::from_chars(value.data(), end, floatValue, std::chars_format::general);
+                if (ec == std::errc{} && ptr == end) {
+                    AppendTag(Tag::Float);
+                    AppendU64(std::bit_cast<uint64_t>(floatValue));
+                    return std::nullopt;
+                }
+                if (ec == std::errc::result_out_of_range) return MakeError(lpCounter, NError::ErrorCode::ResultOutOfRangeError);
+            }
+            return MakeError(
+                lpCounter,
+                NError::ErrorCode::TypeError,
+                "a value is neither a string, a number, a bool, null, an array nor a mapping"
+            );
+        }
+
+        auto Open(uint64_t containerIdx) -> void {
+            const auto& container = View.Containers[containerIdx];
+            Stack.push_back({.Container = containerIdx, .NextChild = 0, .Begin = Out.size()});
+            if (container.IsMapping()) {
+                // The index has no tables for mappings with sorted keys, but the binary form always
+                // has a table for large mappings
+                auto slots = View.KeySlots.subspan(container.FirstKeySlot, container.NKeySlots);
+                if (slots.empty() && container.NChildren >= NIndex::kMinKeysForTable) {
+                    KeySlots.assign(std::bit_ceil(2 * container.NChildren), 0);
+                    FillKeyTable(KeySlots, View.Children.subspan(container.FirstChild, container.NChildren), View.Data);
+                    slots = KeySlots;
+                }
+                AppendTag(NBinary::Tag::Mapping);
+                AppendU32(0);
+                AppendU32(static_cast<uint32_t>(container.NChildren));
+                AppendU32(static_cast<uint32_t>(slots.size()));
+                Out.append(NBinary::kMappingEntrySize * container.NChildren, '\0');
+                for (const auto slot : slots) AppendU32(slot);
+            } else {
+                AppendTag(NBinary::Tag::Array);
+                AppendU32(0);
+                AppendU32(static_cast<uint32_t>(container.NChildren));
+                Out.append(4 * container.NChildren, '\0');
+            }
+        }
+
+        auto Step() -> std::optional<NError::Error> {
+            const auto frame = Stack.back();
+            const auto& container = View.Containers[frame.Container];
+            if (frame.NextChild == container.NChildren) {
+                PatchU32(frame.Begin + 1, Out.size() - frame.Begin);
+                Stack.pop_back();
+                return std::nullopt;
+            }
+            ++Stack.back().NextChild;
+            const auto& child = View.Children[container.FirstChild + frame.NextChild];
+            if (container.IsMapping()) {
+                const auto entry = frame.Begin + NBinary::kMappingHeaderSize + NBinary::kMappingEntrySize * frame.NextChild;
+                PatchU32(entry, static_cast<uint32_t>(child.KeyHash));
+                PatchU32(entry + 4, child.KeyLen);
+                Out += View.Data.substr(child.KeyBegin, child.KeyLen);
+                PatchU32(entry + 8, Out.size() - frame.Begin);
+            } else {
+                PatchU32(frame.Begin + NBinary::kArrayHeaderSize + 4 * frame.NextChild, Out.size() - frame.Begin);
+            }
+            if (child.Container != NIndex::kNone) {
+                Open(child.Container);
+                return std::nullopt;
+            }
+            return WriteScalar(View.Data.substr(child.ValueBegin, child.ValueLen), child.LpCounter);
+        }
+    public:
+        explicit BinaryTranscoder(
+            const DocumentIndexView& view,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+        )
+            : View(view), Out(resource), Stack(resource), KeySlots(resource) {}
+
+        auto Run() -> Expected<std::pmr::string> {
+            if (View.Containers.empty()) {
+                if (const auto error = WriteScalar(View.Data, View.RootLpCounter)) return *error;
+            } else {
+                Open(0);
+                while (!Stack.empty()) {
+                    if (const auto error = Step()) return *error;
+                }
+            }
+            // All the offsets and the sizes are 32-bit
+            if (Out.size() > std::numeric_limits<uint32_t>::max()) return MakeError(
+                View.RootLpCounter,
+                NError::ErrorCode::TranscodingError,
+                "the binary form of the document is larger than 4 GiB"
+            );
+            return std::move(Out);
+        }
+    };
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Produces the binary form of a document (see `BinaryValue`), checking the syntax of the whole
+    // document, as `DocumentIndex::Build` does, and that every scalar is a valid json value.
+    // The result and the temporary memory (including the index built for `root`) are allocated
+    // from `resource`
+    inline auto ToBinary(
+        const DocumentIndexView& view,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> Expected<std::pmr::string> {
+        return NUtils::BinaryTranscoder{view, resource}.Run();
+    }
+    inline auto ToBinary(
+        const JsonValue& root,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) -> Expected<std::pmr::string> {
+        const auto index = pmr::DocumentIndex::Build(root, resource);
+        if (index.HasError()) return index.Error();
+        return ToBinary(index.Value().View(root).Value(), resource);
+    }
+} // namespace NJsonParser
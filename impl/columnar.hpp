@@ -0,0 +1,257 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "shape_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+
+
+namespace NJsonParser {
+    // Types of values that can be extracted into a column
+    template <class T>
+    concept CColumnType = std::same_as<T, Bool>
+                       || std::same_as<T, Int>
+                       || std::same_as<T, Float>
+                       || std::same_as<T, String>;
+
+    // Returns the number of `uint64_t` words needed for a validity bitmap of `nRows` rows
+    constexpr auto ValidityWords(size_t nRows) noexcept -> size_t {
+        return (nRows + 63) / 64;
+    }
+
+    // An output column for `ExtractColumns`. Doesn't own any data: the value of the field
+    // `Field` of the i-th object of an array goes to `Values[i]`, and the i-th bit of the
+    // `Validity` bitmap tells whether the i-th object actually had this field with a value
+    // of type `T`. If it didn't, `Values[i]` is left untouched.
+    template <CColumnType T>
+    struct Column {
+        using value_type = T;
+        std::string_view Field;
+        std::span<T> Values;
+        std::span<uint64_t> Validity;
+
+        // The number of rows this column is able to hold
+        constexpr auto Capacity() const noexcept -> size_t {
+            return std::min(Values.size(), Validity.size() * 64);
+        }
+        constexpr auto IsValid(size_t row) const noexcept -> bool {
+            return (Validity[row / 64] >> (row % 64)) & 1;
+        }
+        constexpr auto SetValid(size_t row) const noexcept -> void {
+            Validity[row / 64] |= uint64_t{1} << (row % 64);
+        }
+        // Tries to store `value` as the value of this column in row `row`. Returns `false`
+        // if `value` doesn't hold a value of type `T` or if the row is already filled
+        constexpr auto TryFill(size_t row, const JsonValue& value) const noexcept -> bool {
+            if (IsValid(row)) return false;
+            const auto typed = value.As<T>();
+            if (typed.HasError()) return false;
+            Values[row] = typed.Value();
+            SetValid(row);
+            return true;
+        }
+    };
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // The common implementation of all `ExtractColumns` overloads.
+    // Walks over the elements of `array` exactly once and, for every element that is
+    // a mapping, walks over its (key, value) pairs once with `matchFields` (which has the
+    // same signature as `NUtils::MatchFields`), calling `tryFill(row, fieldIdx, value)`
+    // for every key that is equal to `fieldAt(fieldIdx)`.
+    constexpr auto ExtractColumnsImpl(
+        const Array& array,
+        size_t nFields,
+        size_t capacity,
+        std::invocable<size_t> auto&& fieldAt,
+        std::invocable<size_t, size_t, const JsonValue&> auto&& tryFill,
+        auto&& matchFields
+    ) -> Expected<size_t> {
+        size_t row = 0;
+        auto it = array.begin();
+        for (; it != array.end(); ++it, ++row) {
+            const auto elem = *it;
+            if (elem.HasError()) return elem.Error();
+            if (row == capacity) return MakeError(
+                elem.Value().GetLpCounter(),
+                NError::ErrorCode::ArrayIndexOutOfRange,
+                NError::ArrayIndexOutOfRangeAdditionalInfo{
+                    .Index = row,
+                    .ArrayLen = array.size(),
+                }
+            );
+            const auto mapping = elem.As<Mapping>();
+            // Rows that are not mappings are simply left invalid in all the columns
+            if (mapping.HasError()) continue;
+            const auto nFilled = matchFields(
+                mapping.Value(), nFields, fieldAt,
+                [row, &tryFill](size_t fieldIdx, const JsonValue& value) {
+                    return tryFill(row, fieldIdx, value);
+                }
+            );
+            if (nFilled.HasError()) return nFilled.Error();
+        }
+        if (it.HasError()) return it.Error();
+        return row;
+    }
+
+    template <CColumnType... Ts>
+    constexpr auto ExtractColumnsImpl(
+        const Array& array,
+        auto&& matchFields,
+        Column<Ts>... columns
+    ) -> Expected<size_t> {
+        (std::ranges::fill(columns.Validity, uint64_t{0}), ...);
+        const auto fields = std::array<std::string_view, sizeof...(Ts)>{columns.Field...};
+        const auto capacity = std::min({std::numeric_limits<size_t>::max(), columns.Capacity()...});
+        return ExtractColumnsImpl(
+            array, sizeof...(Ts), capacity,
+            [&fields](size_t fieldIdx) { return fields[fieldIdx]; },
+            [&columns...](size_t row, size_t fieldIdx, const JsonValue& value) {
+                return [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    bool filled = false;
+                    ((Is == fieldIdx && (filled = columns.TryFill(row, value))), ...);
+                    return filled;
+                }(std::index_sequence_for<Ts...>{});
+            },
+            matchFields
+        );
+    }
+
+    template <CColumnType T>
+    constexpr auto ExtractColumnsImpl(
+        const Array& array,
+        auto&& matchFields,
+        std::span<const Column<T>> columns
+    ) -> Expected<size_t> {
+        auto capacity = std::numeric_limits<size_t>::max();
+        for (const auto& column : columns) {
+            std::ranges::fill(column.Validity, uint64_t{0});
+            capacity = std::min(capacity, column.Capacity());
+        }
+        return ExtractColumnsImpl(
+            array, columns.size(), capacity,
+            [columns](size_t fieldIdx) { return columns[fieldIdx].Field; },
+            [columns](size_t row, size_t fieldIdx, const JsonValue& value) {
+                return columns[fieldIdx].TryFill(row, value);
+            },
+            matchFields
+        );
+    }
+
+    constexpr inline auto kGenericMatchFields = [](
+        const Mapping& mapping,
+        size_t nFields,
+        std::invocable<size_t> auto&& fieldAt,
+        std::invocable<size_t, const JsonValue&> auto&& onField
+    ) -> Expected<size_t> {
+        return MatchFields(mapping, nFields, fieldAt, onField);
+    };
+
+    template <size_t kMaxSlots, class TAllocator>
+    constexpr auto CachedMatchFields(ShapeCache<kMaxSlots, TAllocator>& cache) {
+        return [&cache](
+            const Mapping& mapping,
+            size_t nFields,
+            std::invocable<size_t> auto&& fieldAt,
+            std::invocable<size_t, const JsonValue&> auto&& onField
+        ) -> Expected<size_t> {
+            return cache.Match(mapping, nFields, fieldAt, onField);
+        };
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Fills several columns of different types in a single pass over an array of mappings
+    // (i.e. converts an array of structs into a struct of arrays), e.g.:
+    //
+    //     auto ts = std::array<Int, 2>{}; auto tsValid = std::array<uint64_t, ValidityWords(2)>{};
+    //     auto user = std::array<String, 2>{}; auto userValid = std::array<uint64_t, ValidityWords(2)>{};
+    //     const auto nRows = ExtractColumns(
+    //         JsonValue{R"([{"ts": 1, "user": "a"}, {"ts": 2}])"}.As<Array>().Value(),
+    //         Column<Int>{"ts", ts, tsValid},
+    //         Column<String>{"user", user, userValid}
+    //     ); // == 2, `user` is not valid in row 1
+    //
+    // The validity bitmaps are reset before the extraction. A field that is missing in some row
+    // or holds a value of a different type, as well as a row that is not a mapping, doesn't abort
+    // the extraction and is only reported by the corresponding unset validity bit. If a key occurs
+    // more than once in a mapping, the first occurrence holding a value of the right type is taken.
+    // Several columns may take the same field, e.g. to read it as values of different types.
+    //
+    // Returns the number of rows (i.e. the length of the array) if the extraction succeeded.
+    // Returns an error if the array or some of its elements are syntactically malformed, or
+    // if some of the columns is too short to hold all the rows (`ArrayIndexOutOfRange`).
+    template <CColumnType... Ts>
+    constexpr auto ExtractColumns(const Array& array, Column<Ts>... columns) -> Expected<size_t> {
+        return NUtils::ExtractColumnsImpl(array, NUtils::kGenericMatchFields, columns...);
+    }
+
+    // Same as above, but for a number of columns of the same type which is known only at run-time
+    template <CColumnType T>
+    constexpr auto ExtractColumns(const Array& array, std::span<const Column<T>> columns) -> Expected<size_t> {
+        return NUtils::ExtractColumnsImpl(array, NUtils::kGenericMatchFields, columns);
+    }
+
+    // Same as the two overloads above, but the mappings are walked over using `cache`
+    // (see `impl/shape_cache.hpp`), which is much faster for arrays of mappings with
+    // the same keys going in the same order. The same cache may be reused for several
+    // arrays as long as the list of fields stays the same
+    template <size_t kMaxSlots, class TAllocator, CColumnType... Ts>
+    constexpr auto ExtractColumns(
+        const Array& array,
+        ShapeCache<kMaxSlots, TAllocator>& cache,
+        Column<Ts>... columns
+    ) -> Expected<size_t> {
+        return NUtils::ExtractColumnsImpl(array, NUtils::CachedMatchFields(cache), columns...);
+    }
+    template <size_t kMaxSlots, class TAllocator, CColumnType T>
+    constexpr auto ExtractColumns(
+        const Array& array,
+        ShapeCache<kMaxSlots, TAllocator>& cache,
+        std::span<const Column<T>> columns
+    ) -> Expected<size_t> {
+        return NUtils::ExtractColumnsImpl(array, NUtils::CachedMatchFields(cache), columns);
+    }
+
+    // The following boilerplate is needed for syntactically nice
+    // monadic operations support:
+    template <CColumnType... Ts>
+    constexpr auto ExtractColumns(const Expected<Array>& array, Column<Ts>... columns) -> Expected<size_t> {
+        return array.HasValue() ? ExtractColumns(array.Value(), columns...) : array.Error();
+    }
+    template <CColumnType T>
+    constexpr auto ExtractColumns(
+        const Expected<Array>& array,
+        std::span<const Column<T>> columns
+    ) -> Expected<size_t> {
+        return array.HasValue() ? ExtractColumns(array.Value(), columns) : array.Error();
+    }
+    template <size_t kMaxSlots, class TAllocator, CColumnType... Ts>
+    constexpr auto ExtractColumns(
+        const Expected<Array>& array,
+        ShapeCache<kMaxSlots, TAllocator>& cache,
+        Column<Ts>... columns
+    ) -> Expected<size_t> {
+        return array.HasValue() ? ExtractColumns(array.Value(), cache, columns...) : array.Error();
+    }
+    template <size_t kMaxSlots, class TAllocator, CColumnType T>
+    constexpr auto ExtractColumns(
+        const Expected<Array>& array,
+        ShapeCache<kMaxSlots, TAllocator>& cache,
+        std::span<const Column<T>> columns
+    ) -> Expected<size_t> {
+        return array.HasValue() ? ExtractColumns(array.Value(), cache, columns) : array.Error();
+    }
+} // namespace NJsonParser
@@ -0,0 +1,163 @@
+#pragma once
+
+
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "utils.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+namespace NJsonParser {
+    // A bounded cache of document indexes (see `impl/document_index.hpp`) for documents that
+    // are received again and again, like configs or feature flags. Documents are identified
+    // by the hash of their contents (`NUtils::ContentHash`), so an index built for one buffer
+    // is reused for every other buffer with the same bytes, and navigating a repeated document
+    // doesn't require scanning it at all:
+    //
+    //     auto cache = DocumentCache{{.MaxEntries = 128}};
+    //     ...
+    //     const auto index = cache.GetOrBuild(json).Value();
+    //     const auto view = index->View(json).Value();
+    //     const auto flag = view.Root()["flags"]["new_ui"].As<Bool>();
+    //
+    // When either of the limits is exceeded, the least recently used entries are evicted. Entries
+    // are shared, so an evicted index stays alive for as long as somebody still uses it.
+    // Unlike the rest of the library, the cache is a run-time only facility; it is thread-safe.
+    class DocumentCache {
+    public:
+        struct Options {
+            size_t MaxEntries = 1024;
+            // The limit of the memory used by the cached indexes (and by the copies of the documents)
+            size_t MaxMemoryUsage = 64 << 20;
+            // Whether to keep a copy of every cached document and to compare it with the requested one
+            // on each hit. Without it, two different documents of the same size with colliding 64-bit
+            // hashes would share the same index, which is only acceptable for trusted inputs
+            bool VerifyHits = true;
+            // Where all the memory of the cache (including the indexes) comes from; `nullptr` stands for
+            // `std::pmr::get_default_resource()`. Since entries are evicted one by one, the resource should
+            // be able to reuse freed memory (unlike `ArenaResource`), and since the indexes are built
+            // without holding the lock, it should be thread-safe if the cache is shared between threads
+            std::pmr::memory_resource* Resource = nullptr;
+        };
+        struct Stats {
+            size_t Hits = 0;
+            size_t Misses = 0;
+            size_t Evictions = 0;
+            size_t NEntries = 0;
+            size_t MemoryUsage = 0;
+
+            auto HitRate() const noexcept -> double {
+                return Hits + Misses == 0 ? 0 : static_cast<double>(Hits) / static_cast<double>(Hits + Misses);
+            }
+        };
+    private:
+        struct Entry {
+            uint64_t Hash;
+            std::shared_ptr<const pmr::DocumentIndex> Index;
+            std::pmr::string Contents;
+            size_t MemoryUsage;
+        };
+        Options Opts;
+        mutable std::mutex Mutex;
+        // The most recently used entries go first
+        std::pmr::list<Entry> Entries;
+        std::pmr::unordered_map<uint64_t, std::pmr::list<Entry>::iterator> EntryByHash;
+        Stats CurStats;
+    private:
+        auto Matches(const Entry& entry, std::string_view data) const noexcept -> bool {
+            return !Opts.VerifyHits || entry.Contents == data;
+        }
+
+        auto EvictWhileOverLimits() -> void {
+            while (!Entries.empty()
+                && (Entries.size() > Opts.MaxEntries || CurStats.MemoryUsage > Opts.MaxMemoryUsage)
+            ) {
+                CurStats.MemoryUsage -= Entries.back().MemoryUsage;
+                EntryByHash.erase(Entries.back().Hash);
+                Entries.pop_back();
+                ++CurStats.Evictions;
+            }
+        }
+    public:
+        DocumentCache() : DocumentCache(Options{}) {}
+        explicit DocumentCache(Options options)
+            : Opts(options)
+            , Entries(Opts.Resource ? Opts.Resource : std::pmr::get_default_resource())
+            , EntryByHash(Entries.get_allocator()) {}
+
+        // Returns the cached index for a document with the same contents as `root`,
+        // building and caching a new one if there is none. Indexes that fail to build
+        // (because the document is malformed) are not cached
+        auto GetOrBuild(const JsonValue& root) -> Expected<std::shared_ptr<const pmr::DocumentIndex>> {
+            const auto data = root.GetData();
+            const auto hash = NUtils::ContentHash(data);
+            {
+                const auto lock = std::scoped_lock{Mutex};
+                const auto found = EntryByHash.find(hash);
+                if (found != EntryByHash.end() && Matches(*found->second, data)) {
+                    ++CurStats.Hits;
+                    Entries.splice(Entries.begin(), Entries, found->second);
+                    return found->second->Index;
+                }
+                ++CurStats.Misses;
+            }
+            // The index is built without holding the lock, so that other
+            // threads are not blocked while a large document is being indexed
+            const auto allocator = Entries.get_allocator();
+            const auto built = pmr::DocumentIndex::Build(root, allocator);
+            if (built.HasError()) return built.Error();
+            // The copy is as small as possible and keeps the allocator
+            auto index = std::allocate_shared<const pmr::DocumentIndex>(allocator, built.Value());
+            auto entry = Entry{
+                .Hash = hash,
+                .Index = index,
+                .Contents = std::pmr::string{Opts.VerifyHits ? data : std::string_view{}, allocator},
+                .MemoryUsage = 0,
+            };
+            entry.MemoryUsage = sizeof(Entry) + index->MemoryUsage() + entry.Contents.capacity();
+
+            const auto lock = std::scoped_lock{Mutex};
+            const auto found = EntryByHash.find(hash);
+            if (found != EntryByHash.end()) {
+                // Either another thread has built the same index in the meantime,
+                // or this is a hash collision, in which case the newer document wins
+                if (Matches(*found->second, data)) return found->second->Index;
+                CurStats.MemoryUsage -= found->second->MemoryUsage;
+                Entries.erase(found->second);
+                EntryByHash.erase(found);
+            }
+            CurStats.MemoryUsage += entry.MemoryUsage;
+            Entries.push_front(std::move(entry));
+            EntryByHash.emplace(hash, Entries.begin());
+            EvictWhileOverLimits();
+            return index;
+        }
+        auto GetOrBuild(const Expected<JsonValue>& root) -> Expected<std::shared_ptr<const pmr::DocumentIndex>> {
+            return root.HasValue() ? GetOrBuild(root.Value()) : root.Error();
+        }
+
+        auto GetStats() const -> Stats {
+            const auto lock = std::scoped_lock{Mutex};
+            auto stats = CurStats;
+            stats.NEntries = Entries.size();
+            return stats;
+        }
+
+        // Drops all the entries, but keeps the statistics
+        auto Clear() -> void {
+            const auto lock = std::scoped_lock{Mutex};
+            Entries.clear();
+            EntryByHash.clear();
+            CurStats.MemoryUsage = 0;
+        }
+    };
+} // namespace NJsonParser
@@ -0,0 +1,641 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "line_position_counter.hpp"
+#include "pointer.hpp"
+#include "utils.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace NJsonParser::NIndex {
+    inline constexpr uint64_t kNone = std::numeric_limits<uint64_t>::max();
+
+    // The records a document index consists of. They are plain fixed-width structs that refer
+    // to the document only by byte offsets (counted from the first character of the root value),
+    // so the same index can be used with any copy of the same document.
+
+    // An array or a mapping of the document
+    struct ContainerRecord {
+        // The offsets of the opening and of the closing bracket
+        uint64_t Begin = 0;
+        uint64_t End = 0;
+        // The children of a container are stored contiguously in the children table
+        uint64_t FirstChild = 0;
+        uint64_t NChildren = 0;
+        // An open-addressing hash table (of `NKeySlots` slots, a power of two) in the key slots
+        // table, which maps the hash of a key to the position of the child among the children of
+        // the mapping plus one (0 for an empty slot). Small mappings and mappings with sorted keys
+        // have no table (`NKeySlots == 0`) and are searched linearly or with a binary search
+        uint64_t FirstKeySlot = 0;
+        uint64_t NKeySlots = 0;
+        LinePositionCounter LpCounter = {};
+        // Either '[' or '{'
+        char Kind = '[';
+        // A combination of the `k...` flags below
+        uint8_t Flags = 0;
+
+        // The keys of the mapping are in strictly ascending order (compared byte by byte,
+        // as they are written in the document, so there are no duplicate keys)
+        static constexpr uint8_t kSortedKeys = 1;
+        static constexpr uint8_t kAllFlags = kSortedKeys;
+
+        constexpr auto IsMapping() const noexcept -> bool {
+            return Kind == '{';
+        }
+        constexpr auto HasSortedKeys() const noexcept -> bool {
+            return (Flags & kSortedKeys) != 0;
+        }
+        constexpr auto operator==(const ContainerRecord& other) const noexcept -> bool = default;
+    };
+
+    // An element of an array or a (key, value) pair of a mapping
+    struct ChildRecord {
+        // The offset of the first character of the key (right after the opening double quote),
+        // its length and its hash (see `NUtils::Hash`). Only meaningful for children of mappings
+        uint64_t KeyBegin = 0;
+        uint64_t KeyLen = 0;
+        uint64_t KeyHash = 0;
+        // The offset and the length of the value
+        uint64_t ValueBegin = 0;
+        uint64_t ValueLen = 0;
+        // The index of the container record of the value, or `kNone` if the value is a scalar
+        uint64_t Container = kNone;
+        // The line and the position of the start of the value in the original text
+        LinePositionCounter LpCounter = {};
+
+        constexpr auto operator==(const ChildRecord& other) const noexcept -> bool = default;
+    };
+
+    // Mappings with fewer children than this are not worth a hash table
+    inline constexpr uint64_t kMinKeysForTable = 8;
+} // namespace NJsonParser::NIndex
+
+namespace NJsonParser {
+    class IndexedValue;
+
+    // A document together with its structural index. Doesn't own anything: both the document
+    // and the tables of the index must outlive the view and all the values obtained from it.
+    // Since it consists only of a string and spans, it can be created at compile time as well.
+    struct DocumentIndexView {
+        std::string_view Data;
+        LinePositionCounter RootLpCounter = {};
+        // Empty if the root value is a scalar, otherwise the root container comes first
+        std::span<const NIndex::ContainerRecord> Containers;
+        std::span<const NIndex::ChildRecord> Children;
+        std::span<const uint32_t> KeySlots;
+
+        constexpr auto Root() const noexcept -> IndexedValue;
+        // Returns the index of the first child of the mapping `container` (the index of its container record)
+        // whose key has the hash `keyHash` and for which `compare` returns `std::strong_ordering::equal`,
+        // or `NIndex::kNone`. `compare(key)` compares `key` with the requested key, like `key <=> requested`
+        constexpr auto FindChild(uint64_t container, uint64_t keyHash, auto&& compare) const noexcept -> uint64_t {
+            const auto& record = Containers[container];
+            const auto keyAt = [&](uint64_t childIdx) {
+                const auto& child = Children[childIdx];
+                return Data.substr(child.KeyBegin, child.KeyLen);
+            };
+            const auto keyMatches = [&](uint64_t childIdx) {
+                return Children[childIdx].KeyHash == keyHash && compare(keyAt(childIdx)) == 0;
+            };
+            if (record.HasSortedKeys()) {
+                auto lo = record.FirstChild;
+                auto hi = record.FirstChild + record.NChildren;
+                while (lo != hi) {
+                    const auto mid = lo + (hi - lo) / 2;
+                    const auto order = compare(keyAt(mid));
+                    if (order == 0) return mid;
+                    if (order < 0) lo = mid + 1;
+                    else hi = mid;
+                }
+                return NIndex::kNone;
+            }
+            if (record.NKeySlots == 0) {
+                for (auto i = record.FirstChild; i != record.FirstChild + record.NChildren; ++i) {
+                    if (keyMatches(i)) return i;
+                }
+                return NIndex::kNone;
+            }
+            const auto mask = record.NKeySlots - 1;
+            for (auto slot = keyHash & mask;; slot = (slot + 1) & mask) {
+                const auto entry = KeySlots[record.FirstKeySlot + slot];
+                if (entry == 0) return NIndex::kNone;
+                if (keyMatches(record.FirstChild + entry - 1)) return record.FirstChild + entry - 1;
+            }
+        }
+    };
+
+    // A json value that is navigated with the help of a document index: getting an element
+    // of an array by its index and getting a value from a mapping by its key take O(1) time
+    // instead of a scan over the serialized container. Errors are reported in the same way as
+    // by `JsonValue`. Refers to the view it was obtained from, which must outlive it.
+    class IndexedValue {
+    private:
+        const DocumentIndexView* View;
+        // The index of the container record of the value, or `NIndex::kNone` for a scalar
+        uint64_t Container;
+        JsonValue Value;
+    private:
+        constexpr IndexedValue(const DocumentIndexView& view, uint64_t container, JsonValue value) noexcept
+            : View(&view), Container(container), Value(value) {}
+        friend struct DocumentIndexView;
+
+        constexpr auto MakeChild(uint64_t childIdx) const noexcept -> IndexedValue {
+            const auto& child = View->Children[childIdx];
+            return IndexedValue{
+                *View,
+                child.Container,
+                JsonValue{View->Data.substr(child.ValueBegin, child.ValueLen), child.LpCounter},
+            };
+        }
+
+        constexpr auto Find(
+            std::string_view requestedKey,
+            uint64_t keyHash,
+            auto&& compare
+        ) const noexcept -> Expected<IndexedValue>;
+    public:
+        // The value itself, e.g. for iteration with `.As<Array>()` or `.As<Mapping>()`
+        constexpr auto GetJsonValue() const noexcept -> JsonValue {
+            return Value;
+        }
+        template <CJsonType T> constexpr auto As() const noexcept -> Expected<T> {
+            return Value.As<T>();
+        }
+        // The number of elements of an array or of (key, value) pairs of a mapping
+        constexpr auto size() const noexcept -> Expected<size_t>;
+        // Same effect as `.GetJsonValue()[idx]`
+        constexpr auto operator[](size_t idx) const noexcept -> Expected<IndexedValue>;
+        // Same effect as `.GetJsonValue()[key]`. If a key occurs more
+        // than once, the first occurrence is found
+        constexpr auto operator[](std::string_view key) const noexcept -> Expected<IndexedValue>;
+        // Applies a segment of a json pointer with the key hash precomputed by `CompiledPointer`,
+        // with the same results as `NUtils::ApplyPointerSegment`
+        constexpr auto operator[](const PointerSegment& segment) const noexcept -> Expected<IndexedValue>;
+    };
+
+    constexpr auto DocumentIndexView::Root() const noexcept -> IndexedValue {
+        return IndexedValue{*this, Containers.empty() ? NIndex::kNone : 0, JsonValue{Data, RootLpCounter}};
+    }
+
+    // The specialization of `Expected` class template for `IndexedValue`
+    template <>
+    struct Expected<IndexedValue> : public ExpectedMixin<IndexedValue> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<IndexedValue>::ExpectedMixin;
+        // Monadic methods specific to `Expected<IndexedValue>`:
+        template <CJsonType T> constexpr auto As() const -> Expected<T> {
+            return HasValue() ? Value().As<T>() : Error();
+        }
+        constexpr auto size() const -> Expected<size_t> {
+            return HasValue() ? Value().size() : Error();
+        }
+        constexpr auto operator[](size_t idx) const -> Expected<IndexedValue> {
+            return HasValue() ? Value()[idx] : Error();
+        }
+        constexpr auto operator[](std::string_view key) const -> Expected<IndexedValue> {
+            return HasValue() ? Value()[key] : Error();
+        }
+        constexpr auto operator[](const PointerSegment& segment) const -> Expected<IndexedValue> {
+            return HasValue() ? Value()[segment] : Error();
+        }
+    };
+
+    constexpr auto IndexedValue::Find(
+        std::string_view requestedKey,
+        uint64_t keyHash,
+        auto&& compare
+    ) const noexcept -> Expected<IndexedValue> {
+        if (Container == NIndex::kNone || !View->Containers[Container].IsMapping()) {
+            const auto mapping = Value.As<Mapping>();
+            if (mapping.HasError()) return mapping.Error();
+        }
+        const auto childIdx = View->FindChild(Container, keyHash, compare);
+        if (childIdx == NIndex::kNone) return MakeError(
+            Value.GetLpCounter(),
+            NError::ErrorCode::MappingKeyNotFound,
+            NError::MappingKeyNotFoundAdditionalInfo{requestedKey}
+        );
+        return MakeChild(childIdx);
+    }
+
+    constexpr auto IndexedValue::size() const noexcept -> Expected<size_t> {
+        if (Container == NIndex::kNone) {
+            const auto array = Value.As<Array>();
+            if (array.HasError()) return array.Error();
+            return array.Value().size();
+        }
+        return View->Containers[Container].NChildren;
+    }
+
+    constexpr auto IndexedValue::operator[](size_t idx) const noexcept -> Expected<IndexedValue> {
+        if (Container == NIndex::kNone || View->Containers[Container].IsMapping()) {
+            const auto array = Value.As<Array>();
+            if (array.HasError()) return array.Error();
+        }
+        const auto& container = View->Containers[Container];
+        if (idx >= container.NChildren) return MakeError(
+            Value.GetLpCounter(),
+            NError::ErrorCode::ArrayIndexOutOfRange,
+            NError::ArrayIndexOutOfRangeAdditionalInfo{
+                .Index = idx,
+                .ArrayLen = container.NChildren,
+            }
+        );
+        return MakeChild(container.FirstChild + idx);
+    }
+
+    constexpr auto IndexedValue::operator[](std::string_view key) const noexcept -> Expected<IndexedValue> {
+        return Find(key, NUtils::Hash(key), [key](std::string_view other) { return other <=> key; });
+    }
+
+    constexpr auto IndexedValue::operator[](const PointerSegment& segment) const noexcept -> Expected<IndexedValue> {
+        if (Container == NIndex::kNone) {
+            const auto result = NUtils::ApplyPointerSegment(Value, segment);
+            if (result.HasError()) return result.Error();
+            return IndexedValue{*View, NIndex::kNone, result.Value()};
+        }
+        if (!View->Containers[Container].IsMapping()) {
+            if (!segment.IsIndex()) return MakeError(
+                Value.GetLpCounter(),
+                NError::ErrorCode::InvalidPointerError,
+                "json pointer refers to an array element with something that is not an array index"
+            );
+            return (*this)[segment.Index];
+        }
+        return Find(segment.Raw, segment.KeyHash, [&segment](std::string_view key) {
+            return segment.Compare(key);
+        });
+    }
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // Fills `slots` (a power of two of zeroed slots, more than there are children)
+    // with the key table of a mapping with the `children` (see `NIndex::ContainerRecord`)
+    constexpr auto FillKeyTable(
+        std::span<uint32_t> slots,
+        std::span<const NIndex::ChildRecord> children,
+        std::string_view data
+    ) noexcept -> void {
+        const auto mask = slots.size() - 1;
+        const auto keyAt = [data](const NIndex::ChildRecord& child) {
+            return data.substr(child.KeyBegin, child.KeyLen);
+        };
+        for (uint64_t i = 0; i != children.size(); ++i) {
+            const auto& child = children[i];
+            auto slot = child.KeyHash & mask;
+            for (; slots[slot] != 0; slot = (slot + 1) & mask) {
+                const auto& other = children[slots[slot] - 1];
+                // Only the first occurrence of a key is reachable by lookups
+                if (other.KeyHash == child.KeyHash && keyAt(other) == keyAt(child)) break;
+            }
+            if (slots[slot] == 0) slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    // Checks whether the keys of the `children` of a mapping are in strictly ascending order
+    constexpr auto AreKeysSorted(std::span<const NIndex::ChildRecord> children, std::string_view data) noexcept -> bool {
+        for (size_t i = 1; i < children.size(); ++i) {
+            const auto& prev = children[i - 1];
+            const auto& cur = children[i];
+            if (data.substr(prev.KeyBegin, prev.KeyLen) >= data.substr(cur.KeyBegin, cur.KeyLen)) return false;
+        }
+        return true;
+    }
+
+    // Builds the tables of a document index in a single pass over the document. The children
+    // of the containers that are still open are collected on a stack (one vector per depth,
+    // reused between containers) and are moved to the children table when the container is
+    // closed, so that the children of every container end up stored contiguously.
+    // The temporary vectors use the allocator of the index. The pass is either done at once
+    // with `Run()` or a value at a time with `Start()`, `Step()` and `Finish()`, so that the
+    // indexes of several documents can be built in turns (see `impl/batch_parser.hpp`).
+    template <class TIndex>
+    class DocumentIndexBuilder {
+    private:
+        template <class T>
+        using TVector = typename TIndex::template TVector<T>;
+        std::string_view Data;
+        LinePositionCounter LpCounter;
+        std::string_view::size_type Pos = 0;
+        TIndex& Index;
+        // The container records of the open containers
+        TVector<uint64_t> OpenContainers;
+        TVector<TVector<NIndex::ChildRecord>> PendingChildren;
+    private:
+        constexpr auto Advance(std::string_view::size_type to) noexcept -> void {
+            LpCounter.Process(Data.substr(Pos, to - Pos));
+            Pos = to;
+        }
+        constexpr auto SkipSpaces() noexcept -> void {
+            const auto next = NUtils::SkipSpaces(Data, LpCounter, Pos);
+            Pos = next == std::string_view::npos ? Data.size() : next;
+        }
+        constexpr auto Open() -> void {
+            OpenContainers.push_back(Index.Containers.size());
+            Index.Containers.push_back({.Begin = Pos, .LpCounter = LpCounter, .Kind = Data[Pos]});
+            if (PendingChildren.size() < OpenContainers.size()) PendingChildren.emplace_back();
+            PendingChildren[OpenContainers.size() - 1].clear();
+            Advance(Pos + 1);
+        }
+        constexpr auto BuildKeyTable(NIndex::ContainerRecord& container) -> void {
+            const auto nSlots = std::bit_ceil(2 * container.NChildren);
+            container.FirstKeySlot = Index.KeySlots.size();
+            container.NKeySlots = nSlots;
+            Index.KeySlots.resize(Index.KeySlots.size() + nSlots, 0);
+            FillKeyTable(
+                std::span{Index.KeySlots}.subspan(container.FirstKeySlot, nSlots),
+                std::span{Index.Children}.subspan(container.FirstChild, container.NChildren),
+                Data
+            );
+        }
+        constexpr auto Close() -> std::optional<NError::Error> {
+            const auto containerIdx = OpenContainers.back();
+            const auto kind = Index.Containers[containerIdx].Kind;
+            if (Data[Pos] != (kind == '[' ? ']' : '}')) return MakeError(
+                LpCounter,
+                NError::ErrorCode::SyntaxError,
+                kind == '['
+                    ? "brackets mismatch: a closing square bracket is expected"
+                    : "brackets mismatch: a closing curly brace ('}') is expected"
+            );
+            auto& children = PendingChildren[OpenContainers.size() - 1];
+            auto& container = Index.Containers[containerIdx];
+            container.End = Pos;
+            container.FirstChild = Index.Children.size();
+            container.NChildren = children.size();
+            Index.Children.insert(Index.Children.end(), children.begin(), children.end());
+            if (container.IsMapping()) {
+                // Mappings with sorted keys are binary searched and don't need a table
+                const auto pairs = std::span{Index.Children}.subspan(container.FirstChild, container.NChildren);
+                if (AreKeysSorted(pairs, Data)) container.Flags |= NIndex::ContainerRecord::kSortedKeys;
+                else if (container.NChildren >= NIndex::kMinKeysForTable) BuildKeyTable(container);
+            }
+            OpenContainers.pop_back();
+            if (!OpenContainers.empty()) {
+                PendingChildren[OpenContainers.size() - 1].back().ValueLen = container.End - container.Begin + 1;
+            }
+            Advance(Pos + 1);
+            return std::nullopt;
+        }
+        // Moves past the string starting at the current position. At run-time, the closing
+        // double quote is found by a SIMD kernel, which also counts the newlines on the way
+        constexpr auto SkipString() -> std::optional<NError::Error> {
+            const auto missingQuote = [this] {
+                return MakeError(
+                    LpCounter,
+                    NError::ErrorCode::SyntaxError,
+                    "a double quote (\") is probably missing at the end of a string"
+                );
+            };
+            if (std::is_constant_evaluated()) {
+                const auto closingQuotePos = Data.find('"', Pos + 1);
+                if (closingQuotePos == std::string_view::npos) return missingQuote();
+                Advance(closingQuotePos + 1);
+                return std::nullopt;
+            }
+            const auto contents = Data.data() + Pos + 1;
+            const auto end = Data.data() + Data.size();
+            auto newlines = NSimd::Newlines{};
+            const auto closingQuote = NSimd::GetKernels().FindStructural(contents, end, true, newlines);
+            if (closingQuote == end) return missingQuote();
+            LpCounter.Process('"');
+            ProcessSkipped(LpCounter, contents, closingQuote, newlines);
+            LpCounter.Process('"');
+            Pos = static_cast<size_t>(closingQuote + 1 - Data.data());
+            return std::nullopt;
+        }
+        // Skips the spaces and the comma after a value
+        constexpr auto FinishValue() -> std::optional<NError::Error> {
+            SkipSpaces();
+            if (OpenContainers.empty() || Pos == Data.size()) return std::nullopt;
+            if (Data[Pos] == ',') Advance(Pos + 1);
+            else if (Data[Pos] != ']' && Data[Pos] != '}') return MakeError(
+                LpCounter,
+                NError::ErrorCode::SyntaxError,
+                "a comma is probably missing between two elements"
+            );
+            return std::nullopt;
+        }
+    public:
+        constexpr DocumentIndexBuilder(const JsonValue& root, TIndex& index)
+            : Data(root.GetData())
+            , LpCounter(root.GetLpCounter())
+            , Index(index)
+            , OpenContainers(index.get_allocator())
+            , PendingChildren(index.get_allocator()) {}
+
+        // Starts over with another document (and an empty index), keeping the memory of the temporary vectors
+        constexpr auto Reset(const JsonValue& root) noexcept -> void {
+            Data = root.GetData();
+            LpCounter = root.GetLpCounter();
+            Pos = 0;
+            OpenContainers.clear();
+        }
+
+        // Opens the root container; the index of a scalar document is empty
+        constexpr auto Start() -> void {
+            if (!Data.empty() && (Data.front() == '[' || Data.front() == '{')) Open();
+        }
+
+        constexpr auto IsDone() const noexcept -> bool {
+            return OpenContainers.empty();
+        }
+
+        // Where the next step starts, e.g. to prefetch the characters it is going to read
+        constexpr auto Upcoming() const noexcept -> const char* {
+            return Data.data() + Pos;
+        }
+
+        // Indexes the next value or closes the innermost open container. Only called until `IsDone()`
+        constexpr auto Step() -> std::optional<NError::Error> {
+            SkipSpaces();
+            if (Pos == Data.size()) return MakeError(
+                LpCounter,
+                NError::ErrorCode::SyntaxError,
+                "brackets mismatch: some brackets are never closed"
+            );
+            if (Data[Pos] == ']' || Data[Pos] == '}') {
+                if (const auto error = Close()) return error;
+                return FinishValue();
+            }
+            auto child = NIndex::ChildRecord{};
+            if (Index.Containers[OpenContainers.back()].IsMapping()) {
+                if (Data[Pos] != '"') return MakeError(
+                    LpCounter,
+                    NError::ErrorCode::TypeError,
+                    "expected string, got something else"
+                );
+                child.KeyBegin = Pos + 1;
+                if (const auto error = SkipString()) return error;
+                child.KeyLen = Pos - 1 - child.KeyBegin;
+                child.KeyHash = Hash(Data.substr(child.KeyBegin, child.KeyLen));
+                SkipSpaces();
+                if (Pos == Data.size() || Data[Pos] != ':') return MakeError(
+                    LpCounter,
+                    NError::ErrorCode::SyntaxError,
+                    "a colon is probably missing after a key"
+                );
+                Advance(Pos + 1);
+                SkipSpaces();
+            }
+            child.ValueBegin = Pos;
+            child.LpCounter = LpCounter;
+            auto& siblings = PendingChildren[OpenContainers.size() - 1];
+            if (Pos != Data.size() && (Data[Pos] == '[' || Data[Pos] == '{')) {
+                child.Container = Index.Containers.size();
+                siblings.push_back(child);
+                Open();
+                return std::nullopt;
+            }
+            if (Pos != Data.size() && Data[Pos] == '"') {
+                if (const auto error = SkipString()) return error;
+                child.ValueLen = Pos - child.ValueBegin;
+                siblings.push_back(child);
+                return FinishValue();
+            }
+            auto valueEnd = Pos;
+            while (valueEnd != Data.size() && !IsSpace(Data[valueEnd])
+                && std::string_view{",:[]{}\""}.find(Data[valueEnd]) == std::string_view::npos
+            ) ++valueEnd;
+            if (valueEnd == Pos) return MakeError(LpCounter, NError::ErrorCode::MissingValueError);
+            child.ValueLen = valueEnd - Pos;
+            siblings.push_back(child);
+            Advance(valueEnd);
+            return FinishValue();
+        }
+
+        // Checks that nothing follows the root container once `IsDone()`
+        constexpr auto Finish() const -> std::optional<NError::Error> {
+            // (scalar documents are not scanned at all)
+            if (Pos != 0 && Pos != Data.size()) return MakeError(
+                LpCounter,
+                NError::ErrorCode::SyntaxError,
+                "unexpected characters after the end of the document"
+            );
+            return std::nullopt;
+        }
+
+        constexpr auto Run() -> std::optional<NError::Error> {
+            Start();
+            while (!IsDone()) {
+                if (const auto error = Step()) return error;
+            }
+            return Finish();
+        }
+    };
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // The owning structural index of a document: the offsets of all the values of the document
+    // and hash tables of the keys of its large mappings. Building an index takes a single pass
+    // over the document; after that, every lookup through `IndexedValue` takes O(1) time.
+    // The index refers to the document only by offsets, so it can be reused for any buffer
+    // with the same contents (see `impl/document_cache.hpp`):
+    //
+    //     const auto index = DocumentIndex::Build(json).Value();
+    //     const auto view = index.View(json).Value();
+    //     const auto name = view.Root()["params"]["compilers"][1]["name"].As<String>();
+    //
+    // Unlike the lazy `JsonValue`, which only looks at the parts of a document that are
+    // accessed, building an index checks the syntax of the whole document, so it fails for
+    // some malformed documents that can still be partially read with `JsonValue`.
+    //
+    // All the memory of an index, as well as the temporary memory needed to build it,
+    // is taken from `TAllocator`. `pmr::DocumentIndex` uses a `std::pmr::memory_resource`,
+    // e.g. an `ArenaResource` (see `impl/arena.hpp`) that is released at once per request:
+    //
+    //     auto arena = ArenaResource{};
+    //     const auto built = pmr::DocumentIndex::Build(json, &arena);
+    //
+    // Unlike standard containers, an index keeps its allocator when copied, so
+    // `pmr::DocumentIndex::Build(json, &arena).Value()` is still allocated from `arena`.
+    template <class TAllocator = std::allocator<std::byte>>
+    class BasicDocumentIndex {
+    public:
+        using allocator_type = TAllocator;
+        template <class T>
+        using TVector = std::vector<T, typename std::allocator_traits<TAllocator>::template rebind_alloc<T>>;
+    private:
+        TVector<NIndex::ContainerRecord> Containers;
+        TVector<NIndex::ChildRecord> Children;
+        TVector<uint32_t> KeySlots;
+        uint64_t DataSize = 0;
+        template <class TIndex> friend class NUtils::DocumentIndexBuilder;
+    public:
+        constexpr explicit BasicDocumentIndex(const TAllocator& allocator = {})
+            : Containers(allocator), Children(allocator), KeySlots(allocator) {}
+        constexpr BasicDocumentIndex(const BasicDocumentIndex& other, const TAllocator& allocator)
+            : Containers(other.Containers, allocator)
+            , Children(other.Children, allocator)
+            , KeySlots(other.KeySlots, allocator)
+            , DataSize(other.DataSize) {}
+        constexpr BasicDocumentIndex(const BasicDocumentIndex& other)
+            : BasicDocumentIndex(other, other.get_allocator()) {}
+        constexpr BasicDocumentIndex(BasicDocumentIndex&&) noexcept = default;
+        constexpr auto operator=(const BasicDocumentIndex&) -> BasicDocumentIndex& = default;
+        constexpr auto operator=(BasicDocumentIndex&&) -> BasicDocumentIndex& = default;
+
+        static constexpr auto Build(
+            const JsonValue& root,
+            const TAllocator& allocator = {}
+        ) -> Expected<BasicDocumentIndex> {
+            auto index = BasicDocumentIndex{allocator};
+            index.DataSize = root.GetData().size();
+            if (const auto error = NUtils::DocumentIndexBuilder{root, index}.Run()) return *error;
+            // Shrinking memory taken from an arena would only waste more of it
+            if constexpr (std::same_as<TAllocator, std::allocator<std::byte>>) {
+                index.Containers.shrink_to_fit();
+                index.Children.shrink_to_fit();
+                index.KeySlots.shrink_to_fit();
+            }
+            return index;
+        }
+
+        constexpr auto get_allocator() const noexcept -> TAllocator {
+            return TAllocator{Containers.get_allocator()};
+        }
+
+        // Binds the index to a document. `root` must be the value the index was built
+        // for or a value with exactly the same contents in another buffer
+        constexpr auto View(const JsonValue& root) const noexcept -> Expected<DocumentIndexView> {
+            if (root.GetData().size() != DataSize) return MakeError(
+                root.GetLpCounter(),
+                NError::ErrorCode::TypeError,
+                "the document index was built for another document"
+            );
+            return DocumentIndexView{
+                .Data = root.GetData(),
+                .RootLpCounter = root.GetLpCounter(),
+                .Containers = Containers,
+                .Children = Children,
+                .KeySlots = KeySlots,
+            };
+        }
+
+        // The number of bytes of memory used by the index
+        constexpr auto MemoryUsage() const noexcept -> size_t {
+            return sizeof(*this)
+                + Containers.capacity() * sizeof(NIndex::ContainerRecord)
+                + Children.capacity() * sizeof(NIndex::ChildRecord)
+                + KeySlots.capacity() * sizeof(uint32_t);
+        }
+    };
+
+    using DocumentIndex = BasicDocumentIndex<>;
+
+    namespace pmr {
+        using DocumentIndex = BasicDocumentIndex<std::pmr::polymorphic_allocator<std::byte>>;
+    } // namespace pmr
+} // namespace NJsonParser
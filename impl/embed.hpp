@@ -0,0 +1,154 @@
+#pragma once
+
+
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "line_position_counter.hpp"
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+namespace NJsonParser {
+    struct EmbedOptions {
+        // The namespace of the generated variables
+        std::string_view Namespace = "NEmbedded";
+        // The path the generated header includes the library by
+        std::string_view ParserInclude = "parser.hpp";
+        // The name of the embedded file, mentioned in the comment at the top of the header
+        std::string_view SourceName = {};
+    };
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // Appends `data` as a sequence of string literals, one per line of the document (long lines
+    // are split), so that the generated header stays readable and diffs well
+    inline auto AppendStringLiterals(std::string& out, std::string_view data) -> void {
+        constexpr size_t kMaxLiteralLen = 96;
+        size_t literalLen = 0;
+        out += "        \"";
+        for (size_t i = 0; i != data.size(); ++i) {
+            const auto ch = static_cast<unsigned char>(data[i]);
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                case '\r': out += "\\r"; break;
+                default:
+                    if (ch >= 0x20 && ch < 0x7f) {
+                        out += static_cast<char>(ch);
+                    } else {
+                        // Octal escapes always have three digits, so they can't swallow the next character
+                        out += '\\';
+                        out += static_cast<char>('0' + (ch >> 6));
+                        out += static_cast<char>('0' + ((ch >> 3) & 7));
+                        out += static_cast<char>('0' + (ch & 7));
+                    }
+            }
+            ++literalLen;
+            if (i + 1 != data.size() && (ch == '\n' || literalLen == kMaxLiteralLen)) {
+                out += "\"\n        \"";
+                literalLen = 0;
+            }
+        }
+        out += "\"";
+    }
+
+    inline auto ToString(LinePositionCounter lpCounter) -> std::string {
+        return "{" + std::to_string(lpCounter.LineNumber) + ", " + std::to_string(lpCounter.Position) + "}";
+    }
+
+    inline auto ToString(const NIndex::ContainerRecord& record) -> std::string {
+        return "{" + std::to_string(record.Begin)
+            + ", " + std::to_string(record.End)
+            + ", " + std::to_string(record.FirstChild)
+            + ", " + std::to_string(record.NChildren)
+            + ", " + std::to_string(record.FirstKeySlot)
+            + ", " + std::to_string(record.NKeySlots)
+            + ", " + ToString(record.LpCounter)
+            + ", '" + record.Kind + "'"
+            + ", " + std::to_string(record.Flags) + "}";
+    }
+
+    inline auto ToString(const NIndex::ChildRecord& record) -> std::string {
+        return "{" + std::to_string(record.KeyBegin)
+            + ", " + std::to_string(record.KeyLen)
+            + ", " + std::to_string(record.KeyHash) + "ull"
+            + ", " + std::to_string(record.ValueBegin)
+            + ", " + std::to_string(record.ValueLen)
+            + ", " + (record.Container == NIndex::kNone ? std::string{"NJsonParser::NIndex::kNone"} : std::to_string(record.Container))
+            + ", " + ToString(record.LpCounter) + "}";
+    }
+
+    // Appends the definition of a `std::array` of the given records, one record
+    // (or, for integers, up to 16 of them) per line
+    template <class T>
+    auto AppendArray(std::string& out, std::string_view type, std::string_view name, std::span<const T> records) -> void {
+        constexpr size_t kPerLine = std::integral<T> ? 16 : 1;
+        out += "    inline constexpr std::array<";
+        out += type;
+        out += ", " + std::to_string(records.size()) + "> ";
+        out += name;
+        out += " = {{\n";
+        for (size_t i = 0; i != records.size(); ++i) {
+            out += i % kPerLine == 0 ? "        " : " ";
+            if constexpr (std::integral<T>) out += std::to_string(records[i]) + ",";
+            else out += ToString(records[i]) + ",";
+            if (i % kPerLine == kPerLine - 1 || i + 1 == records.size()) out += "\n";
+        }
+        out += "    }};\n";
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Generates the source of a C++ header that embeds a document together with its document
+    // index (see `impl/document_index.hpp`) as `constexpr` variables in the namespace
+    // `options.Namespace`. `kDocument` is a `DocumentIndexView`, so navigating the embedded
+    // document takes O(1) time per step both at compile- and run-time, and including the
+    // header doesn't require scanning the document at compile time:
+    //
+    //     constexpr auto name = NConfig::kDocument.Root()["params"]["compilers"][1]["name"].As<String>();
+    //
+    // Fails with the error of `DocumentIndex::Build` if the document is malformed.
+    // The header is meant to be generated at build time, e.g. with `tools/embed_json.cpp`
+    inline auto EmbedDocument(const JsonValue& root, const EmbedOptions& options = {}) -> Expected<std::string> {
+        const auto built = DocumentIndex::Build(root);
+        if (built.HasError()) return built.Error();
+        const auto view = built.Value().View(root).Value();
+
+        auto out = std::string{"#pragma once\n\n"};
+        out += "// Generated from ";
+        out += options.SourceName.empty() ? std::string_view{"a json document"} : options.SourceName;
+        out += " by `NJsonParser::EmbedDocument`, do not edit\n\n";
+        out += "#include \"";
+        out += options.ParserInclude;
+        out += "\"\n\n#include <array>\n#include <cstdint>\n#include <string_view>\n\n\n";
+        out += "namespace ";
+        out += options.Namespace;
+        out += " {\n";
+        out += "    // The document itself, without the leading and trailing whitespace\n";
+        out += "    inline constexpr char kData[] =\n";
+        NUtils::AppendStringLiterals(out, view.Data);
+        out += ";\n";
+        NUtils::AppendArray(out, "NJsonParser::NIndex::ContainerRecord", "kContainers", view.Containers);
+        NUtils::AppendArray(out, "NJsonParser::NIndex::ChildRecord", "kChildren", view.Children);
+        NUtils::AppendArray(out, "uint32_t", "kKeySlots", view.KeySlots);
+        out += "    inline constexpr auto kDocument = NJsonParser::DocumentIndexView{\n";
+        out += "        .Data = std::string_view{kData, sizeof(kData) - 1},\n";
+        out += "        .RootLpCounter = " + NUtils::ToString(view.RootLpCounter) + ",\n";
+        out += "        .Containers = kContainers,\n";
+        out += "        .Children = kChildren,\n";
+        out += "        .KeySlots = kKeySlots,\n";
+        out += "    };\n";
+        out += "} // namespace ";
+        out += options.Namespace;
+        out += "\n";
+        return out;
+    }
+} // namespace NJsonParser
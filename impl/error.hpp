@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include "instrumentation.hpp"
 #include "line_position_counter.hpp"
 
 #include <algorithm>
@@ -19,6 +20,12 @@ namespace NJsonParser::NError {
         MappingKeyNotFound,
         EndIteratorDereferenceError,
         ResultOutOfRangeError,
+        InvalidPointerError,
+        InvalidJsonPathError,
+        WriterError,
+        PatchError,
+        IndexFileError,
+        TranscodingError,
     };
     // Maps `ErrorCode` values to string representations
     constexpr auto ToStr(ErrorCode code) noexcept -> std::string_view {
@@ -39,6 +46,18 @@ namespace NJsonParser::NError {
             case ResultOutOfRangeError:
                 return "\"provided int/double value is out of range of representable values "
                        "of int/double type used by this library\" error";
+            case InvalidPointerError:
+                return "\"invalid json pointer\" error";
+            case InvalidJsonPathError:
+                return "\"invalid json path\" error";
+            case WriterError:
+                return "\"writer\" error";
+            case PatchError:
+                return "\"patch\" error";
+            case IndexFileError:
+                return "\"index file\" error";
+            case TranscodingError:
+                return "\"transcoding\" error";
         }
         // To avoid compiler warning; should rather be `std::unreachable()` from c++23.
         // This project is written in c++20 on purpose, so, can't use it here.
@@ -142,6 +161,7 @@ namespace NJsonParser::NError {
         // initializes the `std::variant` with an empty `std::string_view`:
         Error::TAdditionalInfo additionalInfo = {}
     ) noexcept -> Error {
+        NInstrumentation::Count(&NInstrumentation::Counters::Errors);
         return {
             .BasicInfo = {
                 .LineNumber = lpCounter.LineNumber,
@@ -80,6 +80,7 @@ namespace NJsonParser {
         using ExpectedMixin<Mapping>::ExpectedMixin;
         // Monadic methods specific to `Expected<Mapping>`:
         constexpr auto operator[](std::string_view) const noexcept -> Expected<JsonValue>;
+        constexpr auto FindSorted(std::string_view) const noexcept -> Expected<JsonValue>;
         constexpr auto size() const noexcept -> Expected<size_t>;
         constexpr auto begin() const noexcept -> Mapping::Iterator;
         constexpr auto end() const noexcept -> Mapping::Iterator;
@@ -96,5 +97,9 @@ namespace NJsonParser {
         constexpr auto operator[](size_t idx) const -> Expected<JsonValue>;
         // Same effect as `.As<Mapping>()[key]`
         constexpr auto operator[](std::string_view key) const -> Expected<JsonValue>;
+        constexpr auto AtPointer(std::string_view pointer) const -> Expected<JsonValue>;
+        // Same as `Value().Visit(visitor)`, but calls `visitor` with the error if there is no value
+        template <class TVisitor>
+        constexpr auto Visit(TVisitor&& visitor) const -> decltype(auto);
     };
 }
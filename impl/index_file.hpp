@@ -0,0 +1,394 @@
+#pragma once
+
+
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NJSON_PARSER_HAS_MMAP 1
+#endif
+
+
+namespace NJsonParser::NIndex {
+    // An index file is this header followed by the tables of a document index (the containers,
+    // the children and the key slots) stored byte for byte as they are laid out in memory, so that
+    // a memory-mapped index file is used as is, without deserialization. The other side of this is
+    // that an index file can only be read by a build with the same layout of the records, which is
+    // checked with `Layout`.
+    struct IndexFileHeader {
+        static constexpr auto kMagic = std::array<char, 8>{'N', 'J', 'S', 'O', 'N', 'I', 'D', 'X'};
+        static constexpr uint32_t kVersion = 1;
+        static constexpr uint32_t kLayout
+            = static_cast<uint32_t>(sizeof(ContainerRecord))
+            | static_cast<uint32_t>(sizeof(ChildRecord)) << 8
+            | static_cast<uint32_t>(alignof(ContainerRecord)) << 16
+            | static_cast<uint32_t>(std::endian::native == std::endian::little) << 24;
+
+        std::array<char, 8> Magic = kMagic;
+        uint32_t Version = kVersion;
+        uint32_t Layout = kLayout;
+        // The size and the hash (see `NUtils::ContentHash`) of the indexed document
+        uint64_t DataSize = 0;
+        uint64_t DataHash = 0;
+        // The sizes of the tables
+        uint64_t NContainers = 0;
+        uint64_t NChildren = 0;
+        uint64_t NKeySlots = 0;
+    };
+    static_assert(std::is_trivially_copyable_v<IndexFileHeader>);
+    static_assert(sizeof(IndexFileHeader) % alignof(ContainerRecord) == 0);
+    static_assert(sizeof(ContainerRecord) % alignof(ChildRecord) == 0);
+    static_assert(sizeof(ChildRecord) % alignof(uint32_t) == 0);
+} // namespace NJsonParser::NIndex
+
+namespace NJsonParser {
+    // How much of an index file is checked when it is loaded
+    enum class IndexFileCheck : uint8_t {
+        // The format of the file, the sizes of the tables and the size of the document: O(1).
+        // Only for files that are known to be intact and up to date, since navigating a document
+        // with a corrupted index may read out of the bounds of the document and of the tables
+        Header,
+        // Also all the offsets of the index, so that navigation stays within the bounds of the
+        // document and of the tables whatever the index file contains: O(size of the index)
+        Bounds,
+        // Also the hash of the document, so that the index of an edited document of the same
+        // size is rejected: O(size of the document)
+        Contents,
+    };
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // Records are copied field by field into zeroed memory, so that the padding
+    // bytes don't make index files of the same document differ
+    inline auto ZeroPadded(const NIndex::ContainerRecord& record) noexcept -> NIndex::ContainerRecord {
+        auto copy = NIndex::ContainerRecord{};
+        std::memset(static_cast<void*>(&copy), 0, sizeof(copy));
+        copy.Begin = record.Begin;
+        copy.End = record.End;
+        copy.FirstChild = record.FirstChild;
+        copy.NChildren = record.NChildren;
+        copy.FirstKeySlot = record.FirstKeySlot;
+        copy.NKeySlots = record.NKeySlots;
+        copy.LpCounter = record.LpCounter;
+        copy.Kind = record.Kind;
+        copy.Flags = record.Flags;
+        return copy;
+    }
+    inline auto ZeroPadded(const NIndex::ChildRecord& record) noexcept -> NIndex::ChildRecord {
+        auto copy = NIndex::ChildRecord{};
+        std::memset(static_cast<void*>(&copy), 0, sizeof(copy));
+        copy.KeyBegin = record.KeyBegin;
+        copy.KeyLen = record.KeyLen;
+        copy.KeyHash = record.KeyHash;
+        copy.ValueBegin = record.ValueBegin;
+        copy.ValueLen = record.ValueLen;
+        copy.Container = record.Container;
+        copy.LpCounter = record.LpCounter;
+        return copy;
+    }
+
+    // Passes the contents of the index file of `view` to `write(const char*, size_t)` piece by piece
+    inline auto WriteIndexFile(const DocumentIndexView& view, auto&& write) -> void {
+        auto header = NIndex::IndexFileHeader{};
+        std::memset(static_cast<void*>(&header), 0, sizeof(header));
+        header.Magic = NIndex::IndexFileHeader::kMagic;
+        header.Version = NIndex::IndexFileHeader::kVersion;
+        header.Layout = NIndex::IndexFileHeader::kLayout;
+        header.DataSize = view.Data.size();
+        header.DataHash = ContentHash(view.Data);
+        header.NContainers = view.Containers.size();
+        header.NChildren = view.Children.size();
+        header.NKeySlots = view.KeySlots.size();
+        const auto writeObject = [&write](const auto& object) {
+            write(reinterpret_cast<const char*>(&object), sizeof(object));
+        };
+        writeObject(header);
+        for (const auto& container : view.Containers) writeObject(ZeroPadded(container));
+        for (const auto& child : view.Children) writeObject(ZeroPadded(child));
+        write(reinterpret_cast<const char*>(view.KeySlots.data()), view.KeySlots.size_bytes());
+    }
+
+    // Returns `true` if `begin + len <= limit` (without overflows)
+    constexpr auto FitsInto(uint64_t begin, uint64_t len, uint64_t limit) noexcept -> bool {
+        return begin <= limit && len <= limit - begin;
+    }
+
+    // Checks that navigating `view` doesn't go out of the bounds of the document and of the tables
+    inline auto AreIndexBoundsValid(const DocumentIndexView& view) noexcept -> bool {
+        const auto dataSize = view.Data.size();
+        if (view.Containers.empty()) return dataSize == 0 || (view.Data.front() != '[' && view.Data.front() != '{');
+        // The first container is the root
+        const auto& root = view.Containers.front();
+        if (root.Begin != 0 || root.End + 1 != dataSize) return false;
+        for (const auto& container : view.Containers) {
+            if (container.Kind != '[' && container.Kind != '{') return false;
+            if ((container.Flags & ~NIndex::ContainerRecord::kAllFlags) != 0) return false;
+            if (container.Begin >= container.End || container.End >= dataSize) return false;
+            if (!FitsInto(container.FirstChild, container.NChildren, view.Children.size())) return false;
+            if (container.NKeySlots == 0) continue;
+            // Lookups stop at an empty slot, so a table must have more slots than keys
+            if (!std::has_single_bit(container.NKeySlots) || container.NKeySlots <= container.NChildren) return false;
+            if (!FitsInto(container.FirstKeySlot, container.NKeySlots, view.KeySlots.size())) return false;
+            for (const auto entry : view.KeySlots.subspan(container.FirstKeySlot, container.NKeySlots)) {
+                if (entry > container.NChildren) return false;
+            }
+        }
+        for (const auto& child : view.Children) {
+            if (!FitsInto(child.KeyBegin, child.KeyLen, dataSize)) return false;
+            if (!FitsInto(child.ValueBegin, child.ValueLen, dataSize)) return false;
+            if (child.Container != NIndex::kNone && child.Container >= view.Containers.size()) return false;
+        }
+        return true;
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Index files persist the structural index of a document (see `impl/document_index.hpp`)
+    // next to the document, so that a huge document that is reopened again and again
+    // (e.g. on every restart of a service) is only scanned once:
+    //
+    //     // Once, e.g. when the document is published:
+    //     const auto index = DocumentIndex::Build(json).Value();
+    //     SaveIndexFile(index, json, "data.json.index");
+    //     ...
+    //     // On every start:
+    //     const auto document = MappedDocument::Open("data.json", "data.json.index").Value();
+    //     const auto name = document.Root()["params"]["compilers"][1]["name"].As<String>();
+    //
+    // An index file records the size and the hash of the document it was built for, so a stale
+    // index file is rejected when it is loaded (see `IndexFileCheck` for what is checked).
+
+    // Serializes the index of `root` to the format of index files
+    template <class TAllocator>
+    auto SerializeIndex(const BasicDocumentIndex<TAllocator>& index, const JsonValue& root) -> Expected<std::string> {
+        const auto view = index.View(root);
+        if (view.HasError()) return view.Error();
+        auto out = std::string{};
+        NUtils::WriteIndexFile(view.Value(), [&out](const char* data, size_t size) { out.append(data, size); });
+        return out;
+    }
+
+    // Writes the index file of `root` to `path`. The file is written under a temporary name
+    // and then renamed, so that readers never see a partially written index file
+    template <class TAllocator>
+    auto SaveIndexFile(
+        const BasicDocumentIndex<TAllocator>& index,
+        const JsonValue& root,
+        const std::filesystem::path& path
+    ) -> std::optional<NError::Error> {
+        const auto view = index.View(root);
+        if (view.HasError()) return view.Error();
+        auto tmpPath = path;
+        tmpPath += ".tmp";
+        {
+            auto out = std::ofstream{tmpPath, std::ios::binary | std::ios::trunc};
+            NUtils::WriteIndexFile(view.Value(), [&out](const char* data, size_t size) {
+                out.write(data, static_cast<std::streamsize>(size));
+            });
+            if (out.flush(); !out) return MakeError(
+                root.GetLpCounter(),
+                NError::ErrorCode::IndexFileError,
+                "can't write the index file"
+            );
+        }
+        auto error = std::error_code{};
+        std::filesystem::rename(tmpPath, path, error);
+        if (error) return MakeError(
+            root.GetLpCounter(),
+            NError::ErrorCode::IndexFileError,
+            "can't write the index file"
+        );
+        return std::nullopt;
+    }
+
+    // Binds the contents of an index file to the document, which must be the value the index was
+    // built for or a value with the same contents. The returned view refers to `file` and doesn't
+    // copy the tables, so `file` must outlive it and must be aligned to `alignof(std::max_align_t)`,
+    // like the memory returned by `new` or by `mmap`
+    inline auto LoadIndex(
+        std::string_view file,
+        const JsonValue& root,
+        IndexFileCheck check = IndexFileCheck::Contents
+    ) -> Expected<DocumentIndexView> {
+        using NIndex::IndexFileHeader;
+        const auto error = [&root](std::string_view message) {
+            return MakeError(root.GetLpCounter(), NError::ErrorCode::IndexFileError, message);
+        };
+        auto header = IndexFileHeader{};
+        if (file.size() < sizeof(header)) return error("the index file is truncated");
+        std::memcpy(static_cast<void*>(&header), file.data(), sizeof(header));
+        if (header.Magic != IndexFileHeader::kMagic) return error("not an index file");
+        if (header.Version != IndexFileHeader::kVersion) return error("unsupported version of the index file");
+        if (header.Layout != IndexFileHeader::kLayout) return error(
+            "the index file was written by a build with a different layout of the index"
+        );
+        if (reinterpret_cast<uintptr_t>(file.data()) % alignof(NIndex::ContainerRecord) != 0) {
+            return error("the index file is misaligned in memory");
+        }
+        auto tables = file.substr(sizeof(header));
+        if (header.NContainers > tables.size() / sizeof(NIndex::ContainerRecord)
+            || header.NChildren > tables.size() / sizeof(NIndex::ChildRecord)
+            || header.NKeySlots > tables.size() / sizeof(uint32_t)
+            || header.NContainers * sizeof(NIndex::ContainerRecord)
+                + header.NChildren * sizeof(NIndex::ChildRecord)
+                + header.NKeySlots * sizeof(uint32_t) != tables.size()
+        ) return error("the size of the index file doesn't match its header");
+        if (header.DataSize != root.GetData().size()) return error("the index file was built for another document");
+
+        const auto takeTable = [&tables]<class T>(std::type_identity<T>, uint64_t size) {
+            const auto table = std::span{reinterpret_cast<const T*>(tables.data()), size};
+            tables.remove_prefix(table.size_bytes());
+            return table;
+        };
+        const auto view = DocumentIndexView{
+            .Data = root.GetData(),
+            .RootLpCounter = root.GetLpCounter(),
+            .Containers = takeTable(std::type_identity<NIndex::ContainerRecord>{}, header.NContainers),
+            .Children = takeTable(std::type_identity<NIndex::ChildRecord>{}, header.NChildren),
+            .KeySlots = takeTable(std::type_identity<uint32_t>{}, header.NKeySlots),
+        };
+        if (check >= IndexFileCheck::Bounds && !NUtils::AreIndexBoundsValid(view)) {
+            return error("the index file is corrupted");
+        }
+        if (check >= IndexFileCheck::Contents && header.DataHash != NUtils::ContentHash(view.Data)) {
+            return error("the index file was built for another document");
+        }
+        return view;
+    }
+
+#ifdef NJSON_PARSER_HAS_MMAP
+    // A read-only memory mapping of a whole file
+    class MappedFile {
+    private:
+        const char* Data = nullptr;
+        size_t Size = 0;
+    public:
+        MappedFile() noexcept = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept
+            : Data(std::exchange(other.Data, nullptr)), Size(std::exchange(other.Size, 0)) {}
+        auto operator=(MappedFile other) noexcept -> MappedFile& {
+            std::swap(Data, other.Data);
+            std::swap(Size, other.Size);
+            return *this;
+        }
+        ~MappedFile() {
+            if (Data != nullptr) ::munmap(const_cast<char*>(Data), Size);
+        }
+
+        // Returns `std::nullopt` if the file can't be opened or mapped (`errno` tells why)
+        static auto Open(const std::filesystem::path& path) -> std::optional<MappedFile> {
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1) return std::nullopt;
+            auto file = std::optional<MappedFile>{};
+            struct stat stat = {};
+            if (::fstat(fd, &stat) == 0) {
+                file.emplace();
+                file->Size = static_cast<size_t>(stat.st_size);
+                // Empty files can't be mapped
+                if (file->Size != 0) {
+                    const auto data = ::mmap(nullptr, file->Size, PROT_READ, MAP_SHARED, fd, 0);
+                    if (data == MAP_FAILED) file.reset();
+                    else file->Data = static_cast<const char*>(data);
+                }
+            }
+            ::close(fd);
+            return file;
+        }
+
+        auto GetData() const noexcept -> std::string_view {
+            return {Data, Size};
+        }
+    };
+
+    // A document and its index file, both memory-mapped. Opening it takes no time regardless
+    // of the size of the document (apart from the checks requested with `IndexFileCheck`), and
+    // only the pages of the document and of the index that are accessed are ever read from disk.
+    // Copies share the mappings; values obtained from `Root()` refer to the mappings,
+    // so at least one copy of the document must outlive them.
+    class MappedDocument {
+    private:
+        struct TState {
+            MappedFile Document;
+            MappedFile Index;
+            DocumentIndexView View;
+        };
+        std::shared_ptr<const TState> State;
+    private:
+        explicit MappedDocument(std::shared_ptr<const TState> state) noexcept : State(std::move(state)) {}
+
+    public:
+        static auto Open(
+            const std::filesystem::path& documentPath,
+            const std::filesystem::path& indexPath,
+            IndexFileCheck check = IndexFileCheck::Contents
+        ) -> Expected<MappedDocument> {
+            auto document = MappedFile::Open(documentPath);
+            if (!document) return MakeError(
+                LinePositionCounter{},
+                NError::ErrorCode::IndexFileError,
+                "can't map the document"
+            );
+            auto index = MappedFile::Open(indexPath);
+            if (!index) return MakeError(
+                LinePositionCounter{},
+                NError::ErrorCode::IndexFileError,
+                "can't map the index file"
+            );
+            const auto root = JsonValue{document->GetData()};
+            const auto view = LoadIndex(index->GetData(), root, check);
+            if (view.HasError()) return view.Error();
+            return MappedDocument{std::make_shared<const TState>(
+                std::move(*document),
+                std::move(*index),
+                view.Value()
+            )};
+        }
+
+        // Same as `Open`, but if the index file is missing or is rejected, the index
+        // is built from the document and is saved to `indexPath` first
+        static auto OpenOrBuild(
+            const std::filesystem::path& documentPath,
+            const std::filesystem::path& indexPath,
+            IndexFileCheck check = IndexFileCheck::Contents
+        ) -> Expected<MappedDocument> {
+            auto opened = Open(documentPath, indexPath, check);
+            if (opened.HasValue()) return opened;
+            const auto document = MappedFile::Open(documentPath);
+            if (!document) return opened;
+            const auto root = JsonValue{document->GetData()};
+            const auto index = DocumentIndex::Build(root);
+            if (index.HasError()) return index.Error();
+            if (const auto error = SaveIndexFile(index.Value(), root, indexPath)) return *error;
+            return Open(documentPath, indexPath, check);
+        }
+
+        auto Root() const noexcept -> IndexedValue {
+            return State->View.Root();
+        }
+        auto GetView() const noexcept -> const DocumentIndexView& {
+            return State->View;
+        }
+    };
+#endif
+} // namespace NJsonParser
@@ -0,0 +1,96 @@
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace NJsonParser::NInstrumentation {
+    // Counters of the work done by the parser, which help to find access patterns that are
+    // more expensive than they seem (e.g. indexing an array in a loop, which is quadratic).
+    // Counting is enabled by defining the `NJSON_PARSER_INSTRUMENTATION` macro before including
+    // the library; without it, all the hooks compile to nothing. The macro must be defined
+    // (or not) consistently in all the translation units of a program.
+    // Counters are per thread, and the work done at compile time is not counted:
+    //
+    //     const auto before = NInstrumentation::GetCounters();
+    //     ...
+    //     const auto spent = NInstrumentation::GetCounters() - before;
+    //     std::cout << spent.BytesScanned << " bytes scanned\n";
+#if defined(NJSON_PARSER_INSTRUMENTATION)
+    constexpr inline bool kEnabled = true;
+#else
+    constexpr inline bool kEnabled = false;
+#endif
+
+    struct Counters {
+        // Characters looked at while searching for the ends of values
+        // (see `NUtils::FindFirstOfWithZeroBracketBalance`)
+        uint64_t BytesScanned = 0;
+        // Steps of the iterators over arrays and mappings, including those made by `operator[]` and `size()`
+        uint64_t IteratorSteps = 0;
+        // Scans of containers that have recently been scanned from the beginning already
+        // (detected with a small per-thread table of the recently scanned containers, so it's
+        // a lower bound), e.g. `array[i]` in a loop over `i` rescans `array` on every iteration
+        uint64_t ContainerRescans = 0;
+        // Calls to `NError::MakeError`
+        uint64_t Errors = 0;
+        // Heap allocations made by the parser itself (i.e. not through the allocators
+        // of the auxiliary structures like document indexes), which only happen for values
+        // nested deeper than `NUtils::BracketStack` can hold without allocating
+        uint64_t Allocations = 0;
+
+        constexpr auto operator-(const Counters& other) const noexcept -> Counters {
+            return {
+                .BytesScanned = BytesScanned - other.BytesScanned,
+                .IteratorSteps = IteratorSteps - other.IteratorSteps,
+                .ContainerRescans = ContainerRescans - other.ContainerRescans,
+                .Errors = Errors - other.Errors,
+                .Allocations = Allocations - other.Allocations,
+            };
+        }
+        constexpr auto operator==(const Counters& other) const noexcept -> bool = default;
+    };
+} // namespace NJsonParser::NInstrumentation
+
+namespace NJsonParser::NInstrumentation::NImpl {
+    struct ThreadState {
+        Counters Current;
+        // The beginnings of the recently scanned containers, indexed by their hashes
+        std::array<const char*, 64> RecentContainers = {};
+    };
+    inline auto GetThreadState() noexcept -> ThreadState& {
+        thread_local auto state = ThreadState{};
+        return state;
+    }
+} // namespace NJsonParser::NInstrumentation::NImpl
+
+namespace NJsonParser::NInstrumentation {
+    // Returns a snapshot of the counters of the calling thread
+    inline auto GetCounters() noexcept -> Counters {
+        return NImpl::GetThreadState().Current;
+    }
+    inline auto ResetCounters() noexcept -> void {
+        NImpl::GetThreadState() = {};
+    }
+
+    // The hooks called by the library. They can be called from constexpr functions,
+    // but do nothing when evaluated at compile time or when counting is disabled
+    constexpr auto Count(uint64_t Counters::* counter, uint64_t n = 1) noexcept -> void {
+        if constexpr (kEnabled) {
+            if (!std::is_constant_evaluated()) NImpl::GetThreadState().Current.*counter += n;
+        }
+    }
+    constexpr auto CountContainerScan(const char* containerBegin) noexcept -> void {
+        if constexpr (kEnabled) {
+            if (std::is_constant_evaluated()) return;
+            auto& state = NImpl::GetThreadState();
+            const auto addr = reinterpret_cast<uintptr_t>(containerBegin);
+            auto& slot = state.RecentContainers[(addr ^ (addr >> 6)) % state.RecentContainers.size()];
+            if (slot == containerBegin) ++state.Current.ContainerRescans;
+            slot = containerBegin;
+        }
+    }
+} // namespace NJsonParser::NInstrumentation
@@ -4,6 +4,7 @@
 #include "api.hpp"
 #include "error.hpp"
 #include "expected.hpp"
+#include "instrumentation.hpp"
 #include "line_position_counter.hpp"
 #include "utils.hpp"
 
@@ -49,11 +50,7 @@ namespace NJsonParser {
             : Data(data)
             , ElemBegLpCounter(lpCounter)
         {
-            CurElemBegPos = NUtils::FindFirstOf(
-                Data, ElemBegLpCounter,
-                [](char ch) { return !NUtils::IsSpace(ch); },
-                startingPos
-            );
+            CurElemBegPos = NUtils::SkipSpaces(Data, ElemBegLpCounter, startingPos);
             ElemEndLpCounter = ElemBegLpCounter;
             if (IsEnd()) {
                 CurElemEndPos = std::string_view::npos;
@@ -79,7 +76,10 @@ namespace NJsonParser {
             std::string_view data,
             LinePositionCounter lpCounter,
             char delimiter
-        ) -> Self { return {data, lpCounter, 0, delimiter}; }
+        ) -> Self {
+            NInstrumentation::CountContainerScan(data.data());
+            return {data, lpCounter, 0, delimiter};
+        }
 
         static constexpr auto End(
             std::string_view data, 
@@ -88,6 +88,7 @@ namespace NJsonParser {
 
         constexpr auto StepForward(char firstDelimiter, char secondDelimiter) -> Self& {
             if (IsEnd()) return *this;
+            NInstrumentation::Count(&NInstrumentation::Counters::IteratorSteps);
             {
                 auto nextPosOrErr = NUtils::FindNextElementStartPos(
                     Data,
@@ -132,7 +133,12 @@ namespace NJsonParser {
         }
 
         constexpr auto operator==(const Self& other) const -> bool {
-            return Data == other.Data && CurElemBegPos == other.CurElemBegPos;
+            // Iterators over the same sequence view the same memory, so comparing the views
+            // themselves is enough; comparing their contents would make every `it != end()`
+            // check take time proportional to the size of the sequence
+            return Data.data() == other.Data.data()
+                && Data.size() == other.Data.size()
+                && CurElemBegPos == other.CurElemBegPos;
         }
     };
 }
@@ -0,0 +1,415 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+
+
+namespace NJsonParser {
+    // A single step of a json path, e.g. ".name", "[*]", "..id", "[1:5:2]" or "[?(@.price < 10)]"
+    struct JsonPathStep {
+        enum class EKind : uint8_t {
+            Child,    // .name, ['name'], ["name"]
+            Wildcard, // .*, [*]
+            Index,    // [3], [-1]
+            Slice,    // [start:end:step], any of the three may be omitted
+            Filter,   // [?(@.a.b)], [?(@.a.b <op> <literal>)], [?(@ <op> <literal>)]
+        };
+        enum class EFilterOp : uint8_t {
+            Exists, Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual,
+        };
+        enum class ELiteralKind : uint8_t {
+            None, Number, String, Bool,
+        };
+        static constexpr int64_t kUnset = std::numeric_limits<int64_t>::min();
+
+        EKind Kind = EKind::Child;
+        // Set for the steps preceded by "..", which match at any depth
+        bool Recursive = false;
+        // The key for `Child` steps
+        std::string_view Name = {};
+        // The index for `Index` steps, the bounds for `Slice` steps (`kUnset` if omitted)
+        int64_t Start = kUnset;
+        int64_t End = kUnset;
+        int64_t Step = 1;
+        // The path of the filtered value relative to '@', as in ".a.b" in "@.a.b"
+        std::string_view FilterPath = {};
+        EFilterOp FilterOp = EFilterOp::Exists;
+        ELiteralKind LiteralKind = ELiteralKind::None;
+        // The literal to compare with: `String` holds strings without quotes
+        std::string_view String = {};
+        Float Number = 0;
+        Bool Boolean = false;
+    };
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    constexpr auto MakeJsonPathError(std::string_view message) -> NError::Error {
+        return MakeError({}, NError::ErrorCode::InvalidJsonPathError, message);
+    }
+
+    constexpr auto IsJsonPathNameChar(char ch) -> bool {
+        return ch != '.' && ch != '[' && ch != ']' && !IsSpace(ch);
+    }
+
+    constexpr auto SkipJsonPathSpaces(std::string_view path, size_t& pos) -> void {
+        while (pos < path.size() && IsSpace(path[pos])) ++pos;
+    }
+
+    // Parses an optionally negative decimal integer, returns `kUnset` if there is none at `pos`
+    constexpr auto ParseJsonPathInt(std::string_view path, size_t& pos) -> int64_t {
+        const auto start = pos;
+        if (pos < path.size() && path[pos] == '-') ++pos;
+        const auto digitsStart = pos;
+        while (pos < path.size() && '0' <= path[pos] && path[pos] <= '9') ++pos;
+        if (pos == digitsStart) {
+            pos = start;
+            return JsonPathStep::kUnset;
+        }
+        const auto value = JsonValue{path.substr(start, pos - start)}.As<Int>();
+        return value.HasValue() ? value.Value() : JsonPathStep::kUnset;
+    }
+
+    // Parses the contents of "[?( ... )]" (the part between the parentheses)
+    constexpr auto ParseJsonPathFilter(std::string_view filter, JsonPathStep& step) -> Expected<bool> {
+        using enum JsonPathStep::EFilterOp;
+        size_t pos = 0;
+        SkipJsonPathSpaces(filter, pos);
+        if (pos == filter.size() || filter[pos] != '@') return MakeJsonPathError(
+            "a filter expression must start with '@'"
+        );
+        const auto pathStart = ++pos;
+        while (pos < filter.size() && (filter[pos] == '.' || IsJsonPathNameChar(filter[pos]))
+            && filter[pos] != '=' && filter[pos] != '!' && filter[pos] != '<' && filter[pos] != '>'
+        ) ++pos;
+        step.FilterPath = filter.substr(pathStart, pos - pathStart);
+        if (!step.FilterPath.empty() && step.FilterPath.front() != '.') return MakeJsonPathError(
+            "a filtered path must consist of \".name\" steps"
+        );
+        SkipJsonPathSpaces(filter, pos);
+        if (pos == filter.size()) {
+            step.FilterOp = Exists;
+            return true;
+        }
+        constexpr auto ops = std::array<std::pair<std::string_view, JsonPathStep::EFilterOp>, 6>{{
+            {"==", Equal}, {"!=", NotEqual}, {"<=", LessOrEqual},
+            {">=", GreaterOrEqual}, {"<", Less}, {">", Greater},
+        }};
+        const auto* op = std::ranges::find_if(ops, [&](const auto& op) {
+            return filter.substr(pos, op.first.size()) == op.first;
+        });
+        if (op == ops.end()) return MakeJsonPathError("unknown comparison operator in a filter expression");
+        step.FilterOp = op->second;
+        pos += op->first.size();
+        SkipJsonPathSpaces(filter, pos);
+        auto literal = filter.substr(pos);
+        while (!literal.empty() && IsSpace(literal.back())) literal.remove_suffix(1);
+        if (literal.size() >= 2 && (literal.front() == '\'' || literal.front() == '"')
+            && literal.back() == literal.front()
+        ) {
+            step.LiteralKind = JsonPathStep::ELiteralKind::String;
+            step.String = literal.substr(1, literal.size() - 2);
+        } else if (literal == "true" || literal == "false") {
+            step.LiteralKind = JsonPathStep::ELiteralKind::Bool;
+            step.Boolean = (literal == "true");
+        } else if (const auto number = JsonValue{literal}.As<Float>(); number.HasValue()) {
+            step.LiteralKind = JsonPathStep::ELiteralKind::Number;
+            step.Number = number.Value();
+        } else {
+            return MakeJsonPathError("a filter expression must compare with a number, a string or a bool");
+        }
+        return true;
+    }
+
+    // Parses the contents of "[ ... ]" (the part between the brackets)
+    constexpr auto ParseJsonPathBracket(std::string_view bracket, JsonPathStep& step) -> Expected<bool> {
+        using enum JsonPathStep::EKind;
+        size_t pos = 0;
+        SkipJsonPathSpaces(bracket, pos);
+        auto body = bracket.substr(pos);
+        while (!body.empty() && IsSpace(body.back())) body.remove_suffix(1);
+        if (body == "*") {
+            step.Kind = Wildcard;
+            return true;
+        }
+        if (body.size() >= 2 && (body.front() == '\'' || body.front() == '"') && body.back() == body.front()) {
+            step.Kind = Child;
+            step.Name = body.substr(1, body.size() - 2);
+            return true;
+        }
+        if (body.size() >= 3 && body.front() == '?' && body[1] == '(' && body.back() == ')') {
+            step.Kind = Filter;
+            return ParseJsonPathFilter(body.substr(2, body.size() - 3), step);
+        }
+        pos = 0;
+        step.Start = ParseJsonPathInt(body, pos);
+        if (pos == body.size() && step.Start != JsonPathStep::kUnset) {
+            step.Kind = Index;
+            return true;
+        }
+        if (pos == body.size() || body[pos] != ':') return MakeJsonPathError(
+            "expected a key, '*', an index, a slice or a filter expression inside brackets"
+        );
+        step.Kind = Slice;
+        ++pos;
+        step.End = ParseJsonPathInt(body, pos);
+        if (pos != body.size() && body[pos] == ':') {
+            ++pos;
+            step.Step = ParseJsonPathInt(body, pos);
+            if (step.Step == JsonPathStep::kUnset) step.Step = 1;
+        }
+        if (pos != body.size()) return MakeJsonPathError("malformed slice");
+        if (step.Step <= 0) return MakeJsonPathError("only positive slice steps are supported");
+        return true;
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // A compiled json path expression supporting a subset of JSONPath:
+    //   - `$` for the root, which is where every path starts,
+    //   - `.name`, `['name']` and `["name"]` for the children of mappings,
+    //   - `.*` and `[*]` for all the children of arrays and mappings,
+    //   - `..` before any step for matching at any depth (recursive descent), as in `$..id`,
+    //   - `[i]` for array elements (negative indices count from the end),
+    //   - `[start:end:step]` for slices of arrays (with positive steps only),
+    //   - `[?(@.a.b)]` and `[?(@.a.b <op> <literal>)]` for filters, where `<op>` is one of
+    //     `==`, `!=`, `<`, `<=`, `>`, `>=` and `<literal>` is a number, a quoted string or a bool.
+    //
+    // The path is evaluated as an automaton over a single forward walk through the document:
+    // every value is visited at most once with the set of steps it is currently matching,
+    // and only the subtrees that can still produce matches are entered. The steps are held
+    // in place (up to `kMaxSteps` of them), so a path can be compiled at compile time.
+    // Doesn't own any data: the string the path was compiled from must outlive it.
+    template <size_t kMaxSteps = 16>
+    class JsonPath {
+        static_assert(kMaxSteps < 64, "the set of active states is a 64-bit mask");
+    private:
+        using TStates = uint64_t;
+        std::array<JsonPathStep, kMaxSteps> Steps = {};
+        size_t NSteps = 0;
+    private:
+        constexpr JsonPath() noexcept = default;
+
+        static constexpr auto MatchesFilter(const JsonPathStep& step, const JsonValue& value) -> bool {
+            using enum JsonPathStep::EFilterOp;
+            auto target = Expected<JsonValue>{value};
+            for (auto path = step.FilterPath; !path.empty();) {
+                path.remove_prefix(1);
+                const auto nameLen = std::min(path.find('.'), path.size());
+                target = target[path.substr(0, nameLen)];
+                path.remove_prefix(nameLen);
+            }
+            if (target.HasError()) return false;
+            if (step.FilterOp == Exists) return true;
+            const auto compare = [&step](const auto& lhs, const auto& rhs) {
+                switch (step.FilterOp) {
+                    case Equal: return lhs == rhs;
+                    case NotEqual: return lhs != rhs;
+                    case Less: return lhs < rhs;
+                    case LessOrEqual: return lhs <= rhs;
+                    case Greater: return lhs > rhs;
+                    case GreaterOrEqual: return lhs >= rhs;
+                    case Exists: break;
+                }
+                return false;
+            };
+            switch (step.LiteralKind) {
+                case JsonPathStep::ELiteralKind::Number: {
+                    const auto number = target.As<Float>();
+                    return number.HasValue() && compare(number.Value(), step.Number);
+                }
+                case JsonPathStep::ELiteralKind::String: {
+                    const auto string = target.As<String>();
+                    return string.HasValue() && compare(string.Value(), step.String);
+                }
+                case JsonPathStep::ELiteralKind::Bool: {
+                    const auto boolean = target.As<Bool>();
+                    return boolean.HasValue() && compare(boolean.Value(), step.Boolean);
+                }
+                case JsonPathStep::ELiteralKind::None: break;
+            }
+            return false;
+        }
+
+        // Checks whether a child of an array (`key` is empty, `idx` is its index, `len` is
+        // the length of the array or `kUnset` if it hasn't been computed) or of a mapping
+        // (`key` is its key) matches a (non-recursive part of a) step
+        static constexpr auto MatchesChild(
+            const JsonPathStep& step,
+            bool inArray,
+            std::string_view key,
+            int64_t idx,
+            int64_t len,
+            const JsonValue& child
+        ) -> bool {
+            using enum JsonPathStep::EKind;
+            const auto normalize = [len](int64_t i) { return i < 0 ? i + len : i; };
+            switch (step.Kind) {
+                case Child: return !inArray && key == step.Name;
+                case Wildcard: return true;
+                case Index: return inArray && idx == normalize(step.Start);
+                case Slice: {
+                    if (!inArray) return false;
+                    const auto start = step.Start == JsonPathStep::kUnset ? 0 : std::max(normalize(step.Start), int64_t{0});
+                    if (idx < start || (idx - start) % step.Step != 0) return false;
+                    return step.End == JsonPathStep::kUnset || idx < normalize(step.End);
+                }
+                case Filter: return MatchesFilter(step, child);
+            }
+            return false;
+        }
+
+        // Whether the length of an array is needed to match its elements against the steps,
+        // i.e. whether some of the steps uses negative indices
+        constexpr auto NeedsLength(TStates states) const -> bool {
+            constexpr auto isNegative = [](int64_t i) { return i != JsonPathStep::kUnset && i < 0; };
+            for (size_t s = 0; s != NSteps; ++s) {
+                if (!((states >> s) & 1)) continue;
+                const auto& step = Steps[s];
+                if ((step.Kind == JsonPathStep::EKind::Index || step.Kind == JsonPathStep::EKind::Slice)
+                    && (isNegative(step.Start) || isNegative(step.End))
+                ) return true;
+            }
+            return false;
+        }
+
+        constexpr auto ChildStates(
+            TStates states,
+            bool inArray,
+            std::string_view key,
+            int64_t idx,
+            int64_t len,
+            const JsonValue& child
+        ) const -> TStates {
+            auto result = TStates{0};
+            for (size_t s = 0; s != NSteps; ++s) {
+                if (!((states >> s) & 1)) continue;
+                if (Steps[s].Recursive) result |= TStates{1} << s;
+                if (MatchesChild(Steps[s], inArray, key, idx, len, child)) result |= TStates{1} << (s + 1);
+            }
+            return result;
+        }
+
+        constexpr auto Walk(
+            const JsonValue& value,
+            TStates states,
+            std::invocable<const JsonValue&> auto&& onMatch,
+            size_t& nMatches
+        ) const -> std::optional<NError::Error> {
+            const auto data = value.GetData();
+            if (data.empty() || (data.front() != '[' && data.front() != '{')) return std::nullopt;
+            const auto accept = TStates{1} << NSteps;
+            const auto visit = [&](const JsonValue& child, TStates childStates) -> std::optional<NError::Error> {
+                if (childStates & accept) {
+                    onMatch(child);
+                    ++nMatches;
+                }
+                if (childStates & ~accept) return Walk(child, childStates & ~accept, onMatch, nMatches);
+                return std::nullopt;
+            };
+            if (data.front() == '[') {
+                const auto array = value.As<Array>();
+                if (array.HasError()) return array.Error();
+                const auto len = NeedsLength(states)
+                    ? static_cast<int64_t>(array.Value().size())
+                    : JsonPathStep::kUnset;
+                int64_t idx = 0;
+                auto it = array.begin();
+                for (; it != array.end(); ++it, ++idx) {
+                    const auto child = (*it).Value();
+                    const auto err = visit(child, ChildStates(states, true, {}, idx, len, child));
+                    if (err) return err;
+                }
+                if (it.HasError()) return it.Error();
+            } else {
+                const auto mapping = value.As<Mapping>();
+                if (mapping.HasError()) return mapping.Error();
+                auto it = mapping.begin();
+                for (; it != mapping.end(); ++it) {
+                    const auto [k, v] = *it;
+                    if (k.HasError()) return k.Error();
+                    if (v.HasError()) return v.Error();
+                    const auto err = visit(v.Value(), ChildStates(states, false, k.Value(), 0, 0, v.Value()));
+                    if (err) return err;
+                }
+                if (it.HasError()) return it.Error();
+            }
+            return std::nullopt;
+        }
+    public:
+        static constexpr auto Compile(std::string_view path) -> Expected<JsonPath> {
+            auto result = JsonPath{};
+            if (path.empty() || path.front() != '$') return NUtils::MakeJsonPathError(
+                "a json path must start with '$'"
+            );
+            for (size_t pos = 1; pos != path.size();) {
+                if (result.NSteps == kMaxSteps) return NUtils::MakeJsonPathError("json path has too many steps");
+                auto& step = result.Steps[result.NSteps++];
+                if (path[pos] == '.' && pos + 1 < path.size() && path[pos + 1] == '.') {
+                    step.Recursive = true;
+                    pos += (pos + 2 < path.size() && path[pos + 2] == '[') ? 2 : 1;
+                }
+                if (path[pos] == '.') {
+                    const auto start = ++pos;
+                    while (pos < path.size() && NUtils::IsJsonPathNameChar(path[pos])) ++pos;
+                    const auto name = path.substr(start, pos - start);
+                    if (name.empty()) return NUtils::MakeJsonPathError("expected a key or '*' after '.'");
+                    step.Kind = (name == "*") ? JsonPathStep::EKind::Wildcard : JsonPathStep::EKind::Child;
+                    step.Name = name;
+                } else if (path[pos] == '[') {
+                    // Find the matching ']', skipping the ones inside quotes
+                    const auto start = ++pos;
+                    char quote = 0;
+                    for (; pos < path.size() && (quote || path[pos] != ']'); ++pos) {
+                        if (path[pos] != '\'' && path[pos] != '"') continue;
+                        if (!quote) quote = path[pos];
+                        else if (quote == path[pos]) quote = 0;
+                    }
+                    if (pos == path.size()) return NUtils::MakeJsonPathError("missing ']'");
+                    const auto parsed = NUtils::ParseJsonPathBracket(path.substr(start, pos - start), step);
+                    if (parsed.HasError()) return parsed.Error();
+                    ++pos;
+                } else {
+                    return NUtils::MakeJsonPathError("expected '.', '..' or '['");
+                }
+            }
+            return result;
+        }
+
+        constexpr auto GetSteps() const noexcept -> std::span<const JsonPathStep> {
+            return {Steps.data(), NSteps};
+        }
+
+        // Calls `onMatch` for every value matched by the path, in the document order.
+        // Returns the number of matches or the first error encountered in the document.
+        constexpr auto Evaluate(
+            const JsonValue& root,
+            std::invocable<const JsonValue&> auto&& onMatch
+        ) const -> Expected<size_t> {
+            size_t nMatches = 0;
+            if (NSteps == 0) {
+                onMatch(root);
+                return size_t{1};
+            }
+            if (const auto err = Walk(root, TStates{1}, onMatch, nMatches)) return *err;
+            return nMatches;
+        }
+        constexpr auto Evaluate(
+            const Expected<JsonValue>& root,
+            std::invocable<const JsonValue&> auto&& onMatch
+        ) const -> Expected<size_t> {
+            return root.HasValue() ? Evaluate(root.Value(), onMatch) : root.Error();
+        }
+    };
+} // namespace NJsonParser
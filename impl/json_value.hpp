@@ -7,6 +7,8 @@
 #include "utils.hpp"
 
 #include <charconv>
+#include <limits>
+#include <type_traits>
 
 
 namespace NJsonParser {
@@ -46,7 +48,14 @@ namespace NJsonParser {
                     NError::ErrorCode::TypeError,
                     "expected int, got something else"
                 );
-                result = result * 10 + (ch - '0') * sign;
+                const auto digit = ch - '0';
+                // Like `std::from_chars`, report the integers that don't fit into `Int`
+                if (isNegative ? result < (std::numeric_limits<Int>::min() + digit) / 10
+                               : result > (std::numeric_limits<Int>::max() - digit) / 10) return MakeError(
+                    LpCounter,
+                    NError::ErrorCode::ResultOutOfRangeError
+                );
+                result = result * 10 + digit * sign;
             }
         } else {
             // At run-time we use the fast library function `std::from_chars`
@@ -69,19 +78,32 @@ namespace NJsonParser {
     template <> constexpr auto JsonValue::As<Float>() const noexcept -> Expected<Float> {
         if (std::is_constant_evaluated()) {
             // At compile-time we have to parse a double by hand
+            const auto parseIntegral = [](std::string_view digits) -> Expected<Float> {
+                const auto intOrErr = JsonValue{digits}.As<Int>();
+                if (intOrErr.HasValue()) return static_cast<double>(intOrErr.Value());
+                if (intOrErr.Error().BasicInfo.Code != NError::ErrorCode::ResultOutOfRangeError) return intOrErr.Error();
+                // An integer that doesn't fit into `Int` is still a valid double
+                const auto isNegative = (digits.front() == '-');
+                double result = 0;
+                for (const auto ch : digits.substr(isNegative ? 1 : 0)) {
+                    if (ch < '0' || '9' < ch) return MakeError({}, NError::ErrorCode::TypeError);
+                    result = result * 10 + (ch - '0');
+                }
+                return isNegative ? -result : result;
+            };
             const auto dotPosition = Data.find_first_of('.');
             if (dotPosition == std::string_view::npos || dotPosition == Data.size() - 1) {
-                auto intOrErr = JsonValue{Data.substr(0, dotPosition)}.As<Int>();
-                if (intOrErr.HasError()) return MakeError(
+                auto floatOrErr = parseIntegral(Data.substr(0, dotPosition));
+                if (floatOrErr.HasError()) return MakeError(
                     LpCounter,
                     NError::ErrorCode::TypeError,
                     "expected double, got something else"
                 );
-                return static_cast<double>(intOrErr.Value());
+                return floatOrErr.Value();
             }
 
             // Parse the integral part:
-            auto intPartOrErr = JsonValue{Data.substr(0, dotPosition)}.As<Int>();
+            auto intPartOrErr = parseIntegral(Data.substr(0, dotPosition));
             if (intPartOrErr.HasError()) return intPartOrErr.Error();
             const auto intPart = intPartOrErr.Value();
 
@@ -238,6 +260,80 @@ namespace NJsonParser {
         return As<Mapping>()[key];
     }
 
+    constexpr auto JsonValue::Type() const noexcept -> JsonType {
+        if (Data.empty()) return JsonType::Missing;
+        switch (Data.front()) {
+            case 'n': return JsonType::Null;
+            case 't':
+            case 'f': return JsonType::Bool;
+            case '"': return JsonType::String;
+            case '[': return JsonType::Array;
+            case '{': return JsonType::Mapping;
+            case '-': return JsonType::Number;
+            default: return ('0' <= Data.front() && Data.front() <= '9') ? JsonType::Number : JsonType::Invalid;
+        }
+    }
+
+    // The type `JsonValue::Visit` returns: the common type of the results of all the calls it can make
+    template <class TVisitor>
+    using VisitResult = std::common_type_t<
+        std::invoke_result_t<TVisitor&, const Null&>,
+        std::invoke_result_t<TVisitor&, const Bool&>,
+        std::invoke_result_t<TVisitor&, const Int&>,
+        std::invoke_result_t<TVisitor&, const Float&>,
+        std::invoke_result_t<TVisitor&, const String&>,
+        std::invoke_result_t<TVisitor&, const Array&>,
+        std::invoke_result_t<TVisitor&, const Mapping&>,
+        std::invoke_result_t<TVisitor&, const NError::Error&>
+    >;
+
+    template <class TVisitor>
+    constexpr auto JsonValue::Visit(TVisitor&& visitor) const -> decltype(auto) {
+        using TResult = VisitResult<TVisitor>;
+        const auto call = [&visitor](const auto& arg) -> TResult { return visitor(arg); };
+        const auto visit = [&call]<class T>(const Expected<T>& value) -> TResult {
+            return value.HasValue() ? call(value.Value()) : call(value.Error());
+        };
+        switch (Type()) {
+            case JsonType::Missing:
+                return call(MakeError(LpCounter, NError::ErrorCode::MissingValueError));
+            case JsonType::Null:
+                if (Data == "null") return call(Null{});
+                return call(MakeError(LpCounter, NError::ErrorCode::TypeError, "expected null, got something else"));
+            case JsonType::Bool:
+                return visit(As<Bool>());
+            case JsonType::Number:
+                if (Data.find_first_of(".eE") != std::string_view::npos) return visit(As<Float>());
+                // Integers that don't fit into `Int` are visited as `Float`, like `ToBinary` stores them
+                if (std::is_constant_evaluated()) {
+                    const auto intOrErr = As<Int>();
+                    if (intOrErr.HasError() && intOrErr.Error().BasicInfo.Code == NError::ErrorCode::ResultOutOfRangeError) {
+                        return visit(As<Float>());
+                    }
+                    return visit(intOrErr);
+                } else {
+                    // At run-time, without making the error that `As<Int>()` would make for them
+                    Int result = 0;
+                    const auto [_, ec] = std::from_chars(Data.data(), Data.data() + Data.size(), result, 10);
+                    if (ec == std::errc{}) return call(result);
+                    if (ec == std::errc::result_out_of_range) return visit(As<Float>());
+                    return visit(As<Int>());
+                }
+            case JsonType::String:
+                return visit(As<String>());
+            case JsonType::Array:
+                return visit(As<Array>());
+            case JsonType::Mapping:
+                return visit(As<Mapping>());
+            default:
+                return call(MakeError(
+                    LpCounter,
+                    NError::ErrorCode::TypeError,
+                    "a value is neither a string, a number, a bool, null, an array nor a mapping"
+                ));
+        }
+    }
+
     // The following boilerplate is needed for syntactically nice
     // monadic operations support:
     template <> constexpr auto Expected<JsonValue>::As<Bool>() const -> Expected<Bool> {
@@ -264,4 +360,9 @@ namespace NJsonParser {
     constexpr auto Expected<JsonValue>::operator[](std::string_view key) const -> Expected<JsonValue> {
         return As<Mapping>()[key];
     }
+    template <class TVisitor>
+    constexpr auto Expected<JsonValue>::Visit(TVisitor&& visitor) const -> decltype(auto) {
+        if (HasError()) return static_cast<VisitResult<TVisitor>>(visitor(Error()));
+        return Value().Visit(visitor);
+    }
 } // namespace NJsonParser
@@ -0,0 +1,360 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "pointer.hpp"
+#include "utils.hpp"
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace NJsonParser::NUtils {
+    // The index of a single array or mapping: the values (and the keys) of its children,
+    // found by a single scan over the container with the regular iterators. The tables
+    // of the children that are containers themselves are built lazily and published into
+    // `ChildTables` by `LazyDocumentIndex`.
+    struct LazyContainerTable {
+        struct Child {
+            std::string_view Key;
+            uint64_t KeyHash;
+            JsonValue Value;
+        };
+        bool IsMapping = false;
+        // The children are scanned up to the first error; looking up something that is
+        // not among the scanned children reports this error, just like `operator[]` of
+        // `Array` and `Mapping` does, since it would have encountered the error first
+        std::optional<NError::Error> ScanError;
+        std::pmr::vector<Child> Children;
+        // Same as `NIndex::ContainerRecord::FirstKeySlot`, but with a table per container
+        std::pmr::vector<uint32_t> KeySlots;
+        // One slot per child, allocated once the number of children is known
+        std::span<std::atomic<LazyContainerTable*>> ChildTables;
+
+        LazyContainerTable(const JsonValue& container, std::pmr::polymorphic_allocator<> allocator)
+            : Children(allocator), KeySlots(allocator)
+        {
+            const auto data = container.GetData();
+            IsMapping = !data.empty() && data.front() == '{';
+            if (IsMapping) {
+                const auto mapping = container.As<Mapping>();
+                if (mapping.HasError()) ScanError = mapping.Error();
+                else {
+                    auto it = mapping.begin();
+                    for (; it != mapping.end(); ++it) {
+                        const auto [k, v] = *it;
+                        if (k.HasError() || v.HasError()) {
+                            ScanError = k.HasError() ? k.Error() : v.Error();
+                            break;
+                        }
+                        Children.push_back({k.Value(), Hash(k.Value()), v.Value()});
+                    }
+                    if (!ScanError && it.HasError()) ScanError = it.Error();
+                }
+            } else {
+                const auto array = container.As<Array>();
+                if (array.HasError()) ScanError = array.Error();
+                else {
+                    auto it = array.begin();
+                    for (; it != array.end(); ++it) {
+                        const auto elem = *it;
+                        if (elem.HasError()) {
+                            ScanError = elem.Error();
+                            break;
+                        }
+                        Children.push_back({{}, 0, elem.Value()});
+                    }
+                    if (!ScanError && it.HasError()) ScanError = it.Error();
+                }
+            }
+            ChildTables = {allocator.allocate_object<std::atomic<LazyContainerTable*>>(Children.size()), Children.size()};
+            for (auto& childTable : ChildTables) std::construct_at(&childTable, nullptr);
+            if (IsMapping && Children.size() >= NIndex::kMinKeysForTable) BuildKeyTable();
+        }
+
+        LazyContainerTable(const LazyContainerTable&) = delete;
+        auto operator=(const LazyContainerTable&) -> LazyContainerTable& = delete;
+
+        ~LazyContainerTable() {
+            auto allocator = std::pmr::polymorphic_allocator<>{Children.get_allocator()};
+            for (auto& childTable : ChildTables) {
+                if (const auto table = childTable.load(std::memory_order_acquire)) allocator.delete_object(table);
+                std::destroy_at(&childTable);
+            }
+            allocator.deallocate_object(ChildTables.data(), ChildTables.size());
+        }
+
+        auto BuildKeyTable() -> void {
+            const auto nSlots = std::bit_ceil(2 * Children.size());
+            KeySlots.assign(nSlots, 0);
+            for (size_t i = 0; i != Children.size(); ++i) {
+                auto slot = Children[i].KeyHash & (nSlots - 1);
+                for (; KeySlots[slot] != 0; slot = (slot + 1) & (nSlots - 1)) {
+                    const auto& other = Children[KeySlots[slot] - 1];
+                    // Only the first occurrence of a key is reachable by lookups
+                    if (other.KeyHash == Children[i].KeyHash && other.Key == Children[i].Key) break;
+                }
+                if (KeySlots[slot] == 0) KeySlots[slot] = static_cast<uint32_t>(i + 1);
+            }
+        }
+
+        // Returns the index of the first child whose key matches, or `NIndex::kNone`
+        auto FindChild(uint64_t keyHash, auto&& matches) const noexcept -> uint64_t {
+            const auto keyMatches = [&](uint64_t i) {
+                return Children[i].KeyHash == keyHash && matches(Children[i].Key);
+            };
+            if (KeySlots.empty()) {
+                for (uint64_t i = 0; i != Children.size(); ++i) {
+                    if (keyMatches(i)) return i;
+                }
+                return NIndex::kNone;
+            }
+            const auto mask = KeySlots.size() - 1;
+            for (auto slot = keyHash & mask;; slot = (slot + 1) & mask) {
+                if (KeySlots[slot] == 0) return NIndex::kNone;
+                if (keyMatches(KeySlots[slot] - 1)) return KeySlots[slot] - 1;
+            }
+        }
+    };
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    class LazyDocumentIndex;
+
+    // A json value that is navigated with the help of a `LazyDocumentIndex`: the first access to
+    // a child of an array or a mapping scans the container once and publishes its table, and all
+    // the following accesses, from any thread, take O(1) time. Errors are reported in the same way
+    // as by `JsonValue`. Refers to the index it was obtained from, which must outlive it.
+    class LazyIndexedValue {
+    private:
+        using TTable = NUtils::LazyContainerTable;
+        const LazyDocumentIndex* Index;
+        // Where the table of this container is (or is going to be) published, `nullptr` for scalars
+        std::atomic<TTable*>* TableSlot;
+        JsonValue Value;
+    private:
+        LazyIndexedValue(const LazyDocumentIndex& index, std::atomic<TTable*>* tableSlot, JsonValue value) noexcept
+            : Index(&index), TableSlot(tableSlot), Value(value) {}
+        friend class LazyDocumentIndex;
+
+        auto GetTable() const -> const TTable&;
+        auto MakeChild(const TTable& table, uint64_t childIdx) const noexcept -> LazyIndexedValue;
+        auto Find(std::string_view requestedKey, uint64_t keyHash, auto&& matches) const -> Expected<LazyIndexedValue>;
+    public:
+        // The value itself, e.g. for iteration with `.As<Array>()` or `.As<Mapping>()`
+        auto GetJsonValue() const noexcept -> JsonValue {
+            return Value;
+        }
+        template <CJsonType T> auto As() const noexcept -> Expected<T> {
+            return Value.As<T>();
+        }
+        // The number of elements of an array or of (key, value) pairs of a mapping.
+        // Unlike `Array::size()`, reports an error if the container is malformed
+        auto size() const -> Expected<size_t>;
+        // Same effect as `.GetJsonValue()[idx]`
+        auto operator[](size_t idx) const -> Expected<LazyIndexedValue>;
+        // Same effect as `.GetJsonValue()[key]`
+        auto operator[](std::string_view key) const -> Expected<LazyIndexedValue>;
+        // Applies a segment of a json pointer, see `IndexedValue::operator[]`
+        auto operator[](const PointerSegment& segment) const -> Expected<LazyIndexedValue>;
+    };
+
+    // The specialization of `Expected` class template for `LazyIndexedValue`
+    template <>
+    struct Expected<LazyIndexedValue> : public ExpectedMixin<LazyIndexedValue> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<LazyIndexedValue>::ExpectedMixin;
+        // Monadic methods specific to `Expected<LazyIndexedValue>`:
+        template <CJsonType T> auto As() const -> Expected<T> {
+            return HasValue() ? Value().As<T>() : Error();
+        }
+        auto size() const -> Expected<size_t> {
+            return HasValue() ? Value().size() : Error();
+        }
+        auto operator[](size_t idx) const -> Expected<LazyIndexedValue> {
+            return HasValue() ? Value()[idx] : Error();
+        }
+        auto operator[](std::string_view key) const -> Expected<LazyIndexedValue> {
+            return HasValue() ? Value()[key] : Error();
+        }
+        auto operator[](const PointerSegment& segment) const -> Expected<LazyIndexedValue> {
+            return HasValue() ? Value()[segment] : Error();
+        }
+    };
+
+    // A document index that is built lazily, one container at a time, and is shared by all
+    // the threads reading the document:
+    //
+    //     const auto index = LazyDocumentIndex{json};
+    //     // in any number of threads:
+    //     const auto name = index.Root()["params"]["compilers"][1]["name"].As<String>();
+    //
+    // The table of a container is built on the first access to one of its children and is
+    // published with a single compare-and-swap into a slot owned by the parent container, so
+    // readers never take locks. If several threads build the same table at the same time,
+    // all of them but one discard their copies and use the published one. Unlike `DocumentIndex`,
+    // only the containers that are actually accessed are ever scanned, and malformed parts of
+    // the document are only reported when accessed, like with `JsonValue`.
+    //
+    // The tables are allocated from `resource`, which must be thread-safe if the index is shared
+    // between threads (the default resource is). The index is neither copyable nor movable, since
+    // the values obtained from it refer to it.
+    class LazyDocumentIndex {
+    public:
+        struct Stats {
+            // The number of container tables built and published
+            size_t TablesBuilt = 0;
+            // The number of container tables built and discarded because another
+            // thread has published the same table first
+            size_t TablesDiscarded = 0;
+        };
+    private:
+        using TTable = NUtils::LazyContainerTable;
+        JsonValue RootValue;
+        std::pmr::polymorphic_allocator<> Allocator;
+        mutable std::atomic<TTable*> RootTable = nullptr;
+        mutable std::atomic<size_t> TablesBuilt = 0;
+        mutable std::atomic<size_t> TablesDiscarded = 0;
+        friend class LazyIndexedValue;
+    private:
+        static auto IsContainer(const JsonValue& value) noexcept -> bool {
+            const auto data = value.GetData();
+            return !data.empty() && (data.front() == '[' || data.front() == '{');
+        }
+
+        auto GetOrBuildTable(std::atomic<TTable*>& slot, const JsonValue& container) const -> const TTable& {
+            if (const auto table = slot.load(std::memory_order_acquire)) return *table;
+            auto allocator = Allocator;
+            const auto built = allocator.new_object<TTable>(container, allocator);
+            TTable* published = nullptr;
+            if (slot.compare_exchange_strong(published, built, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                TablesBuilt.fetch_add(1, std::memory_order_relaxed);
+                return *built;
+            }
+            allocator.delete_object(built);
+            TablesDiscarded.fetch_add(1, std::memory_order_relaxed);
+            return *published;
+        }
+
+        auto MakeValue(std::atomic<TTable*>& slot, const JsonValue& value) const noexcept -> LazyIndexedValue {
+            return LazyIndexedValue{*this, IsContainer(value) ? &slot : nullptr, value};
+        }
+    public:
+        explicit LazyDocumentIndex(
+            const JsonValue& root,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+        ) noexcept
+            : RootValue(root), Allocator(resource) {}
+
+        LazyDocumentIndex(const LazyDocumentIndex&) = delete;
+        auto operator=(const LazyDocumentIndex&) -> LazyDocumentIndex& = delete;
+
+        ~LazyDocumentIndex() {
+            if (const auto table = RootTable.load(std::memory_order_acquire)) {
+                auto allocator = Allocator;
+                allocator.delete_object(table);
+            }
+        }
+
+        auto Root() const noexcept -> LazyIndexedValue {
+            return MakeValue(RootTable, RootValue);
+        }
+
+        auto GetStats() const noexcept -> Stats {
+            return {
+                .TablesBuilt = TablesBuilt.load(std::memory_order_relaxed),
+                .TablesDiscarded = TablesDiscarded.load(std::memory_order_relaxed),
+            };
+        }
+    };
+
+    inline auto LazyIndexedValue::GetTable() const -> const TTable& {
+        return Index->GetOrBuildTable(*TableSlot, Value);
+    }
+
+    inline auto LazyIndexedValue::MakeChild(const TTable& table, uint64_t childIdx) const noexcept -> LazyIndexedValue {
+        return Index->MakeValue(table.ChildTables[childIdx], table.Children[childIdx].Value);
+    }
+
+    auto LazyIndexedValue::Find(
+        std::string_view requestedKey,
+        uint64_t keyHash,
+        auto&& matches
+    ) const -> Expected<LazyIndexedValue> {
+        if (!TableSlot || Value.GetData().front() != '{') {
+            const auto mapping = Value.As<Mapping>();
+            if (mapping.HasError()) return mapping.Error();
+        }
+        const auto& table = GetTable();
+        const auto childIdx = table.FindChild(keyHash, matches);
+        if (childIdx != NIndex::kNone) return MakeChild(table, childIdx);
+        if (table.ScanError) return *table.ScanError;
+        return MakeError(
+            Value.GetLpCounter(),
+            NError::ErrorCode::MappingKeyNotFound,
+            NError::MappingKeyNotFoundAdditionalInfo{requestedKey}
+        );
+    }
+
+    inline auto LazyIndexedValue::size() const -> Expected<size_t> {
+        if (!TableSlot) {
+            const auto array = Value.As<Array>();
+            if (array.HasError()) return array.Error();
+        }
+        const auto& table = GetTable();
+        if (table.ScanError) return *table.ScanError;
+        return table.Children.size();
+    }
+
+    inline auto LazyIndexedValue::operator[](size_t idx) const -> Expected<LazyIndexedValue> {
+        if (!TableSlot || Value.GetData().front() != '[') {
+            const auto array = Value.As<Array>();
+            if (array.HasError()) return array.Error();
+        }
+        const auto& table = GetTable();
+        if (idx < table.Children.size()) return MakeChild(table, idx);
+        if (table.ScanError) return *table.ScanError;
+        return MakeError(
+            Value.GetLpCounter(),
+            NError::ErrorCode::ArrayIndexOutOfRange,
+            NError::ArrayIndexOutOfRangeAdditionalInfo{
+                .Index = idx,
+                .ArrayLen = table.Children.size(),
+            }
+        );
+    }
+
+    inline auto LazyIndexedValue::operator[](std::string_view key) const -> Expected<LazyIndexedValue> {
+        return Find(key, NUtils::Hash(key), [key](std::string_view other) { return other == key; });
+    }
+
+    inline auto LazyIndexedValue::operator[](const PointerSegment& segment) const -> Expected<LazyIndexedValue> {
+        if (TableSlot && Value.GetData().front() == '[') {
+            if (!segment.IsIndex()) return MakeError(
+                Value.GetLpCounter(),
+                NError::ErrorCode::InvalidPointerError,
+                "json pointer refers to an array element with something that is not an array index"
+            );
+            return (*this)[segment.Index];
+        }
+        if (TableSlot) {
+            return Find(segment.Raw, segment.KeyHash, [&segment](std::string_view key) {
+                return segment.Matches(key);
+            });
+        }
+        const auto result = NUtils::ApplyPointerSegment(Value, segment);
+        if (result.HasError()) return result.Error();
+        return LazyIndexedValue{*Index, nullptr, result.Value()};
+    }
+} // namespace NJsonParser
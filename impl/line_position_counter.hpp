@@ -25,5 +25,6 @@ namespace NJsonParser {
             for (char ch : str) Process(ch);
             return *this;
         }
+        constexpr auto operator==(const LinePositionCounter& other) const noexcept -> bool = default;
     };
 }
@@ -53,6 +53,13 @@ namespace NJsonParser {
             return copy;
         }
         constexpr auto operator==(const Iterator& other) const -> bool = default;
+        // Same as `Array::Iterator::HasError()` and `Array::Iterator::Error()`
+        constexpr auto HasError() const -> bool {
+            return KeyIter.HasError() || ValIter.HasError();
+        }
+        constexpr auto Error() const -> const NError::Error& {
+            return KeyIter.HasError() ? KeyIter.Error() : ValIter.Error();
+        }
     };
 
     constexpr auto Mapping::begin() const noexcept -> Iterator { 
@@ -70,13 +77,15 @@ namespace NJsonParser {
         );
     }
 
-    constexpr auto Mapping::operator[](std::string_view key) const noexcept -> Expected<JsonValue> { 
+    constexpr auto Mapping::Find(std::string_view key, bool sortedKeys) const noexcept -> Expected<JsonValue> {
         auto it = begin();
-        for (; it != end(); ++it) {
+        for (const auto endIt = end(); it != endIt; ++it) {
             const auto [k, v] = *it;
             if (k == key) return v;
             if (k.HasError()) return k.Error();
             if (v.HasError()) return v.Error();
+            // The key can't be further in a sorted mapping
+            if (sortedKeys && k.Value() > key) break;
         }
         if (it.KeyIter.HasError()) return it.KeyIter.Error();
         if (it.ValIter.HasError()) return it.ValIter.Error();
@@ -87,7 +96,17 @@ namespace NJsonParser {
         );
     }
 
+    constexpr auto Mapping::operator[](std::string_view key) const noexcept -> Expected<JsonValue> { 
+        return Find(key, false);
+    }
+
+    constexpr auto Mapping::FindSorted(std::string_view key) const noexcept -> Expected<JsonValue> {
+        return Find(key, true);
+    }
+
     constexpr auto Mapping::size() const noexcept -> size_t {
+        // Only malformed contents need the iterators to find out how many elements come before the error
+        if (const auto n = NUtils::CountElements(Data, true)) return *n;
         return std::distance(begin(), end());
     }
 
@@ -104,6 +123,11 @@ namespace NJsonParser {
         return HasValue() ? Value()[key] : Error();
     }
 
+    constexpr auto Expected<Mapping>::FindSorted(std::string_view key) const noexcept
+    -> Expected<JsonValue> {
+        return HasValue() ? Value().FindSorted(key) : Error();
+    }
+
     constexpr auto Expected<Mapping>::size() const noexcept -> Expected<size_t> {
         return HasValue() ? Expected<size_t>{Value().size()} : Error();
     }
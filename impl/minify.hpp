@@ -0,0 +1,148 @@
+#pragma once
+
+
+#include "error.hpp"
+#include "expected.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace NJsonParser::NUtils {
+    // Json whitespace (unlike `IsSpace`, includes '\r', which is allowed by the json standard)
+    constexpr auto IsJsonWhitespace(char ch) noexcept -> bool {
+        return ch == ' ' || ch == '\n' || ch == '\t' || ch == '\r';
+    }
+
+    // The state of a minification that can be continued from any position
+    struct MinifyState {
+        size_t InPos = 0;
+        size_t OutPos = 0;
+        bool InsideString = false;
+    };
+
+    // Minifies one character at a time; works both at compile- and run-time
+    constexpr auto MinifyScalar(std::string_view in, char* out, MinifyState state) noexcept -> MinifyState {
+        auto& [i, o, insideString] = state;
+        while (i != in.size()) {
+            const auto ch = in[i++];
+            if (insideString) {
+                out[o++] = ch;
+                if (ch == '\\' && i != in.size()) out[o++] = in[i++];
+                else if (ch == '"') insideString = false;
+            } else if (!IsJsonWhitespace(ch)) {
+                out[o++] = ch;
+                if (ch == '"') insideString = true;
+            }
+        }
+        return state;
+    }
+
+#if defined(__SSE2__)
+    // Minifies 16 characters at a time: chunks without whitespace and the contents of strings
+    // are copied with a single store, and whitespace is dropped by a loop over the set bits of the
+    // mask of the characters to keep (which is cheap for indentation, the most common whitespace).
+    // Writes up to 16 bytes ahead of the output position, but never ahead of the input
+    // position, so `out` must be at least as large as `in`
+    inline auto MinifySse2(std::string_view in, char* out) noexcept -> MinifyState {
+        auto state = MinifyState{};
+        auto& [i, o, insideString] = state;
+        const auto quote = _mm_set1_epi8('"');
+        const auto backslash = _mm_set1_epi8('\\');
+        const auto space = _mm_set1_epi8(' ');
+        const auto newline = _mm_set1_epi8('\n');
+        const auto tab = _mm_set1_epi8('\t');
+        const auto carriageReturn = _mm_set1_epi8('\r');
+        while (i + 16 <= in.size()) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.data() + i));
+            const auto quotes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)));
+            if (insideString) {
+                const auto specials = quotes | static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), chunk);
+                if (!specials) {
+                    i += 16, o += 16;
+                    continue;
+                }
+                const auto n = static_cast<size_t>(std::countr_zero(specials));
+                i += n, o += n;
+                if (in[i] == '\\') {
+                    out[o++] = in[i++];
+                    if (i != in.size()) out[o++] = in[i++];
+                } else {
+                    out[o++] = in[i++];
+                    insideString = false;
+                }
+                continue;
+            }
+            const auto whitespace = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, tab), _mm_cmpeq_epi8(chunk, carriageReturn))
+            )));
+            // Only the characters before the first quote are processed here
+            const auto n = quotes ? static_cast<size_t>(std::countr_zero(quotes)) : size_t{16};
+            const auto prefix = (uint32_t{1} << n) - 1;
+            if (!(whitespace & prefix)) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), chunk);
+                o += n;
+            } else {
+                const auto keep = ~whitespace & prefix;
+                for (auto bits = keep; bits; bits &= bits - 1) out[o++] = in[i + std::countr_zero(bits)];
+            }
+            i += n;
+            if (n != 16) {
+                out[o++] = in[i++];
+                insideString = true;
+            }
+        }
+        return state;
+    }
+#endif
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Removes all the whitespace outside of strings from the json document `in`, writing the
+    // result to `out` and returning the part of `out` that has been written. The contents of
+    // strings (including escape sequences) are copied as is, and the document is not validated.
+    // A minified document is quicker to navigate, because every access scans fewer characters.
+    // `out` must be at least as large as `in` (otherwise a `WriterError` is returned)
+    // and must not overlap with it.
+    // At run-time, the document is processed 16 characters at a time when SSE2 is available
+    constexpr auto Minify(std::string_view in, std::span<char> out) noexcept -> Expected<std::string_view> {
+        if (out.size() < in.size()) return MakeError(
+            {},
+            NError::ErrorCode::WriterError,
+            "the output buffer is too small"
+        );
+        auto state = NUtils::MinifyState{};
+#if defined(__SSE2__)
+        if (!std::is_constant_evaluated()) state = NUtils::MinifySse2(in, out.data());
+#endif
+        state = NUtils::MinifyScalar(in, out.data(), state);
+        return std::string_view{out.data(), state.OutPos};
+    }
+
+    // A minified copy of a document known at compile time:
+    //
+    //     static constexpr auto kMinified = MinifiedJson{R"({ "a": [1, 2, 3] })"};
+    //     constexpr auto json = JsonValue{kMinified.GetData()}; // {"a":[1,2,3]}
+    template <size_t kCapacity>
+    class MinifiedJson {
+    private:
+        std::array<char, kCapacity> Buffer = {};
+        size_t Size = 0;
+    public:
+        constexpr MinifiedJson(const char (&in)[kCapacity]) noexcept {
+            Size = Minify({in, kCapacity - 1}, Buffer).Value().size();
+        }
+        constexpr auto GetData() const noexcept -> std::string_view {
+            return {Buffer.data(), Size};
+        }
+    };
+} // namespace NJsonParser
@@ -0,0 +1,343 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "pointer.hpp"
+#include "writer.hpp"
+
+#include <algorithm>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace NJsonParser {
+    // A set of changes to a json document, addressed by json pointers (see **Json pointers** section),
+    // which is applied by splicing: the unchanged byte ranges of the document are copied as is and only
+    // the new fragments are written, so the cost of applying a patch is that of copying the document
+    // (plus finding the changed values), not that of parsing and serializing it again:
+    //
+    //     const auto patched = Patch{}
+    //         .Replace("/auth/token", "\"<redacted>\"")
+    //         .Replace("/hops", std::to_string(hops + 1))
+    //         .Insert("/route/-", "\"gateway\"")
+    //         .Remove("/debug")
+    //         .Apply(json); // -> Expected<std::pmr::string>
+    //
+    // The new fragments are taken as already serialized json values (see `Writer`).
+    // `Insert` adds a new key to a mapping (it is an error if the key exists) or inserts an element
+    // into an array before the given index ("-" or the size of the array stand for the end).
+    // All the pointers refer to the original document, not to the result of the previous operations,
+    // so operations don't depend on their order, except that the values inserted at the same place
+    // appear in the order they were added. Operations that touch overlapping parts of the document
+    // (e.g. replacing a value and an element inside of it) are reported as `PatchError` errors.
+    // Unlike the parser, `Patch` is a run-time only facility, and it owns the pointers and the fragments.
+    // The operations, the temporary memory of `Apply` and its result are allocated from the memory
+    // resource the patch is constructed with, e.g. an `ArenaResource` reset once a request is forwarded.
+    class Patch {
+    private:
+        enum class EKind : uint8_t {
+            Replace,
+            Insert,
+            Remove,
+        };
+        struct Operation {
+            EKind Kind;
+            std::pmr::string Pointer;
+            std::pmr::string Json;
+        };
+        std::pmr::vector<Operation> Operations;
+
+        // Replaces the bytes in [Begin, End) of the original document with `Text`
+        struct Edit {
+            size_t Begin;
+            size_t End;
+            std::pmr::string Text;
+        };
+        // The state of a container some elements of which are inserted or removed
+        struct ContainerEdits {
+            struct Item {
+                size_t Begin;
+                size_t End;
+                String Key;
+                bool Removed = false;
+            };
+            const char* Data;
+            size_t Close;
+            bool IsMapping;
+            std::pmr::vector<Item> Items;
+            // Pairs of (the index of the item to insert before, the serialized element)
+            std::pmr::vector<std::pair<size_t, std::pmr::string>> Inserted;
+        };
+    private:
+        auto Resource() const noexcept -> std::pmr::memory_resource* {
+            return Operations.get_allocator().resource();
+        }
+
+        auto Add(EKind kind, std::string_view pointer, std::string_view json) -> Patch& {
+            Operations.push_back({
+                .Kind = kind,
+                .Pointer = std::pmr::string{pointer, Resource()},
+                .Json = std::pmr::string{json, Resource()},
+            });
+            return *this;
+        }
+
+        static auto MakePatchError(std::string_view info) -> NError::Error {
+            return MakeError({}, NError::ErrorCode::PatchError, info);
+        }
+
+        static auto Offset(std::string_view root, std::string_view part) -> size_t {
+            return static_cast<size_t>(part.data() - root.data());
+        }
+
+        static auto Unescape(const PointerSegment& segment, std::pmr::memory_resource* resource) -> std::pmr::string {
+            auto result = std::pmr::string{resource};
+            for (size_t pos = 0; pos != segment.Raw.size(); ++pos) {
+                auto ch = segment.Raw[pos];
+                if (ch == '~') ch = (segment.Raw[++pos] == '0' ? '~' : '/');
+                result += ch;
+            }
+            return result;
+        }
+
+        // Finds (or scans and adds) the container that is the parent of the value `pointer` refers to
+        static auto GetParent(
+            const JsonValue& root,
+            std::string_view pointer,
+            std::pmr::vector<ContainerEdits>& containers
+        ) -> Expected<ContainerEdits*> {
+            const auto lastSlash = pointer.rfind('/');
+            if (lastSlash == std::string_view::npos) return MakePatchError(
+                "only the elements of arrays and mappings can be inserted or removed"
+            );
+            const auto parent = root.AtPointer(pointer.substr(0, lastSlash));
+            if (parent.HasError()) return parent.Error();
+            const auto data = parent.Value().GetData();
+            for (auto& container : containers) {
+                if (container.Data == data.data()) return &container;
+            }
+            auto container = ContainerEdits{
+                .Data = data.data(),
+                .Close = Offset(root.GetData(), data) + data.size() - 1,
+                .IsMapping = !data.empty() && data.front() == '{',
+                .Items = std::pmr::vector<ContainerEdits::Item>{containers.get_allocator()},
+                .Inserted = std::pmr::vector<std::pair<size_t, std::pmr::string>>{containers.get_allocator()},
+            };
+            if (container.IsMapping) {
+                const auto mapping = parent.As<Mapping>();
+                auto it = mapping.begin();
+                for (; it != mapping.end(); ++it) {
+                    const auto [k, v] = *it;
+                    if (k.HasError()) return k.Error();
+                    if (v.HasError()) return v.Error();
+                    const auto key = k.Value();
+                    const auto value = v.Value().GetData();
+                    container.Items.push_back({
+                        .Begin = Offset(root.GetData(), key) - 1,
+                        .End = Offset(root.GetData(), value) + value.size(),
+                        .Key = key,
+                    });
+                }
+                if (it.HasError()) return it.Error();
+            } else {
+                const auto array = parent.As<Array>();
+                if (array.HasError()) return MakeError(
+                    parent.Value().GetLpCounter(),
+                    NError::ErrorCode::TypeError,
+                    "only the elements of arrays and mappings can be inserted or removed"
+                );
+                auto it = array.begin();
+                for (; it != array.end(); ++it) {
+                    const auto v = *it;
+                    if (v.HasError()) return v.Error();
+                    const auto value = v.Value().GetData();
+                    const auto begin = Offset(root.GetData(), value);
+                    container.Items.push_back({.Begin = begin, .End = begin + value.size(), .Key = {}});
+                }
+                if (it.HasError()) return it.Error();
+            }
+            containers.push_back(std::move(container));
+            return &containers.back();
+        }
+
+        static auto AddStructuralEdit(
+            const JsonValue& root,
+            const Operation& op,
+            std::pmr::vector<ContainerEdits>& containers
+        ) -> std::optional<NError::Error> {
+            const auto resource = containers.get_allocator().resource();
+            const auto parent = GetParent(root, op.Pointer, containers);
+            if (parent.HasError()) return parent.Error();
+            auto& container = *parent.Value();
+            auto pos = op.Pointer.rfind('/');
+            const auto parsed = NUtils::ParsePointerSegment(op.Pointer, pos);
+            if (parsed.HasError()) return parsed.Error();
+            const auto& segment = parsed.Value();
+
+            auto index = container.Items.size();
+            if (container.IsMapping) {
+                const auto found = std::find_if(container.Items.begin(), container.Items.end(), [&](const auto& item) {
+                    return segment.Matches(item.Key);
+                });
+                index = static_cast<size_t>(found - container.Items.begin());
+                if (op.Kind == EKind::Insert) {
+                    if (index != container.Items.size()) return MakePatchError("the inserted key already exists");
+                    auto writer = Writer{resource};
+                    const auto key = writer.Value(Unescape(segment, resource)).Finish();
+                    auto text = std::pmr::string{key.Value(), resource};
+                    text += ':';
+                    text += op.Json;
+                    container.Inserted.emplace_back(index, std::move(text));
+                    return std::nullopt;
+                }
+                if (index == container.Items.size()) return MakeError(
+                    {},
+                    NError::ErrorCode::MappingKeyNotFound,
+                    NError::MappingKeyNotFoundAdditionalInfo{segment.Raw}
+                );
+            } else {
+                const auto isEnd = (op.Kind == EKind::Insert && segment.Raw == "-");
+                if (!isEnd && !segment.IsIndex()) return MakeError(
+                    {},
+                    NError::ErrorCode::InvalidPointerError,
+                    "json pointer refers to an array element with something that is not an array index"
+                );
+                if (!isEnd) index = segment.Index;
+                const auto nValid = container.Items.size() + (op.Kind == EKind::Insert ? 1 : 0);
+                if (index >= nValid) return MakeError(
+                    {},
+                    NError::ErrorCode::ArrayIndexOutOfRange,
+                    NError::ArrayIndexOutOfRangeAdditionalInfo{.Index = index, .ArrayLen = container.Items.size()}
+                );
+                if (op.Kind == EKind::Insert) {
+                    container.Inserted.emplace_back(index, std::pmr::string{op.Json, resource});
+                    return std::nullopt;
+                }
+            }
+            if (container.Items[index].Removed) return MakePatchError("the same value is removed twice");
+            container.Items[index].Removed = true;
+            return std::nullopt;
+        }
+
+        // Turns the inserted and removed elements of a container into edits which touch
+        // only the removed elements and the separators, but not the elements that are kept,
+        // so that the values inside of the kept elements can still be changed
+        static auto AddContainerEdits(const ContainerEdits& container, std::pmr::vector<Edit>& edits) -> void {
+            const auto& items = container.Items;
+            const auto n = items.size();
+            const auto joined = [&](size_t from, size_t to, bool commaBefore, bool commaAfter) {
+                auto text = std::pmr::string{edits.get_allocator()};
+                for (const auto& [before, json] : container.Inserted) {
+                    if (before < from || before > to) continue;
+                    if (!text.empty() || commaBefore) text += ',';
+                    text += json;
+                }
+                if (!text.empty() && commaAfter) text += ',';
+                return text;
+            };
+            // The index of the last kept element, or `n` if there is none yet
+            auto prevKept = n;
+            for (size_t k = 0; k <= n; ++k) {
+                if (k != n && items[k].Removed) continue;
+                const auto first = (prevKept == n ? 0 : prevKept + 1);
+                const auto anyRemoved = (first != k);
+                const auto anyInserted = std::any_of(container.Inserted.begin(), container.Inserted.end(), [&](const auto& inserted) {
+                    return first <= inserted.first && inserted.first <= k;
+                });
+                if (anyRemoved || anyInserted) {
+                    if (k != n) {
+                        // Everything between the previous kept element and this one
+                        edits.push_back({items[first].Begin, items[k].Begin, joined(first, k, false, true)});
+                    } else if (prevKept != n) {
+                        // Everything after the last kept element
+                        edits.push_back({items[prevKept].End, items[n - 1].End, joined(first, k, true, false)});
+                    } else {
+                        // Nothing is kept
+                        const auto begin = (n == 0 ? container.Close : items[0].Begin);
+                        edits.push_back({begin, container.Close, joined(first, k, false, false)});
+                    }
+                }
+                prevKept = k;
+            }
+        }
+    public:
+        explicit Patch(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : Operations(resource) {}
+
+        // Replaces the value `pointer` refers to with `json`
+        auto Replace(std::string_view pointer, std::string_view json) -> Patch& {
+            return Add(EKind::Replace, pointer, json);
+        }
+        // Inserts `json` into the mapping or the array that is the parent of the value `pointer` refers to
+        auto Insert(std::string_view pointer, std::string_view json) -> Patch& {
+            return Add(EKind::Insert, pointer, json);
+        }
+        // Removes the value `pointer` refers to from its parent
+        auto Remove(std::string_view pointer) -> Patch& {
+            return Add(EKind::Remove, pointer, {});
+        }
+
+        auto size() const noexcept -> size_t {
+            return Operations.size();
+        }
+        auto Clear() noexcept -> void {
+            Operations.clear();
+        }
+
+        auto Apply(const JsonValue& root) const -> Expected<std::pmr::string> {
+            const auto data = root.GetData();
+            auto edits = std::pmr::vector<Edit>{Resource()};
+            auto containers = std::pmr::vector<ContainerEdits>{Resource()};
+            for (const auto& op : Operations) {
+                if (NUtils::StripSpaces(op.Json).empty() && op.Kind != EKind::Remove) {
+                    return MakePatchError("an empty json fragment");
+                }
+                if (op.Kind == EKind::Replace) {
+                    const auto target = root.AtPointer(op.Pointer);
+                    if (target.HasError()) return target.Error();
+                    const auto value = target.Value().GetData();
+                    const auto begin = Offset(data, value);
+                    edits.push_back({begin, begin + value.size(), std::pmr::string{op.Json, Resource()}});
+                } else if (const auto error = AddStructuralEdit(root, op, containers)) {
+                    return *error;
+                }
+            }
+            for (const auto& container : containers) AddContainerEdits(container, edits);
+
+            // Insertions (empty ranges) go before the replacements starting at the same place.
+            // Edits never have the same range unless they overlap, so the sort needn't be stable
+            // (and `std::stable_sort` would take its buffer from the global heap)
+            std::sort(edits.begin(), edits.end(), [](const Edit& lhs, const Edit& rhs) {
+                return lhs.Begin != rhs.Begin ? lhs.Begin < rhs.Begin : lhs.End < rhs.End;
+            });
+            auto size = data.size();
+            for (size_t i = 0; i != edits.size(); ++i) {
+                if (i != 0 && edits[i].Begin < edits[i - 1].End) {
+                    return MakePatchError("two operations change overlapping parts of the document");
+                }
+                size = size - (edits[i].End - edits[i].Begin) + edits[i].Text.size();
+            }
+
+            auto result = std::pmr::string{Resource()};
+            result.reserve(size);
+            size_t copied = 0;
+            for (const auto& edit : edits) {
+                result.append(data.data() + copied, edit.Begin - copied);
+                result += edit.Text;
+                copied = edit.End;
+            }
+            result.append(data.data() + copied, data.size() - copied);
+            return result;
+        }
+        auto Apply(const Expected<JsonValue>& root) const -> Expected<std::pmr::string> {
+            return root.HasValue() ? Apply(root.Value()) : root.Error();
+        }
+    };
+} // namespace NJsonParser
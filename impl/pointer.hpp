@@ -0,0 +1,248 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <compare>
+#include <limits>
+#include <span>
+#include <string>
+
+
+namespace NJsonParser {
+    // A single reference token of a json pointer (RFC 6901), e.g. "compilers" or "1"
+    // in "/params/compilers/1/name". Doesn't own any data: `Raw` is a view into
+    // the pointer string, with the escape sequences ("~0" for '~' and "~1" for '/') left as is.
+    struct PointerSegment {
+        static constexpr size_t kNotAnIndex = std::numeric_limits<size_t>::max();
+
+        std::string_view Raw;
+        // The length and the hash (see `NUtils::Hash`) of the unescaped segment,
+        // computed once, so that keys can be quickly checked before being compared
+        size_t KeyLen = 0;
+        uint64_t KeyHash = NUtils::kHashSeed;
+        // The value of the segment as an array index, or `kNotAnIndex` if
+        // the segment is not a valid array index (e.g. "-", "01" or "name")
+        size_t Index = kNotAnIndex;
+        bool HasEscapes = false;
+
+        constexpr auto IsIndex() const noexcept -> bool {
+            return Index != kNotAnIndex;
+        }
+        // Checks whether `key` is equal to the unescaped segment
+        constexpr auto Matches(std::string_view key) const noexcept -> bool {
+            if (key.size() != KeyLen) return false;
+            if (!HasEscapes) return key == Raw;
+            size_t i = 0;
+            for (size_t pos = 0; pos != Raw.size(); ++pos, ++i) {
+                auto ch = Raw[pos];
+                if (ch == '~') ch = (Raw[++pos] == '0' ? '~' : '/');
+                if (key[i] != ch) return false;
+            }
+            return true;
+        }
+        // Compares `key` with the unescaped segment, like `key <=> unescaped`
+        constexpr auto Compare(std::string_view key) const noexcept -> std::strong_ordering {
+            if (!HasEscapes) return key <=> Raw;
+            size_t i = 0;
+            for (size_t pos = 0; pos != Raw.size(); ++pos, ++i) {
+                auto ch = Raw[pos];
+                if (ch == '~') ch = (Raw[++pos] == '0' ? '~' : '/');
+                if (i == key.size()) return std::strong_ordering::less;
+                if (key[i] != ch) return static_cast<unsigned char>(key[i]) <=> static_cast<unsigned char>(ch);
+            }
+            return key.size() <=> i;
+        }
+        constexpr auto operator==(const PointerSegment& other) const noexcept -> bool = default;
+    };
+} // namespace NJsonParser
+
+namespace NJsonParser::NUtils {
+    // Parses the segment of `pointer` which starts right after the '/' at position `pos`
+    // and moves `pos` to the next '/' (or to the end of `pointer`)
+    constexpr auto ParsePointerSegment(
+        std::string_view pointer,
+        std::string_view::size_type& pos
+    ) -> Expected<PointerSegment> {
+        if (pos >= pointer.size() || pointer[pos] != '/') return MakeError(
+            {},
+            NError::ErrorCode::InvalidPointerError,
+            "a non-empty json pointer must start with '/'"
+        );
+        const auto start = ++pos;
+        auto segment = PointerSegment{};
+        size_t index = 0;
+        bool isIndex = true;
+        for (; pos != pointer.size() && pointer[pos] != '/'; ++pos) {
+            auto ch = pointer[pos];
+            if (ch == '~') {
+                if (pos + 1 == pointer.size() || (pointer[pos + 1] != '0' && pointer[pos + 1] != '1')) {
+                    return MakeError(
+                        {},
+                        NError::ErrorCode::InvalidPointerError,
+                        "'~' in a json pointer must be followed by either '0' or '1'"
+                    );
+                }
+                ch = (pointer[++pos] == '0' ? '~' : '/');
+                segment.HasEscapes = true;
+            }
+            segment.KeyHash = Hash({&ch, 1}, segment.KeyHash);
+            ++segment.KeyLen;
+            // An array index is either "0" or a sequence of digits that doesn't start with '0'
+            isIndex = isIndex && '0' <= ch && ch <= '9' && !(segment.KeyLen == 2 && index == 0)
+                   && index <= (PointerSegment::kNotAnIndex - 10) / 10;
+            if (isIndex) index = index * 10 + (ch - '0');
+        }
+        segment.Raw = pointer.substr(start, pos - start);
+        if (isIndex && segment.KeyLen != 0) segment.Index = index;
+        return segment;
+    }
+
+    // Appends '/' and `key` with the characters '~' and '/' escaped to the json pointer `pointer`
+    template <class TString>
+    constexpr auto AppendPointerSegment(TString& pointer, std::string_view key) -> void {
+        pointer += '/';
+        for (const auto ch : key) {
+            if (ch == '~') pointer += "~0";
+            else if (ch == '/') pointer += "~1";
+            else pointer += ch;
+        }
+    }
+
+    // Finds the value of the key matching `segment` in `mapping`. Reports errors
+    // in the same way as `Mapping::operator[]` does
+    constexpr auto FindInMapping(const Mapping& mapping, const PointerSegment& segment) -> Expected<JsonValue> {
+        if (!segment.HasEscapes) return mapping[segment.Raw];
+        auto it = mapping.begin();
+        for (; it != mapping.end(); ++it) {
+            const auto [k, v] = *it;
+            if (k.HasValue() && segment.Matches(k.Value())) return v;
+            if (k.HasError()) return k.Error();
+            if (v.HasError()) return v.Error();
+        }
+        if (it.HasError()) return it.Error();
+        return MakeError(
+            mapping.GetLpCounter(),
+            NError::ErrorCode::MappingKeyNotFound,
+            NError::MappingKeyNotFoundAdditionalInfo{segment.Raw}
+        );
+    }
+
+    // Applies a single segment of a json pointer to `value`, which
+    // is expected to be either an array or a mapping
+    constexpr auto ApplyPointerSegment(const JsonValue& value, const PointerSegment& segment) -> Expected<JsonValue> {
+        const auto data = value.GetData();
+        if (!data.empty() && data.front() == '[') {
+            if (!segment.IsIndex()) return MakeError(
+                value.GetLpCounter(),
+                NError::ErrorCode::InvalidPointerError,
+                "json pointer refers to an array element with something that is not an array index"
+            );
+            return value[segment.Index];
+        }
+        if (!data.empty() && data.front() == '{') {
+            const auto mapping = value.As<Mapping>();
+            if (mapping.HasError()) return mapping.Error();
+            return FindInMapping(mapping.Value(), segment);
+        }
+        if (data.empty()) return MakeError(
+            value.GetLpCounter(),
+            NError::ErrorCode::MissingValueError
+        );
+        return MakeError(
+            value.GetLpCounter(),
+            NError::ErrorCode::TypeError,
+            "json pointer refers to an element of something that is neither an array nor a mapping"
+        );
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    constexpr auto JsonValue::AtPointer(std::string_view pointer) const noexcept -> Expected<JsonValue> {
+        auto cur = *this;
+        for (auto pos = std::string_view::size_type{0}; pos != pointer.size();) {
+            const auto segment = NUtils::ParsePointerSegment(pointer, pos);
+            if (segment.HasError()) return segment.Error();
+            const auto next = NUtils::ApplyPointerSegment(cur, segment.Value());
+            if (next.HasError()) return next;
+            cur = next.Value();
+        }
+        return cur;
+    }
+
+    constexpr auto Expected<JsonValue>::AtPointer(std::string_view pointer) const -> Expected<JsonValue> {
+        return HasValue() ? Value().AtPointer(pointer) : Error();
+    }
+
+    // A json pointer that is parsed once and then can be evaluated against any number of documents
+    // without splitting and unescaping it again. Holds up to `kMaxSegments` segments in place,
+    // so it can be created at compile time from a string literal:
+    //
+    //     constexpr auto ptr = CompiledPointer<>::Compile("/params/compilers/1/name").Value();
+    //     const auto name = ptr.Evaluate(json).As<String>();
+    //
+    // Doesn't own any data: the string the pointer was compiled from must outlive it.
+    template <size_t kMaxSegments = 16>
+    class CompiledPointer {
+    private:
+        std::array<PointerSegment, kMaxSegments> Segments = {};
+        size_t NSegments = 0;
+    private:
+        constexpr CompiledPointer() noexcept = default;
+    public:
+        static constexpr auto Compile(std::string_view pointer) -> Expected<CompiledPointer> {
+            auto result = CompiledPointer{};
+            for (auto pos = std::string_view::size_type{0}; pos != pointer.size();) {
+                if (result.NSegments == kMaxSegments) return MakeError(
+                    {},
+                    NError::ErrorCode::InvalidPointerError,
+                    "json pointer has too many segments"
+                );
+                const auto segment = NUtils::ParsePointerSegment(pointer, pos);
+                if (segment.HasError()) return segment.Error();
+                result.Segments[result.NSegments++] = segment.Value();
+            }
+            return result;
+        }
+
+        constexpr auto GetSegments() const noexcept -> std::span<const PointerSegment> {
+            return {Segments.data(), NSegments};
+        }
+
+        constexpr auto Evaluate(const JsonValue& root) const noexcept -> Expected<JsonValue> {
+            auto cur = root;
+            for (const auto& segment : GetSegments()) {
+                const auto next = NUtils::ApplyPointerSegment(cur, segment);
+                if (next.HasError()) return next;
+                cur = next.Value();
+            }
+            return cur;
+        }
+        constexpr auto Evaluate(const Expected<JsonValue>& root) const noexcept -> Expected<JsonValue> {
+            return root.HasValue() ? Evaluate(root.Value()) : root.Error();
+        }
+
+        // Evaluates the pointer against a value that is able to apply pointer segments
+        // by itself, like `IndexedValue` (see `impl/document_index.hpp`), which uses
+        // the precomputed key hashes of the segments for its lookups
+        template <class TValue>
+        requires requires (const TValue& value, const PointerSegment& segment) {
+            { value[segment] } -> std::same_as<Expected<TValue>>;
+        }
+        constexpr auto Evaluate(const TValue& root) const noexcept -> Expected<TValue> {
+            auto cur = Expected<TValue>{root};
+            for (const auto& segment : GetSegments()) {
+                cur = cur.Value()[segment];
+                if (cur.HasError()) break;
+            }
+            return cur;
+        }
+    };
+} // namespace NJsonParser
@@ -0,0 +1,233 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "mapping.hpp"
+#include "pointer.hpp"
+
+#include <array>
+#include <limits>
+#include <span>
+
+
+namespace NJsonParser {
+    // A set of json pointers that are evaluated against a document all at once.
+    //
+    // The pointers are compiled into a prefix tree, so that the common prefixes of the pointers
+    // (like "/request/headers" in "/request/headers/host" and "/request/headers/accept") are
+    // looked up only once. Every array or mapping of the document is then walked over at most once,
+    // stopping as soon as all the children needed by the queries have been found; the subtrees
+    // that are not needed by any query are skipped by the bracket-balancing scanner without
+    // looking inside them.
+    //
+    // Holds up to `kMaxQueries` pointers and up to `kMaxNodes` prefix tree nodes in place,
+    // so it can be created at compile time. Doesn't own any data: the strings the pointers were
+    // compiled from must outlive it.
+    template <size_t kMaxQueries = 64, size_t kMaxNodes = 4 * kMaxQueries>
+    class QuerySet {
+    private:
+        static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+        struct Node {
+            PointerSegment Segment = {};
+            size_t FirstChild = kNone;
+            size_t NextSibling = kNone;
+            size_t NChildren = 0;
+            // The first of the queries that end at this node, the rest
+            // of them are linked through `NextQueryAtSameNode`
+            size_t FirstQuery = kNone;
+        };
+        std::array<Node, kMaxNodes> Nodes = {};
+        size_t NNodes = 1; // the root node always exists
+        std::array<size_t, kMaxQueries> NextQueryAtSameNode = {};
+        size_t NQueries = 0;
+    private:
+        constexpr QuerySet() noexcept = default;
+
+        constexpr auto SetResult(
+            size_t nodeIdx,
+            const Expected<JsonValue>& value,
+            std::span<Expected<JsonValue>> results
+        ) const -> void {
+            for (auto q = Nodes[nodeIdx].FirstQuery; q != kNone; q = NextQueryAtSameNode[q]) {
+                if (q < results.size()) results[q] = value;
+            }
+        }
+
+        constexpr auto EvaluateNode(
+            size_t nodeIdx,
+            const Expected<JsonValue>& value,
+            std::span<Expected<JsonValue>> results
+        ) const -> void {
+            SetResult(nodeIdx, value, results);
+            const auto& node = Nodes[nodeIdx];
+            if (node.NChildren == 0) return;
+            const auto forEachChild = [this, &node](auto&& callback) {
+                for (auto child = node.FirstChild; child != kNone; child = Nodes[child].NextSibling) {
+                    callback(child);
+                }
+            };
+            // Errors are propagated to all the queries below this node
+            // in the same way as by chained `operator[]` calls
+            if (value.HasError()) {
+                forEachChild([&](size_t child) { EvaluateNode(child, value, results); });
+                return;
+            }
+            const auto data = value.Value().GetData();
+            const auto isArray = !data.empty() && data.front() == '[';
+            const auto isMapping = !data.empty() && data.front() == '{';
+            // Neither an array nor a mapping, or all the children are
+            // non-indices applied to an array: nothing to walk over
+            auto found = std::array<bool, kMaxNodes>{};
+            size_t nToFind = 0;
+            forEachChild([&](size_t child) {
+                if (isMapping || (isArray && Nodes[child].Segment.IsIndex())) ++nToFind;
+                else {
+                    found[child] = true;
+                    EvaluateNode(child, NUtils::ApplyPointerSegment(value.Value(), Nodes[child].Segment), results);
+                }
+            });
+            if (nToFind == 0) return;
+            // The error to report for all the children that haven't been found
+            auto notFoundError = std::optional<NError::Error>{};
+            if (isArray) {
+                const auto array = value.Value().As<Array>();
+                if (array.HasError()) notFoundError = array.Error();
+                else {
+                    size_t i = 0;
+                    auto it = array.begin();
+                    for (; it != array.end() && nToFind != 0; ++it, ++i) {
+                        forEachChild([&](size_t child) {
+                            if (found[child] || Nodes[child].Segment.Index != i) return;
+                            found[child] = true;
+                            --nToFind;
+                            EvaluateNode(child, *it, results);
+                        });
+                    }
+                    if (it.HasError()) notFoundError = it.Error();
+                    else if (nToFind != 0) {
+                        // Report exactly the same error as `Array::operator[]` does
+                        forEachChild([&](size_t child) {
+                            if (found[child]) return;
+                            EvaluateNode(child, MakeError(
+                                array.Value().GetLpCounter(),
+                                NError::ErrorCode::ArrayIndexOutOfRange,
+                                NError::ArrayIndexOutOfRangeAdditionalInfo{
+                                    .Index = Nodes[child].Segment.Index,
+                                    .ArrayLen = i,
+                                }
+                            ), results);
+                        });
+                        return;
+                    }
+                }
+            } else {
+                const auto mapping = value.Value().As<Mapping>();
+                if (mapping.HasError()) notFoundError = mapping.Error();
+                else {
+                    auto it = mapping.begin();
+                    for (; it != mapping.end() && nToFind != 0; ++it) {
+                        const auto [k, v] = *it;
+                        if (k.HasError() || v.HasError()) {
+                            // `Mapping::operator[]` reports such errors for
+                            // all the keys that haven't been found yet
+                            notFoundError = k.HasError() ? k.Error() : v.Error();
+                            break;
+                        }
+                        forEachChild([&](size_t child) {
+                            if (found[child] || !Nodes[child].Segment.Matches(k.Value())) return;
+                            found[child] = true;
+                            --nToFind;
+                            EvaluateNode(child, v, results);
+                        });
+                    }
+                    if (!notFoundError && it.HasError()) notFoundError = it.Error();
+                    if (!notFoundError && nToFind != 0) {
+                        forEachChild([&](size_t child) {
+                            if (found[child]) return;
+                            EvaluateNode(child, MakeError(
+                                mapping.Value().GetLpCounter(),
+                                NError::ErrorCode::MappingKeyNotFound,
+                                NError::MappingKeyNotFoundAdditionalInfo{Nodes[child].Segment.Raw}
+                            ), results);
+                        });
+                        return;
+                    }
+                }
+            }
+            if (notFoundError) forEachChild([&](size_t child) {
+                if (!found[child]) EvaluateNode(child, *notFoundError, results);
+            });
+        }
+    public:
+        // Compiles all the pointers from `pointers` into a query set,
+        // the i-th pointer becoming the i-th query
+        static constexpr auto Compile(std::span<const std::string_view> pointers) -> Expected<QuerySet> {
+            auto result = QuerySet{};
+            for (const auto pointer : pointers) {
+                const auto added = result.Add(pointer);
+                if (added.HasError()) return added.Error();
+            }
+            return result;
+        }
+
+        // Adds a pointer to the query set. Returns the index of the added query
+        constexpr auto Add(std::string_view pointer) -> Expected<size_t> {
+            if (NQueries == kMaxQueries) return MakeError(
+                {},
+                NError::ErrorCode::InvalidPointerError,
+                "too many json pointers in a query set"
+            );
+            size_t nodeIdx = 0;
+            for (auto pos = std::string_view::size_type{0}; pos != pointer.size();) {
+                const auto segment = NUtils::ParsePointerSegment(pointer, pos);
+                if (segment.HasError()) return segment.Error();
+                auto child = Nodes[nodeIdx].FirstChild;
+                while (child != kNone && Nodes[child].Segment.Raw != segment.Value().Raw) {
+                    child = Nodes[child].NextSibling;
+                }
+                if (child == kNone) {
+                    if (NNodes == kMaxNodes) return MakeError(
+                        {},
+                        NError::ErrorCode::InvalidPointerError,
+                        "too many distinct json pointer prefixes in a query set"
+                    );
+                    // Children are linked in the order of addition
+                    child = NNodes++;
+                    Nodes[child].Segment = segment.Value();
+                    auto* link = &Nodes[nodeIdx].FirstChild;
+                    while (*link != kNone) link = &Nodes[*link].NextSibling;
+                    *link = child;
+                    ++Nodes[nodeIdx].NChildren;
+                }
+                nodeIdx = child;
+            }
+            auto* link = &Nodes[nodeIdx].FirstQuery;
+            while (*link != kNone) link = &NextQueryAtSameNode[*link];
+            *link = NQueries;
+            NextQueryAtSameNode[NQueries] = kNone;
+            return NQueries++;
+        }
+
+        // The number of queries in the set
+        constexpr auto size() const noexcept -> size_t {
+            return NQueries;
+        }
+
+        // Evaluates all the queries against `root` in one pass. The result of the i-th query
+        // (which is the same as the result of `root.AtPointer(...)` for the i-th pointer) is
+        // written to `results[i]`; the results of the queries that don't fit into `results` are dropped.
+        constexpr auto Evaluate(const JsonValue& root, std::span<Expected<JsonValue>> results) const -> void {
+            EvaluateNode(0, root, results);
+        }
+        constexpr auto Evaluate(
+            const Expected<JsonValue>& root,
+            std::span<Expected<JsonValue>> results
+        ) const -> void {
+            EvaluateNode(0, root, results);
+        }
+    };
+} // namespace NJsonParser
@@ -0,0 +1,622 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "array.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "line_position_counter.hpp"
+#include "mapping.hpp"
+#include "simd.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace NJsonParser {
+    class SegmentedDocument;
+    template <class TContainer> class SegmentedIterator;
+    template <class TContainer> struct SegmentedRange;
+
+    // A json value of a `SegmentedDocument`. A value that lies within a single segment is
+    // a plain `JsonValue` viewing the segment, and everything about it is delegated to that
+    // `JsonValue`; the containers that straddle the boundaries between segments are navigated
+    // and iterated over by scanning across the segments, and only the scalars that straddle
+    // them are copied into contiguous memory owned by the document, once, when they are read.
+    // Errors are the same as those of `JsonValue` for the concatenation of the segments.
+    // Refers to the document it was obtained from, which must outlive it.
+    class SegmentedValue {
+    private:
+        const SegmentedDocument* Document = nullptr;
+        // The value itself, if it lies within a single segment (or is a copy)
+        std::optional<JsonValue> Contiguous;
+        // Where the value is in the concatenation of the segments, if it straddles a boundary
+        size_t Begin = 0;
+        size_t End = 0;
+        LinePositionCounter LpCounter;
+    private:
+        SegmentedValue() = default;
+        SegmentedValue(const SegmentedDocument& document, JsonValue value) noexcept
+            : Document(&document), Contiguous(value) {}
+        SegmentedValue(const SegmentedDocument& document, size_t begin, size_t end, LinePositionCounter lpCounter) noexcept
+            : Document(&document), Begin(begin), End(end), LpCounter(lpCounter) {}
+        friend class SegmentedDocument;
+        template <class TContainer> friend class SegmentedIterator;
+
+        auto Wrap(const Expected<JsonValue>& value) const -> Expected<SegmentedValue>;
+        // Whether a straddling value starts with `opening` and ends with `closing`
+        auto IsEnclosedIn(char opening, char closing) const noexcept -> bool;
+        // Same as `.As<String>() == str`, but a straddling string is compared
+        // segment by segment, and is only copied to report the error if it is malformed
+        auto IsString(std::string_view str) const -> Expected<bool>;
+    public:
+        // Whether the value lies within a single segment, so that nothing about it is ever copied
+        auto IsContiguous() const noexcept -> bool {
+            return Contiguous.has_value();
+        }
+        // The value itself. Copies a straddling value (once: the copy is reused by the later
+        // calls), so the containers are better iterated over with `Elements()` and `Items()`
+        auto GetJsonValue() const -> JsonValue;
+        // Same as `JsonValue::Type()`, never copies anything
+        auto Type() const noexcept -> JsonType;
+        // Same as `.GetJsonValue().As<T>()`: only straddling values are copied
+        template <CJsonType T> auto As() const -> Expected<T> {
+            return GetJsonValue().As<T>();
+        }
+        // The number of elements of an array or of (key, value) pairs of a mapping
+        auto size() const -> Expected<size_t>;
+        // Same as iterating over `.As<Array>()`, but without copying a straddling array
+        auto Elements() const -> SegmentedRange<Array>;
+        // Same as iterating over `.As<Mapping>()`, but without copying a straddling mapping
+        auto Items() const -> SegmentedRange<Mapping>;
+        // Same effect as `.GetJsonValue()[idx]`
+        auto operator[](size_t idx) const -> Expected<SegmentedValue>;
+        // Same effect as `.GetJsonValue()[key]`
+        auto operator[](std::string_view key) const -> Expected<SegmentedValue>;
+    };
+
+    // The specialization of `Expected` class template for `SegmentedValue`
+    template <>
+    struct Expected<SegmentedValue> : public ExpectedMixin<SegmentedValue> {
+        // Bring constructor from mixin to class scope:
+        using ExpectedMixin<SegmentedValue>::ExpectedMixin;
+        // Monadic methods specific to `Expected<SegmentedValue>`:
+        template <CJsonType T> auto As() const -> Expected<T> {
+            return HasValue() ? Value().As<T>() : Error();
+        }
+        auto size() const -> Expected<size_t> {
+            return HasValue() ? Value().size() : Error();
+        }
+        auto operator[](size_t idx) const -> Expected<SegmentedValue> {
+            return HasValue() ? Value()[idx] : Error();
+        }
+        auto operator[](std::string_view key) const -> Expected<SegmentedValue> {
+            return HasValue() ? Value()[key] : Error();
+        }
+        auto Elements() const -> SegmentedRange<Array>;
+        auto Items() const -> SegmentedRange<Mapping>;
+    };
+
+    // A (key, value) pair of a mapping, same as `Mapping::Iterator::value_type`
+    struct SegmentedItem {
+        Expected<String> Key;
+        Expected<SegmentedValue> Value;
+    };
+
+    // A document that is split across several buffers, like a request body received as a chain
+    // of network buffers, navigated without concatenating them first:
+    //
+    //     const auto segments = std::vector<std::string_view>{...};
+    //     const auto document = SegmentedDocument{segments};
+    //     const auto name = document.Root()["params"]["compilers"][1]["name"].As<String>();
+    //
+    // The structural scan runs over one segment at a time with the same SIMD kernels as for a
+    // contiguous document, carrying the open brackets and strings over the boundaries. The
+    // values that lie within a single segment are views of it, so a copy is only made for the
+    // rare scalar that straddles a boundary (and for a malformed container that does, to report
+    // the same error as `JsonValue`). Each value is copied at most once, the copies live as
+    // long as the document, and `GetStats()` tells how much was copied. The tables of the
+    // segments and the copies are allocated from the memory resource the document is
+    // constructed with, e.g. an `ArenaResource` (see `impl/arena.hpp`) that is reset once the
+    // request is handled.
+    //
+    // The segments must outlive the document. The document is neither copyable nor movable,
+    // since the values obtained from it refer to it, and, since reading a value can add a copy,
+    // it must not be read by several threads at the same time.
+    class SegmentedDocument {
+    public:
+        struct Stats {
+            // The number of values copied because they straddle a boundary between segments
+            size_t Copies = 0;
+            size_t CopiedBytes = 0;
+        };
+    private:
+        // Empty segments are left out
+        std::pmr::vector<std::string_view> Segments;
+        // `Offsets[i]` is where the segment `i` starts in the concatenation of the segments,
+        // and `Offsets.back()` is the size of the document
+        std::pmr::vector<size_t> Offsets;
+        // The copies of the straddling values by their (begin, end) positions. A map never moves
+        // its elements, so the values copied earlier stay valid (and allocates nothing until
+        // something is copied)
+        mutable std::pmr::map<std::pair<size_t, size_t>, std::pmr::string> Copies;
+        mutable size_t NCopies = 0;
+        mutable size_t CopiedBytes = 0;
+        SegmentedValue RootValue;
+        friend class SegmentedValue;
+        template <class TContainer> friend class SegmentedIterator;
+
+        // Same as `GenericSerializedSequenceIterator`, but over the contents of a container that
+        // straddles segments. An iterator that runs into an error stops, and the caller repeats
+        // the whole operation on a copy of the container to report the same error as `JsonValue`
+        struct SequenceIterator {
+            const SegmentedDocument* Document;
+            size_t End;
+            size_t ElemBegin = std::string_view::npos;
+            size_t ElemEnd = std::string_view::npos;
+            LinePositionCounter ElemBegLpCounter;
+            LinePositionCounter ElemEndLpCounter;
+            bool Failed = false;
+
+            SequenceIterator(const SegmentedDocument& document, size_t begin, size_t end, LinePositionCounter lpCounter, char delimiter)
+                : Document(&document), End(end), ElemBegLpCounter(lpCounter)
+            {
+                ElemBegin = Document->SkipSpaces(begin, End, ElemBegLpCounter);
+                ElemEndLpCounter = ElemBegLpCounter;
+                if (ElemBegin == End) {
+                    ElemBegin = std::string_view::npos;
+                    return;
+                }
+                FindElemEnd(delimiter);
+            }
+
+            auto IsEnd() const noexcept -> bool {
+                return ElemBegin == std::string_view::npos;
+            }
+
+            auto FindElemEnd(char delimiter) -> void {
+                const auto found = Document->FindAtZeroBalance(ElemBegin, End, ElemEndLpCounter, [delimiter](char ch) {
+                    return ch == delimiter || NUtils::IsSpace(ch);
+                });
+                if (!found) {
+                    Failed = true;
+                    ElemBegin = std::string_view::npos;
+                    return;
+                }
+                ElemEnd = *found == std::string_view::npos ? End : *found;
+            }
+
+            auto StepForward(char firstDelimiter, char secondDelimiter) -> SequenceIterator& {
+                if (IsEnd()) return *this;
+                const auto found = Document->FindAtZeroBalance(ElemEnd, End, ElemEndLpCounter, [firstDelimiter](char ch) {
+                    return ch == firstDelimiter;
+                });
+                if (found && *found != std::string_view::npos) {
+                    ElemBegin = Document->SkipSpaces(*found + 1, End, ElemEndLpCounter.Process(firstDelimiter));
+                }
+                ElemBegLpCounter = ElemEndLpCounter;
+                if (!found) Failed = true;
+                if (!found || *found == std::string_view::npos || ElemBegin == End) {
+                    ElemBegin = std::string_view::npos;
+                    return *this;
+                }
+                FindElemEnd(secondDelimiter);
+                return *this;
+            }
+
+            auto operator*() const -> SegmentedValue {
+                return Document->MakeValue(ElemBegin, ElemEnd, ElemBegLpCounter);
+            }
+        };
+    private:
+        // The segment with the character at `pos`
+        auto Locate(size_t pos) const noexcept -> size_t {
+            return static_cast<size_t>(std::upper_bound(Offsets.begin(), Offsets.end(), pos) - Offsets.begin()) - 1;
+        }
+
+        auto At(size_t pos) const noexcept -> char {
+            const auto segment = Locate(pos);
+            return Segments[segment][pos - Offsets[segment]];
+        }
+
+        auto MakeValue(size_t begin, size_t end, LinePositionCounter lpCounter) const noexcept -> SegmentedValue {
+            if (begin == end) return {*this, JsonValue{{}, lpCounter}};
+            const auto segment = Locate(begin);
+            if (end <= Offsets[segment + 1]) {
+                return {*this, JsonValue{Segments[segment].substr(begin - Offsets[segment], end - begin), lpCounter}};
+            }
+            return {*this, begin, end, lpCounter};
+        }
+
+        auto Copy(size_t begin, size_t end) const -> std::string_view {
+            const auto [it, inserted] = Copies.try_emplace({begin, end});
+            auto& copy = it->second;
+            if (!inserted) return copy;
+            ++NCopies;
+            copy.reserve(end - begin);
+            for (auto segment = Locate(begin); begin != end; ++segment) {
+                const auto to = std::min(end, Offsets[segment + 1]);
+                copy.append(Segments[segment].substr(begin - Offsets[segment], to - begin));
+                begin = to;
+            }
+            CopiedBytes += copy.size();
+            return copy;
+        }
+
+        // Whether the characters from `begin` to `end` are `str`, compared segment by segment
+        auto Equals(size_t begin, size_t end, std::string_view str) const noexcept -> bool {
+            if (end - begin != str.size()) return false;
+            for (auto segment = begin != end ? Locate(begin) : 0; begin != end; ++segment) {
+                const auto to = std::min(end, Offsets[segment + 1]);
+                const auto piece = Segments[segment].substr(begin - Offsets[segment], to - begin);
+                if (!str.starts_with(piece)) return false;
+                str.remove_prefix(piece.size());
+                begin = to;
+            }
+            return true;
+        }
+
+        // Same as `NUtils::SkipSpaces`, but across the segments, and returns `end` if there are
+        // only spaces
+        auto SkipSpaces(size_t pos, size_t end, LinePositionCounter& lpCounter) const noexcept -> size_t {
+            for (auto segment = pos != end ? Locate(pos) : 0; pos != end; ++segment) {
+                const auto to = std::min(end, Offsets[segment + 1]);
+                const auto next = NUtils::SkipSpaces(Segments[segment].substr(pos - Offsets[segment], to - pos), lpCounter);
+                if (next != std::string_view::npos) return pos + next;
+                pos = to;
+            }
+            return end;
+        }
+
+        // Same as `NUtils::FindFirstOfWithZeroBracketBalance`, but across the segments: the
+        // contents of strings and containers are skipped by `NUtils::SkipNested` one segment at a
+        // time. Returns `std::string_view::npos` if there is no such character, and nothing on
+        // mismatched brackets or an unterminated string
+        auto FindAtZeroBalance(
+            size_t pos,
+            size_t end,
+            LinePositionCounter& lpCounter,
+            auto&& predicate
+        ) const -> std::optional<size_t> {
+            auto stack = NUtils::BracketStack{};
+            bool insideString = false;
+            for (auto segment = pos != end ? Locate(pos) : 0; pos != end; ++segment) {
+                const auto to = std::min(end, Offsets[segment + 1]);
+                const auto* const data = Segments[segment].data();
+                const auto* const stop = data + (to - Offsets[segment]);
+                for (auto it = data + (pos - Offsets[segment]); it != stop; ++it) {
+                    if (insideString || !stack.Empty()) {
+                        auto newlines = NSimd::Newlines{};
+                        const auto next = NUtils::SkipNested(it, stop, stack, insideString, newlines);
+                        NUtils::ProcessSkipped(lpCounter, it, next, newlines);
+                        it = next;
+                        if (it == stop) break;
+                    }
+                    const auto ch = *it;
+                    if (ch == '"') insideString = !insideString;
+                    if (!insideString) {
+                        if (ch == '[' || ch == '{') {
+                            stack.Push(ch);
+                        } else if (ch == ']' || ch == '}') {
+                            if (stack.Empty() || stack.Top() != (ch == ']' ? '[' : '{')) return std::nullopt;
+                            stack.Pop();
+                        }
+                        if (stack.Empty() && predicate(ch)) return Offsets[segment] + static_cast<size_t>(it - data);
+                    }
+                    lpCounter.Process(ch);
+                }
+                pos = to;
+            }
+            if (!stack.Empty() || insideString) return std::nullopt;
+            return std::string_view::npos;
+        }
+
+        // The root value, with the spaces around it stripped like `JsonValue` does
+        auto FindRoot() const noexcept -> SegmentedValue {
+            auto lpCounter = LinePositionCounter{};
+            const auto begin = SkipSpaces(0, Offsets.back(), lpCounter);
+            auto end = Offsets.back();
+            while (end != begin && NUtils::IsSpace(At(end - 1))) --end;
+            return MakeValue(begin, end, {});
+        }
+    public:
+        explicit SegmentedDocument(
+            std::span<const std::string_view> segments,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+        )
+            : Segments(resource)
+            , Offsets(resource)
+            , Copies(resource)
+            , RootValue(*this, JsonValue{})
+        {
+            Segments.reserve(segments.size());
+            Offsets.reserve(segments.size() + 1);
+            Offsets.push_back(0);
+            for (const auto segment : segments) {
+                if (segment.empty()) continue;
+                Segments.push_back(segment);
+                Offsets.push_back(Offsets.back() + segment.size());
+            }
+            RootValue = FindRoot();
+        }
+
+        SegmentedDocument(const SegmentedDocument&) = delete;
+        auto operator=(const SegmentedDocument&) -> SegmentedDocument& = delete;
+
+        auto Root() const noexcept -> SegmentedValue {
+            return RootValue;
+        }
+
+        // The size of the document, the sum of the sizes of the segments
+        auto Size() const noexcept -> size_t {
+            return Offsets.back();
+        }
+
+        auto GetStats() const noexcept -> Stats {
+            return {.Copies = NCopies, .CopiedBytes = CopiedBytes};
+        }
+    };
+
+    // Iterates over the elements of an array (`TContainer = Array`) or over the (key, value) pairs
+    // of a mapping (`TContainer = Mapping`) of a `SegmentedDocument`, giving the same values as
+    // `Array::Iterator` and `Mapping::Iterator` do. The contents of a container that straddles
+    // segments are scanned across them without copying the container; a malformed one is copied
+    // when its error is reached, and the iteration goes on over the copy, so that it ends in the
+    // same way as with `JsonValue`. Like `Array::Iterator`, an iterator that has encountered
+    // an error compares equal to the end, and `HasError()` and `Error()` tell about the error
+    template <class TContainer>
+    class SegmentedIterator {
+    private:
+        static constexpr auto kIsMapping = std::same_as<TContainer, Mapping>;
+        using TIterator = typename TContainer::Iterator;
+        SegmentedValue Container;
+        // Over the contents of a contiguous container, or of the copy of a malformed one
+        TIterator Fallback;
+        TIterator FallbackEnd;
+        // Over the contents of a straddling container, until an error is reached:
+        // the elements of an array, or the keys and the values of a mapping
+        std::optional<SegmentedDocument::SequenceIterator> Iter;
+        std::optional<SegmentedDocument::SequenceIterator> ValIter;
+        // The number of steps made, to resume the iteration over the copy at the same element
+        size_t Steps = 0;
+        friend class SegmentedValue;
+        friend struct Expected<SegmentedValue>;
+    private:
+        SegmentedIterator(SegmentedValue container, TIterator fallback, TIterator fallbackEnd)
+            : Container(std::move(container)), Fallback(fallback), FallbackEnd(fallbackEnd) {}
+
+        static auto Begin(const SegmentedValue& container) -> SegmentedIterator {
+            if (container.Contiguous) {
+                const auto contiguous = container.Contiguous->As<TContainer>();
+                return {container, contiguous.begin(), contiguous.end()};
+            }
+            auto it = SegmentedIterator{container, {}, {}};
+            const auto opening = kIsMapping ? '{' : '[';
+            if (container.IsEnclosedIn(opening, kIsMapping ? '}' : ']')) {
+                it.Iter.emplace(
+                    *container.Document,
+                    container.Begin + 1,
+                    container.End - 1,
+                    container.LpCounter.Copy().Process(opening),
+                    kIsMapping ? ':' : ','
+                );
+                if constexpr (kIsMapping) {
+                    it.ValIter = it.Iter;
+                    it.ValIter->StepForward(':', ',');
+                }
+                it.CheckForErrors();
+            } else {
+                it.ResumeOnCopy();
+            }
+            return it;
+        }
+
+        // An iterator that has encountered `error`, like `Expected<Array>::begin()` of an error
+        static auto FromError(const NError::Error& error) -> SegmentedIterator {
+            const auto container = Expected<TContainer>{error};
+            return {{}, container.begin(), container.end()};
+        }
+
+        // Switches to iterating over the copy of the container if the scan has run into an error
+        // (or, in a mapping, into a key without a value)
+        auto CheckForErrors() -> void {
+            auto failed = Iter->Failed;
+            if constexpr (kIsMapping) failed = failed || ValIter->Failed || (!Iter->IsEnd() && ValIter->IsEnd());
+            if (failed) ResumeOnCopy();
+        }
+
+        auto ResumeOnCopy() -> void {
+            const auto copy = Container.GetJsonValue().template As<TContainer>();
+            Fallback = copy.begin();
+            FallbackEnd = copy.end();
+            for (size_t i = 0; i != Steps && Fallback != FallbackEnd; ++i) ++Fallback;
+            Iter.reset();
+            ValIter.reset();
+        }
+
+        auto IsEnd() const -> bool {
+            return Iter ? Iter->IsEnd() : Fallback == FallbackEnd;
+        }
+    public:
+        using difference_type = int;
+        using value_type = std::conditional_t<kIsMapping, SegmentedItem, Expected<SegmentedValue>>;
+    public:
+        SegmentedIterator() = default;
+
+        auto operator*() const -> value_type {
+            if constexpr (kIsMapping) {
+                if (Iter) return {.Key = (**Iter).As<String>(), .Value = **ValIter};
+                const auto item = *Fallback;
+                return {.Key = item.Key, .Value = Container.Wrap(item.Value)};
+            } else {
+                if (Iter) return **Iter;
+                return Container.Wrap(*Fallback);
+            }
+        }
+        auto operator++() -> SegmentedIterator& {
+            if (IsEnd()) return *this;
+            ++Steps;
+            if (!Iter) {
+                ++Fallback;
+                return *this;
+            }
+            if constexpr (kIsMapping) {
+                *Iter = ValIter->StepForward(',', ':');
+                ValIter->StepForward(':', ',');
+            } else {
+                Iter->StepForward(',', ',');
+            }
+            CheckForErrors();
+            return *this;
+        }
+        auto operator++(int) -> SegmentedIterator {
+            auto copy = *this;
+            ++(*this);
+            return copy;
+        }
+        // Iterators over the same container are at the same element if they have made as many steps
+        auto operator==(const SegmentedIterator& other) const -> bool {
+            const auto isEnd = IsEnd();
+            return isEnd == other.IsEnd() && (isEnd || Steps == other.Steps);
+        }
+        auto HasError() const -> bool {
+            return !Iter && Fallback.HasError();
+        }
+        auto Error() const -> const NError::Error& {
+            return Fallback.Error();
+        }
+    };
+
+    // The elements of an array or the (key, value) pairs of a mapping, see `SegmentedIterator`
+    template <class TContainer>
+    struct SegmentedRange {
+        SegmentedIterator<TContainer> First;
+
+        auto begin() const -> SegmentedIterator<TContainer> { return First; }
+        auto end() const -> SegmentedIterator<TContainer> { return {}; }
+    };
+
+    inline auto SegmentedValue::Elements() const -> SegmentedRange<Array> {
+        return {SegmentedIterator<Array>::Begin(*this)};
+    }
+
+    inline auto SegmentedValue::Items() const -> SegmentedRange<Mapping> {
+        return {SegmentedIterator<Mapping>::Begin(*this)};
+    }
+
+    inline auto Expected<SegmentedValue>::Elements() const -> SegmentedRange<Array> {
+        if (HasValue()) return Value().Elements();
+        return {SegmentedIterator<Array>::FromError(Error())};
+    }
+
+    inline auto Expected<SegmentedValue>::Items() const -> SegmentedRange<Mapping> {
+        if (HasValue()) return Value().Items();
+        return {SegmentedIterator<Mapping>::FromError(Error())};
+    }
+
+    inline auto SegmentedValue::Wrap(const Expected<JsonValue>& value) const -> Expected<SegmentedValue> {
+        if (value.HasError()) return value.Error();
+        return SegmentedValue{*Document, value.Value()};
+    }
+
+    inline auto SegmentedValue::IsEnclosedIn(char opening, char closing) const noexcept -> bool {
+        return Document->At(Begin) == opening && Document->At(End - 1) == closing;
+    }
+
+    inline auto SegmentedValue::IsString(std::string_view str) const -> Expected<bool> {
+        if (Contiguous || !IsEnclosedIn('"', '"')) {
+            const auto string = As<String>();
+            if (string.HasError()) return string.Error();
+            return string.Value() == str;
+        }
+        return Document->Equals(Begin + 1, End - 1, str);
+    }
+
+    inline auto SegmentedValue::GetJsonValue() const -> JsonValue {
+        if (Contiguous) return *Contiguous;
+        return JsonValue{Document->Copy(Begin, End), LpCounter};
+    }
+
+    inline auto SegmentedValue::Type() const noexcept -> JsonType {
+        if (Contiguous) return Contiguous->Type();
+        const auto first = Document->At(Begin);
+        return JsonValue{std::string_view{&first, 1}}.Type();
+    }
+
+    inline auto SegmentedValue::size() const -> Expected<size_t> {
+        const auto isMapping = Type() == JsonType::Mapping;
+        if (Contiguous) return isMapping ? Contiguous->As<Mapping>().size() : Contiguous->As<Array>().size();
+        size_t n = 0;
+        if (isMapping && IsEnclosedIn('{', '}')) {
+            auto keyIt = SegmentedDocument::SequenceIterator{*Document, Begin + 1, End - 1, LpCounter.Copy().Process('{'), ':'};
+            auto valIt = keyIt;
+            valIt.StepForward(':', ',');
+            for (; !keyIt.IsEnd() && !valIt.IsEnd(); ++n) {
+                valIt.StepForward(',', ':');
+                keyIt = valIt;
+                valIt.StepForward(':', ',');
+            }
+            if (keyIt.IsEnd() && !keyIt.Failed) return n;
+        } else if (!isMapping && IsEnclosedIn('[', ']')) {
+            auto it = SegmentedDocument::SequenceIterator{*Document, Begin + 1, End - 1, LpCounter.Copy().Process('['), ','};
+            for (; !it.IsEnd(); it.StepForward(',', ',')) ++n;
+            if (!it.Failed) return n;
+        }
+        // Malformed containers are copied to count their elements the same way as `JsonValue` does
+        const auto json = GetJsonValue();
+        return isMapping ? json.As<Mapping>().size() : json.As<Array>().size();
+    }
+
+    inline auto SegmentedValue::operator[](size_t idx) const -> Expected<SegmentedValue> {
+        if (Contiguous) return Wrap((*Contiguous)[idx]);
+        if (IsEnclosedIn('[', ']')) {
+            auto it = SegmentedDocument::SequenceIterator{*Document, Begin + 1, End - 1, LpCounter.Copy().Process('['), ','};
+            size_t i = 0;
+            for (; !it.IsEnd(); it.StepForward(',', ','), ++i) {
+                if (i == idx) return *it;
+            }
+            if (!it.Failed) return MakeError(
+                LpCounter,
+                NError::ErrorCode::ArrayIndexOutOfRange,
+                NError::ArrayIndexOutOfRangeAdditionalInfo{
+                    .Index = idx,
+                    .ArrayLen = i
+                }
+            );
+        }
+        return Wrap(GetJsonValue()[idx]);
+    }
+
+    inline auto SegmentedValue::operator[](std::string_view key) const -> Expected<SegmentedValue> {
+        if (Contiguous) return Wrap((*Contiguous)[key]);
+        if (IsEnclosedIn('{', '}')) {
+            auto keyIt = SegmentedDocument::SequenceIterator{*Document, Begin + 1, End - 1, LpCounter.Copy().Process('{'), ':'};
+            auto valIt = keyIt;
+            valIt.StepForward(':', ',');
+            // A key without a value is left to the copy, along with the other errors
+            for (; !keyIt.IsEnd() && !valIt.IsEnd();) {
+                const auto isKey = (*keyIt).IsString(key);
+                if (isKey.HasError()) return isKey.Error();
+                if (isKey.Value()) return *valIt;
+                valIt.StepForward(',', ':');
+                keyIt = valIt;
+                valIt.StepForward(':', ',');
+            }
+            if (keyIt.IsEnd() && !keyIt.Failed) return MakeError(
+                LpCounter,
+                NError::ErrorCode::MappingKeyNotFound,
+                NError::MappingKeyNotFoundAdditionalInfo{key}
+            );
+        }
+        return Wrap(GetJsonValue()[key]);
+    }
+} // namespace NJsonParser
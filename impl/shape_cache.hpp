@@ -0,0 +1,290 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "iterator.hpp"
+#include "json_value.hpp"
+#include "line_position_counter.hpp"
+#include "mapping.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+
+
+namespace NJsonParser::NUtils {
+    // Walks over the (key, value) pairs of `mapping` once and calls `onField(fieldIdx, value)`
+    // for every key that is equal to `fieldAt(fieldIdx)`. Several fields may have the same name
+    // (e.g. columns of different types), and each of them is offered the value. `onField` returns
+    // whether it has accepted the value; the walk stops as soon as `nFields` values have been accepted.
+    // Returns the number of accepted values or an error if the mapping is malformed.
+    constexpr auto MatchFields(
+        const Mapping& mapping,
+        size_t nFields,
+        std::invocable<size_t> auto&& fieldAt,
+        std::invocable<size_t, const JsonValue&> auto&& onField
+    ) -> Expected<size_t> {
+        size_t nAccepted = 0;
+        auto it = mapping.begin();
+        for (; it != mapping.end() && nAccepted != nFields; ++it) {
+            const auto [k, v] = *it;
+            // Keys that are not strings can't match any field
+            if (k.HasError() || v.HasError()) continue;
+            for (size_t fieldIdx = 0; fieldIdx != nFields; ++fieldIdx) {
+                if (k.Value() == fieldAt(fieldIdx) && onField(fieldIdx, v.Value())) ++nAccepted;
+            }
+        }
+        if (it.HasError()) return it.Error();
+        return nAccepted;
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Speeds up looking up the same set of fields in many mappings that have the same
+    // "shape", e.g. in the elements of an array like `[{"ts": 1, "v": 2}, {"ts": 3, "v": 4}, ...]`.
+    //
+    // The cache remembers the shape of the last mapping it has walked over: the sequence of
+    // its keys and, for every key, the distance between the key and the start of its value.
+    // The next mapping is then checked speculatively: instead of scanning a key with the
+    // generic bracket-balancing scanner and comparing it against every requested field, only
+    // the bytes at the predicted position are compared against a copy of the remembered key.
+    // On the first mismatch the walk falls back to the generic scan for the rest of the mapping,
+    // and the shape is relearned from that point on.
+    //
+    // Shapes of up to `kMaxSlots` keys are remembered; the keys beyond that are always scanned
+    // in the generic way. A cache must always be used with the same list of fields (call `Reset()`
+    // otherwise). Unlike the rest of the types of this library, `ShapeCache` is mutable and thus
+    // is not thread-safe; however, it doesn't keep any references to the data it has seen
+    // (the remembered keys are copied into memory taken from `TAllocator`; `pmr::ShapeCache`
+    // takes it from a `std::pmr::memory_resource`, e.g. an `ArenaResource`).
+    template <size_t kMaxSlots = 32, class TAllocator = std::allocator<std::byte>>
+    class ShapeCache {
+    public:
+        struct Stats {
+            // The number of mappings that were walked over using only the remembered shape
+            size_t Hits = 0;
+            // The number of mappings for which (a part of) the generic scan was needed
+            size_t Misses = 0;
+            constexpr auto operator==(const Stats& other) const noexcept -> bool = default;
+        };
+        using allocator_type = TAllocator;
+    private:
+        using TString = std::basic_string<
+            char, std::char_traits<char>, typename std::allocator_traits<TAllocator>::template rebind_alloc<char>
+        >;
+        static constexpr size_t kNoField = std::numeric_limits<size_t>::max();
+        struct Slot {
+            // `kNoField` for keys that are not valid strings, which can't be checked speculatively
+            size_t KeyLen = kNoField;
+            // Where the bytes of the key are in `KeyBytes`
+            size_t KeyOffset = 0;
+            // The first field with the name of the key
+            size_t FieldIdx = kNoField;
+            // Whether some of the fields after `FieldIdx` have the same name
+            bool SharedName = false;
+            // The distance between the opening double quote of the key and the start of the value
+            size_t Gap = 0;
+        };
+        // The position of a key in the data of the mapping being walked over,
+        // together with the line and position of this key in the original text
+        struct Cursor {
+            std::string_view::size_type Pos;
+            LinePositionCounter LpCounter;
+        };
+        struct Step {
+            Slot KeySlot;
+            std::string_view Key;
+            JsonValue Value;
+            Cursor Next;
+        };
+    private:
+        std::array<Slot, kMaxSlots> Slots = {};
+        size_t NSlots = 0;
+        // The keys of the slots, one after another in the order of the slots
+        TString KeyBytes;
+        Stats CurStats = {};
+    private:
+        // Checks that the key at `cur` is the one remembered in `slot` and that the value starts
+        // at the remembered distance from it. Returns `false` on any mismatch and on any error:
+        // in both cases the generic scan is going to handle this key anyway.
+        constexpr auto TrySpeculate(
+            std::string_view data,
+            Cursor cur,
+            const Slot& slot,
+            Step& step
+        ) const -> bool {
+            if (slot.KeyLen == kNoField) return false;
+            const auto closingQuotePos = cur.Pos + 1 + slot.KeyLen;
+            const auto valuePos = cur.Pos + slot.Gap;
+            if (valuePos >= data.size() || closingQuotePos >= valuePos) return false;
+            if (data[cur.Pos] != '"' || data[closingQuotePos] != '"') return false;
+            // All the bytes are compared, since a key that merely looks like the remembered one
+            // (e.g. has the same hash) would make a requested field go missing
+            const auto key = data.substr(cur.Pos + 1, slot.KeyLen);
+            if (key != std::string_view{KeyBytes}.substr(slot.KeyOffset, slot.KeyLen)) return false;
+            // Only spaces and exactly one colon may separate the key from the value
+            size_t nColons = 0;
+            for (char ch : data.substr(closingQuotePos + 1, valuePos - closingQuotePos - 1)) {
+                if (ch == ':') ++nColons;
+                else if (!NUtils::IsSpace(ch)) return false;
+            }
+            if (nColons != 1 || NUtils::IsSpace(data[valuePos])) return false;
+
+            const auto valueLpCounter = cur.LpCounter.Copy().Process(data.substr(cur.Pos, slot.Gap));
+            auto lpCounter = valueLpCounter;
+            const auto valueEndOrErr = NUtils::FindCurElementEndPos(data, lpCounter, valuePos, ',');
+            if (valueEndOrErr.HasError()) return false;
+            const auto valueEnd = valueEndOrErr.Value();
+            const auto nextPosOrErr = NUtils::FindNextElementStartPos(data, lpCounter, valueEnd, ',');
+            if (nextPosOrErr.HasError()) return false;
+            step.KeySlot = slot;
+            step.Key = key;
+            step.Value = JsonValue{data.substr(valuePos, valueEnd - valuePos), valueLpCounter};
+            step.Next = {nextPosOrErr.Value(), lpCounter};
+            return true;
+        }
+
+        // Handles the key at `cur` the same way `Mapping::Iterator` does.
+        // Returns `std::nullopt` if there is a key without a value at `cur`
+        static constexpr auto GenericStep(
+            std::string_view data,
+            Cursor cur,
+            size_t nFields,
+            std::invocable<size_t> auto&& fieldAt
+        ) -> Expected<std::optional<Step>> {
+            auto keyIter = GenericSerializedSequenceIterator{data, cur.LpCounter, cur.Pos, ':'};
+            if (keyIter.HasError()) return keyIter.Error();
+            auto valIter = keyIter;
+            valIter.StepForward(':', ',');
+            if (valIter.HasError()) return valIter.Error();
+            if (valIter.IsEnd()) return std::optional<Step>{};
+            const auto key = (*keyIter).As<String>();
+            const auto value = (*valIter).Value();
+            keyIter = valIter;
+            keyIter.StepForward(',', ':');
+            if (keyIter.HasError()) return keyIter.Error();
+
+            auto step = Step{
+                .KeySlot = {},
+                .Key = {},
+                .Value = value,
+                .Next = {
+                    keyIter.IsEnd()
+                        ? std::string_view::npos
+                        : static_cast<size_t>((*keyIter).Value().GetData().data() - data.data()),
+                    keyIter.GetBegLpCounter(),
+                },
+            };
+            if (key.HasError()) return std::optional{step};
+            step.Key = key.Value();
+            step.KeySlot = {
+                .KeyLen = key.Value().size(),
+                .Gap = static_cast<size_t>(value.GetData().data() - data.data()) - cur.Pos,
+            };
+            for (size_t fieldIdx = 0; fieldIdx != nFields; ++fieldIdx) {
+                if (key.Value() != fieldAt(fieldIdx)) continue;
+                if (step.KeySlot.FieldIdx != kNoField) {
+                    step.KeySlot.SharedName = true;
+                    break;
+                }
+                step.KeySlot.FieldIdx = fieldIdx;
+            }
+            return std::optional{step};
+        }
+    public:
+        constexpr explicit ShapeCache(const TAllocator& allocator = {})
+            : KeyBytes(allocator) {}
+
+        constexpr auto get_allocator() const noexcept -> TAllocator {
+            return TAllocator{KeyBytes.get_allocator()};
+        }
+
+        // Same as `NUtils::MatchFields`, but uses and updates the remembered shape
+        constexpr auto Match(
+            const Mapping& mapping,
+            size_t nFields,
+            std::invocable<size_t> auto&& fieldAt,
+            std::invocable<size_t, const JsonValue&> auto&& onField
+        ) -> Expected<size_t> {
+            const auto data = mapping.GetData();
+            auto cur = Cursor{.Pos = 0, .LpCounter = mapping.GetLpCounter().Copy().Process('{')};
+            cur.Pos = NUtils::SkipSpaces(data, cur.LpCounter);
+            size_t nAccepted = 0;
+            size_t slotIdx = 0;
+            bool hit = true;
+            for (; cur.Pos != std::string_view::npos && nAccepted != nFields; ++slotIdx) {
+                auto step = Step{.KeySlot = {}, .Key = {}, .Value = JsonValue{""}, .Next = {}};
+                const auto speculated = slotIdx < NSlots
+                    && TrySpeculate(data, cur, Slots[slotIdx], step);
+                if (!speculated) {
+                    hit = false;
+                    const auto stepOrErr = GenericStep(data, cur, nFields, fieldAt);
+                    if (stepOrErr.HasError()) {
+                        NSlots = 0;
+                        ++CurStats.Misses;
+                        return stepOrErr.Error();
+                    }
+                    if (!stepOrErr.Value().has_value()) break;
+                    step = *stepOrErr.Value();
+                    if (slotIdx < kMaxSlots) {
+                        // Relearning a slot drops the keys of it and of all the slots after it
+                        const auto& prev = Slots[slotIdx == 0 ? 0 : slotIdx - 1];
+                        KeyBytes.resize(slotIdx == 0 ? 0 : prev.KeyOffset + (prev.KeyLen == kNoField ? 0 : prev.KeyLen));
+                        step.KeySlot.KeyOffset = KeyBytes.size();
+                        if (step.KeySlot.KeyLen != kNoField) KeyBytes.append(step.Key);
+                        Slots[slotIdx] = step.KeySlot;
+                        NSlots = slotIdx + 1;
+                    }
+                }
+                if (step.KeySlot.FieldIdx != kNoField && onField(step.KeySlot.FieldIdx, step.Value)) {
+                    ++nAccepted;
+                }
+                if (step.KeySlot.SharedName) {
+                    for (auto fieldIdx = step.KeySlot.FieldIdx + 1; fieldIdx != nFields; ++fieldIdx) {
+                        if (step.Key == fieldAt(fieldIdx) && onField(fieldIdx, step.Value)) ++nAccepted;
+                    }
+                }
+                cur = step.Next;
+            }
+            ++(hit ? CurStats.Hits : CurStats.Misses);
+            return nAccepted;
+        }
+
+        // A more convenient overload for a list of fields given as a span
+        constexpr auto Match(
+            const Mapping& mapping,
+            std::span<const std::string_view> fields,
+            std::invocable<size_t, const JsonValue&> auto&& onField
+        ) -> Expected<size_t> {
+            return Match(
+                mapping, fields.size(),
+                [fields](size_t fieldIdx) { return fields[fieldIdx]; },
+                onField
+            );
+        }
+
+        constexpr auto GetStats() const noexcept -> Stats {
+            return CurStats;
+        }
+
+        // Forgets the remembered shape and resets the statistics
+        constexpr auto Reset() noexcept -> void {
+            NSlots = 0;
+            KeyBytes.clear();
+            CurStats = {};
+        }
+    };
+
+    namespace pmr {
+        template <size_t kMaxSlots = 32>
+        using ShapeCache = NJsonParser::ShapeCache<kMaxSlots, std::pmr::polymorphic_allocator<std::byte>>;
+    } // namespace pmr
+} // namespace NJsonParser
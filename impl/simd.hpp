@@ -0,0 +1,427 @@
+#pragma once
+
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The AVX2 and AVX-512 kernels are compiled for their instruction sets with the `target`
+// attribute, so the library doesn't need to be compiled with `-mavx2` to use them: they are only
+// called on the processors that support them (see `NSimd::GetKernels`)
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NJSON_PARSER_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+
+namespace NJsonParser::NSimd {
+    // The instruction sets the kernels are implemented with, from the slowest to the fastest
+    enum class Isa : uint8_t {
+        Scalar,
+        Sse2,
+        Avx2,
+        // Requires AVX-512F and AVX-512BW
+        Avx512,
+    };
+
+    constexpr auto ToString(Isa isa) noexcept -> std::string_view {
+        switch (isa) {
+            case Isa::Scalar: return "scalar";
+            case Isa::Sse2: return "sse2";
+            case Isa::Avx2: return "avx2";
+            case Isa::Avx512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    // The newlines passed over by a kernel, which are needed to keep track of line numbers
+    // and positions without looking at every character again
+    struct Newlines {
+        size_t Count = 0;
+        // The last of them (only meaningful if `Count != 0`)
+        const char* Last = nullptr;
+    };
+
+    // The number of characters `Kernels::ClassifyBlock` looks at
+    inline constexpr size_t kBlockSize = 64;
+
+    // The characters of a block of `kBlockSize` characters that matter when skipping over values
+    // and counting their elements: bit `i` of every mask stands for the character `i` of the block
+    struct BlockMasks {
+        uint64_t Quotes = 0;
+        // '[' and '{'
+        uint64_t Opening = 0;
+        // ']' and '}'
+        uint64_t Closing = 0;
+        uint64_t Newlines = 0;
+        uint64_t Commas = 0;
+        uint64_t Colons = 0;
+    };
+
+    // The run-time kernels. All of them but `ClassifyBlock` take a range of characters `[begin, end)`
+    struct Kernels {
+        Isa Level;
+        // Returns the first character that is not a space (' ', '\t' or '\n'), or `end`
+        auto (*SkipSpaces)(const char* begin, const char* end, Newlines& newlines) noexcept -> const char*;
+        // Returns the first character that can change the bracket balance or the "inside
+        // a string" state: a double quote, and, if `insideString` is false, a bracket; or `end`
+        auto (*FindStructural)(const char* begin, const char* end, bool insideString, Newlines& newlines) noexcept -> const char*;
+        // Returns the first character that is not ASCII, or `end`
+        auto (*SkipAscii)(const char* begin, const char* end) noexcept -> const char*;
+        // Classifies the `kBlockSize` characters starting at `block`
+        auto (*ClassifyBlock)(const char* block) noexcept -> BlockMasks;
+    };
+} // namespace NJsonParser::NSimd
+
+namespace NJsonParser::NSimd {
+    // The characters `Kernels::FindStructural` stops at
+    constexpr auto IsStructural(char ch, bool insideString) noexcept -> bool {
+        return ch == '"' || (!insideString && (ch == '[' || ch == ']' || ch == '{' || ch == '}'));
+    }
+
+    // Bit `i` of the result is the xor of the bits `0..i` of `mask`: for the mask of the double
+    // quotes of a block, it tells which characters are inside strings (counting the opening quotes
+    // in and the closing ones out), if the block doesn't start inside a string
+    constexpr auto PrefixXor(uint64_t mask) noexcept -> uint64_t {
+        for (int shift = 1; shift != 64; shift *= 2) mask ^= mask << shift;
+        return mask;
+    }
+} // namespace NJsonParser::NSimd
+
+namespace NJsonParser::NSimd::NImpl {
+    constexpr auto IsSpace(char ch) noexcept -> bool {
+        return ch == ' ' || ch == '\t' || ch == '\n';
+    }
+
+    // Adds the newlines of the first `n` bits of the mask of the newlines of a block of characters
+    template <class TMask>
+    inline auto CountNewlines(Newlines& newlines, const char* block, TMask newlineMask, int n) noexcept -> void {
+        constexpr auto kBits = static_cast<int>(sizeof(TMask) * 8);
+        if (n != kBits) newlineMask &= (TMask{1} << n) - 1;
+        if (!newlineMask) return;
+        newlines.Count += static_cast<size_t>(std::popcount(newlineMask));
+        newlines.Last = block + (kBits - 1 - std::countl_zero(newlineMask));
+    }
+
+    inline auto SkipSpacesScalar(const char* begin, const char* end, Newlines& newlines) noexcept -> const char* {
+        for (; begin != end && IsSpace(*begin); ++begin) {
+            if (*begin == '\n') ++newlines.Count, newlines.Last = begin;
+        }
+        return begin;
+    }
+    inline auto FindStructuralScalar(const char* begin, const char* end, bool insideString, Newlines& newlines) noexcept -> const char* {
+        for (; begin != end && !IsStructural(*begin, insideString); ++begin) {
+            if (*begin == '\n') ++newlines.Count, newlines.Last = begin;
+        }
+        return begin;
+    }
+    inline auto SkipAsciiScalar(const char* begin, const char* end) noexcept -> const char* {
+        while (begin != end && static_cast<uint8_t>(*begin) < 0x80) ++begin;
+        return begin;
+    }
+    inline auto ClassifyBlockScalar(const char* block) noexcept -> BlockMasks {
+        auto masks = BlockMasks{};
+        for (size_t i = 0; i != kBlockSize; ++i) {
+            const auto bit = uint64_t{1} << i;
+            switch (block[i]) {
+                case '"': masks.Quotes |= bit; break;
+                case '[': case '{': masks.Opening |= bit; break;
+                case ']': case '}': masks.Closing |= bit; break;
+                case '\n': masks.Newlines |= bit; break;
+                case ',': masks.Commas |= bit; break;
+                case ':': masks.Colons |= bit; break;
+            }
+        }
+        return masks;
+    }
+
+    inline constexpr auto kScalarKernels = Kernels{
+        .Level = Isa::Scalar,
+        .SkipSpaces = SkipSpacesScalar,
+        .FindStructural = FindStructuralScalar,
+        .SkipAscii = SkipAsciiScalar,
+        .ClassifyBlock = ClassifyBlockScalar,
+    };
+
+#if defined(__SSE2__)
+    // The brackets are found with two comparisons instead of four: `ch | 0x20` is '{'
+    // only for '[' and '{', and '}' only for ']' and '}'
+    inline auto SkipSpacesSse2(const char* begin, const char* end, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 16 <= end; begin += 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            const auto newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+            const auto space = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                newline
+            );
+            const auto newlineMask = static_cast<uint16_t>(_mm_movemask_epi8(newline));
+            const auto stopMask = static_cast<uint16_t>(~_mm_movemask_epi8(space));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 16);
+        }
+        return SkipSpacesScalar(begin, end, newlines);
+    }
+    inline auto FindStructuralSse2(const char* begin, const char* end, bool insideString, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 16 <= end; begin += 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            auto stop = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+            if (!insideString) {
+                const auto lowered = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+                stop = _mm_or_si128(stop, _mm_or_si128(
+                    _mm_cmpeq_epi8(lowered, _mm_set1_epi8('{')),
+                    _mm_cmpeq_epi8(lowered, _mm_set1_epi8('}'))
+                ));
+            }
+            const auto newlineMask = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))));
+            const auto stopMask = static_cast<uint16_t>(_mm_movemask_epi8(stop));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 16);
+        }
+        return FindStructuralScalar(begin, end, insideString, newlines);
+    }
+    inline auto SkipAsciiSse2(const char* begin, const char* end) noexcept -> const char* {
+        for (; begin + 16 <= end; begin += 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+            if (const auto mask = static_cast<uint16_t>(_mm_movemask_epi8(chunk))) return begin + std::countr_zero(mask);
+        }
+        return SkipAsciiScalar(begin, end);
+    }
+    inline auto ClassifyBlockSse2(const char* block) noexcept -> BlockMasks {
+        auto masks = BlockMasks{};
+        for (size_t i = 0; i != kBlockSize; i += 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            const auto lowered = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+            const auto bits = [i](__m128i matches) {
+                return uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(matches))} << i;
+            };
+            masks.Quotes |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+            masks.Opening |= bits(_mm_cmpeq_epi8(lowered, _mm_set1_epi8('{')));
+            masks.Closing |= bits(_mm_cmpeq_epi8(lowered, _mm_set1_epi8('}')));
+            masks.Newlines |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+            masks.Commas |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')));
+            masks.Colons |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')));
+        }
+        return masks;
+    }
+
+    inline constexpr auto kSse2Kernels = Kernels{
+        .Level = Isa::Sse2,
+        .SkipSpaces = SkipSpacesSse2,
+        .FindStructural = FindStructuralSse2,
+        .SkipAscii = SkipAsciiSse2,
+        .ClassifyBlock = ClassifyBlockSse2,
+    };
+#endif
+
+#if defined(NJSON_PARSER_X86_DISPATCH)
+    __attribute__((target("avx2")))
+    inline auto SkipSpacesAvx2(const char* begin, const char* end, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 32 <= end; begin += 32) {
+            const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            const auto newline = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+            const auto space = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+                newline
+            );
+            const auto newlineMask = static_cast<uint32_t>(_mm256_movemask_epi8(newline));
+            const auto stopMask = ~static_cast<uint32_t>(_mm256_movemask_epi8(space));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 32);
+        }
+        return SkipSpacesSse2(begin, end, newlines);
+    }
+    __attribute__((target("avx2")))
+    inline auto FindStructuralAvx2(const char* begin, const char* end, bool insideString, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 32 <= end; begin += 32) {
+            const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            auto stop = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+            if (!insideString) {
+                const auto lowered = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+                stop = _mm256_or_si256(stop, _mm256_or_si256(
+                    _mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('{')),
+                    _mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('}'))
+                ));
+            }
+            const auto newlineMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))));
+            const auto stopMask = static_cast<uint32_t>(_mm256_movemask_epi8(stop));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 32);
+        }
+        return FindStructuralSse2(begin, end, insideString, newlines);
+    }
+    __attribute__((target("avx2")))
+    inline auto SkipAsciiAvx2(const char* begin, const char* end) noexcept -> const char* {
+        for (; begin + 32 <= end; begin += 32) {
+            const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+            if (const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(chunk))) return begin + std::countr_zero(mask);
+        }
+        return SkipAsciiSse2(begin, end);
+    }
+    __attribute__((target("avx2")))
+    inline auto ClassifyBlockAvx2(const char* block) noexcept -> BlockMasks {
+        auto masks = BlockMasks{};
+        for (size_t i = 0; i != kBlockSize; i += 32) {
+            const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+            const auto lowered = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+            const auto bits = [i](__m256i matches) __attribute__((target("avx2"))) {
+                return uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(matches))} << i;
+            };
+            masks.Quotes |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')));
+            masks.Opening |= bits(_mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('{')));
+            masks.Closing |= bits(_mm256_cmpeq_epi8(lowered, _mm256_set1_epi8('}')));
+            masks.Newlines |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')));
+            masks.Commas |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(',')));
+            masks.Colons |= bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')));
+        }
+        return masks;
+    }
+
+    inline constexpr auto kAvx2Kernels = Kernels{
+        .Level = Isa::Avx2,
+        .SkipSpaces = SkipSpacesAvx2,
+        .FindStructural = FindStructuralAvx2,
+        .SkipAscii = SkipAsciiAvx2,
+        .ClassifyBlock = ClassifyBlockAvx2,
+    };
+
+    __attribute__((target("avx512f,avx512bw")))
+    inline auto SkipSpacesAvx512(const char* begin, const char* end, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 64 <= end; begin += 64) {
+            const auto chunk = _mm512_loadu_si512(begin);
+            const uint64_t newlineMask = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\n'));
+            const uint64_t stopMask = ~(newlineMask
+                | _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(' '))
+                | _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\t')));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 64);
+        }
+        return SkipSpacesAvx2(begin, end, newlines);
+    }
+    __attribute__((target("avx512f,avx512bw")))
+    inline auto FindStructuralAvx512(const char* begin, const char* end, bool insideString, Newlines& newlines) noexcept -> const char* {
+        for (; begin + 64 <= end; begin += 64) {
+            const auto chunk = _mm512_loadu_si512(begin);
+            uint64_t stopMask = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('"'));
+            if (!insideString) {
+                const auto lowered = _mm512_or_si512(chunk, _mm512_set1_epi8(0x20));
+                stopMask |= _mm512_cmpeq_epi8_mask(lowered, _mm512_set1_epi8('{'))
+                    | _mm512_cmpeq_epi8_mask(lowered, _mm512_set1_epi8('}'));
+            }
+            const uint64_t newlineMask = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\n'));
+            if (stopMask) {
+                const auto n = std::countr_zero(stopMask);
+                CountNewlines(newlines, begin, newlineMask, n);
+                return begin + n;
+            }
+            CountNewlines(newlines, begin, newlineMask, 64);
+        }
+        return FindStructuralAvx2(begin, end, insideString, newlines);
+    }
+    __attribute__((target("avx512f,avx512bw")))
+    inline auto SkipAsciiAvx512(const char* begin, const char* end) noexcept -> const char* {
+        for (; begin + 64 <= end; begin += 64) {
+            const auto chunk = _mm512_loadu_si512(begin);
+            if (const uint64_t mask = _mm512_movepi8_mask(chunk)) return begin + std::countr_zero(mask);
+        }
+        return SkipAsciiAvx2(begin, end);
+    }
+    __attribute__((target("avx512f,avx512bw")))
+    inline auto ClassifyBlockAvx512(const char* block) noexcept -> BlockMasks {
+        const auto chunk = _mm512_loadu_si512(block);
+        const auto lowered = _mm512_or_si512(chunk, _mm512_set1_epi8(0x20));
+        return {
+            .Quotes = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('"')),
+            .Opening = _mm512_cmpeq_epi8_mask(lowered, _mm512_set1_epi8('{')),
+            .Closing = _mm512_cmpeq_epi8_mask(lowered, _mm512_set1_epi8('}')),
+            .Newlines = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\n')),
+            .Commas = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(',')),
+            .Colons = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(':')),
+        };
+    }
+
+    inline constexpr auto kAvx512Kernels = Kernels{
+        .Level = Isa::Avx512,
+        .SkipSpaces = SkipSpacesAvx512,
+        .FindStructural = FindStructuralAvx512,
+        .SkipAscii = SkipAsciiAvx512,
+        .ClassifyBlock = ClassifyBlockAvx512,
+    };
+#endif
+
+    inline auto FindKernels(Isa isa) noexcept -> const Kernels* {
+        switch (isa) {
+            case Isa::Scalar: return &kScalarKernels;
+#if defined(__SSE2__)
+            case Isa::Sse2: return &kSse2Kernels;
+#endif
+#if defined(NJSON_PARSER_X86_DISPATCH)
+            case Isa::Avx2: return __builtin_cpu_supports("avx2") ? &kAvx2Kernels : nullptr;
+            case Isa::Avx512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") ? &kAvx512Kernels : nullptr;
+#endif
+            default: return nullptr;
+        }
+    }
+
+    inline std::atomic<const Kernels*> ActiveKernels = nullptr;
+} // namespace NJsonParser::NSimd::NImpl
+
+namespace NJsonParser::NSimd {
+    // Whether the kernels of `isa` are compiled in and supported by the processor
+    inline auto IsSupported(Isa isa) noexcept -> bool {
+        return NImpl::FindKernels(isa) != nullptr;
+    }
+
+    // The fastest supported instruction set (detected with cpuid)
+    inline auto DetectIsa() noexcept -> Isa {
+        for (auto isa : {Isa::Avx512, Isa::Avx2, Isa::Sse2}) {
+            if (IsSupported(isa)) return isa;
+        }
+        return Isa::Scalar;
+    }
+
+    // The kernels used by the library, chosen by `DetectIsa` on the first call
+    inline auto GetKernels() noexcept -> const Kernels& {
+        auto kernels = NImpl::ActiveKernels.load(std::memory_order_relaxed);
+        if (!kernels) [[unlikely]] {
+            kernels = NImpl::FindKernels(DetectIsa());
+            NImpl::ActiveKernels.store(kernels, std::memory_order_relaxed);
+        }
+        return *kernels;
+    }
+
+    // Makes the library use the kernels of `isa` (e.g. to compare the implementations
+    // in tests and benchmarks). Returns false and changes nothing if `isa` is not supported.
+    // Must not be called concurrently with parsing
+    inline auto SetIsa(Isa isa) noexcept -> bool {
+        const auto kernels = NImpl::FindKernels(isa);
+        if (kernels) NImpl::ActiveKernels.store(kernels, std::memory_order_relaxed);
+        return kernels != nullptr;
+    }
+} // namespace NJsonParser::NSimd
@@ -0,0 +1,366 @@
+#pragma once
+
+
+#include "document_index.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+#include "pointer.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace NJsonParser::NUtils {
+    // The finalizer of MurmurHash3: every bit of the input affects every bit of the result
+    constexpr auto MixHash(uint64_t x) noexcept -> uint64_t {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // Combines hashes in an order-dependent way
+    constexpr auto CombineHashes(uint64_t seed, uint64_t value) noexcept -> uint64_t {
+        return MixHash(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    struct StructuralHashOptions {
+        // Whether mappings with the same pairs in a different order have the same hash
+        bool IgnoreKeyOrder = false;
+    };
+
+    // A value of a document with structural hashes: the index of its container record
+    // (`NIndex::kNone` for a scalar) and the value itself
+    struct StructuralHashNode {
+        uint64_t Container = NIndex::kNone;
+        JsonValue Value = JsonValue{};
+    };
+
+    // The structural hashes of all the subtrees of a document: two values have the same hash if
+    // they are the same up to the spaces between the tokens (and, optionally, the order of the keys).
+    // Scalars are compared by their text, so e.g. `1.0` and `1` are different values. The hashes
+    // are computed in one pass over the index of the document, bottom-up, so that building them
+    // takes about as long as building the index (see `impl/document_index.hpp`):
+    //
+    //     const auto hashes = StructuralHashes::Build(json).Value();
+    //     if (hashes.Root() != oldRoot) ...
+    //
+    // Like an index, the hashes refer to the document, which must outlive them. The index and
+    // the hashes are allocated with `TAllocator`, so `pmr::StructuralHashes` can be built in an
+    // `ArenaResource` (see `impl/arena.hpp`) like `pmr::DocumentIndex`.
+    template <class TAllocator = std::allocator<std::byte>>
+    class BasicStructuralHashes {
+    public:
+        using allocator_type = TAllocator;
+        using Node = StructuralHashNode;
+    private:
+        BasicDocumentIndex<TAllocator> Index;
+        JsonValue RootValue;
+        StructuralHashOptions Options;
+        // The hashes of the containers, in the order of the container records of the index
+        typename BasicDocumentIndex<TAllocator>::template TVector<uint64_t> ContainerHashes;
+        uint64_t RootHash = 0;
+    private:
+        static constexpr uint64_t kArraySeed = 0x6a09e667f3bcc908ull;
+        static constexpr uint64_t kMappingSeed = 0xbb67ae8584caa73bull;
+
+        static constexpr auto ScalarHash(std::string_view token) noexcept -> uint64_t {
+            return NUtils::ContentHash(token);
+        }
+
+        constexpr auto ChildHash(const DocumentIndexView& view, const NIndex::ChildRecord& child) const noexcept -> uint64_t {
+            if (child.Container != NIndex::kNone) return ContainerHashes[child.Container];
+            return ScalarHash(view.Data.substr(child.ValueBegin, child.ValueLen));
+        }
+
+        constexpr auto ComputeHashes() -> void {
+            const auto view = GetView();
+            ContainerHashes.resize(view.Containers.size());
+            // The children of a container always come after it, so, going from the last container
+            // to the first one, the hashes of all the children are known by the time they are needed
+            for (auto i = view.Containers.size(); i-- != 0;) {
+                const auto& container = view.Containers[i];
+                const auto children = view.Children.subspan(container.FirstChild, container.NChildren);
+                auto hash = container.IsMapping() ? kMappingSeed : kArraySeed;
+                if (!container.IsMapping()) {
+                    for (const auto& child : children) hash = NUtils::CombineHashes(hash, ChildHash(view, child));
+                } else if (!Options.IgnoreKeyOrder) {
+                    for (const auto& child : children) {
+                        hash = NUtils::CombineHashes(hash, NUtils::CombineHashes(child.KeyHash, ChildHash(view, child)));
+                    }
+                } else {
+                    // The sum of the mixed hashes of the pairs doesn't depend on their order
+                    uint64_t sum = 0;
+                    for (const auto& child : children) {
+                        sum += NUtils::MixHash(NUtils::CombineHashes(child.KeyHash, ChildHash(view, child)));
+                    }
+                    hash = NUtils::CombineHashes(NUtils::CombineHashes(hash, sum), container.NChildren);
+                }
+                ContainerHashes[i] = hash;
+            }
+            RootHash = view.Containers.empty() ? ScalarHash(view.Data) : ContainerHashes.front();
+        }
+    public:
+        constexpr BasicStructuralHashes(BasicDocumentIndex<TAllocator> index, const JsonValue& root, StructuralHashOptions options)
+            : Index(std::move(index)), RootValue(root), Options(options), ContainerHashes(Index.get_allocator()) {
+            ComputeHashes();
+        }
+
+        static constexpr auto Build(
+            const JsonValue& root,
+            StructuralHashOptions options = {},
+            const TAllocator& allocator = {}
+        ) -> Expected<BasicStructuralHashes> {
+            auto index = BasicDocumentIndex<TAllocator>::Build(root, allocator);
+            if (index.HasError()) return index.Error();
+            return BasicStructuralHashes{index.Value(), root, options};
+        }
+
+        constexpr auto get_allocator() const noexcept -> TAllocator {
+            return Index.get_allocator();
+        }
+
+        // The hash of the whole document
+        constexpr auto Root() const noexcept -> uint64_t {
+            return RootHash;
+        }
+        constexpr auto GetOptions() const noexcept -> StructuralHashOptions {
+            return Options;
+        }
+        constexpr auto GetView() const noexcept -> DocumentIndexView {
+            return Index.View(RootValue).Value();
+        }
+
+        constexpr auto RootNode() const noexcept -> Node {
+            return {GetView().Containers.empty() ? NIndex::kNone : 0, RootValue};
+        }
+        constexpr auto ChildNode(const DocumentIndexView& view, uint64_t childIdx) const noexcept -> Node {
+            const auto& child = view.Children[childIdx];
+            return {child.Container, JsonValue{view.Data.substr(child.ValueBegin, child.ValueLen), child.LpCounter}};
+        }
+        // The hash of a value of the document
+        constexpr auto HashOf(const Node& node) const noexcept -> uint64_t {
+            if (node.Container != NIndex::kNone) return ContainerHashes[node.Container];
+            return ScalarHash(node.Value.GetData());
+        }
+        // Whether a value of this document and a value of `other` are the same
+        template <class TOtherAllocator>
+        constexpr auto Same(const Node& node, const BasicStructuralHashes<TOtherAllocator>& other, const Node& otherNode) const noexcept -> bool {
+            if (node.Container != NIndex::kNone && otherNode.Container != NIndex::kNone) {
+                return HashOf(node) == other.HashOf(otherNode);
+            }
+            return node.Value.GetData() == otherNode.Value.GetData();
+        }
+    };
+
+    using StructuralHashes = BasicStructuralHashes<>;
+
+    namespace pmr {
+        using StructuralHashes = BasicStructuralHashes<std::pmr::polymorphic_allocator<std::byte>>;
+    } // namespace pmr
+
+    // The structural hash of a document (see `StructuralHashes`)
+    constexpr auto StructuralHash(const JsonValue& root, StructuralHashOptions options = {}) -> Expected<uint64_t> {
+        const auto hashes = StructuralHashes::Build(root, options);
+        if (hashes.HasError()) return hashes.Error();
+        return hashes.Value().Root();
+    }
+
+    // A difference between two versions of a document. The pointer is allocated with `TAllocator`
+    template <class TAllocator = std::allocator<std::byte>>
+    struct BasicDocumentChange {
+        using TString = std::basic_string<
+            char, std::char_traits<char>, typename std::allocator_traits<TAllocator>::template rebind_alloc<char>
+        >;
+        enum class EKind : uint8_t {
+            Added,
+            Removed,
+            Changed,
+        };
+        EKind Kind;
+        // The json pointer of the value, e.g. "/params/compilers/1"
+        TString Pointer;
+        // The value in the old version (missing for added values)
+        // and in the new one (missing for removed values)
+        JsonValue Before;
+        JsonValue After;
+
+        constexpr auto operator==(const BasicDocumentChange& other) const -> bool {
+            return Kind == other.Kind && Pointer == other.Pointer
+                && Before.GetData() == other.Before.GetData() && After.GetData() == other.After.GetData();
+        }
+    };
+
+    using DocumentChange = BasicDocumentChange<>;
+
+    namespace pmr {
+        using DocumentChange = BasicDocumentChange<std::pmr::polymorphic_allocator<std::byte>>;
+    } // namespace pmr
+
+    // The list of changes `Diff` returns, allocated with `TAllocator`
+    template <class TAllocator = std::allocator<std::byte>>
+    using DocumentChanges = std::vector<
+        BasicDocumentChange<TAllocator>,
+        typename std::allocator_traits<TAllocator>::template rebind_alloc<BasicDocumentChange<TAllocator>>
+    >;
+
+    // Finds the differences between two versions of a document. Only the branches with different
+    // hashes are visited, so once the hashes are built, finding the changes takes time proportional
+    // to the size of the changed containers rather than to the size of the documents (e.g. the old
+    // hashes can be kept between the reloads of a config). Mappings are compared key by key, and arrays
+    // are compared element by element, so inserting an element into the middle of an array changes
+    // all the elements after it. If only the order of the keys of a mapping differs (and the order
+    // matters, see `StructuralHashOptions`), the mapping itself is reported as changed. Both hashes must
+    // be built with the same options. The changes are listed in the order of the documents.
+    // The changes, their pointers and the temporary memory are allocated with the allocator of `before`
+    // (so e.g. with `pmr::StructuralHashes` built in an arena, the whole diff is made in the arena).
+    template <class TBeforeAllocator, class TAfterAllocator>
+    constexpr auto Diff(
+        const BasicStructuralHashes<TBeforeAllocator>& before,
+        const BasicStructuralHashes<TAfterAllocator>& after
+    ) -> DocumentChanges<TBeforeAllocator> {
+        using TChange = BasicDocumentChange<TBeforeAllocator>;
+        using TString = typename TChange::TString;
+        using EKind = typename TChange::EKind;
+        using Node = StructuralHashNode;
+        struct TItem {
+            // `Compare` compares two values, the others are reported as is
+            bool Compare;
+            TChange Change;
+            Node BeforeNode;
+            Node AfterNode;
+        };
+        using TItems = std::vector<TItem, typename std::allocator_traits<TBeforeAllocator>::template rebind_alloc<TItem>>;
+        const auto allocator = before.get_allocator();
+        const auto beforeView = before.GetView();
+        const auto afterView = after.GetView();
+        const auto isMapping = [](const DocumentIndexView& view, const Node& node) {
+            return view.Containers[node.Container].IsMapping();
+        };
+        const auto compare = [](TString pointer, const Node& lhs, const Node& rhs) {
+            return TItem{true, {EKind::Changed, std::move(pointer), lhs.Value, rhs.Value}, lhs, rhs};
+        };
+        const auto report = [](EKind kind, TString pointer, const Node& lhs, const Node& rhs) {
+            return TItem{false, {kind, std::move(pointer), lhs.Value, rhs.Value}, lhs, rhs};
+        };
+        // The pointer of the `i`-th element of the array at `pointer`
+        const auto elementPointer = [&allocator](const TString& pointer, uint64_t i) {
+            // Copying a string with a polymorphic allocator would take the default resource
+            auto result = TString(pointer, allocator);
+            result += '/';
+            const auto begin = result.size();
+            do {
+                result += static_cast<char>('0' + i % 10);
+                i /= 10;
+            } while (i != 0);
+            std::reverse(result.begin() + static_cast<std::ptrdiff_t>(begin), result.end());
+            return result;
+        };
+
+        auto changes = DocumentChanges<TBeforeAllocator>(allocator);
+        // The items are popped from the back, so the items of a container are pushed in reverse
+        auto stack = TItems(allocator);
+        stack.push_back(compare(TString(allocator), before.RootNode(), after.RootNode()));
+        auto items = TItems(allocator);
+        while (!stack.empty()) {
+            auto item = std::move(stack.back());
+            stack.pop_back();
+            const auto& lhs = item.BeforeNode;
+            const auto& rhs = item.AfterNode;
+            if (!item.Compare) {
+                changes.push_back(std::move(item.Change));
+                continue;
+            }
+            if (before.Same(lhs, after, rhs)) continue;
+            const auto bothContainers = lhs.Container != NIndex::kNone && rhs.Container != NIndex::kNone;
+            if (!bothContainers || isMapping(beforeView, lhs) != isMapping(afterView, rhs)) {
+                changes.push_back(std::move(item.Change));
+                continue;
+            }
+            const auto& lhsRecord = beforeView.Containers[lhs.Container];
+            const auto& rhsRecord = afterView.Containers[rhs.Container];
+            const auto& pointer = item.Change.Pointer;
+            items.clear();
+            if (!lhsRecord.IsMapping()) {
+                for (uint64_t i = 0; i != std::max(lhsRecord.NChildren, rhsRecord.NChildren); ++i) {
+                    auto childPointer = elementPointer(pointer, i);
+                    if (i >= rhsRecord.NChildren) {
+                        items.push_back(report(EKind::Removed, std::move(childPointer), before.ChildNode(beforeView, lhsRecord.FirstChild + i), {}));
+                    } else if (i >= lhsRecord.NChildren) {
+                        items.push_back(report(EKind::Added, std::move(childPointer), {}, after.ChildNode(afterView, rhsRecord.FirstChild + i)));
+                    } else {
+                        const auto lhsChild = before.ChildNode(beforeView, lhsRecord.FirstChild + i);
+                        const auto rhsChild = after.ChildNode(afterView, rhsRecord.FirstChild + i);
+                        items.push_back(compare(std::move(childPointer), lhsChild, rhsChild));
+                    }
+                }
+            } else {
+                const auto keyOf = [](const DocumentIndexView& view, uint64_t childIdx) {
+                    const auto& child = view.Children[childIdx];
+                    return view.Data.substr(child.KeyBegin, child.KeyLen);
+                };
+                // Returns the first child of `container` with the key of `childIdx` (of `view`)
+                const auto find = [&](const DocumentIndexView& inView, uint64_t container, const DocumentIndexView& view, uint64_t childIdx) {
+                    const auto key = keyOf(view, childIdx);
+                    return inView.FindChild(container, view.Children[childIdx].KeyHash, [key](std::string_view other) {
+                        return other <=> key;
+                    });
+                };
+                for (auto i = lhsRecord.FirstChild; i != lhsRecord.FirstChild + lhsRecord.NChildren; ++i) {
+                    // Only the first occurrence of a key is compared
+                    if (find(beforeView, lhs.Container, beforeView, i) != i) continue;
+                    auto childPointer = TString(pointer, allocator);
+                    NUtils::AppendPointerSegment(childPointer, keyOf(beforeView, i));
+                    const auto j = find(afterView, rhs.Container, beforeView, i);
+                    if (j == NIndex::kNone) {
+                        items.push_back(report(EKind::Removed, std::move(childPointer), before.ChildNode(beforeView, i), {}));
+                        continue;
+                    }
+                    const auto lhsChild = before.ChildNode(beforeView, i);
+                    const auto rhsChild = after.ChildNode(afterView, j);
+                    if (before.Same(lhsChild, after, rhsChild)) continue;
+                    items.push_back(compare(std::move(childPointer), lhsChild, rhsChild));
+                }
+                for (auto j = rhsRecord.FirstChild; j != rhsRecord.FirstChild + rhsRecord.NChildren; ++j) {
+                    if (find(afterView, rhs.Container, afterView, j) != j) continue;
+                    if (find(beforeView, lhs.Container, afterView, j) != NIndex::kNone) continue;
+                    auto childPointer = TString(pointer, allocator);
+                    NUtils::AppendPointerSegment(childPointer, keyOf(afterView, j));
+                    items.push_back(report(EKind::Added, std::move(childPointer), {}, after.ChildNode(afterView, j)));
+                }
+                // Only the order of the keys differs
+                if (items.empty()) {
+                    changes.push_back(std::move(item.Change));
+                    continue;
+                }
+            }
+            for (auto it = items.rbegin(); it != items.rend(); ++it) stack.push_back(std::move(*it));
+        }
+        return changes;
+    }
+
+    // Same as `Diff(StructuralHashes::Build(before, options), StructuralHashes::Build(after, options))`
+    constexpr auto Diff(
+        const JsonValue& before,
+        const JsonValue& after,
+        StructuralHashOptions options = {}
+    ) -> Expected<DocumentChanges<>> {
+        const auto beforeHashes = StructuralHashes::Build(before, options);
+        if (beforeHashes.HasError()) return beforeHashes.Error();
+        const auto afterHashes = StructuralHashes::Build(after, options);
+        if (afterHashes.HasError()) return afterHashes.Error();
+        return Diff(beforeHashes.Value(), afterHashes.Value());
+    }
+} // namespace NJsonParser
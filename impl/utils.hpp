@@ -3,9 +3,14 @@
 
 #include "error.hpp"
 #include "expected.hpp"
+#include "instrumentation.hpp"
 #include "line_position_counter.hpp"
+#include "simd.hpp"
 
+#include <bit>
+#include <cstring>
 #include <iostream>
+#include <optional>
 #include <string>
 
 
@@ -14,13 +19,149 @@ namespace NJsonParser::NUtils {
     // Have to write an implementation of `IsSpace` by hand, because
     // in c++20 and even 23 `std::isspace` is not constexpr
     constexpr auto IsSpace(char ch) -> bool {
-        return kSpaces.find(ch) != std::string_view::npos;
+        return ch == ' ' || ch == '\t' || ch == '\n';
     }
     constexpr auto StripSpaces(std::string_view str) -> std::string_view {
-        const auto start = str.find_first_not_of(kSpaces);
-        if (start == std::string_view::npos) return {};
-        const auto end = str.find_last_not_of(kSpaces);
-        return str.substr(start, end - start + 1);
+        if (str.empty() || (!IsSpace(str.front()) && !IsSpace(str.back()))) return str;
+        if (std::is_constant_evaluated()) {
+            const auto start = str.find_first_not_of(kSpaces);
+            if (start == std::string_view::npos) return {};
+            const auto end = str.find_last_not_of(kSpaces);
+            return str.substr(start, end - start + 1);
+        }
+        auto newlines = NSimd::Newlines{};
+        const auto start = NSimd::GetKernels().SkipSpaces(str.data(), str.data() + str.size(), newlines);
+        str.remove_prefix(static_cast<size_t>(start - str.data()));
+        while (!str.empty() && IsSpace(str.back())) str.remove_suffix(1);
+        return str;
+    }
+
+    // Moves `lpCounter` over the characters `[begin, end)` passed over by a kernel
+    // (see `impl/simd.hpp`), which counted the newlines among them
+    inline auto ProcessSkipped(
+        LinePositionCounter& lpCounter,
+        const char* begin,
+        const char* end,
+        const NSimd::Newlines& newlines
+    ) noexcept -> void {
+        if (newlines.Count == 0) {
+            lpCounter.Position += static_cast<uint16_t>(end - begin);
+        } else {
+            lpCounter.LineNumber += static_cast<uint16_t>(newlines.Count);
+            lpCounter.Position = static_cast<uint16_t>(end - newlines.Last - 1);
+        }
+    }
+
+    // Returns the position of the first byte of `str` starting from `pos` that doesn't belong
+    // to a valid UTF-8 sequence (overlong encodings, surrogates and code points above U+10FFFF
+    // are not valid), or `str.size()` if there is none. At run-time, ASCII text is skipped
+    // by the SIMD kernels
+    constexpr auto FindInvalidUtf8(std::string_view str, size_t pos = 0) noexcept -> size_t {
+        while (pos != str.size()) {
+            if (!std::is_constant_evaluated()) {
+                const auto end = NSimd::GetKernels().SkipAscii(str.data() + pos, str.data() + str.size());
+                pos = static_cast<size_t>(end - str.data());
+                if (pos == str.size()) break;
+            }
+            const auto lead = static_cast<uint8_t>(str[pos]);
+            if (lead < 0x80) {
+                ++pos;
+                continue;
+            }
+            size_t len = 0;
+            uint32_t codePoint = 0;
+            uint32_t minCodePoint = 0;
+            if ((lead & 0xE0) == 0xC0) len = 2, codePoint = lead & 0x1F, minCodePoint = 0x80;
+            else if ((lead & 0xF0) == 0xE0) len = 3, codePoint = lead & 0x0F, minCodePoint = 0x800;
+            else if ((lead & 0xF8) == 0xF0) len = 4, codePoint = lead & 0x07, minCodePoint = 0x10000;
+            else return pos;
+            if (str.size() - pos < len) return pos;
+            for (size_t i = 1; i != len; ++i) {
+                const auto continuation = static_cast<uint8_t>(str[pos + i]);
+                if ((continuation & 0xC0) != 0x80) return pos;
+                codePoint = (codePoint << 6) | (continuation & 0x3F);
+            }
+            if (codePoint < minCodePoint || codePoint > 0x10FFFF || (0xD800 <= codePoint && codePoint <= 0xDFFF)) return pos;
+            pos += len;
+        }
+        return str.size();
+    }
+
+    // A simple non-cryptographic 64-bit hash (FNV-1a) that can be computed
+    // both at compile- and run-time. Used to speed up key comparisons
+    // The hash of a concatenation of two strings can be computed as `Hash(second, Hash(first))`
+    constexpr inline uint64_t kHashSeed = 0xcbf29ce484222325;
+    constexpr auto Hash(std::string_view str, uint64_t seed = kHashSeed) noexcept -> uint64_t {
+        auto hash = seed;
+        for (char ch : str) {
+            hash ^= static_cast<uint8_t>(ch);
+            hash *= 0x100000001b3;
+        }
+        return hash;
+    }
+
+    // A fast 64-bit hash of large buffers (the XXH64 algorithm). The input is consumed in 32-byte
+    // blocks by four independent accumulators, so, unlike `Hash`, it runs at about the speed of
+    // reading memory. Used to identify whole documents by their contents
+    constexpr auto ContentHash(std::string_view data, uint64_t seed = 0) noexcept -> uint64_t {
+        constexpr uint64_t p1 = 11400714785074694791ull;
+        constexpr uint64_t p2 = 14029467366897019727ull;
+        constexpr uint64_t p3 = 1609587929392839161ull;
+        constexpr uint64_t p4 = 9650029242287828579ull;
+        constexpr uint64_t p5 = 2870177450012600261ull;
+        constexpr auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+        constexpr auto round = [rotl](uint64_t acc, uint64_t input) {
+            return rotl(acc + input * p2, 31) * p1;
+        };
+        constexpr auto mergeRound = [round](uint64_t acc, uint64_t val) {
+            return (acc ^ round(0, val)) * p1 + p4;
+        };
+        // Little-endian loads that also work at compile time
+        const auto load = [data](size_t pos, size_t nBytes) {
+            uint64_t result = 0;
+            if (std::is_constant_evaluated()) {
+                for (size_t i = 0; i != nBytes; ++i) {
+                    result |= uint64_t{static_cast<uint8_t>(data[pos + i])} << (8 * i);
+                }
+            } else {
+                std::memcpy(&result, data.data() + pos, nBytes);
+                if constexpr (std::endian::native == std::endian::big) {
+                    result = __builtin_bswap64(result) >> (8 * (8 - nBytes));
+                }
+            }
+            return result;
+        };
+
+        size_t pos = 0;
+        uint64_t hash;
+        if (data.size() >= 32) {
+            uint64_t v1 = seed + p1 + p2, v2 = seed + p2, v3 = seed, v4 = seed - p1;
+            for (; pos + 32 <= data.size(); pos += 32) {
+                v1 = round(v1, load(pos, 8));
+                v2 = round(v2, load(pos + 8, 8));
+                v3 = round(v3, load(pos + 16, 8));
+                v4 = round(v4, load(pos + 24, 8));
+            }
+            hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            hash = mergeRound(mergeRound(mergeRound(mergeRound(hash, v1), v2), v3), v4);
+        } else {
+            hash = seed + p5;
+        }
+        hash += data.size();
+        for (; pos + 8 <= data.size(); pos += 8) {
+            hash = rotl(hash ^ round(0, load(pos, 8)), 27) * p1 + p4;
+        }
+        if (pos + 4 <= data.size()) {
+            hash = rotl(hash ^ (load(pos, 4) * p1), 23) * p2 + p3;
+            pos += 4;
+        }
+        for (; pos != data.size(); ++pos) {
+            hash = rotl(hash ^ (static_cast<uint8_t>(data[pos]) * p5), 11) * p1;
+        }
+        hash ^= hash >> 33; hash *= p2;
+        hash ^= hash >> 29; hash *= p3;
+        hash ^= hash >> 32;
+        return hash;
     }
 
     constexpr auto FindFirstOf(
@@ -39,6 +180,138 @@ namespace NJsonParser::NUtils {
         return std::string_view::npos;
     }
 
+    // Same as `FindFirstOf` with the `!IsSpace(ch)` predicate, but at run-time
+    // the spaces are skipped by the SIMD kernels
+    constexpr auto SkipSpaces(
+        std::string_view str,
+        LinePositionCounter& lpCounter,
+        std::string_view::size_type startPos = 0
+    ) -> std::string_view::size_type {
+        if (std::is_constant_evaluated()) {
+            return FindFirstOf(str, lpCounter, [](char ch) { return !IsSpace(ch); }, startPos);
+        }
+        if (startPos >= str.size()) return std::string_view::npos;
+        // Most values are preceded by a single space or by none
+        if (!IsSpace(str[startPos])) return startPos;
+        lpCounter.Process(str[startPos++]);
+        if (startPos != str.size() && !IsSpace(str[startPos])) return startPos;
+        auto newlines = NSimd::Newlines{};
+        const auto begin = str.data() + startPos;
+        const auto end = NSimd::GetKernels().SkipSpaces(begin, str.data() + str.size(), newlines);
+        ProcessSkipped(lpCounter, begin, end, newlines);
+        return end == str.data() + str.size() ? std::string_view::npos : static_cast<size_t>(end - str.data());
+    }
+
+    // A stack of the kinds of the open brackets. The innermost `kInlineDepth` of them are kept
+    // in the bits of an integer, and only deeper ones go to a string, so that scanning a value
+    // usually neither allocates nor (at compile time) spends evaluation steps on a `std::string`
+    class BracketStack {
+    public:
+        static constexpr size_t kInlineDepth = 64;
+    private:
+        // The bit of the innermost bracket is the lowest one; 1 stands for '{'
+        uint64_t Bits = 0;
+        size_t Depth = 0;
+        std::string Overflow;
+    public:
+        constexpr auto Empty() const noexcept -> bool {
+            return Depth == 0;
+        }
+        constexpr auto Size() const noexcept -> size_t {
+            return Depth;
+        }
+        constexpr auto Top() const noexcept -> char {
+            return (Bits & 1) ? '{' : '[';
+        }
+        constexpr auto Push(char bracket) -> void {
+            if (Depth >= kInlineDepth) {
+                if (Overflow.size() == Overflow.capacity()) {
+                    NInstrumentation::Count(&NInstrumentation::Counters::Allocations);
+                }
+                Overflow.push_back((Bits >> 63) ? '{' : '[');
+            }
+            Bits = (Bits << 1) | (bracket == '{' ? 1 : 0);
+            ++Depth;
+        }
+        constexpr auto Pop() -> void {
+            Bits >>= 1;
+            --Depth;
+            if (Depth >= kInlineDepth) {
+                Bits |= uint64_t{Overflow.back() == '{'} << 63;
+                Overflow.pop_back();
+            }
+        }
+    };
+
+    // Skips over the contents of the open strings and containers (`stack` and `insideString` describe
+    // the state at `it`) a block of `NSimd::kBlockSize` characters at a time: the strings are found
+    // with a prefix xor of the mask of the double quotes of a block, so that only the brackets outside
+    // of them are looked at one by one, and blocks without such brackets are skipped as a whole.
+    // Stops at the character that closes the outermost open string or container, or at a closing
+    // bracket that doesn't match the innermost open one (both are left for the caller to process),
+    // or at `end`, updating `stack` and `insideString`
+    inline auto SkipNested(
+        const char* it,
+        const char* end,
+        BracketStack& stack,
+        bool& insideString,
+        NSimd::Newlines& newlines
+    ) -> const char* {
+        const auto& kernels = NSimd::GetKernels();
+        const auto countNewlines = [&newlines](const char* block, uint64_t mask) {
+            if (!mask) return;
+            newlines.Count += static_cast<size_t>(std::popcount(mask));
+            newlines.Last = block + (63 - std::countl_zero(mask));
+        };
+        if (stack.Empty()) {
+            // A string outside of any container ends at the next double quote
+            return kernels.FindStructural(it, end, true, newlines);
+        }
+        char padded[NSimd::kBlockSize];
+        it = kernels.FindStructural(it, end, insideString, newlines);
+        while (it != end) {
+            // Small containers end right at the next character that matters
+            if (!insideString && stack.Size() == 1 && (*it == ']' || *it == '}')) return it;
+            const auto n = static_cast<size_t>(end - it) < NSimd::kBlockSize ? static_cast<size_t>(end - it) : NSimd::kBlockSize;
+            auto block = it;
+            if (n != NSimd::kBlockSize) {
+                // Spaces don't change anything
+                std::memset(padded, ' ', sizeof(padded));
+                std::memcpy(padded, it, n);
+                block = padded;
+            }
+            const auto masks = kernels.ClassifyBlock(block);
+            const auto inside = (masks.Quotes ? NSimd::PrefixXor(masks.Quotes) : 0) ^ (insideString ? ~uint64_t{0} : 0);
+            const auto brackets = (masks.Opening | masks.Closing) & ~inside;
+            auto stop = NSimd::kBlockSize;
+            for (auto rest = brackets; rest; rest &= rest - 1) {
+                const auto i = static_cast<size_t>(std::countr_zero(rest));
+                const auto ch = block[i];
+                if (ch == '[' || ch == '{') {
+                    stack.Push(ch);
+                } else if (stack.Size() == 1 || stack.Top() != (ch == ']' ? '[' : '{')) {
+                    stop = i;
+                    break;
+                } else {
+                    stack.Pop();
+                }
+            }
+            if (stop != NSimd::kBlockSize) {
+                countNewlines(it, masks.Newlines & ((uint64_t{1} << stop) - 1));
+                // The state before the character at `stop`
+                insideString = (((inside ^ masks.Quotes) >> stop) & 1) != 0;
+                return it + stop;
+            }
+            countNewlines(it, masks.Newlines);
+            insideString = (inside >> 63) != 0;
+            it += n;
+            // Long runs without any characters that matter (long strings, arrays of numbers)
+            // are skipped faster by looking only for the next such character
+            if (!masks.Quotes && !brackets) it = kernels.FindStructural(it, end, insideString, newlines);
+        }
+        return end;
+    }
+
     constexpr auto FindFirstOfWithZeroBracketBalance(
         std::string_view str,
         LinePositionCounter& lpCounter,
@@ -46,50 +319,98 @@ namespace NJsonParser::NUtils {
         std::string_view::size_type pos = 0
     ) -> Expected<std::string_view::size_type> { 
         if (str.size() <= pos) return std::string_view::npos;
-        auto stack = std::string{};
-        auto prevLpCounter = lpCounter;
+        auto stack = BracketStack{};
         // indicates whether we are currently parsing a string literal
         bool insideStringLiteral = false;
-        for (char ch : str.substr(pos)) {
+        // Instead of processing every character with `lpCounter`, only the newlines are
+        // counted, and the resulting line and position are computed once, at the end
+        const auto startPos = pos;
+        const auto startLpCounter = lpCounter;
+        size_t nNewlines = 0;
+        size_t lastNewlinePos = 0;
+        const auto lpCounterAt = [&](std::string_view::size_type endPos) {
+            auto result = startLpCounter;
+            if (nNewlines == 0) {
+                result.Position += static_cast<uint16_t>(endPos - startPos);
+            } else {
+                result.LineNumber += static_cast<uint16_t>(nNewlines);
+                result.Position = static_cast<uint16_t>(endPos - lastNewlinePos - 1);
+            }
+            return result;
+        };
+        const auto countScanned = [startPos](std::string_view::size_type endPos) {
+            NInstrumentation::Count(&NInstrumentation::Counters::BytesScanned, endPos - startPos);
+        };
+        const auto* const begin = str.data();
+        const auto* const end = begin + str.size();
+        for (auto it = begin + pos; it != end; ++it) {
+            // At run-time, the contents of strings and containers are skipped with `SkipNested`
+            // up to the character that closes the value (or up to a bracket mismatch)
+            if (!std::is_constant_evaluated() && (insideStringLiteral || !stack.Empty())) {
+                {
+                    auto newlines = NSimd::Newlines{};
+                    it = SkipNested(it, end, stack, insideStringLiteral, newlines);
+                    if (newlines.Count != 0) {
+                        nNewlines += newlines.Count;
+                        lastNewlinePos = static_cast<size_t>(newlines.Last - begin);
+                    }
+                }
+                if (it == end) break;
+            }
+            const auto ch = *it;
+            pos = static_cast<size_t>(it - begin);
             if (ch == '"') insideStringLiteral = !insideStringLiteral;
             if (!insideStringLiteral) {
                 switch (ch) {
                     case '[':
                     case '{':
-                        stack.push_back(ch); break;
+                        stack.Push(ch); break;
                     case ']':
-                        if (stack.empty() || stack.back() != '[') return MakeError(
-                            lpCounter,
-                            NError::ErrorCode::SyntaxError,
-                            "brackets mismatch: encountered an excess ']'"
-                        );
-                        stack.pop_back(); break;
                     case '}':
-                        if (stack.empty() || stack.back() != '{') return MakeError(
-                            lpCounter,
-                            NError::ErrorCode::SyntaxError,
-                            "brackets mismatch: encountered an excess '}'"
-                        );
-                        stack.pop_back(); break;
+                        if (stack.Empty() || stack.Top() != (ch == ']' ? '[' : '{')) {
+                            countScanned(pos + 1);
+                            lpCounter = lpCounterAt(pos);
+                            return MakeError(
+                                lpCounter,
+                                NError::ErrorCode::SyntaxError,
+                                ch == ']'
+                                    ? "brackets mismatch: encountered an excess ']'"
+                                    : "brackets mismatch: encountered an excess '}'"
+                            );
+                        }
+                        stack.Pop(); break;
+                }
+                if (stack.Empty() && predicate(ch)) {
+                    countScanned(pos + 1);
+                    lpCounter = lpCounterAt(pos);
+                    return pos;
                 }
-                const auto balance = stack.size();
-                if (balance == 0 && predicate(ch)) return pos;
             }
-            prevLpCounter = lpCounter;
-            lpCounter.Process(ch);
-            ++pos;
+            if (ch == '\n') {
+                ++nNewlines;
+                lastNewlinePos = pos;
+            }
+        }
+        pos = str.size();
+        countScanned(pos);
+        lpCounter = lpCounterAt(pos);
+        if (!stack.Empty() || insideStringLiteral) {
+            // The errors point to the last character
+            auto prevLpCounter = lpCounter;
+            if (str.back() != '\n') --prevLpCounter.Position;
+            else prevLpCounter = startLpCounter.Copy().Process(str.substr(startPos, str.size() - 1 - startPos));
+            if (!stack.Empty()) return MakeError(
+                prevLpCounter,
+                NError::ErrorCode::SyntaxError,
+                "brackets mismatch: encountered some unmatched opening brackets"
+            );
+            return MakeError(
+                prevLpCounter,
+                NError::ErrorCode::SyntaxError,
+                "a double quote (\") is probably missing "
+                "at the end of a string"
+            );
         }
-        if (const auto balance = stack.size(); balance != 0) return MakeError(
-            prevLpCounter,
-            NError::ErrorCode::SyntaxError,
-            "brackets mismatch: encountered some unmatched opening brackets"
-        );
-        if (insideStringLiteral) return MakeError(
-            prevLpCounter,
-            NError::ErrorCode::SyntaxError,
-            "a double quote (\") is probably missing "
-            "at the end of a string"
-        );
         return std::string_view::npos;
     }
 
@@ -106,11 +427,7 @@ namespace NJsonParser::NUtils {
             pos
         ); if (result.HasError()) return result;
         pos = result.Value(); if (pos == std::string_view::npos) return pos;
-        return FindFirstOf(
-            str, lpCounter.Process(str[pos]),
-            [](char ch) { return !IsSpace(ch); },
-            pos + 1
-        );
+        return SkipSpaces(str, lpCounter.Process(str[pos]), pos + 1);
     }
 
     constexpr auto FindCurElementEndPos(
@@ -127,4 +444,101 @@ namespace NJsonParser::NUtils {
             pos
         );
     } 
+
+    // The number of elements of an array (or, if `isMapping`, of key-value pairs of a mapping)
+    // with the contents `str`, the same as iterating over them would give, found by looking only
+    // at the brackets, the double quotes and the separators outside of the elements. At run-time,
+    // the characters are classified `NSimd::kBlockSize` at a time, and the separators of the outer
+    // level are counted with popcount. Returns nothing if the contents are malformed (mismatched
+    // brackets, an unterminated string, keys and values out of order): the iterators stop
+    // at the first error, and only they can tell how many elements there are before it
+    constexpr auto CountElements(std::string_view str, bool isMapping) -> std::optional<size_t> {
+        NInstrumentation::CountContainerScan(str.data());
+        NInstrumentation::Count(&NInstrumentation::Counters::BytesScanned, str.size());
+        auto stack = BracketStack{};
+        bool insideString = false;
+        // ',' in arrays, ':' and ',' in turn in mappings
+        size_t nSeparators = 0;
+        auto lastSeparatorPos = std::string_view::npos;
+        if (std::is_constant_evaluated()) {
+            for (size_t pos = 0; pos != str.size(); ++pos) {
+                const auto ch = str[pos];
+                if (ch == '"') insideString = !insideString;
+                if (insideString) continue;
+                switch (ch) {
+                    case '[':
+                    case '{':
+                        stack.Push(ch); break;
+                    case ']':
+                    case '}':
+                        if (stack.Empty() || stack.Top() != (ch == ']' ? '[' : '{')) return std::nullopt;
+                        stack.Pop(); break;
+                    case ',':
+                    case ':':
+                        if (!stack.Empty() || (!isMapping && ch == ':')) break;
+                        if (isMapping && ch != (nSeparators % 2 == 0 ? ':' : ',')) return std::nullopt;
+                        ++nSeparators;
+                        lastSeparatorPos = pos;
+                }
+            }
+        } else {
+            const auto& kernels = NSimd::GetKernels();
+            const auto below = [](size_t i) {
+                return i >= NSimd::kBlockSize ? ~uint64_t{0} : (uint64_t{1} << i) - 1;
+            };
+            char padded[NSimd::kBlockSize];
+            for (size_t pos = 0; pos < str.size();) {
+                const auto n = str.size() - pos < NSimd::kBlockSize ? str.size() - pos : NSimd::kBlockSize;
+                auto block = str.data() + pos;
+                if (n != NSimd::kBlockSize) {
+                    std::memset(padded, ' ', sizeof(padded));
+                    std::memcpy(padded, block, n);
+                    block = padded;
+                }
+                const auto masks = kernels.ClassifyBlock(block);
+                const auto inside = (masks.Quotes ? NSimd::PrefixXor(masks.Quotes) : 0) ^ (insideString ? ~uint64_t{0} : 0);
+                const auto separators = (isMapping ? masks.Commas | masks.Colons : masks.Commas) & ~inside;
+                // The separators between the brackets that are reached with an empty stack
+                auto outer = uint64_t{0};
+                size_t from = 0;
+                for (auto rest = (masks.Opening | masks.Closing) & ~inside; rest; rest &= rest - 1) {
+                    const auto i = static_cast<size_t>(std::countr_zero(rest));
+                    if (stack.Empty()) outer |= separators & below(i) & ~below(from);
+                    const auto ch = block[i];
+                    if (ch == '[' || ch == '{') {
+                        stack.Push(ch);
+                    } else if (stack.Empty() || stack.Top() != (ch == ']' ? '[' : '{')) {
+                        return std::nullopt;
+                    } else {
+                        stack.Pop();
+                    }
+                    from = i + 1;
+                }
+                if (stack.Empty()) outer |= separators & ~below(from);
+                if (outer) {
+                    // The odd-numbered separators of a mapping must be the colons
+                    const auto odd = NSimd::PrefixXor(outer) ^ (nSeparators % 2 != 0 ? ~uint64_t{0} : 0);
+                    if (isMapping && (odd & outer) != (masks.Colons & outer)) return std::nullopt;
+                    nSeparators += static_cast<size_t>(std::popcount(outer));
+                    lastSeparatorPos = pos + static_cast<size_t>(63 - std::countl_zero(outer));
+                }
+                insideString = (inside >> 63) != 0;
+                pos += n;
+                // Inside long strings and nested values, only the next double quote or bracket matters
+                if (!masks.Quotes && !(masks.Opening | masks.Closing) && (insideString || !stack.Empty())) {
+                    auto newlines = NSimd::Newlines{};
+                    pos = static_cast<size_t>(kernels.FindStructural(str.data() + pos, str.data() + str.size(), insideString, newlines) - str.data());
+                }
+            }
+        }
+        if (!stack.Empty() || insideString) return std::nullopt;
+        auto lpCounter = LinePositionCounter{};
+        const auto tailPos = lastSeparatorPos == std::string_view::npos ? 0 : lastSeparatorPos + 1;
+        const auto blankTail = SkipSpaces(str, lpCounter, tailPos) == std::string_view::npos;
+        // A trailing separator followed only by spaces doesn't start an element
+        if (!isMapping) return nSeparators + (blankTail ? 0 : 1);
+        // A key without a colon after it is iterated over as a pair with an erroneous value
+        if (nSeparators % 2 == 0 && !blankTail) return std::nullopt;
+        return (nSeparators + 1) / 2;
+    }
 }
@@ -0,0 +1,341 @@
+#pragma once
+
+
+#include "api.hpp"
+#include "error.hpp"
+#include "expected.hpp"
+#include "json_value.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+namespace NJsonParser::NUtils {
+    // The character types, which are integral types too (unlike `signed char` and `unsigned char`,
+    // which are also used as small integers, e.g. as `int8_t` and `uint8_t`)
+    template <class T>
+    concept CCharacter = std::same_as<T, char>
+                      || std::same_as<T, wchar_t>
+                      || std::same_as<T, char8_t>
+                      || std::same_as<T, char16_t>
+                      || std::same_as<T, char32_t>;
+
+    // Characters that can't appear in a json string as is
+    constexpr auto NeedsEscape(char ch) noexcept -> bool {
+        return ch == '"' || ch == '\\' || static_cast<uint8_t>(ch) < 0x20;
+    }
+
+    // Returns the position of the first character of `str` starting from `pos`
+    // that needs to be escaped, or `str.size()` if there is none. At run-time,
+    // checks 16 characters at a time when SSE2 is available
+    constexpr auto FindFirstToEscape(std::string_view str, size_t pos = 0) noexcept -> size_t {
+#if defined(__SSE2__)
+        if (!std::is_constant_evaluated()) {
+            const auto quote = _mm_set1_epi8('"');
+            const auto backslash = _mm_set1_epi8('\\');
+            const auto maxControl = _mm_set1_epi8(0x1F);
+            for (; pos + 16 <= str.size(); pos += 16) {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str.data() + pos));
+                // Unsigned `ch <= 0x1F` is the same as `max(ch, 0x1F) == 0x1F`
+                const auto isControl = _mm_cmpeq_epi8(_mm_max_epu8(chunk, maxControl), maxControl);
+                const auto special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                    isControl
+                );
+                if (const auto mask = _mm_movemask_epi8(special)) return pos + std::countr_zero(static_cast<uint32_t>(mask));
+            }
+        }
+#endif
+        for (; pos != str.size(); ++pos) {
+            if (NeedsEscape(str[pos])) return pos;
+        }
+        return str.size();
+    }
+} // namespace NJsonParser::NUtils
+
+namespace NJsonParser {
+    // Serializes json documents. The output goes to one of the following:
+    //   - a caller-provided buffer: `Writer{buffer}`; running out of space is an error;
+    //   - a caller-provided buffer that is flushed to a sink whenever it is full and when
+    //     `Flush()` is called: `Writer{buffer, [&](std::string_view chunk) { out << chunk; }}`;
+    //   - a buffer that grows as needed: `Writer{}`, optionally with a memory resource.
+    //
+    //     auto writer = Writer{};
+    //     writer.BeginMapping()
+    //         .Key("name").Value("gcc")
+    //         .Key("version").Value(11.4)
+    //         .Key("params").Raw(json["params"].Value()) // copied verbatim, without re-serialization
+    //         .EndMapping();
+    //     const Expected<std::string_view> result = writer.Finish();
+    //
+    // Commas and colons are inserted automatically. Strings are escaped, so note that the strings
+    // returned by `JsonValue::As<String>()` and the keys of mappings are still escaped and thus
+    // should be copied with `RawString()` and `RawKey()` (or the whole value with `Raw()`).
+    // Integers are formatted with `std::to_chars`, and floats and doubles -- in the shortest form
+    // that round-trips in their own type. Misuse (like a key outside of a mapping), strings that are not valid UTF-8 and
+    // running out of space are reported as `WriterError` errors by `Finish()`; after the first
+    // error all the calls are ignored.
+    class Writer {
+    public:
+        using TSink = std::function<void(std::string_view)>;
+        static constexpr size_t kMaxDepth = 256;
+    private:
+        std::pmr::vector<char> Storage;
+        std::span<char> Buffer;
+        size_t Size = 0;
+        TSink Sink;
+        bool Growable = false;
+        // The kinds ('[' or '{') of the containers that are currently open
+        std::array<char, kMaxDepth> OpenContainers = {};
+        size_t Depth = 0;
+        bool NeedComma = false;
+        bool AfterKey = false;
+        bool Complete = false;
+        std::optional<NError::Error> ErrorOpt;
+    private:
+        auto Fail(std::string_view info) -> Writer& {
+            if (!ErrorOpt) ErrorOpt = MakeError({}, NError::ErrorCode::WriterError, info);
+            return *this;
+        }
+
+        auto Put(std::string_view str) -> void {
+            while (!ErrorOpt && !str.empty()) {
+                if (Size == Buffer.size()) {
+                    if (Sink) Flush();
+                    else if (Growable) {
+                        Storage.resize(std::max<size_t>(2 * Storage.size(), 256));
+                        Buffer = Storage;
+                    } else {
+                        Fail("the output buffer is too small");
+                        return;
+                    }
+                }
+                const auto n = std::min(str.size(), Buffer.size() - Size);
+                std::copy_n(str.data(), n, Buffer.data() + Size);
+                Size += n;
+                str.remove_prefix(n);
+            }
+        }
+
+        auto PutEscaped(std::string_view str) -> void {
+            for (size_t pos = 0; pos != str.size();) {
+                const auto special = NUtils::FindFirstToEscape(str, pos);
+                Put(str.substr(pos, special - pos));
+                if (special == str.size()) break;
+                switch (const auto ch = str[special]) {
+                    case '"': Put("\\\""); break;
+                    case '\\': Put("\\\\"); break;
+                    case '\n': Put("\\n"); break;
+                    case '\t': Put("\\t"); break;
+                    case '\r': Put("\\r"); break;
+                    case '\b': Put("\\b"); break;
+                    case '\f': Put("\\f"); break;
+                    default: {
+                        constexpr auto kHexDigits = std::string_view{"0123456789abcdef"};
+                        const char escaped[] = {'\\', 'u', '0', '0', kHexDigits[ch >> 4], kHexDigits[ch & 0xF]};
+                        Put({escaped, sizeof(escaped)});
+                    }
+                }
+                pos = special + 1;
+            }
+        }
+
+        // Checks that a value may be written at this point and writes a comma if needed
+        auto BeginValue() -> bool {
+            if (ErrorOpt) return false;
+            if (Depth == 0) {
+                if (Complete) return Fail("the document is already complete"), false;
+                return true;
+            }
+            if (OpenContainers[Depth - 1] == '{') {
+                if (!AfterKey) return Fail("a key is expected before a value in a mapping"), false;
+                AfterKey = false;
+                return true;
+            }
+            if (NeedComma) Put(",");
+            return true;
+        }
+        auto EndValue() -> Writer& {
+            NeedComma = true;
+            Complete = (Depth == 0);
+            return *this;
+        }
+
+        auto Begin(char kind) -> Writer& {
+            if (!BeginValue()) return *this;
+            if (Depth == kMaxDepth) return Fail("the document is nested too deeply");
+            Put({&kind, 1});
+            OpenContainers[Depth++] = kind;
+            NeedComma = false;
+            return *this;
+        }
+        auto WriteKey(std::string_view key, bool escape) -> Writer& {
+            if (ErrorOpt) return *this;
+            if (Depth == 0 || OpenContainers[Depth - 1] != '{') return Fail("a key outside of a mapping");
+            if (AfterKey) return Fail("two keys in a row");
+            if (NUtils::FindInvalidUtf8(key) != key.size()) return Fail("a string is not valid utf-8");
+            if (NeedComma) Put(",");
+            Put("\"");
+            if (escape) PutEscaped(key);
+            else Put(key);
+            Put("\":");
+            AfterKey = true;
+            return *this;
+        }
+        auto WriteString(std::string_view value, bool escape) -> Writer& {
+            if (!BeginValue()) return *this;
+            if (NUtils::FindInvalidUtf8(value) != value.size()) return Fail("a string is not valid utf-8");
+            Put("\"");
+            if (escape) PutEscaped(value);
+            else Put(value);
+            Put("\"");
+            return EndValue();
+        }
+
+        auto End(char kind) -> Writer& {
+            if (ErrorOpt) return *this;
+            if (Depth == 0 || OpenContainers[Depth - 1] != kind) {
+                return Fail(kind == '[' ? "no array to end" : "no mapping to end");
+            }
+            if (AfterKey) return Fail("a key without a value at the end of a mapping");
+            const char closing = (kind == '[' ? ']' : '}');
+            Put({&closing, 1});
+            --Depth;
+            return EndValue();
+        }
+    public:
+        // Writes into a buffer that grows as needed
+        explicit Writer(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : Storage(resource), Growable(true) {}
+        // Writes into `buffer`
+        explicit Writer(std::span<char> buffer) noexcept
+            : Buffer(buffer) {}
+        // Writes into `buffer`, passing its contents to `sink` whenever it gets full
+        Writer(std::span<char> buffer, TSink sink)
+            : Buffer(buffer), Sink(std::move(sink))
+        {
+            if (Buffer.empty()) Fail("the output buffer is too small");
+        }
+        Writer(const Writer&) = delete;
+        auto operator=(const Writer&) -> Writer& = delete;
+        // Moving the storage keeps its memory, so `Buffer` stays valid
+        Writer(Writer&&) noexcept = default;
+        // Assigning storages with different memory resources would copy their elements,
+        // and `Buffer` would refer to the old memory
+        auto operator=(Writer&&) -> Writer& = delete;
+
+        auto BeginArray() -> Writer& { return Begin('['); }
+        auto EndArray() -> Writer& { return End('['); }
+        auto BeginMapping() -> Writer& { return Begin('{'); }
+        auto EndMapping() -> Writer& { return End('{'); }
+
+        // Writes `key`, escaping it. `key` must be valid UTF-8
+        auto Key(std::string_view key) -> Writer& {
+            return WriteKey(key, true);
+        }
+        // Writes `key` in double quotes without escaping it: `key` must be escaped already,
+        // like the keys of the mappings read by the parser
+        auto RawKey(std::string_view key) -> Writer& {
+            return WriteKey(key, false);
+        }
+
+        auto Value(Bool value) -> Writer& {
+            if (!BeginValue()) return *this;
+            Put(value ? "true" : "false");
+            return EndValue();
+        }
+        template <std::integral T>
+        requires (!NUtils::CCharacter<T>)
+        auto Value(T value) -> Writer& {
+            if (!BeginValue()) return *this;
+            char digits[24];
+            const auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+            Put({digits, static_cast<size_t>(end - digits)});
+            return EndValue();
+        }
+        template <std::floating_point T>
+        auto Value(T value) -> Writer& {
+            if (!BeginValue()) return *this;
+            if (!std::isfinite(value)) return Fail("json can't represent infinities and NaNs");
+            // The shortest representation that is parsed back to the same value of type `T`
+            // (so `0.1f` is written as `0.1`, not as the digits of its widened double)
+            char digits[64];
+            const auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+            Put({digits, static_cast<size_t>(end - digits)});
+            return EndValue();
+        }
+        // Writes `value` as a string, escaping it. `value` must be valid UTF-8
+        auto Value(std::string_view value) -> Writer& {
+            return WriteString(value, true);
+        }
+        auto Value(const char* value) -> Writer& {
+            return Value(std::string_view{value});
+        }
+        // A character is neither written as its code nor converted to `Bool`: write it as a string
+        template <NUtils::CCharacter T>
+        auto Value(T value) -> Writer& = delete;
+        auto Null() -> Writer& {
+            if (!BeginValue()) return *this;
+            Put("null");
+            return EndValue();
+        }
+        // Writes `value` in double quotes without escaping it: `value` must be escaped already,
+        // like the strings returned by `JsonValue::As<String>()`
+        auto RawString(std::string_view value) -> Writer& {
+            return WriteString(value, false);
+        }
+        // Copies the serialized data of `value` as is
+        auto Raw(const JsonValue& value) -> Writer& {
+            return Raw(value.GetData());
+        }
+        // Copies `json`, which must be a serialized json value, as is
+        auto Raw(std::string_view json) -> Writer& {
+            if (!BeginValue()) return *this;
+            if (json.empty()) return Fail("an empty raw value");
+            Put(json);
+            return EndValue();
+        }
+
+        // The data that has been written but not flushed to the sink yet
+        auto GetData() const noexcept -> std::string_view {
+            return {Buffer.data(), Size};
+        }
+
+        // Passes all the buffered data to the sink (does nothing if there is no sink)
+        auto Flush() -> void {
+            if (!Sink || Size == 0) return;
+            Sink(GetData());
+            Size = 0;
+        }
+
+        // Checks that the document is complete and flushes it to the sink if there is one.
+        // Returns the written document (or an empty string if it has been flushed to the sink)
+        auto Finish() -> Expected<std::string_view> {
+            if (!ErrorOpt && !Complete) Fail("the document is incomplete");
+            if (ErrorOpt) return *ErrorOpt;
+            Flush();
+            return GetData();
+        }
+
+        // Forgets the written document, but keeps the buffer
+        auto Reset() noexcept -> void {
+            Size = 0;
+            Depth = 0;
+            NeedComma = AfterKey = Complete = false;
+            ErrorOpt.reset();
+        }
+    };
+} // namespace NJsonParser
@@ -2,7 +2,27 @@
 
 
 #include "impl/api.hpp"
+#include "impl/arena.hpp"
 #include "impl/array.hpp"
+#include "impl/batch_parser.hpp"
+#include "impl/binary.hpp"
+#include "impl/columnar.hpp"
+#include "impl/document_cache.hpp"
+#include "impl/document_index.hpp"
+#include "impl/embed.hpp"
 #include "impl/expected.hpp"
+#include "impl/index_file.hpp"
+#include "impl/instrumentation.hpp"
+#include "impl/json_path.hpp"
 #include "impl/json_value.hpp"
+#include "impl/lazy_index.hpp"
 #include "impl/mapping.hpp"
+#include "impl/minify.hpp"
+#include "impl/patch.hpp"
+#include "impl/pointer.hpp"
+#include "impl/query_set.hpp"
+#include "impl/segmented_document.hpp"
+#include "impl/shape_cache.hpp"
+#include "impl/simd.hpp"
+#include "impl/structural_hash.hpp"
+#include "impl/writer.hpp"
@@ -0,0 +1,80 @@
+#pragma once
+
+// Generated from embedded.json by `NJsonParser::EmbedDocument`, do not edit
+
+#include "../parser.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+
+namespace NEmbeddedExample {
+    // The document itself, without the leading and trailing whitespace
+    inline constexpr char kData[] =
+        "{\n"
+        "    \"params\": {\n"
+        "        \"cpp_standard\": 20,\n"
+        "        \"compilers\": [\n"
+        "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        "            {\"version\": \"11.4.0\", \"name\": \"gcc\"}\n"
+        "        ]\n"
+        "    },\n"
+        "    \"escapes\": \"a\\\\b\\tc\",\n"
+        "    \"numbers\": [1, 2.5, -3, true, false, null, [], {}],\n"
+        "    \"large\": {\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, \""
+        "k9\": 9}\n"
+        "}";
+    inline constexpr std::array<NJsonParser::NIndex::ContainerRecord, 9> kContainers = {{
+        {0, 373, 26, 4, 0, 0, {0, 0}, '{', 0},
+        {16, 184, 6, 2, 0, 0, {1, 14}, '{', 0},
+        {67, 178, 4, 2, 0, 0, {3, 21}, '[', 0},
+        {81, 118, 0, 2, 0, 0, {4, 12}, '{', 1},
+        {133, 168, 2, 2, 0, 0, {5, 12}, '{', 0},
+        {228, 266, 8, 8, 0, 0, {9, 15}, '[', 0},
+        {260, 261, 8, 0, 0, 0, {9, 47}, '[', 0},
+        {264, 265, 8, 0, 0, 0, {9, 51}, '{', 1},
+        {282, 371, 16, 10, 0, 0, {10, 13}, '{', 1},
+    }};
+    inline constexpr std::array<NJsonParser::NIndex::ChildRecord, 30> kChildren = {{
+        {83, 4, 14176396743819860870ull, 90, 7, NJsonParser::NIndex::kNone, {4, 21}},
+        {100, 7, 13502572527641750071ull, 110, 8, NJsonParser::NIndex::kNone, {4, 41}},
+        {135, 7, 13502572527641750071ull, 145, 8, NJsonParser::NIndex::kNone, {5, 24}},
+        {156, 4, 14176396743819860870ull, 163, 5, NJsonParser::NIndex::kNone, {5, 42}},
+        {0, 0, 0ull, 81, 38, 3, {4, 12}},
+        {0, 0, 0ull, 133, 36, 4, {5, 12}},
+        {27, 12, 1883367689967826182ull, 42, 2, NJsonParser::NIndex::kNone, {2, 24}},
+        {55, 9, 13404650988662331317ull, 67, 112, 2, {3, 21}},
+        {0, 0, 0ull, 229, 1, NJsonParser::NIndex::kNone, {9, 16}},
+        {0, 0, 0ull, 232, 3, NJsonParser::NIndex::kNone, {9, 19}},
+        {0, 0, 0ull, 237, 2, NJsonParser::NIndex::kNone, {9, 24}},
+        {0, 0, 0ull, 241, 4, NJsonParser::NIndex::kNone, {9, 28}},
+        {0, 0, 0ull, 247, 5, NJsonParser::NIndex::kNone, {9, 34}},
+        {0, 0, 0ull, 254, 4, NJsonParser::NIndex::kNone, {9, 41}},
+        {0, 0, 0ull, 260, 2, 6, {9, 47}},
+        {0, 0, 0ull, 264, 2, 7, {9, 51}},
+        {284, 2, 629956424149115662ull, 289, 1, NJsonParser::NIndex::kNone, {10, 20}},
+        {293, 2, 629957523660743873ull, 298, 1, NJsonParser::NIndex::kNone, {10, 29}},
+        {302, 2, 629954225125859240ull, 307, 1, NJsonParser::NIndex::kNone, {10, 38}},
+        {311, 2, 629955324637487451ull, 316, 1, NJsonParser::NIndex::kNone, {10, 47}},
+        {320, 2, 629960822195628506ull, 325, 1, NJsonParser::NIndex::kNone, {10, 56}},
+        {329, 2, 629961921707256717ull, 334, 1, NJsonParser::NIndex::kNone, {10, 65}},
+        {338, 2, 629958623172372084ull, 343, 1, NJsonParser::NIndex::kNone, {10, 74}},
+        {347, 2, 629959722684000295ull, 352, 1, NJsonParser::NIndex::kNone, {10, 83}},
+        {356, 2, 629947628056089974ull, 361, 1, NJsonParser::NIndex::kNone, {10, 92}},
+        {365, 2, 629948727567718185ull, 370, 1, NJsonParser::NIndex::kNone, {10, 101}},
+        {7, 6, 4990418123820780179ull, 16, 169, 1, {1, 14}},
+        {192, 7, 11529850155731195151ull, 202, 9, NJsonParser::NIndex::kNone, {8, 15}},
+        {218, 7, 14649120916916816585ull, 228, 39, 5, {9, 15}},
+        {274, 5, 12700309194067802324ull, 282, 90, 8, {10, 13}},
+    }};
+    inline constexpr std::array<uint32_t, 0> kKeySlots = {{
+    }};
+    inline constexpr auto kDocument = NJsonParser::DocumentIndexView{
+        .Data = std::string_view{kData, sizeof(kData) - 1},
+        .RootLpCounter = {0, 0},
+        .Containers = kContainers,
+        .Children = kChildren,
+        .KeySlots = kKeySlots,
+    };
+} // namespace NEmbeddedExample
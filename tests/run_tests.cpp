@@ -3,27 +3,69 @@
 
 
 using Test = auto () -> void;
+Test TestArena;
 Test TestArrayAPI;
 Test TestArrayErrorHandling;
 Test TestBasicErrorHandling;
 Test TestBasicValueParsing;
+Test TestBatchParser;
+Test TestBinary;
+Test TestColumnar;
 Test TestComplexStructure;
+Test TestDocumentCache;
+Test TestDocumentIndex;
+Test TestEmbed;
+Test TestIndexFile;
+Test TestInstrumentation;
+Test TestJsonPath;
+Test TestLazyIndex;
 Test TestMappingAPI;
 Test TestMappingErrorHandling;
+Test TestMinify;
+Test TestPatch;
+Test TestPointer;
+Test TestQuerySet;
+Test TestSegmentedDocument;
+Test TestShapeCache;
+Test TestSimd;
+Test TestStructuralHash;
+Test TestVisit;
 Test TestWeirdStringLiterals;
+Test TestWriter;
 
 
 #define RUN_TEST(testName) testName(); std::cout << #testName << " passed!\n"
 
 
 auto main() -> int {
+    RUN_TEST(TestArena);
     RUN_TEST(TestArrayAPI);
     RUN_TEST(TestArrayErrorHandling);
     RUN_TEST(TestBasicErrorHandling);
     RUN_TEST(TestBasicValueParsing);
+    RUN_TEST(TestBatchParser);
+    RUN_TEST(TestBinary);
+    RUN_TEST(TestColumnar);
     RUN_TEST(TestComplexStructure);
+    RUN_TEST(TestDocumentCache);
+    RUN_TEST(TestDocumentIndex);
+    RUN_TEST(TestEmbed);
+    RUN_TEST(TestIndexFile);
+    RUN_TEST(TestInstrumentation);
+    RUN_TEST(TestJsonPath);
+    RUN_TEST(TestLazyIndex);
     RUN_TEST(TestMappingAPI);
     RUN_TEST(TestMappingErrorHandling);
+    RUN_TEST(TestMinify);
+    RUN_TEST(TestPatch);
+    RUN_TEST(TestPointer);
+    RUN_TEST(TestQuerySet);
+    RUN_TEST(TestSegmentedDocument);
+    RUN_TEST(TestShapeCache);
+    RUN_TEST(TestSimd);
+    RUN_TEST(TestStructuralHash);
+    RUN_TEST(TestVisit);
     RUN_TEST(TestWeirdStringLiterals);
+    RUN_TEST(TestWriter);
     std::cout << "All tests passed!\n";
 }
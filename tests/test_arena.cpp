@@ -0,0 +1,94 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestArena() -> void {
+    {   // Memory is bumped out of chunks, and the most recent allocation can be given back
+        auto arena = ArenaResource{256};
+        const auto a = arena.allocate(16, 8);
+        const auto b = arena.allocate(24, 8);
+        assert(static_cast<std::byte*>(b) == static_cast<std::byte*>(a) + 16);
+        assert(arena.GetStats().BytesAllocated == 40);
+        arena.deallocate(b, 24, 8);
+        assert(arena.allocate(32, 8) == b);
+        // Other deallocations are ignored
+        arena.deallocate(a, 16, 8);
+        assert(arena.GetStats().BytesAllocated == 48);
+        // Alignment is respected
+        const auto c = arena.allocate(1, 1);
+        const auto d = arena.allocate(8, 64);
+        assert(reinterpret_cast<uintptr_t>(d) % 64 == 0);
+        assert(d != c);
+        assert(arena.GetStats().NUpstreamAllocations == 1);
+        // Allocations larger than a chunk get a chunk of their own
+        static_cast<void>(arena.allocate(1000, 8));
+        assert(arena.GetStats().NUpstreamAllocations == 2);
+        assert(arena.GetStats().BytesReserved >= 1256);
+        // Resetting keeps only the last (the largest) chunk
+        arena.Reset();
+        assert(arena.GetStats().BytesAllocated == 0);
+        assert(arena.GetStats().BytesReserved < 1256 + 256);
+        static_cast<void>(arena.allocate(1000, 8));
+        assert(arena.GetStats().NUpstreamAllocations == 2);
+        arena.Release();
+        assert(arena.GetStats().BytesReserved == 0);
+    }
+
+    {   // The old buffer of a grown vector is not reclaimed: the new one is allocated first
+        auto arena = ArenaResource{};
+        {
+            auto vec = std::pmr::vector<int32_t>{&arena};
+            vec.reserve(4);
+            const auto old = vec.data();
+            vec.reserve(8);
+            assert(vec.data() != old);
+            assert(arena.GetStats().BytesAllocated == 4 * 4 + 8 * 4);
+        }
+        // Only the most recent allocation, the new buffer, is given back when the vector is destroyed
+        assert(arena.GetStats().BytesAllocated == 4 * 4);
+        arena.Reset();
+        assert(arena.GetStats().BytesAllocated == 0);
+    }
+
+    {   // A caller-provided buffer is used first
+        alignas(16) std::byte buffer[128];
+        auto arena = ArenaResource{buffer};
+        assert(arena.allocate(100, 8) == buffer);
+        static_cast<void>(arena.allocate(100, 8));
+        assert(arena.GetStats().NUpstreamAllocations == 1);
+        arena.Release();
+        assert(arena.allocate(8, 8) == buffer);
+    }
+
+    {   // Document indexes can be built entirely in an arena
+        const auto json = JsonValue{R"({"a": [1, 2, {"b": "c"}], "d": {"e": null}})"};
+        auto arena = ArenaResource{};
+        for (int request = 0; request != 3; ++request) {
+            const auto built = pmr::DocumentIndex::Build(json, &arena);
+            assert(built.Value().get_allocator().resource() == &arena);
+            // Copies keep the allocator
+            const auto index = built.Value();
+            assert(index.get_allocator().resource() == &arena);
+            const auto view = index.View(json).Value();
+            assert(view.Root()["a"][2]["b"].As<String>() == "c");
+            assert(arena.GetStats().BytesAllocated >= 2 * index.MemoryUsage() - 2 * sizeof(index));
+            arena.Reset();
+        }
+        assert(arena.GetStats().NUpstreamAllocations == 1);
+    }
+
+    {   // So can the whole document cache
+        auto pool = std::pmr::unsynchronized_pool_resource{};
+        auto cache = DocumentCache{{.Resource = &pool}};
+        const auto json = JsonValue{R"([{"id": 1}, {"id": 2}])"};
+        const auto index = cache.GetOrBuild(json).Value();
+        assert(index->get_allocator().resource() == &pool);
+        assert(index->View(json).Value().Root()[1]["id"].As<Int>() == 2);
+    }
+}
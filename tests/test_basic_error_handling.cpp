@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <sstream>
+#include <string>
 
 
 using namespace NJsonParser;
@@ -66,4 +67,19 @@ auto TestBasicErrorHandling() -> void {
             "\"mapping key not found\" error (key \"interpreters\" doesn't exist in mapping) at line 5, position 14"
         );
     }
+
+    {   // Brackets are matched at any depth, including the depths at which the open
+        // brackets no longer fit into the bits of `NUtils::BracketStack`
+        auto deep = std::string{};
+        for (size_t depth = 0; depth != 100; ++depth) deep += (depth % 3 ? "[" : "{\"k\": ");
+        auto closing = std::string{};
+        for (size_t depth = 100; depth != 0; --depth) closing += ((depth - 1) % 3 ? "]" : "}");
+        const auto valid = "[" + deep + "0" + closing + ", 1]";
+        assert(JsonValue{valid}[1].As<Int>() == 1);
+        auto mismatched = closing;
+        mismatched[30] = (mismatched[30] == ']' ? '}' : ']');
+        const auto invalid = "[" + deep + "0" + mismatched + ", 1]";
+        assert(JsonValue{invalid}[1].Error().BasicInfo.Code == NError::ErrorCode::SyntaxError);
+        assert(JsonValue{invalid}[1].Error().BasicInfo.Position == 1 + deep.size() + 1 + 30);
+    }
 }
@@ -0,0 +1,104 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // Request-like documents of different sizes and depths, with some scalar, empty and malformed ones
+    auto MakeDocuments(size_t count) -> std::vector<std::string> {
+        auto docs = std::vector<std::string>{};
+        for (size_t i = 0; i != count; ++i) {
+            switch (i % 11) {
+                case 3: docs.push_back(" " + std::to_string(i) + "\n"); continue;
+                case 5: docs.push_back("{\"id\": " + std::to_string(i) + ", \"tags\": [1, 2}"); continue;
+                case 7: docs.push_back(std::string(i % 50 + 1, '[') + std::string(i % 50 + 1, ']')); continue;
+                case 9: docs.push_back(""); continue;
+            }
+            auto doc = "  {\"id\": " + std::to_string(i) + ", \"items\": [";
+            for (size_t j = 0; j != i % 40; ++j) doc += "{\"k" + std::to_string(j) + "\": \"v\"}, ";
+            doc += "null], \"params\": {";
+            for (size_t j = 0; j != i % 13; ++j) doc += "\"p" + std::to_string(12 - j) + "\": " + std::to_string(j) + ", ";
+            doc += "\"last\": true}}\n";
+            docs.push_back(std::move(doc));
+        }
+        return docs;
+    }
+
+    template <class T>
+    auto Same(const Expected<T>& lhs, const Expected<T>& rhs) -> bool {
+        if (lhs.HasValue() != rhs.HasValue()) return false;
+        return lhs.HasValue() ? lhs.Value() == rhs.Value() : lhs.Error() == rhs.Error();
+    }
+} // namespace
+
+
+auto TestBatchParser() -> void {
+    const auto docs = MakeDocuments(100);
+    const auto views = std::vector<std::string_view>(docs.begin(), docs.end());
+    auto parser = BatchParser{};
+
+    {   // The roots are the same as those of the indexes built one by one
+        for (const auto batchSize : {size_t{0}, size_t{1}, BatchParser::kInFlight + 1, views.size()}) {
+            const auto batch = std::span{views}.first(batchSize);
+            const auto roots = parser.Parse(batch);
+            assert(roots.size() == batch.size());
+            for (size_t i = 0; i != batch.size(); ++i) {
+                const auto json = JsonValue{batch[i]};
+                const auto index = DocumentIndex::Build(json);
+                assert(roots[i].HasError() == index.HasError());
+                if (index.HasError()) {
+                    assert(roots[i].Error() == index.Error());
+                    continue;
+                }
+                const auto view = index.Value().View(json).Value();
+                const auto root = view.Root();
+                assert(roots[i].Value().GetJsonValue().GetData() == root.GetJsonValue().GetData());
+                assert(Same(roots[i].size(), root.size()));
+                assert(Same(roots[i]["id"].As<Int>(), root["id"].As<Int>()));
+                assert(Same(roots[i]["items"].size(), root["items"].size()));
+                assert(Same(roots[i]["params"]["p12"].As<Int>(), root["params"]["p12"].As<Int>()));
+                assert(Same(roots[i]["params"]["last"].As<Bool>(), root["params"]["last"].As<Bool>()));
+                assert(roots[i]["params"]["p13"].HasError() && root["params"]["p13"].HasError());
+                assert(Same(roots[i][0].size(), root[0].size()));
+                assert(Same(roots[i].As<Int>(), root.As<Int>()));
+            }
+        }
+    }
+
+    {   // Large mappings and deep documents take many turns
+        const auto large = [] {
+            auto doc = std::string{"{"};
+            for (int i = 0; i != 100; ++i) doc += "\"key" + std::to_string(99 - i) + "\": [" + std::to_string(i) + "], ";
+            return doc + "\"end\": {}}";
+        }();
+        const auto deep = std::string(1000, '[') + "1" + std::string(1000, ']');
+        const auto batch = std::vector<std::string_view>{large, deep, "[1, 2, 3] 4", "{\"a\": 1}"};
+        const auto roots = parser.Parse(batch);
+        assert(roots[0]["key42"][0].As<Int>() == 57);
+        assert(roots[0]["end"].size() == 0u);
+        auto cur = roots[1];
+        for (int i = 0; i != 1000; ++i) cur = cur[0];
+        assert(cur.As<Int>() == 1);
+        assert(roots[2].Error() == DocumentIndex::Build(JsonValue{batch[2]}).Error());
+        assert(roots[3]["a"].As<Int>() == 1);
+    }
+
+    {   // The memory of the parser is taken from its memory resource, and is reused by the next batches
+        auto arena = ArenaResource{};
+        auto arenaParser = BatchParser{&arena};
+        const auto roots = arenaParser.Parse(views);
+        for (size_t i = 0; i != views.size(); ++i) {
+            const auto root = parser.Parse(std::span{views}.subspan(i, 1))[0];
+            assert(Same(roots[i]["id"].As<Int>(), root["id"].As<Int>()));
+        }
+        const auto allocated = arena.GetStats().BytesAllocated;
+        assert(allocated != 0);
+        arenaParser.Parse(views);
+        assert(arena.GetStats().BytesAllocated == allocated);
+    }
+}
@@ -0,0 +1,172 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr auto kSource = std::string_view{
+        "{\n"
+        "    \"params\": {\n"
+        "        \"cpp_standard\": 20,\n"
+        "        \"compilers\": [\n"
+        "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        "            {\"version\": \"11.4.0\", \"name\": \"gcc\"}\n"
+        "        ]\n"
+        "    },\n"
+        "    \"escapes\": \"a\\\\b\\tc\",\n"
+        "    \"numbers\": [1, 2.5, -3, true, false, null, [], {}, 1e3, 100000000000000000000],\n"
+        "    \"large\": {\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, \"k9\": 9, \"k0\": 10},\n"
+        "    \"a/b\": {\"~\": 1}\n"
+        "}\n"
+    };
+
+    // Accessor code that works with both formats
+    template <class TValue>
+    auto Summarize(const TValue& root) -> std::string {
+        auto summary = std::string{};
+        summary += root["params"]["compilers"][1]["name"].template As<String>().Value();
+        summary += std::to_string(root["params"]["cpp_standard"].template As<Int>().Value());
+        for (const auto [key, value] : root["params"]["compilers"][0].template As<Mapping>()) {
+            summary += key.Value();
+            summary += value.template As<String>().Value();
+        }
+        for (const auto elem : root["numbers"].template As<Array>()) {
+            const auto number = elem.template As<Float>();
+            summary += number.HasValue() ? std::to_string(number.Value()) : "-";
+        }
+        summary += std::to_string(root["numbers"].template As<Array>().size().Value());
+        summary += std::to_string(root["large"].template As<Mapping>().size().Value());
+        summary += std::to_string(root.AtPointer("/a~1b/~0").template As<Int>().Value());
+        return summary;
+    }
+
+    // Errors of both formats are the same up to the line and position
+    auto SameError(const NError::Error& lhs, const NError::Error& rhs) -> bool {
+        return lhs.BasicInfo.Code == rhs.BasicInfo.Code && lhs.AdditionalInfo == rhs.AdditionalInfo;
+    }
+
+    constexpr auto kBinary = [] {
+        // The binary form of `[true, "ab", {"k": -2}]`, as produced by `ToBinary`
+        return std::string_view{
+            "\x06\x40\0\0\0" "\x03\0\0\0" "\x15\0\0\0" "\x16\0\0\0" "\x1d\0\0\0"
+            "\x02"
+            "\x05\x02\0\0\0" "ab"
+            "\x07\x23\0\0\0" "\x01\0\0\0" "\0\0\0\0" "\x8a\xfd\x01\x86" "\x01\0\0\0" "\x1a\0\0\0" "k"
+            "\x03\xfe\xff\xff\xff\xff\xff\xff\xff",
+            0x40
+        };
+    }();
+} // namespace
+
+
+auto TestBinary() -> void {
+    const auto json = JsonValue{kSource};
+    const auto binary = ToBinary(json);
+    assert(binary.HasValue());
+    const auto root = BinaryValue{binary.Value()};
+
+    {   // The same accessor code gives the same results with both formats
+        assert(Summarize(root) == Summarize(json));
+        assert(root["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        assert(root["escapes"].As<String>() == "a\\\\b\\tc");
+        assert(root["numbers"][0].As<Int>() == 1);
+        assert(root["numbers"][1].As<Float>() == 2.5);
+        assert(root["numbers"][2].As<Int>() == -3);
+        assert(root["numbers"][3].As<Bool>() == true);
+        assert(root["numbers"][6].As<Array>().size() == 0u);
+        assert(root["numbers"][7].As<Mapping>().size() == 0u);
+        assert(root["numbers"][8].As<Float>() == 1000.0);
+        // Integers that don't fit into `Int` are stored as `Float`
+        assert(root["numbers"][9].As<Float>() == 1e20);
+        // The first occurrence of a duplicate key is found, like with `JsonValue`
+        assert(root["large"]["k0"].As<Int>() == 0 && json["large"]["k0"].As<Int>() == 0);
+        assert(root["large"]["k9"].As<Int>() == 9);
+        assert(root["large"].As<Mapping>().size() == 11u);
+        // Large mappings with sorted keys have no table in the index, but get one in the binary form
+        const auto sorted = JsonValue{R"({"a": 0, "b": 1, "c": 2, "d": 3, "e": 4, "f": 5, "g": 6, "h": 7, "i": 8})"};
+        const auto sortedBinary = ToBinary(sorted).Value();
+        assert(NBinary::ReadU32(sortedBinary, 9) == 32);
+        assert(BinaryValue{sortedBinary}["h"].As<Int>() == 7);
+        assert(BinaryValue{sortedBinary}["j"].HasError());
+        const auto ptr = CompiledPointer<>::Compile("/params/compilers/0/version").Value();
+        assert(ptr.Evaluate(root).As<String>() == "14.0.0");
+    }
+
+    {   // The same errors as those of `JsonValue`
+        const auto checkSame = [&](const Expected<BinaryValue>& lhs, const Expected<JsonValue>& rhs) {
+            assert(lhs.HasError() && rhs.HasError());
+            assert(SameError(lhs.Error(), rhs.Error()));
+        };
+        checkSame(root["params"]["compilers"][2], json["params"]["compilers"][2]);
+        checkSame(root["large"]["k10"], json["large"]["k10"]);
+        checkSame(root["params"][0], json["params"][0]);
+        checkSame(root["numbers"]["x"], json["numbers"]["x"]);
+        checkSame(root.AtPointer("/numbers/x"), json.AtPointer("/numbers/x"));
+        checkSame(root.AtPointer("/escapes/x"), json.AtPointer("/escapes/x"));
+        checkSame(root.AtPointer("params"), json.AtPointer("params"));
+        for (size_t i = 0; i != 8; ++i) {
+            const auto lhs = root["numbers"][i];
+            const auto rhs = json["numbers"][i];
+            if (rhs.As<Int>().HasError()) assert(SameError(lhs.As<Int>().Error(), rhs.As<Int>().Error()));
+            if (rhs.As<Bool>().HasError()) assert(SameError(lhs.As<Bool>().Error(), rhs.As<Bool>().Error()));
+            // (`JsonValue` words the type error for one-character strings differently)
+            if (rhs.As<String>().HasError()) assert(lhs.As<String>().Error().BasicInfo.Code == rhs.As<String>().Error().BasicInfo.Code);
+            if (rhs.As<Array>().HasError()) assert(SameError(lhs.As<Array>().Error(), rhs.As<Array>().Error()));
+            if (rhs.As<Mapping>().HasError()) assert(SameError(lhs.As<Mapping>().Error(), rhs.As<Mapping>().Error()));
+        }
+        assert(BinaryValue{}.As<Int>().Error().BasicInfo.Code == NError::ErrorCode::MissingValueError);
+        // Errors are iterated over as empty containers
+        for ([[maybe_unused]] const auto elem : root["escapes"].As<Array>()) assert(false);
+    }
+
+    {   // The layout of the binary form
+        const auto small = ToBinary(JsonValue{"[true, \"ab\", {\"k\": -2}]"});
+        assert(small.HasValue());
+        assert(small.Value() == kBinary);
+        static_assert(BinaryValue{kBinary}[2]["k"].As<Int>() == -2);
+        static_assert(BinaryValue{kBinary}.As<Array>().size() == 3u);
+        // Scalar documents
+        assert(BinaryValue{ToBinary(JsonValue{"\"str\""}).Value()}.As<String>() == "str");
+        assert(BinaryValue{ToBinary(JsonValue{"-1.5"}).Value()}.As<Float>() == -1.5);
+        // Elements are skipped in O(1) time: every value knows its size
+        assert(root.GetData().size() == binary.Value().size());
+        assert(root["params"].Value().GetData().size() < root.GetData().size());
+    }
+
+    {   // The binary form and the temporary memory are allocated from the given memory resource
+        auto arena = ArenaResource{};
+        const auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        const auto fromArena = ToBinary(json, &arena);
+        std::pmr::set_default_resource(previous);
+        assert(fromArena.Value() == binary.Value());
+        assert(fromArena.Value().get_allocator().resource() == &arena);
+        assert(arena.GetStats().BytesAllocated >= binary.Value().size());
+    }
+
+    {   // Deeply nested documents don't exhaust the call stack
+        const auto depth = 100000;
+        const auto nested = std::string(depth, '[') + std::string(depth, ']');
+        const auto deep = ToBinary(JsonValue{nested});
+        assert(deep.HasValue());
+        auto cur = Expected<BinaryValue>{BinaryValue{deep.Value()}};
+        for (int i = 0; i + 1 != depth; ++i) cur = cur[0];
+        assert(cur.As<Array>().size() == 0u);
+    }
+
+    {   // Invalid documents are rejected
+        assert(ToBinary(JsonValue{"{\"a\": [1, 2}"}).Error() == DocumentIndex::Build(JsonValue{"{\"a\": [1, 2}"}).Error());
+        const auto invalid = ToBinary(JsonValue{"[1, 2, nope]"});
+        assert(invalid.HasError() && invalid.Error().BasicInfo.Code == NError::ErrorCode::TypeError);
+        assert(invalid.Error().BasicInfo.Position == 7);
+        assert(ToBinary(JsonValue{"[12abc]"}).HasError());
+        assert(ToBinary(JsonValue{"[-inf]"}).HasError());
+        assert(ToBinary(JsonValue{"[1e999]"}).Error().BasicInfo.Code == NError::ErrorCode::ResultOutOfRangeError);
+        assert(ToBinary(JsonValue{""}).Error().BasicInfo.Code == NError::ErrorCode::MissingValueError);
+    }
+}
@@ -0,0 +1,124 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <tuple>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestColumnar() -> void {
+    static constexpr auto json = JsonValue{
+        /* line numbers: */
+        /* 0 */ "[                                                   \n"
+        /* 1 */ "    {\"ts\": 1, \"user\": \"alice\", \"v\": 0.5},    \n"
+        /* 2 */ "    {\"user\": \"bob\", \"ts\": 2},                  \n"
+        /* 3 */ "    {\"ts\": \"three\", \"user\": \"carol\", \"v\": 1},\n"
+        /* 4 */ "    42,                                              \n"
+        /* 5 */ "    {\"v\": 2.5, \"ts\": 5, \"ts\": 6}               \n"
+        /* 6 */ "]                                                   \n"
+    };
+
+    {   // Extract several columns of different types in a single pass over the array.
+        // This can be done at compile time:
+        struct TColumns {
+            size_t NRows;
+            std::array<Int, 5> Ts;
+            uint64_t TsValid;
+            std::array<String, 5> Users;
+            uint64_t UsersValid;
+        };
+        constexpr auto columns = []() {
+            auto ts = std::array<Int, 5>{};
+            auto tsValid = std::array<uint64_t, ValidityWords(5)>{};
+            auto users = std::array<String, 5>{};
+            auto usersValid = std::array<uint64_t, ValidityWords(5)>{};
+            const auto nRows = ExtractColumns(
+                json.As<Array>(),
+                Column<Int>{"ts", ts, tsValid},
+                Column<String>{"user", users, usersValid}
+            );
+            return TColumns{nRows.Value(), ts, tsValid[0], users, usersValid[0]};
+        }();
+        static_assert(columns.NRows == 5);
+        // Row 2 has a string instead of an int in the "ts" field, row 3 is not a mapping at all:
+        static_assert(columns.TsValid == 0b10011);
+        // The first occurrence of a repeated key wins:
+        static_assert(columns.Ts[0] == 1 && columns.Ts[1] == 2 && columns.Ts[4] == 5);
+        // Rows 3 and 4 don't have the "user" field:
+        static_assert(columns.UsersValid == 0b00111);
+        static_assert(columns.Users[0] == "alice");
+        static_assert(columns.Users[1] == "bob");
+        static_assert(columns.Users[2] == "carol");
+    }
+
+    {   // A run-time list of columns of the same type
+        auto ts = std::vector<Float>(5);
+        auto v = std::vector<Float>(5);
+        auto tsValid = std::vector<uint64_t>(ValidityWords(5));
+        auto vValid = std::vector<uint64_t>(ValidityWords(5));
+        const auto columns = std::vector<Column<Float>>{
+            {.Field = "v", .Values = v, .Validity = vValid},
+            {.Field = "ts", .Values = ts, .Validity = tsValid},
+        };
+        const auto nRows = ExtractColumns(json.As<Array>(), std::span{columns});
+        assert(nRows == 5u);
+        assert(vValid[0] == 0b10101);
+        assert(v[0] == 0.5 && v[2] == 1 && v[4] == 2.5);
+        assert(columns[1].IsValid(1) && !columns[1].IsValid(2) && columns[1].IsValid(4));
+    }
+
+    {   // Several columns may take the same field, e.g. to read it as values of different types
+        auto tsInt = std::array<Int, 5>{};
+        auto tsIntValid = std::array<uint64_t, 1>{};
+        auto tsString = std::array<String, 5>{};
+        auto tsStringValid = std::array<uint64_t, 1>{};
+        const auto columns = [&] {
+            return std::tuple{Column<Int>{"ts", tsInt, tsIntValid}, Column<String>{"ts", tsString, tsStringValid}};
+        };
+        assert(std::apply([](auto... c) { return ExtractColumns(json.As<Array>(), c...); }, columns()) == 5u);
+        assert(tsIntValid[0] == 0b10011 && tsInt[4] == 5);
+        assert(tsStringValid[0] == 0b00100 && tsString[2] == "three");
+        // The same with the shape cache, and with a run-time list of columns
+        auto cache = ShapeCache{};
+        for (auto i = 0; i != 2; ++i) {
+            assert(std::apply([&](auto... c) { return ExtractColumns(json.As<Array>(), cache, c...); }, columns()) == 5u);
+            assert(tsIntValid[0] == 0b10011 && tsStringValid[0] == 0b00100);
+        }
+        auto vFloat = std::array<Float, 5>{};
+        auto vFloatValid = std::array<uint64_t, 1>{};
+        auto vAgain = std::array<Float, 5>{};
+        auto vAgainValid = std::array<uint64_t, 1>{};
+        const auto floats = std::vector<Column<Float>>{{"v", vFloat, vFloatValid}, {"v", vAgain, vAgainValid}};
+        assert(ExtractColumns(json.As<Array>(), std::span{floats}) == 5u);
+        assert(vFloatValid[0] == 0b10101 && vAgainValid[0] == 0b10101 && vAgain[0] == 0.5);
+    }
+
+    {   // If the columns are too short to hold all the rows, an error is returned
+        auto ts = std::array<Int, 3>{};
+        auto tsValid = std::array<uint64_t, 1>{};
+        const auto nRows = ExtractColumns(json.As<Array>(), Column<Int>{"ts", ts, tsValid});
+        assert(nRows.HasError());
+        assert((nRows.Error() == NError::Error{
+            .BasicInfo = {
+                .LineNumber = 4,
+                .Position = 4, // points at the first row that doesn't fit
+                .Code = NError::ErrorCode::ArrayIndexOutOfRange,
+            },
+            .AdditionalInfo = NError::ArrayIndexOutOfRangeAdditionalInfo{
+                .Index = 3,
+                .ArrayLen = 5,
+            },
+        }));
+    }
+
+    {   // Syntax errors, unlike missing or mistyped fields, abort the extraction
+        constexpr auto malformed = JsonValue{"[{\"ts\": 1}, {\"ts\": [2}]"};
+        auto ts = std::array<Int, 2>{};
+        auto tsValid = std::array<uint64_t, 1>{};
+        const auto nRows = ExtractColumns(malformed.As<Array>(), Column<Int>{"ts", ts, tsValid});
+        assert(nRows.HasError());
+        assert(nRows.Error().BasicInfo.Code == NError::ErrorCode::SyntaxError);
+    }
+}
@@ -0,0 +1,79 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestDocumentCache() -> void {
+    const auto config = std::string{R"({"flags": {"new_ui": true, "beta": false}, "limits": [10, 20]})"};
+
+    {   // Repeated documents are indexed only once, even if they come in different buffers
+        auto cache = DocumentCache{};
+        const auto first = cache.GetOrBuild(JsonValue{config}).Value();
+        const auto copy = std::string{config};
+        const auto second = cache.GetOrBuild(JsonValue{copy}).Value();
+        assert(first == second);
+        const auto view = second->View(JsonValue{copy}).Value();
+        assert(view.Root()["flags"]["new_ui"].As<Bool>() == true);
+        assert(view.Root()["limits"][1].As<Int>() == 20);
+
+        const auto stats = cache.GetStats();
+        assert(stats.Hits == 1);
+        assert(stats.Misses == 1);
+        assert(stats.NEntries == 1);
+        assert(stats.HitRate() == 0.5);
+        assert(stats.MemoryUsage >= first->MemoryUsage() + config.size());
+
+        // Malformed documents are not cached
+        assert(cache.GetOrBuild(JsonValue{"[1, 2"}).HasError());
+        assert(cache.GetStats().NEntries == 1);
+        cache.Clear();
+        assert(cache.GetStats().NEntries == 0);
+        assert(cache.GetStats().MemoryUsage == 0);
+    }
+
+    {   // The least recently used entries are evicted
+        auto cache = DocumentCache{{.MaxEntries = 2}};
+        const auto docs = std::array<std::string, 3>{"[1]", "[2]", "[3]"};
+        const auto evicted = cache.GetOrBuild(JsonValue{docs[0]}).Value();
+        cache.GetOrBuild(JsonValue{docs[1]});
+        cache.GetOrBuild(JsonValue{docs[0]});
+        cache.GetOrBuild(JsonValue{docs[2]}); // evicts "[2]"
+        assert(cache.GetStats().Evictions == 1);
+        assert(cache.GetStats().NEntries == 2);
+        cache.GetOrBuild(JsonValue{docs[0]});
+        assert(cache.GetStats().Hits == 2);
+        cache.GetOrBuild(JsonValue{docs[1]});
+        assert(cache.GetStats().Misses == 4);
+        // An evicted index is still usable by those who hold it
+        assert(evicted->View(JsonValue{docs[0]}).Value().Root()[0].As<Int>() == 1);
+
+        auto tiny = DocumentCache{{.MaxMemoryUsage = 1}};
+        assert(tiny.GetOrBuild(JsonValue{config}).HasValue());
+        assert(tiny.GetStats().NEntries == 0);
+    }
+
+    {   // The cache can be shared between threads
+        auto cache = DocumentCache{{.MaxEntries = 4}};
+        auto docs = std::vector<std::string>{};
+        for (int i = 0; i != 8; ++i) docs.push_back("{\"id\": " + std::to_string(i) + "}");
+        auto threads = std::vector<std::thread>{};
+        for (int t = 0; t != 4; ++t) threads.emplace_back([&cache, &docs, t] {
+            for (int i = 0; i != 1000; ++i) {
+                const auto& doc = docs[(i + t) % docs.size()];
+                const auto index = cache.GetOrBuild(JsonValue{doc}).Value();
+                const auto view = index->View(JsonValue{doc}).Value();
+                assert(view.Root()["id"].As<Int>() == static_cast<Int>((i + t) % docs.size()));
+            }
+        });
+        for (auto& thread : threads) thread.join();
+        const auto stats = cache.GetStats();
+        assert(stats.Hits + stats.Misses == 4000);
+        assert(stats.NEntries <= 4);
+    }
+}
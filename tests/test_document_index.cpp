@@ -0,0 +1,158 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+auto TestDocumentIndex() -> void {
+    static constexpr auto json = JsonValue{
+        /* line numbers: */
+        /* 0 */ "{                                                            \n"
+        /* 1 */ "    \"params\": {                                            \n"
+        /* 2 */ "        \"cpp_standard\": 20,                                \n"
+        /* 3 */ "        \"compilers\": [                                     \n"
+        /* 4 */ "            {\"name\": \"clang\", \"version\": \"14.0.0\"},  \n"
+        /* 5 */ "            {\"version\": \"11.4.0\", \"name\": \"gcc\"},    \n"
+        /* 6 */ "        ]                                                    \n"
+        /* 7 */ "    },                                                       \n"
+        /* 8 */ "    \"a/b\": [1, 2.5, true, \"x\", [], {}],                  \n"
+        /* 9 */ "    \"a/b\": \"a duplicate key\"                             \n"
+        /* 10*/ "}                                                            \n"
+    };
+
+    {   // Navigation through the index gives the same values as navigation through `JsonValue`
+        const auto index = DocumentIndex::Build(json).Value();
+        const auto view = index.View(json).Value();
+        const auto root = view.Root();
+        assert(root.size() == 3u);
+        assert(root.size() == json.As<Mapping>().Value().size());
+        assert(root["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        assert(root["params"]["cpp_standard"].As<Int>() == 20);
+        assert(root["params"]["compilers"].size() == 2u);
+        const auto compiler = root["params"]["compilers"][0].Value();
+        assert(compiler.GetJsonValue().GetData() == json["params"]["compilers"][0].Value().GetData());
+        assert(compiler.GetJsonValue().GetLpCounter().LineNumber == 4);
+        assert(compiler.GetJsonValue().GetLpCounter().Position == 12);
+        // The first occurrence of a duplicate key is found, like with `Mapping::operator[]`
+        assert(root["a/b"].size() == 6u);
+        assert(root["a/b"][1].As<Float>() == 2.5);
+        assert(root["a/b"][2].As<Bool>() == true);
+        assert(root["a/b"][3].As<String>() == "x");
+        assert(root["a/b"][4].size() == 0u);
+        assert(root["a/b"][5].size() == 0u);
+        // Iteration is done through the underlying `JsonValue`
+        size_t nElements = 0;
+        for (const auto elem : root["a/b"].As<Array>()) nElements += elem.HasValue();
+        assert(nElements == 6);
+        // Compiled json pointers use the precomputed hashes of their keys
+        static constexpr auto pointer = CompiledPointer<>::Compile("/a~1b/3").Value();
+        assert(pointer.Evaluate(root).As<String>() == "x");
+    }
+
+    {   // Errors are the same as those of `JsonValue`
+        const auto index = DocumentIndex::Build(json).Value();
+        const auto view = index.View(json).Value();
+        const auto root = view.Root();
+        assert(root["params"]["compilers"][2].Error() == json["params"]["compilers"][2].Error());
+        assert(root["params"]["interpreters"].Error() == json["params"]["interpreters"].Error());
+        assert(root["params"][0].Error() == json["params"][0].Error());
+        assert(root["params"]["cpp_standard"]["x"].Error() == json["params"]["cpp_standard"]["x"].Error());
+        assert(root["a/b"]["x"].Error() == json["a/b"]["x"].Error());
+        assert(root["params"]["cpp_standard"].size().HasError());
+        static constexpr auto pointer = CompiledPointer<>::Compile("/params/compilers/-").Value();
+        assert(pointer.Evaluate(root).Error() == pointer.Evaluate(json).Error());
+    }
+
+    {   // Large mappings get hash tables for their keys
+        auto data = std::string{"{"};
+        for (int i = 0; i != 100; ++i) {
+            data += "\"key" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+        }
+        data += "\"key7\": -1}";
+        const auto large = JsonValue{data};
+        const auto index = DocumentIndex::Build(large).Value();
+        const auto view = index.View(large).Value();
+        for (int i = 0; i != 100; ++i) {
+            assert(view.Root()["key" + std::to_string(i)].As<Int>() == i);
+        }
+        assert(view.Root()["key100"].Error() == large["key100"].Error());
+        assert(view.Root().size() == 101u);
+        assert(index.MemoryUsage() > 101 * sizeof(NIndex::ChildRecord));
+
+        // The index can be used with another buffer with the same contents, but not with another document
+        const auto copy = std::string{data};
+        assert(index.View(JsonValue{copy}).Value().Root()["key42"].As<Int>() == 42);
+        assert(index.View(json).HasError());
+    }
+
+    {   // Mappings with sorted keys are searched with a binary search instead of a hash table
+        auto data = std::string{"{"};
+        for (int i = 0; i != 100; ++i) {
+            data += "\"key" + std::string(i < 10 ? "0" : "") + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+        }
+        data += "\"~/\": [{\"a\": 1, \"b\": 2}, {\"b\": 1, \"a\": 2}]}";
+        const auto sorted = JsonValue{data};
+        const auto index = DocumentIndex::Build(sorted).Value();
+        const auto view = index.View(sorted).Value();
+        assert(view.Containers[0].HasSortedKeys());
+        assert(view.Containers[0].NKeySlots == 0 && view.KeySlots.empty());
+        assert(view.Containers[2].HasSortedKeys() && !view.Containers[3].HasSortedKeys());
+        for (int i = 0; i != 100; ++i) {
+            const auto key = "key" + std::string(i < 10 ? "0" : "") + std::to_string(i);
+            assert(view.Root()[key].As<Int>() == i);
+        }
+        assert(view.Root()["key100"].Error() == sorted["key100"].Error());
+        assert(view.Root()["a"].Error() == sorted["a"].Error());
+        assert(view.Root()["zzz"].Error() == sorted["zzz"].Error());
+        assert(view.Root()["~/"][1]["a"].As<Int>() == 2);
+        // Escaped pointer segments are compared with the keys as well
+        assert(CompiledPointer<>::Compile("/~0~1/0/b").Value().Evaluate(view.Root()).As<Int>() == 2);
+        assert(CompiledPointer<>::Compile("/~0~0/0").Value().Evaluate(view.Root()).HasError());
+        assert(CompiledPointer<>::Compile("/~0/0").Value().Evaluate(view.Root()).HasError());
+
+        // Keys are compared byte by byte, as they are written
+        const auto escaped = JsonValue{"{\"\\u0063\": 1, \"b\": 2}"};
+        const auto escapedIndex = DocumentIndex::Build(escaped).Value();
+        assert(escapedIndex.View(escaped).Value().Containers[0].HasSortedKeys());
+        assert(escapedIndex.View(escaped).Value().Root()["\\u0063"].As<Int>() == 1);
+        const auto nonAscii = JsonValue{"{\"z\": 1, \"\xc3\xa9\": 2}"};
+        const auto nonAsciiIndex = DocumentIndex::Build(nonAscii).Value();
+        assert(nonAsciiIndex.View(nonAscii).Value().Containers[0].HasSortedKeys());
+        assert(nonAsciiIndex.View(nonAscii).Value().Root()["\xc3\xa9"].As<Int>() == 2);
+    }
+
+    {   // Scalars and malformed documents
+        const auto scalar = JsonValue{" 57 "};
+        const auto index = DocumentIndex::Build(scalar).Value();
+        const auto view = index.View(scalar).Value();
+        assert(view.Root().As<Int>() == 57);
+        assert(view.Root()[0].Error() == scalar[0].Error());
+
+        // Trailing commas are accepted, like everywhere else in the library
+        assert(DocumentIndex::Build(JsonValue{"[1, 2, ]"}).HasValue());
+        const auto expectError = [](std::string_view data, NError::ErrorCode code, uint16_t position) {
+            const auto error = DocumentIndex::Build(JsonValue{data}).Error();
+            assert(error.BasicInfo.Code == code);
+            assert(error.BasicInfo.Position == position);
+        };
+        expectError("[1, 2", NError::ErrorCode::SyntaxError, 5);
+        expectError("[1, 2}", NError::ErrorCode::SyntaxError, 5);
+        expectError("[1 2]", NError::ErrorCode::SyntaxError, 3);
+        expectError("[1, , 2]", NError::ErrorCode::MissingValueError, 4);
+        expectError("{\"a\": 1, 2: 3}", NError::ErrorCode::TypeError, 9);
+        expectError("{\"a\" 1}", NError::ErrorCode::SyntaxError, 5);
+        expectError("[\"abc]", NError::ErrorCode::SyntaxError, 1);
+        expectError("[1], 2", NError::ErrorCode::SyntaxError, 3);
+    }
+
+    {   // Indexes can be built and used at compile time as well
+        static_assert([] {
+            const auto index = DocumentIndex::Build(json).Value();
+            const auto view = index.View(json).Value();
+            return view.Root()["params"]["compilers"][0]["version"].As<String>() == "14.0.0";
+        }());
+    }
+}
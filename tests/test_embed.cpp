@@ -0,0 +1,97 @@
+#include "../parser.hpp"
+// Generated from the same document as `kSource` below with:
+//     ./embed_json embedded.json tests/embedded_example.hpp --namespace=NEmbeddedExample --include=../parser.hpp
+#include "embedded_example.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr auto kSource = std::string_view{
+        "{\n"
+        "    \"params\": {\n"
+        "        \"cpp_standard\": 20,\n"
+        "        \"compilers\": [\n"
+        "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        "            {\"version\": \"11.4.0\", \"name\": \"gcc\"}\n"
+        "        ]\n"
+        "    },\n"
+        "    \"escapes\": \"a\\\\b\\tc\",\n"
+        "    \"numbers\": [1, 2.5, -3, true, false, null, [], {}],\n"
+        "    \"large\": {\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, \"k9\": 9}\n"
+        "}\n"
+    };
+
+    // The embedded document is navigated at compile time through its precomputed index
+    constexpr auto kRoot = NEmbeddedExample::kDocument.Root();
+    static_assert(kRoot.size() == 4u);
+    static_assert(kRoot["params"]["compilers"][1]["name"].As<String>() == "gcc");
+    static_assert(kRoot["params"]["cpp_standard"].As<Int>() == 20);
+    static_assert(kRoot["escapes"].As<String>() == "a\\\\b\\tc");
+    static_assert(kRoot["numbers"][1].As<Float>() == 2.5);
+    static_assert(kRoot["numbers"][6].size() == 0u);
+    static_assert(kRoot["large"]["k7"].As<Int>() == 7);
+    static_assert(kRoot["params"]["compilers"][2].Error().BasicInfo.Code == NError::ErrorCode::ArrayIndexOutOfRange);
+    static_assert(kRoot["large"]["k10"].Error().BasicInfo.Code == NError::ErrorCode::MappingKeyNotFound);
+} // namespace
+
+
+auto TestEmbed() -> void {
+    {   // The generated header is up to date with the index that is built now
+        const auto json = JsonValue{kSource};
+        const auto index = DocumentIndex::Build(json).Value();
+        const auto view = index.View(json).Value();
+        const auto& embedded = NEmbeddedExample::kDocument;
+        assert(embedded.Data == view.Data);
+        assert(std::ranges::equal(embedded.Containers, view.Containers));
+        assert(std::ranges::equal(embedded.Children, view.Children));
+        assert(std::ranges::equal(embedded.KeySlots, view.KeySlots));
+        // Errors point at the same places as those of `JsonValue`
+        assert(kRoot["params"]["compilers"][2].Error() == json["params"]["compilers"][2].Error());
+        assert(kRoot["large"]["k10"].Error() == json["large"]["k10"].Error());
+    }
+
+    {   // The generated header
+        const auto header = EmbedDocument(JsonValue{kSource}, {
+            .Namespace = "NConfig",
+            .ParserInclude = "../parser.hpp",
+            .SourceName = "config.json",
+        });
+        assert(header.HasValue());
+        const auto& text = header.Value();
+        assert(text.starts_with("#pragma once\n"));
+        assert(text.find("// Generated from config.json") != std::string::npos);
+        assert(text.find("#include \"../parser.hpp\"") != std::string::npos);
+        assert(text.find("namespace NConfig {") != std::string::npos);
+        assert(text.find("inline constexpr auto kDocument = NJsonParser::DocumentIndexView{") != std::string::npos);
+        // Every line of the document is a separate string literal
+        assert(text.find("        \"    \\\"params\\\": {\\n\"\n") != std::string::npos);
+        assert(text.ends_with("} // namespace NConfig\n"));
+    }
+
+    {   // Characters that can't appear in a string literal as is are escaped
+        const auto header = EmbedDocument(JsonValue{"[\"caf\xc3\xa9\", \"a\\\\b\", \"\t\"]"});
+        assert(header.HasValue());
+        assert(header.Value().find("\"[\\\"caf\\303\\251\\\", \\\"a\\\\\\\\b\\\", \\\"\\t\\\"]\";") != std::string::npos);
+    }
+
+    {   // Scalars have no containers, and long lines are split
+        const auto longString = "\"" + std::string(200, 'x') + "\"";
+        const auto header = EmbedDocument(JsonValue{longString});
+        assert(header.HasValue());
+        assert(header.Value().find("std::array<NJsonParser::NIndex::ContainerRecord, 0> kContainers = {{\n    }};") != std::string::npos);
+        assert(header.Value().find("\"\n        \"" + std::string(96, 'x')) != std::string::npos);
+    }
+
+    {   // Malformed documents are reported with the errors of `DocumentIndex::Build`
+        const auto json = JsonValue{"{\"a\": [1, 2}"};
+        const auto header = EmbedDocument(json);
+        assert(header.HasError());
+        assert(header.Error() == DocumentIndex::Build(json).Error());
+    }
+}
@@ -0,0 +1,174 @@
+#include "../parser.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr auto kSource = std::string_view{
+        "{\n"
+        "    \"params\": {\n"
+        "        \"cpp_standard\": 20,\n"
+        "        \"compilers\": [\n"
+        "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        "            {\"version\": \"11.4.0\", \"name\": \"gcc\"}\n"
+        "        ]\n"
+        "    },\n"
+        "    \"numbers\": [1, 2.5, -3, true, false, null, [], {}],\n"
+        "    \"large\": {\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, \"k9\": 9}\n"
+        "}\n"
+    };
+
+    // Index files are loaded from memory aligned like the memory returned by `mmap`
+    struct AlignedCopy {
+        std::unique_ptr<uint64_t[]> Buffer;
+        std::string_view Data;
+
+        explicit AlignedCopy(std::string_view data)
+            : Buffer(std::make_unique<uint64_t[]>(data.size() / sizeof(uint64_t) + 1))
+            , Data(reinterpret_cast<const char*>(Buffer.get()), data.size()) {
+            std::memcpy(Buffer.get(), data.data(), data.size());
+        }
+    };
+
+    auto IndexFileErrorMessage(const Expected<DocumentIndexView>& view) -> std::string_view {
+        assert(view.HasError());
+        assert(view.Error().BasicInfo.Code == NError::ErrorCode::IndexFileError);
+        return std::get<std::string_view>(view.Error().AdditionalInfo);
+    }
+
+    auto WriteFile(const std::filesystem::path& path, std::string_view data) -> void {
+        auto out = std::ofstream{path, std::ios::binary | std::ios::trunc};
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+} // namespace
+
+
+auto TestIndexFile() -> void {
+    const auto json = JsonValue{kSource};
+    const auto index = DocumentIndex::Build(json).Value();
+    const auto serialized = SerializeIndex(index, json);
+    assert(serialized.HasValue());
+    const auto file = AlignedCopy{serialized.Value()};
+
+    {   // A loaded index is the same as the one it was saved from
+        const auto view = index.View(json).Value();
+        const auto loaded = LoadIndex(file.Data, json);
+        assert(loaded.HasValue());
+        assert(std::ranges::equal(loaded.Value().Containers, view.Containers));
+        assert(std::ranges::equal(loaded.Value().Children, view.Children));
+        assert(std::ranges::equal(loaded.Value().KeySlots, view.KeySlots));
+        const auto root = loaded.Value().Root();
+        assert(root["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        assert(root["large"]["k7"].As<Int>() == 7);
+        assert(root["numbers"].size() == 8u);
+        assert(root["large"]["k10"].Error() == json["large"]["k10"].Error());
+        // The tables are used in place
+        assert(reinterpret_cast<const char*>(loaded.Value().Containers.data()) == file.Data.data() + sizeof(NIndex::IndexFileHeader));
+        // Serialization is deterministic
+        assert(SerializeIndex(DocumentIndex::Build(json).Value(), json).Value() == serialized.Value());
+    }
+
+    {   // The same document in another buffer (with other surrounding spaces)
+        const auto copy = "\n\n  " + std::string{kSource} + "  ";
+        const auto other = JsonValue{copy};
+        const auto loaded = LoadIndex(file.Data, other);
+        assert(loaded.HasValue());
+        assert(loaded.Value().Root()["params"]["cpp_standard"].As<Int>() == 20);
+    }
+
+    {   // Scalar documents have an empty index
+        const auto scalar = JsonValue{"\"just a string\""};
+        const auto scalarFile = AlignedCopy{SerializeIndex(DocumentIndex::Build(scalar).Value(), scalar).Value()};
+        assert(scalarFile.Data.size() == sizeof(NIndex::IndexFileHeader));
+        const auto loaded = LoadIndex(scalarFile.Data, scalar);
+        assert(loaded.HasValue());
+        assert(loaded.Value().Root().As<String>() == "just a string");
+    }
+
+    {   // Stale index files are rejected
+        auto edited = std::string{kSource};
+        edited.replace(edited.find("gcc"), 3, "icc");
+        assert(IndexFileErrorMessage(LoadIndex(file.Data, JsonValue{edited})) == "the index file was built for another document");
+        // Unless the contents are not checked
+        assert(LoadIndex(file.Data, JsonValue{edited}, IndexFileCheck::Bounds).HasValue());
+        const auto longer = std::string{kSource.substr(0, kSource.size() - 2)} + ", \"x\": 1}";
+        assert(IndexFileErrorMessage(LoadIndex(file.Data, JsonValue{longer}, IndexFileCheck::Header)) == "the index file was built for another document");
+    }
+
+    {   // Broken index files are rejected
+        const auto corrupt = [&](size_t offset, char byte) {
+            auto broken = std::string{file.Data};
+            broken[offset] = byte;
+            const auto copy = AlignedCopy{broken};
+            return std::string{IndexFileErrorMessage(LoadIndex(copy.Data, json))};
+        };
+        assert(corrupt(0, 'X') == "not an index file");
+        assert(corrupt(offsetof(NIndex::IndexFileHeader, Version), 2) == "unsupported version of the index file");
+        assert(corrupt(offsetof(NIndex::IndexFileHeader, Layout), 1) == "the index file was written by a build with a different layout of the index");
+        assert(corrupt(offsetof(NIndex::IndexFileHeader, NChildren), 1) == "the size of the index file doesn't match its header");
+        // The offset of the value of the first child points past the end of the document
+        const auto firstChild = sizeof(NIndex::IndexFileHeader) + index.View(json).Value().Containers.size() * sizeof(NIndex::ContainerRecord);
+        assert(corrupt(firstChild + offsetof(NIndex::ChildRecord, ValueBegin) + 7, 1) == "the index file is corrupted");
+        // The kind of the root container
+        assert(corrupt(sizeof(NIndex::IndexFileHeader) + offsetof(NIndex::ContainerRecord, Kind), 'x') == "the index file is corrupted");
+        // Unknown flags of the root container
+        assert(corrupt(sizeof(NIndex::IndexFileHeader) + offsetof(NIndex::ContainerRecord, Flags), 0x40) == "the index file is corrupted");
+
+        assert(IndexFileErrorMessage(LoadIndex(file.Data.substr(0, 10), json)) == "the index file is truncated");
+        assert(IndexFileErrorMessage(LoadIndex(file.Data.substr(0, file.Data.size() - 4), json)) == "the size of the index file doesn't match its header");
+        const auto shifted = AlignedCopy{" " + std::string{file.Data}};
+        assert(IndexFileErrorMessage(LoadIndex(shifted.Data.substr(1), json)) == "the index file is misaligned in memory");
+    }
+
+#ifdef NJSON_PARSER_HAS_MMAP
+    {   // Memory-mapped documents and index files
+        const auto dir = std::filesystem::temp_directory_path() / ("njson_parser_index_file_" + std::to_string(::getpid()));
+        std::filesystem::create_directories(dir);
+        const auto documentPath = dir / "data.json";
+        const auto indexPath = dir / "data.json.index";
+        WriteFile(documentPath, kSource);
+
+        assert(!SaveIndexFile(index, json, indexPath));
+        assert(!std::filesystem::exists(dir / "data.json.index.tmp"));
+        {
+            const auto document = MappedDocument::Open(documentPath, indexPath);
+            assert(document.HasValue());
+            const auto copy = document.Value();
+            assert(copy.Root()["params"]["compilers"][0]["version"].As<String>() == "14.0.0");
+            assert(copy.GetView().Children.size() == index.View(json).Value().Children.size());
+        }
+
+        // The document has changed since the index file was written
+        WriteFile(documentPath, std::string{kSource}.replace(kSource.find("clang"), 5, "CLANG"));
+        const auto stale = MappedDocument::Open(documentPath, indexPath);
+        assert(stale.HasError() && stale.Error().BasicInfo.Code == NError::ErrorCode::IndexFileError);
+        const auto rebuilt = MappedDocument::OpenOrBuild(documentPath, indexPath);
+        assert(rebuilt.HasValue());
+        assert(rebuilt.Value().Root()["params"]["compilers"][0]["name"].As<String>() == "CLANG");
+        assert(MappedDocument::Open(documentPath, indexPath).HasValue());
+
+        // Missing files
+        std::filesystem::remove(indexPath);
+        assert(MappedDocument::Open(documentPath, indexPath).HasError());
+        assert(MappedDocument::OpenOrBuild(documentPath, indexPath).HasValue());
+        assert(MappedDocument::OpenOrBuild(dir / "missing.json", indexPath).HasError());
+        // Malformed documents are reported with the errors of `DocumentIndex::Build`
+        WriteFile(documentPath, "{\"a\": [1, 2}");
+        const auto malformed = MappedDocument::OpenOrBuild(documentPath, indexPath);
+        assert(malformed.HasError());
+        assert(malformed.Error() == DocumentIndex::Build(JsonValue{"{\"a\": [1, 2}"}).Error());
+
+        std::filesystem::remove_all(dir);
+    }
+#endif
+}
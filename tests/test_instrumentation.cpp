@@ -0,0 +1,64 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <thread>
+
+
+using namespace NJsonParser;
+
+
+auto TestInstrumentation() -> void {
+    const auto deep = std::string(100, '[') + "0" + std::string(100, ']');
+    const auto doc = "{\"a\": [1, 2, 3, 4], \"b\": " + deep + "}";
+    const auto json = JsonValue{doc};
+    using NInstrumentation::Counters;
+
+    // Compile-time evaluation is never counted
+    static_assert(JsonValue{"[1, 2]"}[1].As<Int>() == 2);
+
+    NInstrumentation::ResetCounters();
+    const auto a = json["a"].As<Array>().Value();
+    int64_t sum = 0;
+    for (size_t i = 0; i != a.size(); ++i) sum += a[i].As<Int>().Value();
+    assert(sum == 10);
+    const auto indexing = NInstrumentation::GetCounters();
+
+    NInstrumentation::ResetCounters();
+    sum = 0;
+    for (const auto elem : a) sum += elem.As<Int>().Value();
+    assert(sum == 10);
+    const auto iteration = NInstrumentation::GetCounters();
+
+    NInstrumentation::ResetCounters();
+    assert(json["c"].HasError());
+    assert(json["b"].HasValue());
+    const auto other = NInstrumentation::GetCounters();
+
+    if constexpr (NInstrumentation::kEnabled) {
+        // Indexing an array in a loop rescans it on every iteration
+        assert(indexing.ContainerRescans >= 4);
+        assert(indexing.IteratorSteps > iteration.IteratorSteps);
+        assert(indexing.BytesScanned > iteration.BytesScanned);
+        assert(iteration.ContainerRescans == 0);
+        assert(iteration.IteratorSteps == 4);
+        assert(iteration.Errors == 0);
+        // A missing key is an error, and the deeply nested value doesn't fit into `NUtils::BracketStack`
+        assert(other.Errors >= 1);
+        assert(other.Allocations >= 1);
+        assert(other.ContainerRescans == 1);
+        // Counters are per thread
+        auto otherThread = Counters{};
+        std::thread{[&] {
+            assert(json["a"][3].As<Int>() == 4);
+            otherThread = NInstrumentation::GetCounters();
+        }}.join();
+        assert(otherThread.IteratorSteps >= 3);
+        assert(NInstrumentation::GetCounters() == other);
+        assert((other - other) == Counters{});
+    } else {
+        assert(indexing == Counters{});
+        assert(iteration == Counters{});
+        assert(other == Counters{});
+    }
+}
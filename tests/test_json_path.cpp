@@ -0,0 +1,91 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    auto Collect(std::string_view path, const JsonValue& json) -> std::vector<std::string_view> {
+        auto matches = std::vector<std::string_view>{};
+        const auto nMatches = JsonPath<>::Compile(path).Value().Evaluate(json, [&](const JsonValue& value) {
+            matches.push_back(value.GetData());
+        });
+        assert(nMatches == matches.size());
+        return matches;
+    }
+}
+
+
+auto TestJsonPath() -> void {
+    static constexpr auto json = JsonValue{
+        "{                                                                   \n"
+        "    \"store\": {                                                    \n"
+        "        \"items\": [                                                \n"
+        "            {\"id\": 1, \"name\": \"pen\", \"price\": 1.5},         \n"
+        "            {\"id\": 2, \"name\": \"book\", \"price\": 12},         \n"
+        "            {\"id\": 3, \"name\": \"lamp\", \"price\": 30.25,       \n"
+        "             \"parts\": [{\"id\": 31}, {\"id\": 32}]},              \n"
+        "            {\"id\": 4, \"name\": \"mug\", \"price\": 7, \"sale\": true}\n"
+        "        ],                                                          \n"
+        "        \"owner\": {\"id\": 0, \"name\": \"bob\"}                   \n"
+        "    }                                                               \n"
+        "}                                                                   \n"
+    };
+
+    {   // Children, wildcards and bracket notation
+        assert((Collect("$.store.items[*].price", json) == std::vector<std::string_view>{"1.5", "12", "30.25", "7"}));
+        assert((Collect("$['store'][\"owner\"].name", json) == std::vector<std::string_view>{"\"bob\""}));
+        assert((Collect("$.store.owner.*", json) == std::vector<std::string_view>{"0", "\"bob\""}));
+        assert(Collect("$", json).size() == 1);
+        assert(Collect("$.store.nothing", json).empty());
+    }
+
+    {   // Recursive descent visits every subtree only once
+        assert((Collect("$..id", json) == std::vector<std::string_view>{"1", "2", "3", "31", "32", "4", "0"}));
+        assert((Collect("$.store..parts[*].id", json) == std::vector<std::string_view>{"31", "32"}));
+        assert(Collect("$..*", json).size() == 27);
+    }
+
+    {   // Indices and slices
+        assert((Collect("$.store.items[1].name", json) == std::vector<std::string_view>{"\"book\""}));
+        assert((Collect("$.store.items[-1].name", json) == std::vector<std::string_view>{"\"mug\""}));
+        assert((Collect("$.store.items[1:3].id", json) == std::vector<std::string_view>{"2", "3"}));
+        assert((Collect("$.store.items[::2].id", json) == std::vector<std::string_view>{"1", "3"}));
+        assert((Collect("$.store.items[-2:].id", json) == std::vector<std::string_view>{"3", "4"}));
+    }
+
+    {   // Filters
+        assert((Collect("$.store.items[?(@.price < 10)].name", json) == std::vector<std::string_view>{"\"pen\"", "\"mug\""}));
+        assert((Collect("$.store.items[?(@.name == 'lamp')].id", json) == std::vector<std::string_view>{"3"}));
+        assert((Collect("$.store.items[?(@.sale)].id", json) == std::vector<std::string_view>{"4"}));
+        assert((Collect("$.store.items[?(@.sale == true)].id", json) == std::vector<std::string_view>{"4"}));
+        assert((Collect("$..[?(@.id >= 31)].id", json) == std::vector<std::string_view>{"31", "32"}));
+        assert((Collect("$.store.items[*].id[?(@ > 2)]", json).empty()));
+    }
+
+    {   // Paths can be compiled and evaluated at compile time
+        static constexpr auto path = JsonPath<>::Compile("$.store.items[?(@.price >= 12)].id").Value();
+        static_assert(path.GetSteps().size() == 4);
+        constexpr auto sumOfIds = []() {
+            Int sum = 0;
+            path.Evaluate(json, [&sum](const JsonValue& id) { sum += id.As<Int>().Value(); });
+            return sum;
+        }();
+        static_assert(sumOfIds == 2 + 3);
+    }
+
+    {   // Errors
+        static_assert(JsonPath<>::Compile("store").Error().BasicInfo.Code == NError::ErrorCode::InvalidJsonPathError);
+        static_assert(JsonPath<>::Compile("$.a[").HasError());
+        static_assert(JsonPath<>::Compile("$.a[?(@.b ~ 1)]").HasError());
+        static_assert(JsonPath<>::Compile("$.a[1:2:-1]").HasError());
+        static_assert(JsonPath<2>::Compile("$.a.b.c").HasError());
+        // Errors in the document are reported as well
+        constexpr auto malformed = JsonValue{"{\"a\": [1, 2}"};
+        const auto nMatches = JsonPath<>::Compile("$.a[*]").Value().Evaluate(malformed, [](const JsonValue&) {});
+        assert(nMatches.Error().BasicInfo.Code == NError::ErrorCode::SyntaxError);
+    }
+}
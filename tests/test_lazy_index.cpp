@@ -0,0 +1,80 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestLazyIndex() -> void {
+    const auto json = JsonValue{
+        /* line numbers: */
+        /* 0 */ "{                                                            \n"
+        /* 1 */ "    \"params\": {                                            \n"
+        /* 2 */ "        \"cpp_standard\": 20,                                \n"
+        /* 3 */ "        \"compilers\": [                                     \n"
+        /* 4 */ "            {\"name\": \"clang\", \"version\": \"14.0.0\"},  \n"
+        /* 5 */ "            {\"version\": \"11.4.0\", \"name\": \"gcc\"},    \n"
+        /* 6 */ "        ]                                                    \n"
+        /* 7 */ "    },                                                       \n"
+        /* 8 */ "    \"broken\": [1, 2, {\"a\" 3}, 4],                        \n"
+        /* 9 */ "    \"a/b\": [1, 2.5, true, \"x\"]                           \n"
+        /* 10*/ "}                                                            \n"
+    };
+
+    {   // Navigation gives the same values and errors as navigation through `JsonValue`
+        const auto index = LazyDocumentIndex{json};
+        const auto root = index.Root();
+        assert(root["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        assert(root["params"]["cpp_standard"].As<Int>() == 20);
+        assert(root["params"]["compilers"].size() == 2u);
+        assert(root["a/b"][2].As<Bool>() == true);
+        assert(root["params"]["compilers"][2].Error() == json["params"]["compilers"][2].Error());
+        assert(root["params"]["interpreters"].Error() == json["params"]["interpreters"].Error());
+        assert(root["params"][0].Error() == json["params"][0].Error());
+        assert(root["params"]["cpp_standard"]["x"].Error() == json["params"]["cpp_standard"]["x"].Error());
+        // Malformed containers are reported only when accessed
+        assert(root["broken"][1].As<Int>() == 2);
+        assert(root["broken"][2]["a"].Error() == json["broken"][2]["a"].Error());
+        assert(root["broken"][3].As<Int>() == 4);
+        static constexpr auto pointer = CompiledPointer<>::Compile("/a~1b/3").Value();
+        assert(pointer.Evaluate(root).As<String>() == "x");
+
+        // Every container is scanned at most once
+        assert(index.GetStats().TablesBuilt == 7);
+        assert(root["params"]["compilers"][0]["version"].As<String>() == "14.0.0");
+        assert(index.GetStats().TablesBuilt == 8);
+        assert(root["params"]["compilers"][0]["name"].As<String>() == "clang");
+        assert(index.GetStats().TablesBuilt == 8);
+    }
+
+    {   // Tables are shared by all the threads
+        auto data = std::string{"["};
+        for (int i = 0; i != 200; ++i) {
+            data += "{";
+            for (int j = 0; j != 10; ++j) {
+                data += "\"k" + std::to_string(j) + "\": " + std::to_string(i * j) + ", ";
+            }
+            data += "}, ";
+        }
+        data += "]";
+        const auto large = JsonValue{data};
+        const auto index = LazyDocumentIndex{large};
+        auto threads = std::vector<std::thread>{};
+        for (int t = 0; t != 4; ++t) threads.emplace_back([&index, t] {
+            for (int round = 0; round != 3; ++round) {
+                for (int i = 0; i != 200; ++i) {
+                    const auto j = (i + t) % 10;
+                    assert(index.Root()[i]["k" + std::to_string(j)].As<Int>() == i * j);
+                }
+            }
+        });
+        for (auto& thread : threads) thread.join();
+        const auto stats = index.GetStats();
+        assert(stats.TablesBuilt == 201);
+        assert(stats.TablesDiscarded <= 3 * 201);
+    }
+}
@@ -30,6 +30,18 @@ auto TestMappingAPI() -> void {
         static_assert(map["dct"]["bar"].As<Int>() == 5);
     }
 
+    {   // Use `FindSorted` to access values of mappings whose keys are known to be sorted:
+        // a missing key is reported as soon as a greater key is found
+        static constexpr auto sorted = JsonValue{R"({"a": 1, "c": [2, 3], "e": {"f": 4}})"}.As<Mapping>();
+        static_assert(sorted.FindSorted("c")[1].As<Int>() == 3);
+        static_assert(sorted.FindSorted("e").As<Mapping>().FindSorted("f").As<Int>() == 4);
+        static_assert(sorted.FindSorted("b").Error() == sorted["b"].Error());
+        static_assert(sorted.FindSorted("z").Error() == sorted["z"].Error());
+        // The keys after the position of the requested key are not looked at
+        static_assert(JsonValue{R"({"a": 1, "b": 2, 3: 4})"}.As<Mapping>().FindSorted("ab").Error().BasicInfo.Code == NError::ErrorCode::MappingKeyNotFound);
+        static_assert(JsonValue{R"({"a": 1, "b": 2, 3: 4})"}.As<Mapping>()["ab"].Error().BasicInfo.Code != NError::ErrorCode::MappingKeyNotFound);
+    }
+
     {   // Iterate over json maps in usual ways.
         // `JsonMap` provides `.begin()` and `.end()` iterators of type `Mapping::Iterator`,
         // which is guaranteed to be at least a `forward_iterator`
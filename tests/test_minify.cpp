@@ -0,0 +1,63 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <random>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    static constexpr auto kMinified = MinifiedJson{
+        "{                                      \n"
+        "    \"name\": \"gcc\",                 \n"
+        "    \"flags\": [\"-O2\", \" -g \"],    \n"
+        "    \"quote\": \"a \\\" b\"            \n"
+        "}                                      \n"
+    };
+    static_assert(kMinified.GetData() == R"({"name":"gcc","flags":["-O2"," -g "],"quote":"a \" b"})");
+    static_assert(JsonValue{kMinified.GetData()}["flags"][1].As<String>() == " -g ");
+}
+
+
+auto TestMinify() -> void {
+    {   // Whitespace is removed only outside of strings
+        const auto in = std::string_view{" [ 1 ,\t\"a \\\\\" , \r\n\"\\\" \" , { \"k\" : null } ] "};
+        auto out = std::string(in.size(), '\0');
+        assert(Minify(in, out).Value() == R"([1,"a \\","\" ",{"k":null}])");
+        assert(Minify(in, std::span<char>{out.data(), 3}).Error().BasicInfo.Code == NError::ErrorCode::WriterError);
+        assert(Minify("", out).Value().empty());
+    }
+
+    {   // The vectorized kernel gives the same results as the character by character one
+        auto rng = std::mt19937{42};
+        constexpr auto kAlphabet = std::string_view{" \t\n\r\"\\ab[]{},:  \"\"    "};
+        for (size_t iter = 0; iter != 2000; ++iter) {
+            auto in = std::string(rng() % 100, ' ');
+            for (auto& ch : in) ch = kAlphabet[rng() % kAlphabet.size()];
+            auto out = std::string(in.size(), '\0');
+            auto expected = std::string(in.size(), '\0');
+            const auto state = NUtils::MinifyScalar(in, expected.data(), {});
+            assert(Minify(in, out).Value() == std::string_view(expected.data(), state.OutPos));
+        }
+    }
+
+    {   // A minified document is navigated in the same way
+        const auto pretty = std::string{
+            "{\n"
+            "    \"params\": {\n"
+            "        \"compilers\": [\n"
+            "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+            "            {\"name\": \"gcc\", \"version\": \"11.4.0\"}\n"
+            "        ]\n"
+            "    }\n"
+            "}\n"
+        };
+        auto out = std::string(pretty.size(), '\0');
+        const auto json = JsonValue{Minify(pretty, out).Value()};
+        assert(json.GetData().find_first_of(" \n") == std::string_view::npos);
+        assert(json["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        assert(json.AtPointer("/params/compilers/0/version").As<String>() == "14.0.0");
+    }
+}
@@ -0,0 +1,102 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <memory_resource>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+auto TestPatch() -> void {
+    const auto json = JsonValue{
+        "{\n"
+        "    \"auth\": {\"user\": \"root\", \"token\": \"s3cr3t\"},\n"
+        "    \"hops\": 3,\n"
+        "    \"route\": [\"a\", \"b\", \"c\"],\n"
+        "    \"debug\": {\"trace\": [1, 2]},\n"
+        "    \"a/b\": []\n"
+        "}"
+    };
+
+    {   // Unchanged parts of the document are copied as is
+        const auto patched = Patch{}
+            .Replace("/auth/token", "\"<redacted>\"")
+            .Replace("/hops", std::to_string(4))
+            .Insert("/route/-", "\"gateway\"")
+            .Insert("/route/0", "\"client\"")
+            .Remove("/debug")
+            .Insert("/a~1b/0", "{}")
+            .Insert("/new~0key", "[true]")
+            .Apply(json);
+        assert(patched.HasValue());
+        assert(patched.Value() ==
+            "{\n"
+            "    \"auth\": {\"user\": \"root\", \"token\": \"<redacted>\"},\n"
+            "    \"hops\": 4,\n"
+            "    \"route\": [\"client\",\"a\", \"b\", \"c\",\"gateway\"],\n"
+            "    \"a/b\": [{}],\"new~key\":[true]\n"
+            "}"
+        );
+        const auto result = JsonValue{patched.Value()};
+        assert(result["route"].As<Array>().size() == 5u);
+        assert(result["new~key"][0].As<Bool>() == true);
+        assert(result["debug"].Error().BasicInfo.Code == NError::ErrorCode::MappingKeyNotFound);
+        // An empty patch copies the document
+        assert(Patch{}.Apply(json).Value() == json.GetData());
+    }
+
+    {   // Removing elements keeps the separators valid
+        const auto array = JsonValue{"[0, 1, 2, 3, 4]"};
+        assert(Patch{}.Remove("/0").Apply(array).Value() == "[1, 2, 3, 4]");
+        assert(Patch{}.Remove("/4").Apply(array).Value() == "[0, 1, 2, 3]");
+        assert(Patch{}.Remove("/1").Remove("/2").Apply(array).Value() == "[0, 3, 4]");
+        assert(Patch{}.Remove("/3").Remove("/4").Apply(array).Value() == "[0, 1, 2]");
+        assert(Patch{}.Remove("/0").Remove("/2").Remove("/4").Apply(array).Value() == "[1, 3]");
+        assert(Patch{}.Remove("/0").Remove("/1").Remove("/2").Remove("/3").Remove("/4").Apply(array).Value() == "[]");
+        assert(Patch{}.Remove("/4").Remove("/3").Insert("/-", "5").Apply(array).Value() == "[0, 1, 2,5]");
+        assert(Patch{}.Remove("/1").Insert("/1", "\"one\"").Apply(array).Value() == "[0, \"one\",2, 3, 4]");
+        const auto mapping = JsonValue{"{\"a\": 1, \"b\": [1, 2]}"};
+        assert(Patch{}.Remove("/a").Apply(mapping).Value() == "{\"b\": [1, 2]}");
+        assert(Patch{}.Remove("/b").Apply(mapping).Value() == "{\"a\": 1}");
+        assert(Patch{}.Remove("/a").Remove("/b").Insert("/c", "null").Apply(mapping).Value() == "{\"c\":null}");
+        // Kept elements can still be changed
+        assert(Patch{}.Remove("/a").Remove("/b/0").Replace("/b/1", "3").Apply(mapping).Value() == "{\"b\": [3]}");
+        assert(Patch{}.Replace("", "42").Apply(mapping).Value() == "42");
+    }
+
+    {   // The operations, the temporary memory and the result are allocated from the resource of the patch
+        auto arena = ArenaResource{};
+        const auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        const auto patched = Patch{&arena}
+            .Replace("/auth/token", "\"<redacted>\"")
+            .Insert("/route/1", "\"gateway\"")
+            .Remove("/debug")
+            .Insert("/new~0key", "[true]")
+            .Apply(json);
+        std::pmr::set_default_resource(previous);
+        assert(patched.Value().get_allocator().resource() == &arena);
+        assert(JsonValue{patched.Value()}["route"][1].As<String>() == "gateway");
+        assert(arena.GetStats().BytesAllocated >= patched.Value().size());
+    }
+
+    {   // Errors
+        const auto codeOf = [&](const Patch& patch) { return patch.Apply(json).Error().BasicInfo.Code; };
+        using enum NError::ErrorCode;
+        assert(codeOf(Patch{}.Replace("/auth/password", "1")) == MappingKeyNotFound);
+        assert(codeOf(Patch{}.Remove("/route/3")) == ArrayIndexOutOfRange);
+        assert(codeOf(Patch{}.Insert("/route/4", "1")) == ArrayIndexOutOfRange);
+        assert(codeOf(Patch{}.Insert("/route/x", "1")) == InvalidPointerError);
+        assert(codeOf(Patch{}.Insert("/hops/0", "1")) == TypeError);
+        assert(codeOf(Patch{}.Insert("/hops", "1")) == PatchError);
+        assert(codeOf(Patch{}.Remove("")) == PatchError);
+        assert(codeOf(Patch{}.Replace("/hops", " ")) == PatchError);
+        assert(codeOf(Patch{}.Remove("/hops").Remove("/hops")) == PatchError);
+        assert(codeOf(Patch{}.Replace("/auth", "{}").Replace("/auth/user", "\"admin\"")) == PatchError);
+        assert(codeOf(Patch{}.Remove("/route/1").Replace("/route/1", "1")) == PatchError);
+        assert(codeOf(Patch{}.Remove("/route/2").Replace("/route/2", "1")) == PatchError);
+        // Errors of navigation are the same as those of `JsonValue::AtPointer`
+        const auto broken = JsonValue{"{\"a\" 1}"};
+        assert(Patch{}.Replace("/a", "1").Apply(broken).Error() == broken.AtPointer("/a").Error());
+    }
+}
@@ -0,0 +1,82 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+
+
+using namespace NJsonParser;
+
+
+auto TestPointer() -> void {
+    static constexpr auto json = JsonValue{
+        /* line numbers: */
+        /* 0  */ "{                                                           \n"
+        /* 1  */ "    \"params\": {                                           \n"
+        /* 2  */ "        \"cpp_standard\": 20,                               \n"
+        /* 3  */ "        \"compilers\": [                                    \n"
+        /* 4  */ "            {\"name\": \"clang\", \"version\": \"14.0.0\"}, \n"
+        /* 5  */ "            {\"version\": \"11.4.0\", \"name\": \"gcc\"},   \n"
+        /* 6  */ "        ]                                                   \n"
+        /* 7  */ "    },                                                      \n"
+        /* 8  */ "    \"a/b\": 1,                                             \n"
+        /* 9  */ "    \"m~n\": 2,                                             \n"
+        /* 10 */ "    \"7\": 3                                                \n"
+        /* 11 */ "}                                                           \n"
+    };
+
+    {   // Evaluate json pointers given as strings
+        static_assert(json.AtPointer("/params/compilers/1/name").As<String>() == "gcc");
+        static_assert(json.AtPointer("/params/cpp_standard").As<Int>() == 20);
+        // The empty pointer refers to the whole document
+        static_assert(json.AtPointer("").Value().GetData() == json.GetData());
+        // "~1" stands for '/' and "~0" stands for '~'
+        static_assert(json.AtPointer("/a~1b").As<Int>() == 1);
+        static_assert(json.AtPointer("/m~0n").As<Int>() == 2);
+        // Segments that look like array indices are used as keys when applied to mappings
+        static_assert(json.AtPointer("/7").As<Int>() == 3);
+        // Same thing at run-time, with monadic chaining
+        const auto pointer = std::string{"/compilers/0/version"};
+        assert(json["params"].AtPointer(pointer).As<String>() == "14.0.0");
+    }
+
+    {   // Errors are reported in the same way as by `operator[]`
+        static_assert(
+            json.AtPointer("/params/compilers/2/name").Error() == json["params"]["compilers"][2]["name"].Error()
+        );
+        static_assert(json.AtPointer("/params/interpreters").Error() == json["params"]["interpreters"].Error());
+        static_assert(json.AtPointer("/params/compilers/0/name/0").Error().BasicInfo.Code == NError::ErrorCode::TypeError);
+        static_assert(json.AtPointer("/params/compilers/-").Error() == NError::Error{
+            .BasicInfo = {
+                .LineNumber = 3,
+                .Position = 21, // points at the start of the array
+                .Code = NError::ErrorCode::InvalidPointerError,
+            },
+            .AdditionalInfo = "json pointer refers to an array element with something that is not an array index",
+        });
+        // Invalid pointers
+        static_assert(json.AtPointer("params").Error().BasicInfo.Code == NError::ErrorCode::InvalidPointerError);
+        static_assert(json.AtPointer("/m~2n").Error().BasicInfo.Code == NError::ErrorCode::InvalidPointerError);
+        static_assert(json.AtPointer("/params/compilers/01").Error().BasicInfo.Code == NError::ErrorCode::InvalidPointerError);
+    }
+
+    {   // Compile a pointer once and evaluate it many times. Pointers
+        // given as literals can be compiled at compile time
+        static constexpr auto pointer = CompiledPointer<>::Compile("/params/compilers/1/name").Value();
+        static_assert(pointer.GetSegments().size() == 4);
+        static_assert(pointer.GetSegments()[2].IsIndex() && pointer.GetSegments()[2].Index == 1);
+        static_assert(!pointer.GetSegments()[3].IsIndex());
+        static_assert(pointer.GetSegments()[3].KeyHash == NUtils::Hash("name"));
+        static_assert(pointer.Evaluate(json).As<String>() == "gcc");
+
+        constexpr auto escaped = CompiledPointer<>::Compile("/a~1b").Value();
+        static_assert(escaped.GetSegments()[0].KeyLen == 3);
+        static_assert(escaped.GetSegments()[0].KeyHash == NUtils::Hash("a/b"));
+        static_assert(escaped.Evaluate(json).As<Int>() == 1);
+
+        const auto other = JsonValue{R"({"params": {"compilers": [{}, {"name": "msvc"}]}})"};
+        assert(pointer.Evaluate(other).As<String>() == "msvc");
+
+        static_assert(CompiledPointer<2>::Compile("/a/b/c").HasError());
+        static_assert(CompiledPointer<>::Compile("/a~").HasError());
+    }
+}
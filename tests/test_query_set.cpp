@@ -0,0 +1,86 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestQuerySet() -> void {
+    static constexpr auto json = JsonValue{
+        /* line numbers: */
+        /* 0 */ "{                                                      \n"
+        /* 1 */ "    \"request\": {                                     \n"
+        /* 2 */ "        \"headers\": {                                 \n"
+        /* 3 */ "            \"host\": \"example.com\",                 \n"
+        /* 4 */ "            \"accept\": \"*/*\",                       \n"
+        /* 5 */ "            \"a/b\": [10, 20, 30]                      \n"
+        /* 6 */ "        },                                             \n"
+        /* 7 */ "        \"body\": {\"huge\": [[1, 2], [3, 4], [5, 6]]}, \n"
+        /* 8 */ "        \"id\": 57                                     \n"
+        /* 9 */ "    }                                                  \n"
+        /* 10*/ "}                                                      \n"
+    };
+    static constexpr auto pointers = std::array<std::string_view, 9>{
+        "/request/headers/host",
+        "/request/headers/accept",
+        "/request/id",
+        "/request/headers/a~1b/2",
+        "/request/headers/a~1b/3",      // index out of range
+        "/request/headers/cookie",      // missing key
+        "/request/id/x",                // not a container
+        "/request/headers/host",        // the same query twice
+        "",                             // the whole document
+    };
+
+    {   // Compile a set of pointers once (even at compile time) and evaluate all of them in one pass
+        static constexpr auto querySet = QuerySet<16>::Compile(pointers).Value();
+        static_assert(querySet.size() == 9);
+
+        auto results = std::vector<Expected<JsonValue>>(querySet.size());
+        querySet.Evaluate(json, results);
+        assert(results[0].As<String>() == "example.com");
+        assert(results[1].As<String>() == "*/*");
+        assert(results[2].As<Int>() == 57);
+        assert(results[3].As<Int>() == 30);
+        assert(results[7].As<String>() == "example.com");
+        assert(results[8].Value().GetData() == json.GetData());
+        // The results are exactly the same as those of separate lookups, including the errors
+        for (size_t i = 0; i != pointers.size(); ++i) {
+            const auto expected = json.AtPointer(pointers[i]);
+            assert(results[i].HasError() == expected.HasError());
+            if (expected.HasError()) assert(results[i].Error() == expected.Error());
+            else assert(results[i].Value().GetData() == expected.Value().GetData());
+        }
+        assert(results[4].Error().BasicInfo.Code == NError::ErrorCode::ArrayIndexOutOfRange);
+        assert(results[5].Error().BasicInfo.Code == NError::ErrorCode::MappingKeyNotFound);
+        assert(results[6].Error().BasicInfo.Code == NError::ErrorCode::TypeError);
+    }
+
+    {   // Queries can also be evaluated at compile time
+        constexpr auto hostAndId = []() {
+            auto querySet = QuerySet<2>::Compile({}).Value();
+            const auto host = querySet.Add("/request/headers/host").Value();
+            const auto id = querySet.Add("/request/id").Value();
+            auto results = std::array<Expected<JsonValue>, 2>{};
+            querySet.Evaluate(json, results);
+            return std::pair{results[host].As<String>().Value(), results[id].As<Int>().Value()};
+        }();
+        static_assert(hostAndId.first == "example.com");
+        static_assert(hostAndId.second == 57);
+        static_assert(QuerySet<1>::Compile(pointers).HasError()); // too many queries
+        static_assert(QuerySet<2>::Compile(std::array<std::string_view, 1>{"no slash"}).HasError());
+    }
+
+    {   // Errors in the document are propagated to all the queries that depend on them
+        constexpr auto malformed = JsonValue{"{\"a\": {\"b\": 1, 7: 2, \"d\": 3}}"};
+        constexpr auto querySet = QuerySet<3>::Compile(std::array<std::string_view, 3>{"/a/b", "/a/d", "/a/d/e"}).Value();
+        auto results = std::array<Expected<JsonValue>, 3>{};
+        querySet.Evaluate(malformed, results);
+        assert(results[0].As<Int>() == 1);
+        assert(results[1].HasError() && results[1].Error() == malformed.AtPointer("/a/d").Error());
+        assert(results[1].Error().BasicInfo.Code == NError::ErrorCode::TypeError); // 7 is not a valid key
+        assert(results[2].HasError() && results[2].Error() == results[1].Error());
+    }
+}
@@ -0,0 +1,237 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // Splits `data` into pieces of `size` characters (the last one may be shorter)
+    auto Split(std::string_view data, size_t size) -> std::vector<std::string_view> {
+        auto segments = std::vector<std::string_view>{};
+        for (size_t pos = 0; pos < data.size(); pos += size) segments.push_back(data.substr(pos, size));
+        return segments;
+    }
+
+    template <class T>
+    auto Same(const Expected<T>& lhs, const Expected<T>& rhs) -> bool {
+        if (lhs.HasValue() != rhs.HasValue()) return false;
+        return lhs.HasValue() ? lhs.Value() == rhs.Value() : lhs.Error() == rhs.Error();
+    }
+
+    auto SameElement(const Expected<SegmentedValue>& elem, const Expected<JsonValue>& expected) -> bool {
+        if (elem.HasError() || expected.HasError()) return elem.HasError() && expected.HasError() && elem.Error() == expected.Error();
+        return elem.Value().GetJsonValue().GetData() == expected.Value().GetData();
+    }
+
+    // Iterating over the value gives the same elements and (key, value) pairs
+    // as iterating over its `JsonValue` counterpart, and ends with the same error
+    auto CheckIteration(const Expected<SegmentedValue>& value, const Expected<JsonValue>& expected) -> void {
+        const auto array = expected.As<Array>();
+        auto elemIt = value.Elements().begin();
+        auto expectedElemIt = array.begin();
+        for (; expectedElemIt != array.end(); ++elemIt, ++expectedElemIt) {
+            assert(elemIt != value.Elements().end());
+            assert(SameElement(*elemIt, *expectedElemIt));
+        }
+        assert(elemIt == value.Elements().end());
+        assert(elemIt.HasError() == expectedElemIt.HasError());
+        assert(!elemIt.HasError() || elemIt.Error() == expectedElemIt.Error());
+
+        const auto mapping = expected.As<Mapping>();
+        auto itemIt = value.Items().begin();
+        auto expectedItemIt = mapping.begin();
+        for (; expectedItemIt != mapping.end(); ++itemIt, ++expectedItemIt) {
+            assert(itemIt != value.Items().end());
+            const auto [key, val] = *itemIt;
+            const auto [expectedKey, expectedVal] = *expectedItemIt;
+            assert(Same(key, expectedKey));
+            assert(SameElement(val, expectedVal));
+        }
+        assert(itemIt == value.Items().end());
+        assert(itemIt.HasError() == expectedItemIt.HasError());
+        assert(!itemIt.HasError() || itemIt.Error() == expectedItemIt.Error());
+    }
+
+    // The value and its `JsonValue` counterpart have the same type, the same size
+    // and the same scalar value, or both are the same error
+    auto Check(const Expected<SegmentedValue>& value, const Expected<JsonValue>& expected) -> void {
+        assert(value.HasError() == expected.HasError());
+        if (expected.HasError()) {
+            assert(value.Error() == expected.Error());
+            return;
+        }
+        assert(value.Value().Type() == expected.Value().Type());
+        assert(value.Value().GetJsonValue().GetData() == expected.Value().GetData());
+        assert(value.Value().GetJsonValue().GetLpCounter() == expected.Value().GetLpCounter());
+        assert(Same(value.size(), expected.Value().Type() == JsonType::Mapping
+            ? expected.As<Mapping>().size()
+            : expected.As<Array>().size()
+        ));
+        assert(Same(value.As<Int>(), expected.As<Int>()));
+        assert(Same(value.As<String>(), expected.As<String>()));
+        assert(Same(value.As<Bool>(), expected.As<Bool>()));
+        CheckIteration(value, expected);
+    }
+} // namespace
+
+
+auto TestSegmentedDocument() -> void {
+    const auto data = std::string{
+        /* line numbers: */
+        /* 0 */ "  {                                                     \n"
+        /* 1 */ "    \"params\": {                                       \n"
+        /* 2 */ "        \"cpp_standard\": 20,                           \n"
+        /* 3 */ "        \"compilers\": [                                \n"
+        /* 4 */ "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        /* 5 */ "            {\"version\": \"11.4.0\", \"name\": \"gcc\"}\n"
+        /* 6 */ "        ],                                              \n"
+        /* 7 */ "        \"flags\": [\"-O2\", \"-Wall\", \"-Wextra\"]    \n"
+        /* 8 */ "    },                                                  \n"
+        /* 9 */ "    \"broken\": [1, 2, {\"a\" 3}, [4}],                 \n"
+        /* 10*/ "    \"truncated\": {\"a\": 1, \"b\"},                   \n"
+        /* 11*/ "    \"empty\": [], \"nothing\": [1,, 2], \"ok\": true   \n"
+        /* 12*/ "}                                                       \n"
+    };
+    const auto json = JsonValue{data};
+
+    {   // Navigation gives the same values and errors as `JsonValue` for every way of splitting the document
+        auto splits = std::vector<std::vector<std::string_view>>{};
+        for (const size_t size : {size_t{1}, size_t{2}, size_t{3}, size_t{7}, size_t{16}, size_t{61}, data.size()}) {
+            splits.push_back(Split(data, size));
+        }
+        for (size_t pos = 1; pos != data.size(); ++pos) {
+            splits.push_back({std::string_view{data}.substr(0, pos), std::string_view{data}.substr(pos)});
+        }
+        for (const auto& segments : splits) {
+            const auto document = SegmentedDocument{segments};
+            assert(document.Size() == data.size());
+            const auto root = document.Root();
+            Check(root, json);
+            Check(root["params"], json["params"]);
+            Check(root["params"]["cpp_standard"], json["params"]["cpp_standard"]);
+            for (size_t i = 0; i != 3; ++i) {
+                Check(root["params"]["compilers"][i], json["params"]["compilers"][i]);
+                Check(root["params"]["compilers"][i]["name"], json["params"]["compilers"][i]["name"]);
+                Check(root["params"]["flags"][i], json["params"]["flags"][i]);
+            }
+            Check(root["params"]["interpreters"], json["params"]["interpreters"]);
+            Check(root["params"][0], json["params"][0]);
+            Check(root["params"]["cpp_standard"]["x"], json["params"]["cpp_standard"]["x"]);
+            // Malformed containers are reported only when the error is reached, like with `JsonValue`
+            for (size_t i = 0; i != 5; ++i) {
+                Check(root["broken"][i], json["broken"][i]);
+                Check(root["nothing"][i], json["nothing"][i]);
+            }
+            Check(root["broken"][2]["a"], json["broken"][2]["a"]);
+            Check(root["truncated"]["a"], json["truncated"]["a"]);
+            Check(root["truncated"]["b"], json["truncated"]["b"]);
+            Check(root["truncated"]["c"], json["truncated"]["c"]);
+            Check(root["empty"], json["empty"]);
+            Check(root["empty"][0], json["empty"][0]);
+            Check(root["ok"], json["ok"]);
+            CheckIteration(root["broken"][2], json["broken"][2]);
+            CheckIteration(root["missing"], json["missing"]);
+            assert(root["params"]["compilers"][1]["name"].As<String>() == "gcc");
+        }
+    }
+
+    {   // Only the values that straddle a boundary are copied
+        const auto first = std::string_view{"{\"id\": 12345, \"name\": \"seg"};
+        const auto second = std::string_view{"mented\", \"items\": [1, 2, 3], \"tail\": {\"a\": [tru"};
+        const auto third = std::string_view{"e]}}"};
+        const auto segments = std::vector<std::string_view>{first, {}, second, third};
+        const auto document = SegmentedDocument{segments};
+        const auto root = document.Root();
+        assert(!root.IsContiguous());
+        assert(root["id"].As<Int>() == 12345);
+        assert(root["items"].Value().IsContiguous());
+        assert(root["items"][2].As<Int>() == 3);
+        assert(root["items"].size() == 3u);
+        assert(root.size() == 4u);
+        // Contiguous values are views of the segments
+        assert(root["id"].Value().GetJsonValue().GetData().data() == first.data() + 7);
+        assert(document.GetStats().Copies == 0);
+        assert(!root["tail"].Value().IsContiguous());
+        assert(root["tail"]["a"][0].As<Bool>() == true);
+        assert(document.GetStats().Copies == 1);
+        assert(document.GetStats().CopiedBytes == 4);
+        // The strings that are copied stay valid as long as the document
+        const auto name = root["name"].As<String>();
+        assert(name == "segmented");
+        assert(document.GetStats().Copies == 2);
+    }
+
+    {   // Straddling containers are iterated over and searched without copying them or their keys
+        const auto segments = std::vector<std::string_view>{"{\"lo", "ng_key\": [1, [2, ", "3], 4], \"x\": 5}"};
+        const auto document = SegmentedDocument{segments};
+        const auto root = document.Root();
+        for (int i = 0; i != 1000; ++i) assert(root["x"].As<Int>() == 5);
+        assert(root["long_key"].size() == 3u);
+        for (int i = 0; i != 3; ++i) {
+            int64_t sum = 0;
+            for (const auto elem : root["long_key"].Elements()) {
+                if (elem.Value().Type() == JsonType::Number) sum += elem.As<Int>().Value();
+                else for (const auto nested : elem.Value().Elements()) sum += nested.As<Int>().Value();
+            }
+            assert(sum == 10);
+        }
+        assert(document.GetStats().Copies == 0);
+        // A straddling key is copied when it is returned, and only once
+        for (int i = 0; i != 3; ++i) {
+            auto keys = std::vector<std::string_view>{};
+            for (const auto [key, _] : root.Items()) keys.push_back(key.Value());
+            assert((keys == std::vector<std::string_view>{"long_key", "x"}));
+        }
+        assert(document.GetStats().Copies == 1);
+        assert(document.GetStats().CopiedBytes == 10);
+        // So are the straddling scalars
+        const auto split = SegmentedDocument{std::vector<std::string_view>{"[12", "34]"}};
+        for (int i = 0; i != 3; ++i) assert(split.Root()[0].As<Int>() == 1234);
+        assert(split.GetStats().Copies == 1);
+    }
+
+    {   // The tables of the segments and the copies are allocated from the memory resource of the document
+        auto arena = ArenaResource{};
+        const auto text = std::string(100, 'x');
+        const auto data = "[\"" + text + "\"]";
+        const auto document = SegmentedDocument{Split(data, 50), &arena};
+        const auto afterConstruction = arena.GetStats().BytesAllocated;
+        assert(afterConstruction != 0);
+        assert(document.Root()[0].As<String>() == text);
+        assert(document.GetStats().CopiedBytes == text.size() + 2);
+        assert(arena.GetStats().BytesAllocated >= afterConstruction + text.size() + 2);
+    }
+
+    {   // A large document split into network-sized buffers is navigated with few copies
+        auto large = std::string{"{\"items\": ["};
+        for (int i = 0; i != 2000; ++i) {
+            large += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"t" + std::to_string(i % 7) + "\"], \"ok\": true}, ";
+        }
+        large += "{}]}";
+        const auto segments = Split(large, 1500);
+        const auto document = SegmentedDocument{segments};
+        const auto items = document.Root()["items"];
+        assert(items.size() == 2001u);
+        for (int i = 0; i < 2000; i += 97) {
+            assert(items[i]["id"].As<Int>() == i);
+            assert(items[i]["tags"][0].As<String>() == "t" + std::to_string(i % 7));
+        }
+        assert(document.GetStats().Copies <= 21);
+    }
+
+    {   // Documents of spaces and scalars
+        const auto empty = SegmentedDocument{std::vector<std::string_view>{}};
+        assert(empty.Root().Type() == JsonType::Missing);
+        assert(empty.Root().As<Int>().Error() == JsonValue{}.As<Int>().Error());
+        const auto spaces = SegmentedDocument{std::vector<std::string_view>{"  ", "\n", " "}};
+        assert(spaces.Root().Type() == JsonType::Missing);
+        const auto number = SegmentedDocument{std::vector<std::string_view>{" -12", "34", "5 "}};
+        assert(number.Root().Type() == JsonType::Number);
+        assert(number.Root().As<Int>() == -12345);
+        assert(number.Root()[0].Error() == JsonValue{" -12345 "}[0].Error());
+    }
+}
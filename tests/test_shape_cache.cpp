@@ -0,0 +1,134 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestShapeCache() -> void {
+    static constexpr auto json = JsonValue{
+        /* line numbers: */
+        /* 0 */ "[                                                  \n"
+        /* 1 */ "    {\"ts\": 1, \"user\": \"alice\", \"v\": 0.5},   \n"
+        /* 2 */ "    {\"ts\": 22, \"user\": \"bob\", \"v\": 1.5},    \n"
+        /* 3 */ "    {\"ts\": 333, \"user\": \"carol\", \"v\": 2.5}, \n"
+        /* 4 */ "    {\"user\": \"dave\", \"ts\": 4444, \"v\": 3.5}, \n"
+        /* 5 */ "    {\"user\": \"eve\", \"ts\": 5, \"v\": 4.5},     \n"
+        /* 6 */ "    {\"user\": \"eve\", \"ts\": 5, \"extra\": 4.5}  \n"
+        /* 7 */ "]                                                  \n"
+    };
+    static constexpr auto fields = std::array<std::string_view, 2>{"ts", "v"};
+
+    {   // Look up the same fields in every element of an array. The first mapping is walked over
+        // with the generic scan, and its shape is remembered. The next two mappings have the same
+        // shape (the values differ in length, but the keys and the distances between the keys and
+        // the values are the same), so they are walked over speculatively. The fourth mapping has
+        // a different order of keys: the shape is relearned, and the fifth mapping matches it again.
+        // In the last one, the key "v" is replaced with "extra", which is detected as well.
+        auto cache = ShapeCache{};
+        auto sumTs = Int{0};
+        auto sumV = Float{0};
+        auto positions = std::vector<LinePositionCounter>{};
+        for (const auto elem : json.As<Array>()) {
+            const auto nFound = cache.Match(
+                elem.As<Mapping>().Value(), fields,
+                [&](size_t fieldIdx, const JsonValue& value) {
+                    positions.push_back(value.GetLpCounter());
+                    if (fieldIdx == 0) sumTs += value.As<Int>().Value();
+                    else sumV += value.As<Float>().Value();
+                    return true;
+                }
+            );
+            assert(nFound.HasValue());
+        }
+        assert(sumTs == 1 + 22 + 333 + 4444 + 5 + 5);
+        assert(sumV == 0.5 + 1.5 + 2.5 + 3.5 + 4.5);
+        assert((cache.GetStats() == ShapeCache<>::Stats{.Hits = 3, .Misses = 3}));
+        // The values found speculatively have the same positions as the ones found by the generic scan
+        assert((positions[2].LineNumber == 2 && positions[2].Position == 11));
+        assert((positions[3].LineNumber == 2 && positions[3].Position == 35));
+        for (size_t i = 0; i != positions.size(); ++i) {
+            const auto lpCounter = json[i / 2][fields[i % 2]].Value().GetLpCounter();
+            assert(positions[i].LineNumber == lpCounter.LineNumber);
+            assert(positions[i].Position == lpCounter.Position);
+        }
+    }
+
+    {   // The cache can be used to extract columns, which gives the same results as without it
+        constexpr auto extractTs = [](bool useCache) {
+            auto ts = std::array<Int, 6>{};
+            auto tsValid = std::array<uint64_t, 1>{};
+            auto v = std::array<Float, 6>{};
+            auto vValid = std::array<uint64_t, 1>{};
+            auto cache = ShapeCache<4>{};
+            const auto nRows = useCache
+                ? ExtractColumns(json.As<Array>(), cache, Column<Int>{"ts", ts, tsValid}, Column<Float>{"v", v, vValid})
+                : ExtractColumns(json.As<Array>(), Column<Int>{"ts", ts, tsValid}, Column<Float>{"v", v, vValid});
+            return std::pair{ts, vValid[0] + 100 * nRows.Value() + 1000 * cache.GetStats().Hits};
+        };
+        static_assert(extractTs(true).first == extractTs(false).first);
+        static_assert(extractTs(false).second == 0b011111 + 100 * 6);
+        static_assert(extractTs(true).second == 0b011111 + 100 * 6 + 1000 * 3);
+    }
+
+    {   // A key that is not requested is compared byte by byte, so a different key of the same
+        // length (even one with the same hash) makes the cache fall back to the generic scan
+        auto cache = ShapeCache{};
+        auto found = std::vector<std::string_view>{};
+        const auto match = [&](const JsonValue& elem) {
+            return cache.Match(
+                elem.As<Mapping>().Value(), std::array<std::string_view, 1>{"v"},
+                [&found](size_t, const JsonValue& value) { found.push_back(value.GetData()); return true; }
+            );
+        };
+        assert(match(JsonValue{"{\"ab\": 1, \"v\": 2}"}) == 1u);
+        assert(match(JsonValue{"{\"ab\": 3, \"v\": 4}"}) == 1u);
+        assert(match(JsonValue{"{\"cd\": 5, \"v\": 6}"}) == 1u);
+        assert(match(JsonValue{"{\"cd\": {\"v\": 7}, \"v\": 8}"}) == 1u);
+        assert((found == std::vector<std::string_view>{"2", "4", "6", "8"}));
+        // The last mapping has the same keys as the one before, only a longer value
+        assert((cache.GetStats() == ShapeCache<>::Stats{.Hits = 2, .Misses = 2}));
+        // The remembered keys are copies, so they don't refer to the mappings seen before
+        {
+            auto data = std::string{"{\"xy\": 1, \"v\": 2}"};
+            assert(match(JsonValue{data}) == 1u);
+            data[2] = 'z';
+        }
+        assert(match(JsonValue{"{\"xy\": 1, \"v\": 9}"}) == 1u);
+        assert(found.back() == "9");
+        assert((cache.GetStats() == ShapeCache<>::Stats{.Hits = 3, .Misses = 3}));
+    }
+
+    {   // Syntax errors are reported the same way as by the generic scan
+        auto cache = ShapeCache{};
+        const auto check = [&](const JsonValue& elem) {
+            const auto expected = elem["b"];
+            auto found = std::string_view{};
+            const auto nFound = cache.Match(
+                elem.As<Mapping>().Value(), std::array<std::string_view, 1>{"b"},
+                [&found](size_t, const JsonValue& value) { found = value.GetData(); return true; }
+            );
+            if (expected.HasError()) assert(nFound == expected.Error());
+            else assert(found == expected.Value().GetData());
+        };
+        check(JsonValue{"{\"a\": 1, \"b\": 2}"});
+        check(JsonValue{"{\"a\": 1, \"b\": [2}"});
+    }
+
+    {   // The remembered keys are copied into memory taken from the allocator of the cache
+        auto arena = ArenaResource{};
+        auto cache = pmr::ShapeCache<>{&arena};
+        const auto longKey = std::string(100, 'k');
+        const auto data = "{\"" + longKey + "\": 1, \"v\": 2}";
+        const auto elem = JsonValue{data};
+        for (auto i = 0; i != 2; ++i) {
+            assert(cache.Match(elem.As<Mapping>().Value(), fields, [](size_t, const JsonValue&) { return true; }) == 1u);
+        }
+        assert((cache.GetStats() == pmr::ShapeCache<>::Stats{.Hits = 1, .Misses = 1}));
+        assert(cache.get_allocator().resource() == &arena);
+        assert(arena.GetStats().BytesAllocated >= longKey.size());
+    }
+}
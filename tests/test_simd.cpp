@@ -0,0 +1,289 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // Inputs of all lengths up to a few vector widths, with the interesting characters
+    // at all positions relative to the vector boundaries
+    auto MakeInputs() -> std::vector<std::string> {
+        auto inputs = std::vector<std::string>{};
+        constexpr auto kAlphabet = std::string_view{"    \t\n\nab,:\"[]{}\x80\xc3\xa9"};
+        uint64_t state = 42;
+        for (size_t len = 0; len != 200; ++len) {
+            for (int variant = 0; variant != 4; ++variant) {
+                auto input = std::string{};
+                for (size_t i = 0; i != len; ++i) {
+                    state = state * 6364136223846793005ull + 1442695040888963407ull;
+                    // Long runs of the same class of characters, so that vectors are skipped as a whole
+                    const auto r = state >> 33;
+                    if (variant == 0) input += kAlphabet[r % kAlphabet.size()];
+                    else if (variant == 1) input += (r % 64 == 0) ? kAlphabet[r % kAlphabet.size()] : ' ';
+                    else if (variant == 2) input += (r % 64 == 0) ? kAlphabet[r % kAlphabet.size()] : 'x';
+                    else input += (r % 16 == 0) ? '\n' : (r % 64 == 1 ? '"' : 'x');
+                }
+                inputs.push_back(std::move(input));
+            }
+        }
+        return inputs;
+    }
+
+    auto SameNewlines(const NSimd::Newlines& lhs, const NSimd::Newlines& rhs) -> bool {
+        return lhs.Count == rhs.Count && (lhs.Count == 0 || lhs.Last == rhs.Last);
+    }
+
+    // Documents with containers and strings (with brackets inside) nested in all possible ways,
+    // most of them balanced, with newlines here and there
+    auto MakeNestedInputs() -> std::vector<std::string> {
+        auto inputs = std::vector<std::string>{};
+        uint64_t state = 7;
+        const auto next = [&state](uint64_t n) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (state >> 33) % n;
+        };
+        for (size_t len = 0; len < 400; len += 3) {
+            for (const auto maxDepth : {2, 8, 100}) {
+                auto input = std::string{};
+                auto open = std::string{};
+                while (input.size() < len) {
+                    const auto r = next(10);
+                    if (r < 3 && open.size() < static_cast<size_t>(maxDepth)) {
+                        open += next(2) ? '[' : '{';
+                        input += open.back();
+                    } else if (r < 6 && !open.empty()) {
+                        // Occasionally a mismatched bracket
+                        const auto match = open.back() == '[' ? ']' : '}';
+                        input += next(50) ? match : (match == ']' ? '}' : ']');
+                        open.pop_back();
+                    } else if (r < 8) {
+                        input += '"';
+                        for (auto n = next(len / 4 + 2); n != 0; --n) input += "ab[]{} \n,:"[next(11)];
+                        input += '"';
+                    } else {
+                        input += r == 8 ? ", " : "1\n";
+                    }
+                }
+                while (!open.empty()) {
+                    input += open.back() == '[' ? ']' : '}';
+                    open.pop_back();
+                }
+                inputs.push_back(std::move(input));
+            }
+        }
+        return inputs;
+    }
+
+    // The contents of arrays and mappings made of the nested inputs, most of them well-formed,
+    // some with a character inserted or removed here and there
+    auto MakeSequences(const std::vector<std::string>& nestedInputs) -> std::vector<std::string> {
+        auto sequences = std::vector<std::string>{};
+        uint64_t state = 11;
+        const auto next = [&state](uint64_t n) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            return (state >> 33) % n;
+        };
+        for (size_t i = 0; i != 1000; ++i) {
+            auto sequence = std::string{};
+            const auto isMapping = next(2) != 0;
+            for (auto n = next(8); n != 0; --n) {
+                if (!sequence.empty()) sequence += next(2) ? ", " : ",\n";
+                if (isMapping) sequence += next(2) ? "\"k\": " : "\"a:b,\":";
+                const auto& value = nestedInputs[next(nestedInputs.size())];
+                sequence += value.empty() ? "1" : value;
+            }
+            if (next(4) == 0) sequence += next(2) ? ", " : ",";
+            for (auto n = next(3) == 0 ? next(3) + 1 : 0; n != 0 && !sequence.empty(); --n) {
+                const auto pos = next(sequence.size());
+                if (next(2)) sequence.erase(pos, 1);
+                else sequence.insert(pos, 1, ",:[]{}\" "[next(8)]);
+            }
+            sequences.push_back(std::move(sequence));
+        }
+        return sequences;
+    }
+
+    // What `NUtils::SkipNested` does, one character at a time
+    auto SkipNestedSlowly(
+        const char* it,
+        const char* end,
+        std::string& stack,
+        bool& insideString,
+        NSimd::Newlines& newlines
+    ) -> const char* {
+        for (; it != end; ++it) {
+            const auto ch = *it;
+            if (ch == '"') {
+                if (stack.empty()) return it;
+                insideString = !insideString;
+            } else if (!insideString && (ch == '[' || ch == '{')) {
+                stack += ch;
+            } else if (!insideString && (ch == ']' || ch == '}')) {
+                if (stack.size() == 1 || stack.back() != (ch == ']' ? '[' : '{')) return it;
+                stack.pop_back();
+            }
+            if (ch == '\n') ++newlines.Count, newlines.Last = it;
+        }
+        return end;
+    }
+} // namespace
+
+
+auto TestSimd() -> void {
+    const auto detected = NSimd::DetectIsa();
+    assert(NSimd::IsSupported(NSimd::Isa::Scalar));
+    assert(NSimd::IsSupported(detected));
+    assert(NSimd::GetKernels().Level == detected);
+
+    const auto inputs = MakeInputs();
+    const auto nestedInputs = MakeNestedInputs();
+    const auto sequences = MakeSequences(nestedInputs);
+    const auto json = std::string{
+        "{                                                                       \n"
+        "    \"params\": {\"cpp_standard\": 20, \"flags\": [\"-O2\", \"-g\"]},      \n"
+        "    \"long\": \"a string that is longer than any vector register, with [brackets] and {braces}\",\n"
+        "    \"list\": [1,    2,\n\n\n                                       3],   \n"
+        "    \"broken\": [[1, 2], [3, 4]]]                                        \n"
+        "}                                                                       \n"
+    };
+    const auto root = JsonValue{json};
+    // The results of the library with the scalar kernels, which the other kernels must match
+    std::vector<NError::Error> expectedErrors;
+    std::vector<LinePositionCounter> expectedLpCounters;
+
+    for (const auto isa : {NSimd::Isa::Scalar, NSimd::Isa::Sse2, NSimd::Isa::Avx2, NSimd::Isa::Avx512}) {
+        if (!NSimd::SetIsa(isa)) continue;
+        const auto& kernels = NSimd::GetKernels();
+        assert(kernels.Level == isa);
+
+        {   // The kernels give the same results as the scalar ones
+            const auto& scalar = NSimd::NImpl::kScalarKernels;
+            for (const auto& input : inputs) {
+                for (size_t offset = 0; offset <= std::min<size_t>(input.size(), 3); ++offset) {
+                    const auto begin = input.data() + offset;
+                    const auto end = input.data() + input.size();
+                    auto expectedNewlines = NSimd::Newlines{};
+                    auto newlines = NSimd::Newlines{};
+                    assert(kernels.SkipSpaces(begin, end, newlines) == scalar.SkipSpaces(begin, end, expectedNewlines));
+                    assert(SameNewlines(newlines, expectedNewlines));
+                    for (const auto insideString : {false, true}) {
+                        expectedNewlines = newlines = {};
+                        assert(
+                            kernels.FindStructural(begin, end, insideString, newlines)
+                            == scalar.FindStructural(begin, end, insideString, expectedNewlines)
+                        );
+                        assert(SameNewlines(newlines, expectedNewlines));
+                    }
+                    assert(kernels.SkipAscii(begin, end) == scalar.SkipAscii(begin, end));
+                    if (end - begin >= static_cast<ptrdiff_t>(NSimd::kBlockSize)) {
+                        const auto masks = kernels.ClassifyBlock(begin);
+                        const auto expectedMasks = scalar.ClassifyBlock(begin);
+                        assert(masks.Quotes == expectedMasks.Quotes && masks.Opening == expectedMasks.Opening);
+                        assert(masks.Closing == expectedMasks.Closing && masks.Newlines == expectedMasks.Newlines);
+                        assert(masks.Commas == expectedMasks.Commas && masks.Colons == expectedMasks.Colons);
+                    }
+                }
+            }
+        }
+
+        {   // Skipping over nested values gives the same results as going over them one character at a time
+            for (const auto& input : nestedInputs) {
+                for (size_t start = 0; start < input.size(); start += 1 + start / 8) {
+                    const auto ch = input[start];
+                    if (ch != '[' && ch != '{' && ch != '"') continue;
+                    const auto begin = input.data() + start + 1;
+                    const auto end = input.data() + input.size();
+                    auto expectedStack = std::string(ch == '"' ? 0 : 1, ch);
+                    auto expectedInsideString = ch == '"';
+                    auto expectedNewlines = NSimd::Newlines{};
+                    const auto expected = SkipNestedSlowly(begin, end, expectedStack, expectedInsideString, expectedNewlines);
+
+                    auto stack = NUtils::BracketStack{};
+                    if (ch != '"') stack.Push(ch);
+                    auto insideString = ch == '"';
+                    auto newlines = NSimd::Newlines{};
+                    assert(NUtils::SkipNested(begin, end, stack, insideString, newlines) == expected);
+                    assert(stack.Size() == expectedStack.size());
+                    assert(stack.Empty() || stack.Top() == expectedStack.back());
+                    assert(insideString == expectedInsideString);
+                    assert(SameNewlines(newlines, expectedNewlines));
+                }
+            }
+        }
+
+        {   // Counting the elements gives the same results as iterating over them
+            for (const auto& sequence : sequences) {
+                const auto arrayJson = "[" + sequence + "]";
+                const auto mappingJson = "{" + sequence + "}";
+                const auto array = JsonValue{arrayJson}.As<Array>().Value();
+                assert(array.size() == static_cast<size_t>(std::distance(array.begin(), array.end())));
+                const auto mapping = JsonValue{mappingJson}.As<Mapping>().Value();
+                assert(mapping.size() == static_cast<size_t>(std::distance(mapping.begin(), mapping.end())));
+            }
+        }
+
+        {   // The library gives the same results with all the kernels
+            auto errors = std::vector<NError::Error>{};
+            auto lpCounters = std::vector<LinePositionCounter>{};
+            for (const auto [key, value] : root.As<Mapping>()) {
+                if (value.HasValue()) lpCounters.push_back(value.Value().GetLpCounter());
+                else errors.push_back(value.Error());
+            }
+            for (const auto elem : root["list"].As<Array>()) lpCounters.push_back(elem.Value().GetLpCounter());
+            assert(root["long"].As<String>() == "a string that is longer than any vector register, with [brackets] and {braces}");
+            assert(root["list"][2].As<Int>() == 3);
+            errors.push_back(root["broken"][2].Error());
+            errors.push_back(root["missing"].Error());
+            errors.push_back(JsonValue{std::string_view{json}.substr(0, json.size() - 3)}["broken"].Error());
+            errors.push_back(JsonValue{std::string_view{json}.substr(0, 100)}["long"].Error());
+            if (isa == NSimd::Isa::Scalar) {
+                expectedErrors = errors;
+                expectedLpCounters = lpCounters;
+            }
+            assert(errors == expectedErrors);
+            assert(lpCounters == expectedLpCounters);
+            assert(NUtils::StripSpaces("   \n\t  \n  x y  \n ") == "x y");
+            assert(NUtils::StripSpaces(std::string(100, ' ')).empty());
+        }
+
+        {   // UTF-8 validation
+            assert(NUtils::FindInvalidUtf8("") == 0);
+            constexpr auto ascii = std::string_view{"plain ascii text that is longer than a vector register"};
+            assert(NUtils::FindInvalidUtf8(ascii) == ascii.size());
+            constexpr auto multibyte = std::string_view{"caf\xc3\xa9, \xe2\x82\xac, \xf0\x9f\x98\x80"};
+            assert(NUtils::FindInvalidUtf8(multibyte) == multibyte.size());
+            const auto longValid = std::string(100, 'a') + "\xd0\xb6" + std::string(100, 'b');
+            assert(NUtils::FindInvalidUtf8(longValid) == longValid.size());
+            const auto longInvalid = std::string(100, 'a') + "\xd0" + std::string(100, 'b');
+            assert(NUtils::FindInvalidUtf8(longInvalid) == 100);
+            // Overlong encodings, surrogates, code points above U+10FFFF and truncated sequences
+            assert(NUtils::FindInvalidUtf8("a\xc0\xaf") == 1);
+            assert(NUtils::FindInvalidUtf8("a\xed\xa0\x80") == 1);
+            assert(NUtils::FindInvalidUtf8("a\xf4\x90\x80\x80") == 1);
+            assert(NUtils::FindInvalidUtf8("a\xe2\x82") == 1);
+            assert(NUtils::FindInvalidUtf8("a\x80") == 1);
+        }
+    }
+    assert(NSimd::SetIsa(detected));
+
+    // The characters between pairs of quotes
+    static_assert(NSimd::PrefixXor(0b10'1001'0010) == 0b01'1000'1110);
+    static_assert(NSimd::PrefixXor(1) == ~uint64_t{0});
+    // The elements are counted the same way at compile time
+    static_assert(NUtils::CountElements("1, [2, 3], \"4,5\", {\"6\": 7},  ", false) == 4u);
+    static_assert(NUtils::CountElements("\"a\": [1, 2], \"b:c\": {\"d\": 3}", true) == 2u);
+    static_assert(!NUtils::CountElements("\"a\": 1: 2", true).has_value());
+    static_assert(!NUtils::CountElements("[1, 2}", false).has_value());
+
+    // The portable implementations are used at compile time
+    static_assert(NUtils::FindInvalidUtf8("caf\xc3\xa9") == 5);
+    static_assert(NUtils::FindInvalidUtf8("caf\xc3") == 3);
+    static_assert(NUtils::StripSpaces("  \n x \t") == "x");
+    static_assert(JsonValue{"{\"a\": [1, \"a long string that doesn't fit into a vector register\"]}"}["a"][1].As<String>().HasValue());
+}
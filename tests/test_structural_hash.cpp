@@ -0,0 +1,189 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    constexpr auto kConfig = std::string_view{
+        "{\n"
+        "    \"params\": {\n"
+        "        \"cpp_standard\": 20,\n"
+        "        \"compilers\": [\n"
+        "            {\"name\": \"clang\", \"version\": \"14.0.0\"},\n"
+        "            {\"name\": \"gcc\", \"version\": \"11.4.0\"}\n"
+        "        ]\n"
+        "    },\n"
+        "    \"flags\": [\"-O2\", \"-Wall\"],\n"
+        "    \"a/b~c\": 1\n"
+        "}\n"
+    };
+
+    auto Minified(std::string_view data) -> std::string {
+        auto buffer = std::string(data.size(), '\0');
+        buffer.resize(Minify(data, buffer).Value().size());
+        return buffer;
+    }
+
+    auto Changes(std::string_view before, std::string_view after, StructuralHashOptions options = {}) -> std::vector<DocumentChange> {
+        const auto diff = Diff(JsonValue{before}, JsonValue{after}, options);
+        assert(diff.HasValue());
+        return diff.Value();
+    }
+
+    template <class TAllocator>
+    auto Describe(const DocumentChanges<TAllocator>& changes) -> std::string {
+        using EKind = typename BasicDocumentChange<TAllocator>::EKind;
+        auto result = std::string{};
+        for (const auto& change : changes) {
+            result += change.Kind == EKind::Added ? '+' : change.Kind == EKind::Removed ? '-' : '~';
+            result += change.Pointer;
+            result += ' ';
+            result += change.Before.GetData();
+            result += "->";
+            result += change.After.GetData();
+            result += ';';
+        }
+        return result;
+    }
+} // namespace
+
+
+auto TestStructuralHash() -> void {
+    const auto hash = [](std::string_view data, StructuralHashOptions options = {}) {
+        return StructuralHash(JsonValue{data}, options).Value();
+    };
+
+    {   // Hashes don't depend on the spaces between the tokens
+        assert(hash(kConfig) == hash(Minified(kConfig)));
+        assert(hash(" [1, {\"a\" : null}] ") == hash("[1,{\"a\":null}]"));
+        assert(hash("  \"str\"\n") == hash("\"str\""));
+        // But they depend on everything else
+        assert(hash("[1, 2]") != hash("[2, 1]"));
+        assert(hash("[1, 2]") != hash("[1, 2, 2]"));
+        assert(hash("[[1], 2]") != hash("[1, [2]]"));
+        assert(hash("[]") != hash("{}"));
+        assert(hash("[1]") != hash("1"));
+        assert(hash("{\"a\": 1}") != hash("{\"b\": 1}"));
+        assert(hash("{\"a\": \"b\"}") != hash("[\"a\", \"b\"]"));
+        assert(hash("1") != hash("1.0"));
+        assert(hash("\"1\"") != hash("1"));
+        // Computed at compile time as well
+        static_assert(StructuralHash(JsonValue{"{\"a\": [1, 2]}"}).Value() == StructuralHash(JsonValue{"{\"a\":[1,2]}"}).Value());
+    }
+
+    {   // The order of the keys of mappings may be ignored
+        const auto ignoreOrder = StructuralHashOptions{.IgnoreKeyOrder = true};
+        assert(hash("{\"a\": 1, \"b\": [2]}") != hash("{\"b\": [2], \"a\": 1}"));
+        assert(hash("{\"a\": 1, \"b\": [2]}", ignoreOrder) == hash("{\"b\": [2], \"a\": 1}", ignoreOrder));
+        assert(hash("{\"a\": 1, \"b\": 2}", ignoreOrder) != hash("{\"a\": 2, \"b\": 1}", ignoreOrder));
+        assert(hash("{\"a\": 1}", ignoreOrder) != hash("{\"a\": 1, \"a\": 1}", ignoreOrder));
+        // But not the order of the elements of arrays
+        assert(hash("[1, 2]", ignoreOrder) != hash("[2, 1]", ignoreOrder));
+    }
+
+    {   // The hashes of subtrees
+        const auto hashes = StructuralHashes::Build(JsonValue{kConfig}).Value();
+        const auto view = hashes.GetView();
+        const auto& params = view.Children[view.Containers[0].FirstChild];
+        assert(hashes.HashOf(hashes.ChildNode(view, view.Containers[0].FirstChild)) == hash(view.Data.substr(params.ValueBegin, params.ValueLen)));
+        assert(hashes.Root() == hash(kConfig));
+        assert(StructuralHash(JsonValue{"[1, 2"}).Error() == DocumentIndex::Build(JsonValue{"[1, 2"}).Error());
+    }
+
+    {   // The index and the hashes can be allocated in an arena
+        auto arena = ArenaResource{};
+        const auto edited = std::string{"[1, {\"a\": [2, 3]}, 4]"};
+        const auto hashes = pmr::StructuralHashes::Build(JsonValue{edited}, {}, &arena).Value();
+        assert(hashes.get_allocator().resource() == &arena);
+        assert(arena.GetStats().BytesAllocated != 0);
+        assert(hashes.Root() == hash(edited));
+        // Hashes with different allocators can be compared
+        const auto old = StructuralHashes::Build(JsonValue{"[1, {\"a\": [2, 5]}, 4]"}).Value();
+        assert(Describe(Diff(old, hashes)) == "~/1/a/1 5->3;");
+        // The changes are allocated with the allocator of the old version
+        const auto key = std::string(64, 'k');
+        const auto before = "{\"" + key + "\": [1, 2]}";
+        const auto after = "{\"" + key + "\": [1, 2, 3]}";
+        const auto beforeHashes = pmr::StructuralHashes::Build(JsonValue{before}, {}, &arena).Value();
+        const auto afterHashes = StructuralHashes::Build(JsonValue{after}).Value();
+        const auto allocated = arena.GetStats().BytesAllocated;
+        const auto previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        const auto changes = Diff(beforeHashes, afterHashes);
+        std::pmr::set_default_resource(previous);
+        assert(Describe(changes) == "+/" + key + "/2 ->3;");
+        assert(changes.get_allocator().resource() == &arena);
+        assert(changes[0].Pointer.get_allocator().resource() == &arena);
+        assert(arena.GetStats().BytesAllocated >= allocated + key.size());
+    }
+
+    {   // Changes between two versions of a document
+        assert(Changes(kConfig, kConfig).empty());
+        assert(Changes(kConfig, Minified(kConfig)).empty());
+
+        auto edited = std::string{kConfig};
+        edited.replace(edited.find("11.4.0"), 6, "12.3.0");
+        edited.replace(edited.find("\"-Wall\""), 7, "\"-Wall\", \"-Werror\"");
+        edited.replace(edited.find("\"a/b~c\": 1"), 10, "\"a/b~c\": {\"x\": 1}, \"new\": null");
+        assert(Describe(Changes(kConfig, edited)) ==
+            "~/params/compilers/1/version \"11.4.0\"->\"12.3.0\";"
+            "+/flags/2 ->\"-Werror\";"
+            "~/a~1b~0c 1->{\"x\": 1};"
+            "+/new ->null;"
+        );
+        assert(Describe(Changes(edited, kConfig)) ==
+            "~/params/compilers/1/version \"12.3.0\"->\"11.4.0\";"
+            "-/flags/2 \"-Werror\"->;"
+            "~/a~1b~0c {\"x\": 1}->1;"
+            "-/new null->;"
+        );
+
+        // The values of the changes point into the documents
+        const auto changes = Changes(kConfig, edited);
+        assert(JsonValue{edited}.AtPointer(changes[0].Pointer).Value().GetData() == changes[0].After.GetData());
+        assert(changes[0].After.As<String>() == "12.3.0");
+
+        // Whole documents
+        assert(Describe(Changes("1", " 2 ")) == "~ 1->2;");
+        assert(Describe(Changes("[1]", "{\"0\": 1}")) == "~ [1]->{\"0\": 1};");
+        assert(Describe(Changes("[[1, 2], 3]", "[[1, 2]]")) == "-/1 3->;");
+    }
+
+    {   // Changes of the order of the keys
+        assert(Describe(Changes("{\"m\": {\"a\": 1, \"b\": 2}}", "{\"m\": {\"b\": 2, \"a\": 1}}")) ==
+            "~/m {\"a\": 1, \"b\": 2}->{\"b\": 2, \"a\": 1};"
+        );
+        const auto ignoreOrder = StructuralHashOptions{.IgnoreKeyOrder = true};
+        assert(Changes("{\"m\": {\"a\": 1, \"b\": 2}}", "{\"m\": {\"b\": 2, \"a\": 1}}", ignoreOrder).empty());
+        assert(Describe(Changes("{\"a\": 1, \"b\": 2}", "{\"b\": 3, \"a\": 1}", ignoreOrder)) == "~/b 2->3;");
+        // Only the first occurrences of duplicate keys are compared, like the ones found by `operator[]`
+        assert(Describe(Changes("{\"a\": 1, \"a\": 2}", "{\"a\": 3}")) == "~/a 1->3;");
+    }
+
+    {   // Large mappings are compared with the help of the key tables of the index
+        auto before = std::string{"{"};
+        auto after = std::string{"{"};
+        for (int i = 0; i != 100; ++i) {
+            const auto key = "\"k" + std::to_string(i) + "\": ";
+            before += (i ? ", " : "") + key + std::to_string(i);
+            after += (i ? ", " : "") + key + std::to_string(i == 42 ? -1 : i);
+        }
+        before += "}";
+        after += "}";
+        assert(Describe(Changes(before, after)) == "~/k42 42->-1;");
+    }
+
+    {   // Deeply nested documents don't exhaust the call stack
+        const auto depth = 100000;
+        const auto before = std::string(depth, '[') + "1" + std::string(depth, ']');
+        const auto after = std::string(depth, '[') + "2" + std::string(depth, ']');
+        assert(hash(before) != hash(after));
+        const auto changes = Changes(before, after);
+        assert(changes.size() == 1 && changes[0].Pointer.size() == 2 * depth);
+    }
+}
@@ -0,0 +1,97 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    // A visitor that names what it was called with
+    constexpr auto kDescribe = Overloaded{
+        [](Null) -> std::string { return "null"; },
+        [](Bool b) -> std::string { return b ? "true" : "false"; },
+        [](Int i) -> std::string { return "int " + std::to_string(i); },
+        [](Float) -> std::string { return "float"; },
+        [](String s) -> std::string { return "string " + std::string{s}; },
+        [](Array a) -> std::string { return "array of " + std::to_string(a.size()); },
+        [](Mapping m) -> std::string { return "mapping of " + std::to_string(m.size()); },
+        [](const NError::Error& e) -> std::string { return "error " + std::string{NError::ToStr(e.BasicInfo.Code)}; },
+    };
+} // namespace
+
+
+auto TestVisit() -> void {
+    {   // The type is told by the first character
+        static_assert(JsonValue{"null"}.Type() == JsonType::Null);
+        static_assert(JsonValue{"true"}.Type() == JsonType::Bool);
+        static_assert(JsonValue{" false "}.Type() == JsonType::Bool);
+        static_assert(JsonValue{"-12"}.Type() == JsonType::Number);
+        static_assert(JsonValue{"1.5e3"}.Type() == JsonType::Number);
+        static_assert(JsonValue{"\"str\""}.Type() == JsonType::String);
+        static_assert(JsonValue{"[1, 2]"}.Type() == JsonType::Array);
+        static_assert(JsonValue{"{\"a\": 1}"}.Type() == JsonType::Mapping);
+        static_assert(JsonValue{}.Type() == JsonType::Missing);
+        static_assert(JsonValue{"abc"}.Type() == JsonType::Invalid);
+        // Only the first character is looked at: the value can still be malformed
+        static_assert(JsonValue{"[1, 2"}.Type() == JsonType::Array);
+        static_assert(JsonValue{"[1, 2"}.As<Array>().HasError());
+    }
+
+    {   // A heterogeneous array is decoded without trying the wrong types first
+        const auto json = JsonValue{"[1, \"fizz\", 2.5, true, null, [3, 4], {\"a\": 5}, 100000000000000000000, nope]"};
+        auto described = std::vector<std::string>{};
+        for (const auto elem : json.As<Array>()) described.push_back(elem.Visit(kDescribe));
+        assert((described == std::vector<std::string>{
+            "int 1", "string fizz", "float", "true", "null", "array of 2", "mapping of 1",
+            // Integers that don't fit into `Int` are visited as `Float`
+            "float",
+            "error type error",
+        }));
+        // No errors are made for the well-formed values
+        if constexpr (NInstrumentation::kEnabled) {
+            NInstrumentation::ResetCounters();
+            for (const auto elem : json.As<Array>()) elem.Visit([](const auto&) {});
+            assert(NInstrumentation::GetCounters().Errors == 1);
+        }
+    }
+
+    {   // Malformed values and missing values are visited as errors
+        assert(JsonValue{"\"abc"}.Visit(kDescribe) == "error syntax error");
+        assert(JsonValue{"nul"}.Visit(kDescribe) == "error type error");
+        assert(JsonValue{"tru"}.Visit(kDescribe) == "error type error");
+        assert(JsonValue{}.Visit(kDescribe) == "error \"missing value\" error");
+        assert(JsonValue{"[1]"}[3].Visit(kDescribe) == "error \"array index out of range\" error");
+        // The error is the same as that of the conversion to the type
+        const auto error = JsonValue{"{\"a\": 1"}.Visit(Overloaded{
+            [](const NError::Error& e) { return e; },
+            [](const auto&) { return NError::Error{}; },
+        });
+        assert(error == JsonValue{"{\"a\": 1"}.As<Mapping>().Error());
+    }
+
+    {   // Visiting works at compile time, and the results of the calls are converted to their common type
+        constexpr auto sum = [](const JsonValue& json) {
+            int64_t total = 0;
+            for (const auto elem : json.As<Array>()) {
+                total += elem.Visit(Overloaded{
+                    [](Int i) { return i; },
+                    [](Bool b) { return static_cast<int>(b); },
+                    [](String s) { return static_cast<int64_t>(s.size()); },
+                    [](const auto&) { return 0; },
+                });
+            }
+            return total;
+        };
+        static_assert(sum(JsonValue{"[1, 2, true, \"abc\", null, [10], 2.5]"}) == 7);
+        static_assert(JsonValue{"null"}.Visit(Overloaded{[](Null) { return true; }, [](const auto&) { return false; }}));
+        // Integers that don't fit into `Int` are visited as `Float` at compile time too
+        constexpr auto asFloat = Overloaded{[](Float f) { return f; }, [](const auto&) { return 0.0; }};
+        static_assert(JsonValue{"100000000000000000000"}.Visit(asFloat) == 1e20);
+        static_assert(JsonValue{"-100000000000000000000"}.Visit(asFloat) == -1e20);
+        static_assert(JsonValue{"-9223372036854775808"}.Visit(Overloaded{[](Int i) { return i; }, [](const auto&) { return Int{0}; }}) < 0);
+        static_assert(JsonValue{"100000000000000000000"}.As<Int>().Error().BasicInfo.Code == NError::ErrorCode::ResultOutOfRangeError);
+    }
+}
@@ -0,0 +1,166 @@
+#include "../parser.hpp"
+
+#include <cassert>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+auto TestWriter() -> void {
+    const auto json = JsonValue{
+        "{                                                     \n"
+        "    \"params\": {\"cpp_standard\": 20, \"flags\": [\"-O2\", \"-g\"]}, \n"
+        "    \"name\": \"gcc\"                                  \n"
+        "}                                                     \n"
+    };
+
+    {   // Commas and colons are inserted automatically, raw values are copied as is
+        auto writer = Writer{};
+        writer.BeginMapping()
+            .Key("name").Value("clang")
+            .Key("version").Value(14)
+            .Key("ratio").Value(0.1)
+            .Key("enabled").Value(true)
+            .Key("nothing").Null()
+            .Key("params").Raw(json["params"].Value())
+            .Key("empty").BeginArray().EndArray()
+            .Key("list").BeginArray().Value(-1).Value(uint64_t{18446744073709551615u}).BeginMapping().EndMapping().EndArray()
+            .EndMapping();
+        const auto result = writer.Finish();
+        assert(result.HasValue());
+        assert(result.Value() ==
+            "{\"name\":\"clang\",\"version\":14,\"ratio\":0.1,\"enabled\":true,\"nothing\":null,"
+            "\"params\":{\"cpp_standard\": 20, \"flags\": [\"-O2\", \"-g\"]},"
+            "\"empty\":[],\"list\":[-1,18446744073709551615,{}]}"
+        );
+        const auto parsed = JsonValue{result.Value()};
+        assert(parsed["params"]["flags"][1].As<String>() == "-g");
+        assert(parsed["ratio"].As<Float>() == 0.1);
+    }
+
+    {   // Strings and keys read by the parser are still escaped, and are copied without escaping them again
+        const auto escaped = JsonValue{R"({"tab\there": "a\nb é \\"})"};
+        auto writer = Writer{};
+        writer.BeginMapping();
+        for (const auto [k, v] : escaped.As<Mapping>()) writer.RawKey(k.Value()).RawString(v.As<String>().Value());
+        writer.EndMapping();
+        const auto result = writer.Finish();
+        assert(result.Value() == R"({"tab\there":"a\nb é \\"})");
+        assert(JsonValue{result.Value()}["tab\\there"].As<String>() == R"(a\nb é \\)");
+        // `Key()` and `Value()` would have escaped the backslashes a second time
+        auto twice = Writer{};
+        twice.BeginMapping().Key("tab\\there").Value("a\\nb").EndMapping();
+        assert(twice.Finish().Value() == R"({"tab\\there":"a\\nb"})");
+        // The raw variants are checked like the others
+        auto misplaced = Writer{};
+        misplaced.BeginArray().RawKey("k");
+        assert(misplaced.Finish().HasError());
+        auto invalid = Writer{};
+        invalid.RawString("\xff");
+        assert(invalid.Finish().HasError());
+    }
+
+    {   // Strings are escaped, both short ones and long ones (processed 16 characters at a time)
+        auto writer = Writer{};
+        auto text = std::string{"a \"quoted\" path C:\\dir\\file\twith a tab\nand a newline"};
+        text += '\x01';
+        text += std::string(40, 'x') + "\x1f";
+        writer.Value(text);
+        assert(writer.Finish().Value() ==
+            "\"a \\\"quoted\\\" path C:\\\\dir\\\\file\\twith a tab\\nand a newline\\u0001"
+            + std::string(40, 'x') + "\\u001f\""
+        );
+        static_assert(NUtils::FindFirstToEscape("plain text") == 10);
+        static_assert(NUtils::FindFirstToEscape("a \"b\"", 3) == 4);
+        for (size_t pos = 0; pos != 40; ++pos) {
+            auto str = std::string(40, 'y');
+            str[pos] = '\\';
+            assert(NUtils::FindFirstToEscape(str) == pos);
+            str[pos] = static_cast<char>(0x80); // non-ascii bytes are copied as is
+            assert(NUtils::FindFirstToEscape(str) == 40);
+        }
+    }
+
+    {   // Characters are not numbers, while small integers are
+        const auto canWrite = []<class T>(T) { return requires(Writer& w, T value) { w.Value(value); }; };
+        static_assert(!canWrite('a') && !canWrite(u8'a') && !canWrite(L'a'));
+        static_assert(canWrite(int8_t{-1}) && canWrite(uint8_t{1}) && canWrite(true));
+        auto writer = Writer{};
+        writer.BeginArray().Value(int8_t{-1}).Value(uint8_t{255}).EndArray();
+        assert(writer.Finish() == std::string_view{"[-1,255]"});
+    }
+
+    {   // Doubles are written in the shortest form that round-trips
+        auto writer = Writer{};
+        writer.BeginArray().Value(1e300).Value(2.5f).Value(-0.0).Value(1.0 / 3).EndArray();
+        const auto result = writer.Finish().Value();
+        assert(result == "[1e+300,2.5,-0,0.3333333333333333]");
+        assert(JsonValue{result}[3].As<Float>() == 1.0 / 3);
+        // Floats are written in the shortest form that is parsed back to the same float
+        auto floats = Writer{};
+        floats.BeginArray().Value(0.1f).Value(1.0f / 3).EndArray();
+        assert(floats.Finish() == std::string_view{"[0.1,0.33333334]"});
+    }
+
+    {   // A fixed buffer
+        char buffer[16];
+        auto writer = Writer{buffer};
+        writer.BeginArray().Value(1).Value(2).EndArray();
+        assert(writer.Finish() == std::string_view{"[1,2]"});
+        writer.Reset();
+        writer.Value("a string that doesn't fit");
+        assert(writer.Finish().Error().BasicInfo.Code == NError::ErrorCode::WriterError);
+    }
+
+    {   // A buffer flushed to a sink whenever it gets full
+        char buffer[4];
+        auto out = std::string{};
+        auto nFlushes = 0;
+        auto writer = Writer{buffer, [&](std::string_view chunk) { out += chunk; ++nFlushes; }};
+        writer.BeginMapping().Key("params").Raw(json["params"].Value()).Key("name").Value("g\"cc").EndMapping();
+        assert(writer.Finish() == std::string_view{});
+        assert(out == "{\"params\":" + std::string{json["params"].Value().GetData()} + ",\"name\":\"g\\\"cc\"}");
+        assert(nFlushes == static_cast<int>((out.size() + 3) / 4));
+    }
+
+    {   // A growable writer can't be copied, since the copy would write into the memory of the original,
+        // but it can be moved, and the moved writer keeps writing into the same buffer
+        static_assert(!std::is_copy_constructible_v<Writer> && !std::is_copy_assignable_v<Writer>);
+        static_assert(std::is_nothrow_move_constructible_v<Writer> && !std::is_move_assignable_v<Writer>);
+        auto resource = std::pmr::monotonic_buffer_resource{};
+        auto writer = Writer{&resource};
+        writer.BeginArray().Value(1);
+        auto moved = Writer{std::move(writer)};
+        for (auto i = 0; i != 100; ++i) moved.Value(i);
+        moved.EndArray();
+        const auto result = moved.Finish();
+        assert(result.Value().starts_with("[1,0,1,2,") && result.Value().ends_with(",98,99]"));
+    }
+
+    {   // Misuse is reported by `Finish()`
+        const auto errorOf = [](auto&& write) {
+            auto writer = Writer{};
+            write(writer);
+            const auto result = writer.Finish();
+            assert(result.HasError());
+            assert(result.Error().BasicInfo.Code == NError::ErrorCode::WriterError);
+            return std::get<std::string_view>(result.Error().AdditionalInfo);
+        };
+        assert(errorOf([](Writer& w) { w.BeginArray().Key("a"); }) == "a key outside of a mapping");
+        assert(errorOf([](Writer& w) { w.BeginMapping().Value(1); }) == "a key is expected before a value in a mapping");
+        assert(errorOf([](Writer& w) { w.BeginMapping().Key("a").Key("b"); }) == "two keys in a row");
+        assert(errorOf([](Writer& w) { w.BeginMapping().Key("a").EndMapping(); }) == "a key without a value at the end of a mapping");
+        assert(errorOf([](Writer& w) { w.BeginArray().EndMapping(); }) == "no mapping to end");
+        assert(errorOf([](Writer& w) { w.BeginArray(); }) == "the document is incomplete");
+        assert(errorOf([](Writer& w) { w.Value(1).Value(2); }) == "the document is already complete");
+        assert(errorOf([](Writer& w) { w.Value(std::numeric_limits<double>::infinity()); }) == "json can't represent infinities and NaNs");
+        assert(errorOf([](Writer& w) { w.Value("caf\xc3"); }) == "a string is not valid utf-8");
+        assert(errorOf([](Writer& w) { w.BeginMapping().Key("\xff"); }) == "a string is not valid utf-8");
+        assert(errorOf([](Writer& w) { for (size_t i = 0; i <= Writer::kMaxDepth; ++i) w.BeginArray(); }) == "the document is nested too deeply");
+    }
+}
@@ -0,0 +1,85 @@
+// Turns a json file into a C++ header that contains the document together with its precomputed
+// document index as `constexpr` variables (see `NJsonParser::EmbedDocument`), so that the document
+// can be navigated at compile time without being scanned on every compilation.
+//
+// Build:
+//     g++ --std=c++20 -O2 tools/embed_json.cpp -o embed_json
+// Run:
+//     ./embed_json config.json config_json.hpp --namespace=NConfig --include=path/to/parser.hpp
+//
+// Options:
+//     --namespace=<name>  the namespace of the generated variables ("NEmbedded" by default)
+//     --include=<path>    the path the generated header includes the library by ("parser.hpp" by default)
+//
+// The output file is only rewritten when its contents change, so that the files
+// that include it are not recompiled needlessly when the build reruns the tool.
+
+#include "../parser.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace NJsonParser;
+
+
+namespace {
+    auto ReadFile(const std::string& path, std::string& contents) -> bool {
+        auto in = std::ifstream{path, std::ios::binary};
+        if (!in) return false;
+        auto buffer = std::ostringstream{};
+        buffer << in.rdbuf();
+        contents = std::move(buffer).str();
+        return true;
+    }
+} // namespace
+
+
+auto main(int argc, char** argv) -> int {
+    auto namespaceName = std::string{"NEmbedded"};
+    auto parserInclude = std::string{"parser.hpp"};
+    auto paths = std::vector<std::string>{};
+    for (int i = 1; i != argc; ++i) {
+        const auto arg = std::string{argv[i]};
+        if (arg.starts_with("--namespace=")) namespaceName = arg.substr(12);
+        else if (arg.starts_with("--include=")) parserInclude = arg.substr(10);
+        else if (arg.starts_with("--")) {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        } else paths.push_back(arg);
+    }
+    if (paths.size() != 2) {
+        std::fprintf(stderr, "usage: %s <input.json> <output.hpp> [--namespace=<name>] [--include=<path>]\n", argv[0]);
+        return 1;
+    }
+    const auto& inputPath = paths[0];
+    const auto& outputPath = paths[1];
+
+    auto json = std::string{};
+    if (!ReadFile(inputPath, json)) {
+        std::fprintf(stderr, "can't read %s\n", inputPath.c_str());
+        return 1;
+    }
+    const auto header = EmbedDocument(JsonValue{json}, {
+        .Namespace = namespaceName,
+        .ParserInclude = parserInclude,
+        .SourceName = inputPath.substr(inputPath.rfind('/') + 1),
+    });
+    if (header.HasError()) {
+        std::cerr << inputPath << ": " << header.Error() << "\n";
+        return 1;
+    }
+
+    auto previous = std::string{};
+    if (ReadFile(outputPath, previous) && previous == header.Value()) return 0;
+    auto out = std::ofstream{outputPath, std::ios::binary};
+    out << header.Value();
+    if (!out.flush()) {
+        std::fprintf(stderr, "can't write %s\n", outputPath.c_str());
+        return 1;
+    }
+}